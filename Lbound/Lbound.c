@@ -16,6 +16,7 @@
 #include <math.h>   // M_PI
 
 #include <frtbp.h>
+#include <htraj.h>	// htraj_t, htraj_read
 #include <approxint.h>	// stability_t
 #include "Lbound_module.h"
 
@@ -41,10 +42,16 @@ Compute an upper bound for \f$L_{hom}(t)\f$ for all $\fJ\in[J_-, J_+]\f$.
 
   For each input line, it outputs result to stdout:
   - bound
+
+  Usage: Lbound [storefile]
+
+  If a store file written by intersec is given, the homoclinic of each input
+  line is evaluated from the next store of the file (see \ref Lbound_htraj)
+  instead of being integrated again.
  
  */
  
-int main( )
+int main(int argc, char *argv[])
 {
    double mu;
 
@@ -57,6 +64,9 @@ int main( )
    double T;	    /* period */
    double t;	    /* integration time from z_u to z */
 
+   FILE *fstore = NULL;	/* store file (if given) */
+   htraj_t tr;		/* homoclinic from z_u to z */
+
    // auxiliary vars
    int status;
    stability_t st;
@@ -71,9 +81,32 @@ int main( )
 
    st = (stability==0 ? UNSTABLE : STABLE);
 
+   if(argc > 1 && (fstore = fopen(argv[1], "rb")) == NULL)
+   {
+      perror("main: error opening store file");
+      exit(EXIT_FAILURE);
+   }
+
    // Input period T, zu, time to reach hom. pt. z, from stdin.
    while(scanf("%le %le %le %le %le %le", &T, zu, zu+1, zu+2, zu+3, &t) == 6)
    {
+	   if(fstore != NULL)
+	   {
+		  if(htraj_read(fstore, &tr))
+			 exit(EXIT_FAILURE);
+		  if(!tr.del || fabs(tr.t1-t) > 1.e-10*fabs(t))
+		  {
+			 fprintf(stderr, "main: store does not match input line\n");
+			 exit(EXIT_FAILURE);
+		  }
+		  status = Lbound_htraj(&tr, &bound);
+		  htraj_free(&tr);
+		  if(status)
+			 exit(EXIT_FAILURE);
+		  printf("%.15e\n", bound);
+		  fflush(NULL);
+		  continue;
+	   }
 	   if(st==UNSTABLE)
 	   {
 		   // Instead of fetching zs from intersecs_st_SECg_br1.res, 
@@ -15,7 +15,10 @@
 #include <utils_module.h>           // dblcpy
 #include <frtbp.h>
 #include <cardel.h>
-#include <math.h>           // cbrt
+#include <htraj.h>	// htraj_eval_del
+#include <math.h>           // cbrt, floor
+
+#include "Lbound_module.h"
 
 const double SHORT_TIME=0.01;       ///< integration "step" for frtbp
 
@@ -52,3 +55,31 @@ int Lbound(double mu, double x[DIM], double t, double *bound)
    }
    return 0;
 }
+
+int Lbound_htraj(const htraj_t *tr, double *bound)
+{
+    double L0 = 1.0/cbrt(3);    ///< resonant value \f$ L_0 \f$
+
+   // auxiliary variables
+   int i, n;
+   double xt_del[DIM];		/* point x(t) in Delaunay*/
+   double dt, L;
+
+   dt = (tr->t1>0 ? SHORT_TIME : -SHORT_TIME);
+   n = (int)floor(tr->t1/dt + 1.e-6);
+   
+   *bound = 0.0;
+   for(i=1; i<=n; i++)
+   {
+	   if(htraj_eval_del(tr,i*dt,xt_del))
+	   {
+         fprintf(stderr, "Lbound_htraj: evaluation error at sample %d\n", i);
+         return(1);
+	   }
+
+       /* Update L bound */
+       L = xt_del[1];
+       if(fabs(L-L0) > *bound) *bound=fabs(L-L0);
+   }
+   return 0;
+}
@@ -1,3 +1,15 @@
 #include <rtbp.h>   // DIM
+#include <htraj.h>  // htraj_t
 
 int Lbound(double mu, double x[DIM], double t, double *bound); 
+
+/**
+  Bound for \f$|L_{hom}(t,J) - L_0|\f$ along a stored homoclinic.
+
+  Same as \ref Lbound, but the homoclinic is evaluated from a trajectory
+  store with Delaunay elements (such as those written by intersec) instead
+  of being integrated again. The samples are taken every SHORT_TIME units of
+  time, from 0 to tr->t1; unlike \ref Lbound, no sample is taken past
+  tr->t1.
+  */
+int Lbound_htraj(const htraj_t *tr, double *bound);
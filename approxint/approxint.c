@@ -17,6 +17,9 @@
 #include <prtbp_nl.h>	// prtbp_nl, prtbp_nl_inv
 #include <disc.h>	// disc
 #include <utils_module.h>	// l2_norm
+#include <section.h>	// SEC2
+#include <hinv.h>	// hinv
+#include "approxint.h"
 
 /*! \brief 
   Max number of iterations of unst segment before we give up looking for
@@ -31,6 +34,12 @@ int
 u_i (double mu, double H, int k, double z[2], double a, double *l, int *idx);
 int 
 s_i (double mu, double H, int k, double z[2], double a, double *l, int *idx);
+int
+approxint_predict (const approxint_track_t *tr, double H, double h0,
+      double h1, int *n, double *h_1, double *h_2);
+int
+approxint_check (stability_t stable, double mu, double H, int k, double p[2],
+      double v[2], double a, int n, double h_1, double h_2, double z[2]);
 
 // NOTES
 // =====
@@ -226,6 +235,62 @@ approxint_st (double mu, double H, int k, double p[2], double v[2],
    return(0);
 }
 
+void
+approxint_track_init (approxint_track_t *tr)
+{
+   tr->nrows = 0;
+   tr->hits = 0;
+   tr->misses = 0;
+}
+
+int
+approxint_track (approxint_track_t *tr, stability_t stable, double mu,
+      double H, int k, double p[2], double v[2], double lambda, double h,
+      double a, int *piter, double *h_1, double *h_2, double z[2])
+{
+   double rho = (stable==UNSTABLE ? lambda : 1.0/lambda);
+   int status, i;
+
+   if(tr->nrows > 0 && (tr->stable != stable || tr->a != a))
+      tr->nrows = 0;
+
+   // Prediction, checked with one evaluation of the map.
+   if(approxint_predict(tr, H, h, rho*h, piter, h_1, h_2) == 0 &&
+	 approxint_check(stable, mu, H, k, p, v, a, *piter, *h_1, *h_2, z) == 0)
+      tr->hits++;
+   else
+   {
+      // Full search.
+      tr->misses++;
+      if(stable==UNSTABLE)
+	 status = approxint_unst(mu, H, k, p, v, lambda, h, a, piter, h_1,
+	       h_2, z);
+      else
+	 status = approxint_st(mu, H, k, p, v, lambda, h, a, piter, h_1,
+	       h_2, z);
+      if(status)
+	 return(status);
+   }
+
+   // Store this energy level as the most recent one.
+   if(tr->nrows < APPROXINT_TRACK_ROWS)
+      tr->nrows++;
+   for(i=tr->nrows-1; i>0; i--)
+   {
+      tr->H[i] = tr->H[i-1];
+      tr->n[i] = tr->n[i-1];
+      tr->h1[i] = tr->h1[i-1];
+      tr->h2[i] = tr->h2[i-1];
+   }
+   tr->stable = stable;
+   tr->a = a;
+   tr->H[0] = H;
+   tr->n[0] = *piter;
+   tr->h1[0] = *h_1;
+   tr->h2[0] = *h_2;
+   return(0);
+}
+
 // name OF FUNCTION: u_i
 //
 // PURPOSE
@@ -394,3 +459,101 @@ s_i (double mu, double H, int k, double z[2], double a, double *l4, int *idx)
    return(0);
 }
 
+
+// name OF FUNCTION: approxint_predict
+//
+// PURPOSE
+// =======
+// Predict the number of iterates n and the bracket (h_1,h_2) at energy H
+// from the levels stored in the tracker. The midpoint of the bracket and n
+// are extrapolated linearly in H from the last two levels (or copied from
+// the last one). The half-width of the bracket is the width of the last
+// bracket plus the extrapolation step, and the bracket is clipped to the
+// fundamental segment between h0 and h1.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if there is no prediction (empty tracker, or the
+// bracket falls outside the fundamental segment), and 0 otherwise.
+
+int
+approxint_predict (const approxint_track_t *tr, double H, double h0,
+      double h1, int *n, double *h_1, double *h_2)
+{
+   double c0, c1;	// midpoints of the last two brackets
+   double c;		// predicted midpoint
+   double s = 0;	// extrapolation parameter
+   double w;		// half-width of the predicted bracket
+   double lo = (h0 < h1 ? h0 : h1);
+   double hi = (h0 < h1 ? h1 : h0);
+
+   if(tr->nrows == 0)
+      return(1);
+
+   c0 = (tr->h1[0]+tr->h2[0])/2;
+   c = c0;
+   *n = tr->n[0];
+   if(tr->nrows > 1 && tr->H[0] != tr->H[1])
+   {
+      c1 = (tr->h1[1]+tr->h2[1])/2;
+      s = (H-tr->H[0])/(tr->H[0]-tr->H[1]);
+      c = c0 + s*(c0-c1);
+      *n = (int)lround(tr->n[0] + s*(tr->n[0]-tr->n[1]));
+   }
+   if(*n < 1 || *n > MAXITER)
+      return(1);
+
+   w = fabs(tr->h2[0]-tr->h1[0]) + fabs(c-c0);
+   *h_1 = (c-w > lo ? c-w : lo);
+   *h_2 = (c+w < hi ? c+w : hi);
+   return(!(*h_1 < *h_2));
+}
+
+// name OF FUNCTION: approxint_check
+//
+// PURPOSE
+// =======
+// Check that the bracket (h_1,h_2) contains the preimage of an intersection
+// of the n-th iterate of the manifold with the line $p_x=a$: the images
+// under $P^n$ (resp. $P^{-n}$) of the endpoints $p+h_1 v$ and $p+h_2 v$
+// must straddle the line and be "close enough", as in u_i. On success, z
+// holds the image of the first endpoint.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the check fails (or the map could not be
+// computed), and 0 otherwise.
+
+int
+approxint_check (stability_t stable, double mu, double H, int k, double p[2],
+      double v[2], double a, int n, double h_1, double h_2, double z[2])
+{
+   double x[2][DIM];	// endpoints of the bracket, and their images
+   double d[2];		// difference between the images
+   double hb[2] = {h_1, h_2};
+   double ti;
+   int j, status;
+
+   for(j=0; j<2; j++)
+   {
+      x[j][0] = p[0] + hb[j]*v[0];	// x
+      x[j][1] = 0;			// y
+      x[j][2] = p[1] + hb[j]*v[1];	// px
+      if(hinv(mu,SEC2,H,x[j]))
+	 return(1);
+      if(stable==UNSTABLE)
+	 status = prtbp_nl(mu,SEC2,n*k,x[j],&ti);
+      else
+	 status = prtbp_nl_inv(mu,SEC2,n*k,x[j],&ti);
+      if(status)
+	 return(1);
+   }
+   d[0] = x[0][0]-x[1][0];
+   d[1] = x[0][2]-x[1][2];
+   if((x[0][2]-a)*(x[1][2]-a) > 0 || l2_norm(d, 2) >= 0.5)
+      return(1);
+
+   z[0] = x[0][0];
+   z[1] = x[0][2];
+   return(0);
+}
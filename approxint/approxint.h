@@ -105,4 +105,68 @@ approxint_st (double mu, double H, int k, double p[2], double v[2],
       double lambda, double h, double a, 
       int *piter, double *h_1, double *h_2, double z[2]);
 
+/// Number of energy levels kept by the tracker of \ref approxint_track.
+#define APPROXINT_TRACK_ROWS 2
+
+/**
+  Tracker of the approximate intersection along an energy sweep.
+
+  Along a sweep in the energy H, the number of iterates $n$ and the bracket
+  $(h_1,h_2)$ returned by \ref approxint_unst (\ref approxint_st) change
+  smoothly. The tracker keeps the results of the last
+  APPROXINT_TRACK_ROWS energy levels, most recent first, to predict them
+  for the next level (see \ref approxint_track).
+
+  A tracker must only be used for one sweep, i.e. fixed mu, k, manifold and
+  branch. It is reset if it is called with another manifold or line.
+  */
+typedef struct
+{
+   int nrows;		///< number of energy levels stored
+   stability_t stable;	///< manifold of the stored levels
+   double a;		///< line $p_x=a$ of the stored levels
+   double H[APPROXINT_TRACK_ROWS];	///< energy values
+   int n[APPROXINT_TRACK_ROWS];		///< number of iterates
+   double h1[APPROXINT_TRACK_ROWS];	///< brackets
+   double h2[APPROXINT_TRACK_ROWS];
+   int hits;		///< number of predictions accepted
+   int misses;		///< number of full searches
+} approxint_track_t;
+
+/** Initialize an (empty) tracker. */
+void approxint_track_init(approxint_track_t *tr);
+
+/**
+  Approximate intersection of the manifold with the line $p_x=a$, warm
+  started from the previous energy levels of the sweep.
+
+  The number of iterates $n$ and the midpoint of the bracket are
+  extrapolated linearly in H from the last two levels (or copied from the
+  last one), and the predicted bracket is the midpoint $\pm$ the width of
+  the last bracket (plus the size of the extrapolation step), clipped to
+  the fundamental segment. The prediction is checked with a single
+  evaluation of $P^n$ (resp. $P^{-n}$) at the two endpoints: their images
+  must straddle the line $p_x=a$ and be close to each other, as in \ref
+  approxint_unst. If the check fails, or there is no previous level, the
+  full search of \ref approxint_unst (\ref approxint_st) is done.
+
+  The result is then stored in the tracker for the next level.
+
+  \remark The check does not verify that $n$ is the first iterate that
+  crosses the line. The continuity along the sweep is what keeps the
+  intersection in the primary family.
+
+  \param[in,out] tr	tracker (see \ref approxint_track_init)
+  \param[in] stable	unstable or stable manifold
+
+  The other parameters are those of \ref approxint_unst.
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success (see \ref approxint_unst).
+  */
+int
+approxint_track (approxint_track_t *tr, stability_t stable, double mu,
+      double H, int k, double p[2], double v[2], double lambda, double h,
+      double a, int *piter, double *h_1, double *h_2, double z[2]);
+
 #endif // APPROXINT_H_INCLUDED
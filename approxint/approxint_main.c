@@ -8,7 +8,7 @@
 #include <section.h>	// branch_t
 #include <prtbp.h>		// SEC2
 #include <errmfld.h>	// h_opt
-#include "approxint.h"	// approxint_unst, approxint_st
+#include "approxint.h"	// approxint_track
 
 /** 
    Approximate Intersection of Invariant Manifolds: main prog
@@ -46,7 +46,10 @@
   
       2.2. Find an approximate intersection point of the manifolds, in the
       form of an interval $u_i=(h_1,h_2)$ containig the root p_u = p+h_u v_u,
-      where \f$h_u\in (h_1,h_2)\f$.
+      where \f$h_u\in (h_1,h_2)\f$. The interval is predicted from the
+      previous energy levels and checked with a single evaluation of the
+      map; the full search is only done when the check fails (see \ref
+      approxint_track).
   
       2.3. Output the following line to stdout: 
          H, iter, h_1, h_2, z.
@@ -98,6 +101,9 @@ int main( )
 
    double a;	// horizontal axis line $p_x=a$
 
+   // tracker of the energy sweep
+   approxint_track_t track;
+
    // auxiliary vars
    int status;
    branch_t br;
@@ -139,6 +145,8 @@ int main( )
       }
    }
 
+   approxint_track_init(&track);
+
    // For each energy level H in the range, do
    while(scanf("%le %le %le %le %le %le", 
 	    &H, p, p+1, v, v+1, &lambda)==6)
@@ -162,8 +170,8 @@ int main( )
       // cross the $x$ axis).
       if(!stable)
       {
-	 status = approxint_unst(mu, H, k, p, v, lambda, h, a, &iter, &h_1, 
-	       &h_2, z);
+	 status = approxint_track(&track, UNSTABLE, mu, H, k, p, v, lambda, h,
+	       a, &iter, &h_1, &h_2, z);
 	 if(status)
 	 {
 	    fprintf(stderr, 
@@ -180,8 +188,8 @@ int main( )
       }
       else
       {
-	 status = approxint_st(mu, H, k, p, v, lambda, h, a, &iter, &h_1, 
-	       &h_2, z);
+	 status = approxint_track(&track, STABLE, mu, H, k, p, v, lambda, h,
+	       a, &iter, &h_1, &h_2, z);
 	 if(status)
 	 {
 	    fprintf(stderr, 
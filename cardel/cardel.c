@@ -141,3 +141,89 @@ void cardel(double X[DIM], double Y[DIM])
    Y[2]=g;
    Y[3]=G;
 }
+
+void cardel_batch(int n, const double *restrict x, const double *restrict y,
+      const double *restrict px, const double *restrict py,
+      double *restrict l, double *restrict L, double *restrict g,
+      double *restrict G)
+{
+   int i;
+
+   // auxiliary variables
+   double r, Gi, Lsq, e, cu, su, u, sgn, v, gi;
+
+   for(i=0; i<n; i++)
+   {
+      r = sqrt(x[i]*x[i]+y[i]*y[i]);
+      Gi = -y[i]*px[i] + x[i]*py[i];
+      Lsq = -1.0/( px[i]*px[i] + py[i]*py[i] -2.0/r );
+      e = sqrt(1.0 - Gi*Gi/Lsq);
+
+      // Make sure cos(u) is in the range [-1,1].
+      cu = 1.0/e*(1.0-r/Lsq);
+      cu = fmin(fmax(cu, -1.0), 1.0);
+
+      // The sign of the radial velocity $\dot r=(x p_x+y p_y)/r$ gives the
+      // sign of the eccentric anomaly $u$.
+      sgn = (x[i]*px[i]+y[i]*py[i] >= 0 ? 1.0 : -1.0);
+      u = sgn*acos(cu);
+      su = sgn*sqrt(1-cu*cu);
+
+      // True anomaly, from the half-angle formula
+      // \tan(v/2) = \sqrt{(1+e)/(1-e)} \tan(u/2).
+      // Written with atan2, there is no need to treat $u=\pm\pi$ apart.
+      v = 2.0*atan2(sgn*sqrt((1.0+e)*(1.0-cu)), sqrt((1.0-e)*(1.0+cu)));
+
+      // Normalize g between [-pi,pi]
+      gi = atan2(y[i],x[i]) - v;
+      gi -= (gi > M_PI ? TWOPI : 0.0);
+      gi += (gi < -M_PI ? TWOPI : 0.0);
+
+      l[i] = u-e*su;
+      L[i] = sqrt(Lsq);
+      g[i] = gi;
+      G[i] = Gi;
+   }
+}
+
+// name OF FUNCTION: delcar
+// PURPOSE:
+//    Inverse of cardel: rotating cartesian coordinates (x,y,px,py) of the
+//    point with rotating Delaunay coordinates (l,L,g,G).
+//    Kepler's equation $u-e\sin u=l$ is solved with Newton's method, starting
+//    from $u=l+e\sin l$ (this converges for all $e<1$).
+//    The position is $r(\cos\phi,\sin\phi)$, with $\phi=g+v$, and the
+//    momentum has radial component $\dot r=Le\sin u/r$ and angular component
+//    $G/r$ (the momenta of the RTBP are the inertial velocities).
+void delcar(const double Y[DIM], double X[DIM])
+{
+   double l=Y[0];
+   double L=Y[1];
+   double g=Y[2];
+   double G=Y[3];
+
+   double Lsq = L*L;
+   double e = sqrt(fmax(1.0 - G*G/Lsq, 0.0));	// eccentricity
+   double u, du;	// eccentric anomaly, Newton correction
+   double v;		// true anomaly
+   double r, dotr, phi;
+   int iter;
+
+   u = l + e*sin(l);
+   for(iter=0; iter<50; iter++)
+   {
+      du = (u - e*sin(u) - l)/(1.0 - e*cos(u));
+      u -= du;
+      if(fabs(du) <= 1.e-15*(1.0+fabs(u)))
+	 break;
+   }
+   r = Lsq*(1.0 - e*cos(u));
+   v = 2.0*atan2(sqrt(1.0+e)*sin(u/2.0), sqrt(1.0-e)*cos(u/2.0));
+   phi = g + v;
+   dotr = L*e*sin(u)/r;
+
+   X[0] = r*cos(phi);
+   X[1] = r*sin(phi);
+   X[2] = dotr*cos(phi) - G/r*sin(phi);
+   X[3] = dotr*sin(phi) + G/r*cos(phi);
+}
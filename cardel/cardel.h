@@ -35,3 +35,30 @@
   \return void
 */    
 void cardel(double X[DIM], double Y[DIM]);
+
+/**
+  Batch version of \ref cardel, for n points in structure-of-arrays layout.
+
+  The loop has no branches (the sign of $u$ is a select), and the true
+  anomaly is obtained with a single atan2 of the half angle, so that
+  compilers can vectorize it. Results agree with \ref cardel up to
+  roundoff.
+
+  \param[in] n number of points
+  \param[in] x,y,px,py rotating cartesian coordinates of the points
+  \param[out] l,L,g,G rotating Delaunay coordinates of the points
+*/
+void cardel_batch(int n, const double *restrict x, const double *restrict y,
+      const double *restrict px, const double *restrict py,
+      double *restrict l, double *restrict L, double *restrict g,
+      double *restrict G);
+
+/**
+  Obtain rotating cartesian coordinates (x,y,p_x,p_y) from rotating Delaunay
+  (l,L,g,G). This is the inverse of \ref cardel.
+
+  \param[in] Y point in rotating Delaunay coordinates, Y=(l,L,g,G).
+  \param[out] X point in rotating cartesian coordinates, X=(x,y,p_x,p_y).
+  \return void
+*/
+void delcar(const double Y[DIM], double X[DIM]);
@@ -0,0 +1,229 @@
+/*! \file
+    \brief Chaos Indicator Maps on Poincare Section Grids
+*/
+
+#include <stdio.h>	// fprintf, fopen, fwrite
+#include <math.h>	// log, sqrt, NAN, M_PI
+#include <gsl/gsl_errno.h>	// GSL_SUCCESS
+#include <gsl/gsl_odeiv.h>
+
+#include <rtbp.h>	// DIM, rtbp
+#include <section.h>	// SEC2
+#include <hinv.h>	// hinv
+#include <hinvdel.h>	// hinv_del
+#include <cardel.h>	// delcar
+#include <tolprof.h>	// tolprof_tol
+
+#include "chaosmap.h"
+
+const int ERR_CHAOS_FLOW=1;
+const int ERR_CHAOS_IO=2;
+
+const double CHAOS_TOL=1.e-12;
+
+/// Dimension of the extended system: point, tangent vector, MEGNO integrals.
+#define DIMCHAOS (2*DIM+2)
+
+/// The tangent vector is renormalized when its norm exceeds this value.
+static const double CHAOS_RENORM=1.e100;
+
+int rtbp_chaos(double t, const double *x, double *f, void *params);
+
+int chaos_indicator(double mu, chaos_ind_t ind, double T, double stop,
+      const double x[DIM], const double w[DIM], double *val, double *t)
+{
+   double y[DIMCHAOS];	// point, tangent vector, MEGNO integrals
+   double logw = 0;	// log of the norm removed by the renormalizations
+   double nw;		// norm of the tangent vector
+   double fli = 0;
+   double h = 1.e-3;	// step size
+   double tol = tolprof_tol(TOL_FLOW,CHAOS_TOL);
+   int status = GSL_SUCCESS;
+   int i;
+
+   const gsl_odeiv_step_type *Ty = gsl_odeiv_step_rk8pd;
+   gsl_odeiv_step *s = gsl_odeiv_step_alloc(Ty,DIMCHAOS);
+   gsl_odeiv_control *c = gsl_odeiv_control_y_new(tol,tol);
+   gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIMCHAOS);
+   gsl_odeiv_system sys = {rtbp_chaos,NULL,DIMCHAOS,&mu};
+
+   for(i=0; i<DIM; i++)
+   {
+      y[i] = x[i];
+      y[DIM+i] = w[i];
+   }
+   y[2*DIM] = 0;	// 2 \int_0^t (w.w'/w.w) s ds
+   y[2*DIM+1] = 0;	// \int_0^t Y(s) ds
+
+   *t = 0;
+   *val = 0;
+   while(*t < T)
+   {
+      status = gsl_odeiv_evolve_apply(e,c,s,&sys,t,T,&h,y);
+      if(status != GSL_SUCCESS)
+	 break;
+
+      nw = 0;
+      for(i=DIM; i<2*DIM; i++)
+	 nw += y[i]*y[i];
+      nw = sqrt(nw);
+      if(nw > CHAOS_RENORM)
+      {
+	 for(i=DIM; i<2*DIM; i++)
+	    y[i] /= nw;
+	 logw += log(nw);
+	 nw = 1;
+      }
+      if(logw + log(nw) > fli)
+	 fli = logw + log(nw);
+
+      *val = (ind==CHAOS_FLI ? fli : y[2*DIM+1]/(*t));
+      if(stop > 0 && *val > stop)
+	 break;
+   }
+   gsl_odeiv_evolve_free(e);
+   gsl_odeiv_control_free(c);
+   gsl_odeiv_step_free(s);
+   return(status == GSL_SUCCESS ? 0 : ERR_CHAOS_FLOW);
+}
+
+int chaosmap_ic(const chaosmap_t *m, int i, int j, double x[DIM])
+{
+   double u = m->u0 + (m->nu > 1 ? i*(m->u1-m->u0)/(m->nu-1) : 0);
+   double v = m->v0 + (m->nv > 1 ? j*(m->v1-m->v0)/(m->nv-1) : 0);
+   double p[DIM];
+
+   if(m->grid == CHAOS_GRID_CAR)
+   {
+      x[0] = u;		// x
+      x[1] = 0;		// y
+      x[2] = v;		// px
+      return(hinv(m->mu,SEC2,m->H,x));
+   }
+   p[0] = M_PI;		// l
+   p[2] = u;		// g
+   p[3] = v;		// G
+   if(hinv_del(m->mu,m->H,p))
+      return(1);
+   delcar(p,x);
+   return(0);
+}
+
+int chaosmap(const chaosmap_t *m, double *val, int progress)
+{
+   const double w[DIM] = {0.5, 0.5, 0.5, 0.5};	// initial tangent vector
+   int mu_tiles = (m->nu + CHAOS_TILE-1)/CHAOS_TILE;
+   int mv_tiles = (m->nv + CHAOS_TILE-1)/CHAOS_TILE;
+   int ntiles = mu_tiles*mv_tiles;
+   int done = 0;	// number of finished tiles
+   int nnan = 0;	// number of empty cells
+   int k;
+
+   #pragma omp parallel for schedule(dynamic,1) reduction(+:nnan)
+   for(k=0; k<ntiles; k++)
+   {
+      int i0 = (k % mu_tiles)*CHAOS_TILE;
+      int j0 = (k / mu_tiles)*CHAOS_TILE;
+      int i, j, n;
+      double x[DIM], t;
+
+      for(j=j0; j<j0+CHAOS_TILE && j<m->nv; j++)
+	 for(i=i0; i<i0+CHAOS_TILE && i<m->nu; i++)
+	 {
+	    if(chaosmap_ic(m,i,j,x) ||
+		  chaos_indicator(m->mu,m->ind,m->T,m->stop,x,w,
+		     val+j*m->nu+i,&t))
+	    {
+	       val[j*m->nu+i] = NAN;
+	       nnan++;
+	    }
+	 }
+      if(progress)
+      {
+	 #pragma omp atomic capture
+	 n = ++done;
+	 fprintf(stderr, "chaosmap: %d/%d tiles\n", n, ntiles);
+      }
+   }
+   return(nnan);
+}
+
+int chaosmap_write(const char *fname, const chaosmap_t *m, const double *val)
+{
+   const int ihdr[4] = {m->grid, m->ind, m->nu, m->nv};
+   const double dhdr[8] = {m->mu, m->H, m->u0, m->u1, m->v0, m->v1, m->T,
+      m->stop};
+   size_t n = (size_t)m->nu*m->nv;
+   FILE *fp;
+   int ok;
+
+   fp = fopen(fname, "wb");
+   if(fp == NULL)
+   {
+      fprintf(stderr, "chaosmap_write: cannot open file %s\n", fname);
+      return(ERR_CHAOS_IO);
+   }
+   ok = (fwrite("CHAOSMAP", 1, 8, fp) == 8 && fwrite(ihdr, sizeof(int), 4, fp)
+	 == 4 && fwrite(dhdr, sizeof(double), 8, fp) == 8 &&
+	 fwrite(val, sizeof(double), n, fp) == n);
+   if(fclose(fp) || !ok)
+   {
+      fprintf(stderr, "chaosmap_write: error writing file %s\n", fname);
+      return(ERR_CHAOS_IO);
+   }
+   return(0);
+}
+
+// name OF FUNCTION: rtbp_chaos
+//
+// PURPOSE
+// =======
+// Vectorfield of the RTBP (see rtbp), extended with the variational
+// equations for one tangent vector and the MEGNO integrals. The point is
+// (x[0],...,x[3]), the tangent vector w=(x[4],...,x[7]), and
+//    x[8]' = 2t (w.Jw)/(w.w),	x[9]' = x[8]/t,
+// where J is the Jacobian of the vectorfield of the RTBP, so that the mean
+// MEGNO is x[9]/t.
+//
+// RETURN VALUE
+// ============
+// GSL_SUCCESS, or ERR_COLLISION (see rtbp).
+
+int rtbp_chaos(double t, const double *x, double *f, void *params)
+{
+   double mu = *(double *)params;
+   double mu1 = mu;
+   double mu2 = 1.0-mu;
+   const double *w = x+DIM;
+   double *dw = f+DIM;
+   double dx1, dx2, r1sq, r2sq, r13, r23, r15, r25;
+   double Vxx, Vxy, Vyy;	// second derivatives of the potential
+   double ww, wdw;
+   int status;
+
+   if((status=rtbp(t,x,f,params)))
+      return(status);
+
+   dx1 = x[0]-mu2;
+   dx2 = x[0]+mu1;
+   r1sq = dx1*dx1+x[1]*x[1];
+   r2sq = dx2*dx2+x[1]*x[1];
+   r13 = r1sq*sqrt(r1sq);
+   r23 = r2sq*sqrt(r2sq);
+   r15 = r13*r1sq;
+   r25 = r23*r2sq;
+   Vxx = mu1*(1/r13 - 3*dx1*dx1/r15) + mu2*(1/r23 - 3*dx2*dx2/r25);
+   Vxy = -3*x[1]*(mu1*dx1/r15 + mu2*dx2/r25);
+   Vyy = mu1*(1/r13 - 3*x[1]*x[1]/r15) + mu2*(1/r23 - 3*x[1]*x[1]/r25);
+
+   dw[0] = w[2]+w[1];
+   dw[1] = -w[0]+w[3];
+   dw[2] = w[3] - Vxx*w[0] - Vxy*w[1];
+   dw[3] = -w[2] - Vxy*w[0] - Vyy*w[1];
+
+   ww = w[0]*w[0]+w[1]*w[1]+w[2]*w[2]+w[3]*w[3];
+   wdw = w[0]*dw[0]+w[1]*dw[1]+w[2]*dw[2]+w[3]*dw[3];
+   f[2*DIM] = 2*t*wdw/ww;
+   f[2*DIM+1] = (t > 0 ? x[2*DIM]/t : 0);
+   return(GSL_SUCCESS);
+}
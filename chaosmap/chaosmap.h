@@ -0,0 +1,140 @@
+/*! \file
+    \brief Chaos Indicator Maps on Poincare Section Grids
+
+    The Fast Lyapunov Indicator (FLI) or the MEGNO of the RTBP is computed
+    for every cell of a grid of initial conditions at fixed energy, either
+    $(x,p_x)$ on the Cartesian section SEC2 $\{y=0, p_y<0\}$ or $(g,G)$ on
+    the Delaunay section $\{l=\pi\}$. The missing coordinate is obtained
+    with \ref hinv (resp. \ref hinv_del).
+
+    Each orbit is integrated together with one tangent vector $w$ (and the
+    two MEGNO integrals) with the Runge-Kutta Prince-Dormand (8,9) method.
+    It keeps no global state, so the cells can be computed in parallel (the
+    Taylor integrator of \ref dfrtbp uses a global mass parameter).
+    The grid is split into tiles of CHAOS_TILE x CHAOS_TILE cells, which are
+    distributed dynamically among the OpenMP threads. The integration of a
+    cell stops as soon as the indicator passes a threshold, so chaotic cells
+    are cheap.
+*/
+
+#ifndef CHAOSMAP_H_INCLUDED
+#define CHAOSMAP_H_INCLUDED
+
+#include <rtbp.h>	// DIM
+
+/// Side of the (square) tiles of cells given to each thread.
+#define CHAOS_TILE 16
+
+/** Integration error (e.g. collision). */
+extern const int ERR_CHAOS_FLOW;
+
+/** Error writing the raster. */
+extern const int ERR_CHAOS_IO;
+
+/// Relative and absolute tolerance of the integrator (relaxed by the
+/// tolerance profile, see \ref tolprof_tol).
+extern const double CHAOS_TOL;
+
+/// Chaos indicator.
+typedef enum
+{
+   CHAOS_FLI,	///< $\sup_{t\le T} \log\|w(t)\|$, $\|w(0)\|=1$
+   CHAOS_MEGNO	///< mean MEGNO $\langle Y\rangle(T)$
+} chaos_ind_t;
+
+/// Grid of initial conditions.
+typedef enum
+{
+   CHAOS_GRID_CAR,	///< $(x,p_x)$ on SEC2, $p_y$ from \ref hinv
+   CHAOS_GRID_DEL	///< $(g,G)$ on $\{l=\pi\}$, $L$ from \ref hinv_del
+} chaos_grid_t;
+
+/**
+  Chaos indicator map.
+
+  The cell (i,j) has coordinates $u_i = u_0 + i(u_1-u_0)/(n_u-1)$,
+  $v_j = v_0 + j(v_1-v_0)/(n_v-1)$ (the first and second coordinates of the
+  grid, e.g. $x$ and $p_x$), and it is stored at index $j n_u + i$ of the
+  raster.
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   double H;		///< energy value
+   chaos_grid_t grid;	///< grid of initial conditions
+   chaos_ind_t ind;	///< chaos indicator
+   double u0, u1;	///< range of the first coordinate
+   int nu;		///< number of cells in the first coordinate
+   double v0, v1;	///< range of the second coordinate
+   int nv;		///< number of cells in the second coordinate
+   double T;		///< integration time
+   /// Early termination: the integration of a cell stops when the indicator
+   /// is larger than stop (0 to integrate always up to time T).
+   double stop;
+} chaosmap_t;
+
+/**
+  Chaos indicator of one orbit.
+
+  Integrate the orbit of x and the tangent vector $w$ up to time T (or
+  until the indicator passes stop), and compute the FLI
+  \f[ FLI(t) = \sup_{s\le t} \log\|w(s)\| \f]
+  or the mean MEGNO
+  \f[ Y(t) = \frac{2}{t} \int_0^t \frac{w\cdot\dot w}{w\cdot w} s\,ds,
+  \quad \langle Y\rangle(t) = \frac{1}{t} \int_0^t Y(s)\,ds. \f]
+  The tangent vector is renormalized when it grows large, so there is no
+  overflow.
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] ind	chaos indicator
+  \param[in] T		integration time (positive)
+  \param[in] stop	early termination threshold, or 0
+  \param[in] x		initial point $(x,y,p_x,p_y)$
+  \param[in] w		initial tangent vector (unit length)
+  \param[out] val	value of the indicator at the final time
+  \param[out] t		final time (smaller than T if stopped early)
+
+  \retval ERR_CHAOS_FLOW	Integration error. On return, val and t hold
+  the last values.
+  */
+int chaos_indicator(double mu, chaos_ind_t ind, double T, double stop,
+      const double x[DIM], const double w[DIM], double *val, double *t);
+
+/**
+  Initial condition of the cell (i,j) of the map, in Cartesian coordinates.
+
+  \returns a non-zero error code if the energy level does not reach the
+  cell, and 0 on success.
+  */
+int chaosmap_ic(const chaosmap_t *m, int i, int j, double x[DIM]);
+
+/**
+  Compute the chaos indicator map.
+
+  The tiles are computed in parallel. The initial tangent vector is
+  $(1,1,1,1)/2$ for all cells.
+
+  \param[in] m		map parameters
+  \param[out] val
+     Raster of $n_u n_v$ values, see \ref chaosmap_t. Cells not reached by
+     the energy level, or whose integration fails (e.g. a collision), are
+     set to NAN.
+  \param[in] progress
+     If set, the number of finished tiles is reported to stderr.
+
+  \returns the number of cells set to NAN.
+  */
+int chaosmap(const chaosmap_t *m, double *val, int progress);
+
+/**
+  Write the map to a binary raster file.
+
+  The file holds, in native byte order, the string "CHAOSMAP" (8 bytes),
+  the ints grid, ind, nu, nv, the doubles mu, H, u0, u1, v0, v1, T, stop,
+  and the $n_u n_v$ doubles of the raster (NAN for empty cells).
+
+  \retval ERR_CHAOS_IO	Error writing the file.
+  */
+int chaosmap_write(const char *fname, const chaosmap_t *m, const double *val);
+
+#endif // CHAOSMAP_H_INCLUDED
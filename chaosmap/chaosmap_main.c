@@ -0,0 +1,91 @@
+/*! \file
+    \brief Chaos Indicator Maps: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, malloc
+#include <gsl/gsl_errno.h>	// gsl_set_error_handler_off
+#include <tolprof.h>		// tolprof_getenv
+#include "chaosmap.h"		// chaosmap_t, chaosmap
+
+/**
+   Chaos Indicator Maps: main prog
+
+   Usage: chaosmap rasterfile
+
+   Compute the FLI or MEGNO map on a grid of initial conditions at fixed
+   energy, and write it to a binary raster file (see \ref chaosmap_write).
+
+   The tolerances are those of the profile in the environment variable
+   RTBP_TOLPROF, if it is defined (e.g. RTBP_TOLPROF=draft for exploratory
+   runs, see \ref tolprof_parse).
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin:
+
+      - mass parameter "mu"
+      - energy value "H"
+      - grid: (x,p_x) on SEC2=0, (g,G) on {l=pi}=1
+      - indicator: FLI=0, MEGNO=1
+      - range and number of cells of the first coordinate: u0 u1 nu
+      - range and number of cells of the second coordinate: v0 v1 nv
+      - integration time "T"
+      - early termination threshold "stop" (0 for none)
+
+   2. Compute the map (the tiles in parallel), reporting the progress to
+   stderr.
+
+   3. Write the raster file.
+ */
+
+int main(int argc, char *argv[])
+{
+   chaosmap_t m;
+   int grid, ind;
+   double *val;
+   int nnan;
+
+   if(argc < 2)
+   {
+      fprintf(stderr, "Usage: %s rasterfile\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %le %d %d %le %le %d %le %le %d %le %le", &m.mu, &m.H,
+	    &grid, &ind, &m.u0, &m.u1, &m.nu, &m.v0, &m.v1, &m.nv, &m.T,
+	    &m.stop) < 12 || m.nu < 1 || m.nv < 1)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+   m.grid = (grid ? CHAOS_GRID_DEL : CHAOS_GRID_CAR);
+   m.ind = (ind ? CHAOS_MEGNO : CHAOS_FLI);
+
+   val = malloc((size_t)m.nu*m.nv*sizeof(double));
+   if(val == NULL)
+   {
+      fprintf(stderr, "main: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   // Stop GSL default error handler from aborting the program
+   gsl_set_error_handler_off();
+   if(tolprof_getenv())
+      exit(EXIT_FAILURE);
+
+   // 2. Compute the map.
+   nnan = chaosmap(&m, val, 1);
+   fprintf(stderr, "main: %d empty cells out of %d\n", nnan, m.nu*m.nv);
+
+   // 3. Write the raster file.
+   if(chaosmap_write(argv[1], &m, val))
+   {
+      free(val);
+      exit(EXIT_FAILURE);
+   }
+   free(val);
+   exit(EXIT_SUCCESS);
+}
@@ -14,6 +14,7 @@
 #include <math.h>   // M_PI
 
 #include <frtbp.h>
+#include <htraj.h>	// htraj_t, htraj_read
 #include <approxint.h>	// stability_t
 #include "ebound_module.h"
 
@@ -44,9 +45,15 @@ $\fJ\in[J_-, J_+]\f$.
   - H
   - E11 bound
   - E2 bound
+
+  Usage: ebound [storefile]
+
+  If a store file written by intersec is given, the homoclinic of each input
+  line is evaluated from the next store of the file (see \ref ebound_htraj)
+  instead of being integrated again.
  */
  
-int main( )
+int main(int argc, char *argv[])
 {
    double mu;
 
@@ -67,6 +74,8 @@ int main( )
    int status;
    stability_t st;
    double t_aux;
+   FILE *fstore = NULL;	/* store file (if given) */
+   htraj_t tr;		/* homoclinic from z_u to z */
 
    // Input parameters from stdin.
    if(scanf("%le %d", &mu, &stability)<2)
@@ -77,6 +86,12 @@ int main( )
 
    st = (stability==0 ? UNSTABLE : STABLE);
 
+   if(argc > 1 && (fstore = fopen(argv[1], "rb")) == NULL)
+   {
+      perror("main: error opening store file");
+      exit(EXIT_FAILURE);
+   }
+
    // Input energy H, period T, zu, time to reach hom. pt. z, from stdin.
    while(scanf("%le %le %le %le %le %le %le", &H, &T, zu, zu+1, zu+2, zu+3, &t) == 7)
    {
@@ -94,8 +109,24 @@ int main( )
        zs_car[2] = -zu_car[2];
        */
 
-       // Compute bounds, integrating along $z(s) = \gamma^*(s)$.
-       ebound(mu, H, zu, t, &E11_bound, &E2_bound);
+       // Compute bounds, integrating along $z(s) = \gamma^*(s)$, or
+       // evaluating it from the store.
+       if(fstore != NULL)
+       {
+           if(htraj_read(fstore, &tr))
+               exit(EXIT_FAILURE);
+           if(!tr.del || fabs(tr.t1-t) > 1.e-10*fabs(t))
+           {
+               fprintf(stderr, "main: store does not match input line\n");
+               exit(EXIT_FAILURE);
+           }
+           status = ebound_htraj(&tr, H, &E11_bound, &E2_bound);
+           htraj_free(&tr);
+           if(status)
+               exit(EXIT_FAILURE);
+       }
+       else
+           ebound(mu, H, zu, t, &E11_bound, &E2_bound);
 
        // Output result to stdout.
        printf("%.15e %.15e %24.16e\n", H, E11_bound, E2_bound);
@@ -22,7 +22,10 @@
 #include <utils_module.h>           // dblcpy
 #include <frtbp.h>
 #include <cardel.h>
-#include <math.h>           // sqrt, pow, cbrt
+#include <htraj.h>	// htraj_eval_del
+#include <math.h>           // sqrt, pow, cbrt, floor
+
+#include "ebound_module.h"
 
 const double SHORT_TIME=0.01;       ///< integration "step" for frtbp
 
@@ -73,3 +76,39 @@ double *E2_bound)
    }
    return 0;
 }
+
+int ebound_htraj(const htraj_t *tr, double J, double *E11_bound,
+double *E2_bound) 
+{
+    double L0 = 1.0/cbrt(3);    ///< resonant value \f$ L_0 \f$
+
+   // auxiliary variables
+   int i, n;
+   double xt_del[DIM];		/* point x(t) in Delaunay*/
+   double dt, L, G, E11, E2;
+
+   dt = (tr->t1>0 ? SHORT_TIME : -SHORT_TIME);
+   n = (int)floor(tr->t1/dt + 1.e-6);
+   
+   *E11_bound = 0.0;
+   *E2_bound = 0.0;
+   for(i=1; i<=n; i++)
+   {
+	   if(htraj_eval_del(tr,i*dt,xt_del))
+	   {
+         fprintf(stderr, "ebound_htraj: evaluation error at sample %d\n", i);
+         return(1);
+	   }
+       L = xt_del[1];
+       G = xt_del[3];
+
+       /* Update bounds E11 and E2*/
+
+       E11 = E(J,L)-E(J,L0);
+       if(fabs(E11) > *E11_bound) *E11_bound=fabs(E11);
+
+       E2 = sqrt(1.0 - G*G / (L*L)) - E(J,L);
+       if(fabs(E2) > *E2_bound) *E2_bound=fabs(E2);
+   }
+   return 0;
+}
@@ -1,4 +1,17 @@
 #include <rtbp.h>   // DIM
+#include <htraj.h>  // htraj_t
 
 int ebound(double mu, double J, double x[DIM], double t, double *E11_bound,
 double *E2_bound);
+
+/**
+  Bounds for \f$ \mathcal{E}_1^1 \f$ and \f$ E_2 \f$ along a stored
+  homoclinic.
+
+  Same as \ref ebound, but the homoclinic is evaluated from a trajectory
+  store with Delaunay elements (such as those written by intersec) instead
+  of being integrated again. As in \ref Lbound_htraj, no sample is taken
+  past tr->t1.
+  */
+int ebound_htraj(const htraj_t *tr, double J, double *E11_bound,
+double *E2_bound);
@@ -5,13 +5,39 @@
     $Date: 2013-03-26 22:17:52 $
 */
 
+#include <stdio.h>	// fprintf
+#include <math.h>	// fabs, log10, sqrt
+#include <float.h>	// DBL_EPSILON
+#include <gsl/gsl_errno.h>	// GSL_SUCCESS
+#include <gsl/gsl_odeiv.h>
 #include <taylor2d.h>	// taylor_step_rtbp2d
 #include <taylor2dv.h>	// taylor_step_rtbp2dv
-#include <rtbp.h>	// DIM
+#include <rtbp.h>	// DIM, DIMLC, rtbp_lc
+#include <tolprof.h>	// tolprof_tol
 #include "frtbp.h"	// DIMV
 
 double mu;	///< global variable, needed in taylor_step_rtbp2d and taylor_step_rtbp2dv
 
+const double LC_RADIUS=1.e-2;
+const double LC_RADIUS_EXIT=2.e-2;
+
+/// Max number of Newton iterations to land exactly on the final time.
+static const int LC_MAXITER=20;
+
+/// Max order of the Taylor polynomial of a step in frtbp_sample.
+#define FRTBP_MAXORD 40
+
+int frtbp_lc(double mu_loc, double *t, double t1, double x[DIM]);
+int rtbp_var(double t, const double *x, double *y, void *params);
+void frtbp_jet(double mu_loc, const double x[DIM], int ord,
+      double c[DIM][FRTBP_MAXORD+1]);
+void frtbp_horner(double c[DIM][FRTBP_MAXORD+1], int ord, double dt,
+      double x[DIM]);
+
+// Distance to Jupiter
+#define LC_DIST(mu_loc,x) \
+   sqrt(((x)[0]-1.0+(mu_loc))*((x)[0]-1.0+(mu_loc))+(x)[1]*(x)[1])
+
 // NOTES
 // =====
 // Notice that the taylor integrator was written using the opposite
@@ -21,10 +47,10 @@ double mu;	///< global variable, needed in taylor_step_rtbp2d and taylor_step_rt
 int dfrtbp(double mu_loc, double t1, double x[DIM], double dphi[DIMV])
 {
    /* (log10) absolute error for local error control */
-   double log10_eps_abs = -16;	
+   double log10_eps_abs = log10(tolprof_tol(TOL_FLOW,1.e-16));
 
    /* (log10) relative error for local error control */
-   double log10_eps_rel = -16;	
+   double log10_eps_rel = log10_eps_abs;
 
    double t = 0.0;
    double h;		/* step size */
@@ -76,11 +102,17 @@ int dfrtbp(double mu_loc, double t1, double x[DIM], double dphi[DIMV])
 // Notice that the taylor integrator was written using the opposite
 // convention. To avoid re-writting the taylor integrator, we simply call
 // taylor with parameter mu=1-mu.
+//
+// Inside the sphere of radius LC_RADIUS around Jupiter, the Taylor method
+// is replaced by the integration of the Levi-Civita regularized equations
+// (see frtbp_lc), until the orbit leaves the sphere of radius
+// LC_RADIUS_EXIT. This is transparent to the caller.
 
 int frtbp(double mu_loc, double t1, double x[DIM])
 {
-   double log10_eps_abs = -16;	/* (log10) absolute error for local error control */
-   double log10_eps_rel = -16;	/* (log10) relative error for local error control */
+   /* (log10) absolute and relative error for local error control */
+   double log10_eps_abs = log10(tolprof_tol(TOL_FLOW,1.e-16));
+   double log10_eps_rel = log10_eps_abs;
 
    double t = 0.0;
    double h;		/* step size */
@@ -98,6 +130,13 @@ int frtbp(double mu_loc, double t1, double x[DIM])
       // Forward integration
       while (t<t1)
       {
+	 // Close approach to Jupiter: switch to Levi-Civita coordinates
+	 if(LC_DIST(mu_loc,x) < LC_RADIUS)
+	 {
+	    if(frtbp_lc(mu_loc,&t,t1,x))
+	       return(1);
+	    continue;
+	 }
 	    status =
         taylor_step_rtbp2d(&t,x,1,1,log10_eps_abs,log10_eps_rel,&t1,&h,&nt,NULL);
 	 // What if there is a singularity in the vectorfield?? This is not
@@ -108,8 +147,446 @@ int frtbp(double mu_loc, double t1, double x[DIM])
    {
       // Backwards integration
       while (t>t1)
+      {
+	 // Close approach to Jupiter: switch to Levi-Civita coordinates
+	 if(LC_DIST(mu_loc,x) < LC_RADIUS)
+	 {
+	    if(frtbp_lc(mu_loc,&t,t1,x))
+	       return(1);
+	    continue;
+	 }
 	    status =
         taylor_step_rtbp2d(&t,x,-1,1,log10_eps_abs,log10_eps_rel,&t1,&h,&nt,NULL);
+      }
+   }
+   return(0);
+}
+
+// NOTES
+// =====
+// Same as frtbp, with the Runge-Kutta Prince-Dormand (8,9) method instead
+// of the Taylor method. Nothing is shared between calls (the Taylor
+// integrator needs the global variable "mu"), so it may be called from
+// several threads at once.
+
+int frtbp_rk(double mu_loc, double t1, double x[DIM])
+{
+   /* absolute and relative error for local error control */
+   double eps_abs = tolprof_tol(TOL_FLOW,1.e-15);
+   double eps_rel = eps_abs;
+
+   double t = 0.0;
+   double dir = (t1 >= 0 ? 1 : -1);
+   double h = dir*1.e-3;	/* step size */
+   int status = GSL_SUCCESS;
+
+   const gsl_odeiv_step_type *T = gsl_odeiv_step_rk8pd;
+   gsl_odeiv_step *s = gsl_odeiv_step_alloc(T,DIM);
+   gsl_odeiv_control *c = gsl_odeiv_control_y_new(eps_abs,eps_rel);
+   gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIM);
+   gsl_odeiv_system sys = {rtbp,NULL,DIM,&mu_loc};
+
+   while (dir*(t1-t) > 0)
+   {
+      // Close approach to Jupiter: switch to Levi-Civita coordinates
+      if(LC_DIST(mu_loc,x) < LC_RADIUS)
+      {
+	 if(frtbp_lc(mu_loc,&t,t1,x))
+	 {
+	    status = 1;
+	    break;
+	 }
+	 gsl_odeiv_evolve_reset(e);
+	 continue;
+      }
+      status = gsl_odeiv_evolve_apply(e,c,s,&sys,&t,t1,&h,x);
+      if (status != GSL_SUCCESS)
+	 break;
+   }
+   gsl_odeiv_evolve_free(e);
+   gsl_odeiv_control_free(c);
+   gsl_odeiv_step_free(s);
+
+   if (status != GSL_SUCCESS)
+   {
+      fprintf(stderr, "frtbp_rk: error integrating trajectory\n");
+      return(1);
+   }
+   return(0);
+}
+
+// NOTES
+// =====
+// Same as dfrtbp, with the Runge-Kutta Prince-Dormand (8,9) method on the
+// variational equations (see rtbp_var) instead of the Taylor method.
+
+int dfrtbp_rk(double mu_loc, double t1, double x[DIM], double dphi[DIMV])
+{
+   /* absolute and relative error for local error control */
+   double eps_abs = tolprof_tol(TOL_FLOW,1.e-15);
+   double eps_rel = eps_abs;
+
+   double t = 0.0;
+   double h = (t1 >= 0 ? 1.e-3 : -1.e-3);	/* step size */
+   double xvar[DIM+DIMV];	/* point + derivative */
+   int status = GSL_SUCCESS;
+   int i;
+
+   const gsl_odeiv_step_type *T = gsl_odeiv_step_rk8pd;
+   gsl_odeiv_step *s = gsl_odeiv_step_alloc(T,DIM+DIMV);
+   gsl_odeiv_control *c = gsl_odeiv_control_y_new(eps_abs,eps_rel);
+   gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIM+DIMV);
+   gsl_odeiv_system sys = {rtbp_var,NULL,DIM+DIMV,&mu_loc};
+
+   // Initial condition, and derivative initialized to the identity.
+   for(i=0; i<DIM; i++)
+      xvar[i] = x[i];
+   for(i=0; i<DIMV; i++)
+      xvar[DIM+i] = (i%(DIM+1) == 0 ? 1 : 0);
+
+   while ((t1 >= 0 ? t < t1 : t > t1))
+   {
+      status = gsl_odeiv_evolve_apply(e,c,s,&sys,&t,t1,&h,xvar);
+      if (status != GSL_SUCCESS)
+	 break;
+   }
+   gsl_odeiv_evolve_free(e);
+   gsl_odeiv_control_free(c);
+   gsl_odeiv_step_free(s);
+
+   if (status != GSL_SUCCESS)
+   {
+      fprintf(stderr, "dfrtbp_rk: error integrating variational equations\n");
+      return(1);
    }
+   for(i=0; i<DIMV; i++)
+      dphi[i] = xvar[DIM+i];
    return(0);
 }
+
+// NOTES
+// =====
+// The samples are the times ts=k*h, k=0,1,..., with |ts|<|t1|, and t1. The
+// Taylor integrator is driven towards t1 as in frtbp. Before each step the
+// initial point is saved, and the samples inside the step are evaluated on
+// its Taylor polynomial, recomputed by frtbp_jet at the order nt of the
+// step (so its error is that of the step). If the order is larger than
+// FRTBP_MAXORD, the samples of the step are integrated with frtbp from the
+// initial point of the step.
+
+int frtbp_sample(double mu_loc, double t1, double x[DIM], double h,
+      frtbp_out_t out, void *par)
+{
+   /* (log10) absolute and relative error for local error control */
+   double log10_eps_abs = log10(tolprof_tol(TOL_FLOW,1.e-16));
+   double log10_eps_rel = log10_eps_abs;
+
+   double c[DIM][FRTBP_MAXORD+1];	/* Taylor coefficients of the step */
+   double xk[DIM], xs[DIM];	/* initial point of the step, sample */
+   double t = 0.0, tk, ts;
+   double hs;		/* step size */
+   int dir = (t1 >= 0 ? 1 : -1);
+   long k = 1;		/* index of the next sample */
+   int status, nt, i;
+
+   if(h == 0 || h*t1 < 0)
+   {
+      fprintf(stderr, "frtbp_sample: invalid time between samples %e\n", h);
+      return(1);
+   }
+
+   // Set global variable "mu". This needs to defined before calling
+   // taylor_step_rtbp2d
+   mu=1.0-mu_loc;
+
+   if(out(0.0,x,par))
+      return(1);
+   ts = (dir*(t1-h) > 0 ? h : t1);
+   while (dir*(t1-t) > 0)
+   {
+      // Close approach to Jupiter: regularized integration up to the next
+      // sample.
+      if(LC_DIST(mu_loc,x) < LC_RADIUS)
+      {
+	 if(frtbp_lc(mu_loc,&t,ts,x))
+	    return(1);
+      }
+      else
+      {
+	 for(i=0; i<DIM; i++)
+	    xk[i] = x[i];
+	 tk = t;
+	 status =
+	    taylor_step_rtbp2d(&t,x,dir,1,log10_eps_abs,log10_eps_rel,&t1,&hs,
+		  &nt,NULL);
+	 if(dir*(t-ts) > 0 && nt <= FRTBP_MAXORD)
+	    frtbp_jet(mu_loc,xk,nt,c);
+
+	 // Samples inside the step
+	 while(dir*(t-ts) > 0)
+	 {
+	    if(nt <= FRTBP_MAXORD)
+	       frtbp_horner(c,nt,ts-tk,xs);
+	    else
+	    {
+	       for(i=0; i<DIM; i++)
+		  xs[i] = xk[i];
+	       if(frtbp(mu_loc,ts-tk,xs))
+		  return(1);
+	    }
+	    if(out(ts,xs,par))
+	       return(1);
+	    k++;
+	    ts = (dir*(t1-k*h) > 0 ? k*h : t1);
+	 }
+      }
+      // The step ends exactly on a sample
+      if(t == ts)
+      {
+	 if(out(ts,x,par))
+	    return(1);
+	 k++;
+	 ts = (dir*(t1-k*h) > 0 ? k*h : t1);
+      }
+   }
+   return(0);
+}
+
+// name OF FUNCTION: frtbp_lc
+//
+// PURPOSE
+// =======
+// Integrate the RTBP in Levi-Civita coordinates centered at Jupiter (see
+// rtbp_lc), from the point x at time *t, until time t1 or until the orbit
+// leaves the sphere of radius LC_RADIUS_EXIT around Jupiter, whatever
+// happens first. On return, x and *t hold the final point and time.
+//
+// The regularized equations are integrated in the fictitious time $s$ with
+// the Runge-Kutta Prince-Dormand (8,9) method. Since $dt/ds = r > 0$, the
+// direction of integration is the same in $s$ and $t$. When the time t1 is
+// passed, the last step is redone with Newton's method on its length, so
+// that the final time is exactly t1.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an integration error (or that
+// Newton's method for the last step did not converge in LC_MAXITER
+// iterations) and 0 to indicate success.
+
+int frtbp_lc(double mu_loc, double *t, double t1, double x[DIM])
+{
+   /* absolute and relative error for local error control */
+   double eps_abs = tolprof_tol(TOL_FLOW,1.e-15);
+   double eps_rel = eps_abs;
+
+   double par[2] = {mu_loc, Hamilt(mu_loc,x)};	/* mu, H */
+   double dir = (t1 >= *t ? 1 : -1);
+   double y[DIMLC], y_pre[DIMLC], yerr[DIMLC];
+   double s = 0.0, s_pre;
+   double h = dir*1.e-6;	/* step size (in s) */
+   double ds, corr;
+   int status = GSL_SUCCESS;
+   int i, iter;
+
+   const gsl_odeiv_step_type *T = gsl_odeiv_step_rk8pd;
+   gsl_odeiv_step *st = gsl_odeiv_step_alloc(T,DIMLC);
+   gsl_odeiv_control *c = gsl_odeiv_control_y_new(eps_abs,eps_rel);
+   gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIMLC);
+   gsl_odeiv_system sys = {rtbp_lc,NULL,DIMLC,par};
+
+   car2lc(mu_loc,x,y);
+   y[4] = *t;
+   while(1)
+   {
+      for(i=0; i<DIMLC; i++)
+	 y_pre[i] = y[i];
+      s_pre = s;
+
+      status = gsl_odeiv_evolve_apply(e,c,st,&sys,&s,dir*1.e10,&h,y);
+      if (status != GSL_SUCCESS)
+	 break;
+
+      if(dir*(y[4]-t1) >= 0)
+      {
+	 // Time t1 was passed during the last step. Redo it, with length ds
+	 // such that t(s_pre+ds) = t1.
+	 ds = (t1-y_pre[4])/(y_pre[0]*y_pre[0]+y_pre[1]*y_pre[1]);
+	 for(iter=0; iter<LC_MAXITER; iter++)
+	 {
+	    for(i=0; i<DIMLC; i++)
+	       y[i] = y_pre[i];
+	    gsl_odeiv_step_reset(st);
+	    status = gsl_odeiv_step_apply(st,s_pre,ds,y,yerr,NULL,NULL,&sys);
+	    if (status != GSL_SUCCESS)
+	       break;
+	    corr = (t1-y[4])/(y[0]*y[0]+y[1]*y[1]);
+	    ds += corr;
+	    if(fabs(corr) <= 4*DBL_EPSILON*fabs(ds))
+	       break;
+	 }
+	 if(status == GSL_SUCCESS && iter == LC_MAXITER)
+	 {
+	    fprintf(stderr, "frtbp_lc: final step to t1 did not converge\n");
+	    status = GSL_EMAXITER;
+	 }
+	 else
+	    y[4] = t1;
+	 break;
+      }
+      // The orbit leaves the neighbourhood of Jupiter
+      if(y[0]*y[0]+y[1]*y[1] > LC_RADIUS_EXIT)
+	 break;
+   }
+   gsl_odeiv_evolve_free(e);
+   gsl_odeiv_control_free(c);
+   gsl_odeiv_step_free(st);
+
+   if (status != GSL_SUCCESS)
+   {
+      fprintf(stderr, "frtbp_lc: error integrating trajectory\n");
+      return(1);
+   }
+   lc2car(mu_loc,y,x);
+   *t = y[4];
+   return(0);
+}
+
+// name OF FUNCTION: frtbp_jet
+//
+// PURPOSE
+// =======
+// Taylor coefficients c[i][k], k=0,...,ord, of the solution of the RTBP
+// (see rtbp) through the point x at t=0, computed with the automatic
+// differentiation recurrences of the vectorfield. With $A=x-\mu_2$,
+// $B=x+\mu_1$, the series $s_1=A^2+y^2$, $s_2=B^2+y^2$ are powered to
+// $q=s^{-3/2}$ with the recurrence
+// $q_k = \frac{1}{k s_0} \sum_{j=1}^k (-\frac{3}{2} j - (k-j)) s_j q_{k-j}$,
+// and the coefficient k+1 of the solution is the coefficient k of the
+// vectorfield divided by k+1.
+
+void frtbp_jet(double mu_loc, const double x[DIM], int ord,
+      double c[DIM][FRTBP_MAXORD+1])
+{
+   const double mu1 = mu_loc;
+   const double mu2 = 1.0-mu_loc;
+   double a[FRTBP_MAXORD+1], b[FRTBP_MAXORD+1];	/* x-mu2, x+mu1 */
+   double s1[FRTBP_MAXORD+1], s2[FRTBP_MAXORD+1];	/* r1^2, r2^2 */
+   double q1[FRTBP_MAXORD+1], q2[FRTBP_MAXORD+1];	/* r1^-3, r2^-3 */
+   double yy, aq, bq, qy;
+   int i, j, k;
+
+   for(i=0; i<DIM; i++)
+      c[i][0] = x[i];
+   for(k=0; k<ord; k++)
+   {
+      a[k] = b[k] = c[0][k];
+      if(k == 0)
+      {
+	 a[0] -= mu2;
+	 b[0] += mu1;
+      }
+      s1[k] = s2[k] = 0;
+      for(j=0; j<=k; j++)
+      {
+	 yy = c[1][j]*c[1][k-j];
+	 s1[k] += a[j]*a[k-j] + yy;
+	 s2[k] += b[j]*b[k-j] + yy;
+      }
+      if(k == 0)
+      {
+	 q1[0] = 1/(s1[0]*sqrt(s1[0]));
+	 q2[0] = 1/(s2[0]*sqrt(s2[0]));
+      }
+      else
+      {
+	 q1[k] = q2[k] = 0;
+	 for(j=1; j<=k; j++)
+	 {
+	    q1[k] += (-1.5*j-(k-j))*s1[j]*q1[k-j];
+	    q2[k] += (-1.5*j-(k-j))*s2[j]*q2[k-j];
+	 }
+	 q1[k] /= k*s1[0];
+	 q2[k] /= k*s2[0];
+      }
+      aq = bq = qy = 0;
+      for(j=0; j<=k; j++)
+      {
+	 aq += a[j]*q1[k-j];
+	 bq += b[j]*q2[k-j];
+	 qy += (mu1*q1[j]+mu2*q2[j])*c[1][k-j];
+      }
+      c[0][k+1] = (c[2][k]+c[1][k])/(k+1);
+      c[1][k+1] = (-c[0][k]+c[3][k])/(k+1);
+      c[2][k+1] = (c[3][k]-mu1*aq-mu2*bq)/(k+1);
+      c[3][k+1] = (-c[2][k]-qy)/(k+1);
+   }
+}
+
+// name OF FUNCTION: frtbp_horner
+//
+// PURPOSE
+// =======
+// Evaluate the Taylor polynomial of order ord with coefficients c (see
+// frtbp_jet) at time dt, with Horner's rule.
+
+void frtbp_horner(double c[DIM][FRTBP_MAXORD+1], int ord, double dt,
+      double x[DIM])
+{
+   int i, k;
+
+   for(i=0; i<DIM; i++)
+   {
+      x[i] = c[i][ord];
+      for(k=ord-1; k>=0; k--)
+	 x[i] = x[i]*dt + c[i][k];
+   }
+}
+
+// name OF FUNCTION: rtbp_var
+//
+// PURPOSE
+// =======
+// Vector field of the RTBP together with its variational equations, in the
+// GSL convention (params=&mu). The point is x[0..DIM-1], and the derivative
+// of the flow (by rows) is x[DIM..DIM+DIMV-1]; its vector field is A*Dphi,
+// with A the Jacobian of the vector field of rtbp at the point.
+//
+// RETURN VALUE
+// ============
+// Returns ERR_COLLISION if the point is too close to a primary, and
+// GSL_SUCCESS otherwise.
+
+int rtbp_var(double t, const double *x, double *y, void *params)
+{
+   double mu_loc = *(double *)params;
+   double dx1 = x[0]-1.0+mu_loc;	// relative to Jupiter (mass mu)
+   double dx2 = x[0]+mu_loc;		// relative to the Sun (mass 1-mu)
+   double r12 = dx1*dx1+x[1]*x[1];
+   double r22 = dx2*dx2+x[1]*x[1];
+   double r13 = r12*sqrt(r12), r15 = r13*r12;
+   double r23 = r22*sqrt(r22), r25 = r23*r22;
+   double vxx, vxy, vyy;	// second derivatives of the potential
+   double a[DIM][DIM];
+   int i, j, l;
+
+   if(rtbp(t,x,y,params))
+      return ERR_COLLISION;
+
+   vxx = mu_loc*(1/r13-3*dx1*dx1/r15) + (1-mu_loc)*(1/r23-3*dx2*dx2/r25);
+   vxy = -3*x[1]*(mu_loc*dx1/r15 + (1-mu_loc)*dx2/r25);
+   vyy = mu_loc*(1/r13-3*x[1]*x[1]/r15) + (1-mu_loc)*(1/r23-3*x[1]*x[1]/r25);
+
+   a[0][0] = 0;    a[0][1] = 1;    a[0][2] = 1;  a[0][3] = 0;
+   a[1][0] = -1;   a[1][1] = 0;    a[1][2] = 0;  a[1][3] = 1;
+   a[2][0] = -vxx; a[2][1] = -vxy; a[2][2] = 0;  a[2][3] = 1;
+   a[3][0] = -vxy; a[3][1] = -vyy; a[3][2] = -1; a[3][3] = 0;
+
+   for(i=0; i<DIM; i++)
+      for(j=0; j<DIM; j++)
+      {
+	 y[DIM+DIM*i+j] = 0;
+	 for(l=0; l<DIM; l++)
+	    y[DIM+DIM*i+j] += a[i][l]*x[DIM+DIM*l+j];
+      }
+   return GSL_SUCCESS;
+}
@@ -117,6 +117,13 @@ int dfrtbp(double mu_loc, double t1, double x[DIM], double dphi[DIMV]);
  
   \remark
   A Taylor method (provided by Angel Jorba) is used to solve the ODE.
+
+  \remark
+  Close approaches to Jupiter (closer than LC_RADIUS) are integrated in
+  Levi-Civita regularized coordinates (see \ref rtbp_lc), and the orbit is
+  brought back to Cartesian coordinates once it is farther than
+  LC_RADIUS_EXIT. The cost per unit of time is then bounded near
+  collisions with Jupiter.
  
   \remark
   We follow the convention to place the large mass (Sun) to the LEFT of the
@@ -125,3 +132,87 @@ int dfrtbp(double mu_loc, double t1, double x[DIM], double dphi[DIMV]);
  */
 
 int frtbp(double mu, double t1, double x[DIM]);
+
+/**
+  Flow of the Restricted Three Body Problem, reentrant version.
+
+  Same as \ref frtbp, but the trajectory is integrated with the Runge-Kutta
+  Prince-Dormand (8,9) method (local error 1e-15) instead of the Taylor
+  method. It keeps no global state, so it can be used from several threads
+  at once (e.g. in \ref portrait).
+
+  \param[in] mu	mass parameter for the RTBP
+  \param[in] t1	integration time (positive or negative)
+  \param[in,out] x	initial condition; on return, the final point
+  
+  \return
+  a non-zero error code to indicate an error and 0 to indicate success.
+ */
+
+int frtbp_rk(double mu, double t1, double x[DIM]);
+
+/**
+  Derivative of the flow of the RTBP, reentrant version.
+
+  Same as \ref dfrtbp, but the variational equations are integrated with
+  the Runge-Kutta Prince-Dormand (8,9) method, as in \ref frtbp_rk. It keeps
+  no global state, so it can be used from several threads at once.
+
+  \param[in] mu	mass parameter for the RTBP
+  \param[in] t1	integration time (positive or negative)
+  \param[in] x	argument of the derivative (not modified)
+  \param[out] dphi	derivative \f$D\phi(t,x)\f$, by rows (as \ref dfrtbp)
+
+  \return
+  a non-zero error code to indicate an error and 0 to indicate success.
+
+  \remark
+  The close approaches to Jupiter are not regularized.
+ */
+
+int dfrtbp_rk(double mu, double t1, double x[DIM], double dphi[DIMV]);
+
+/// Radius of the sphere around Jupiter where the regularized equations are
+/// used.
+extern const double LC_RADIUS;
+
+/// Radius where the integration goes back to Cartesian coordinates.
+extern const double LC_RADIUS_EXIT;
+
+/**
+  Output function of \ref frtbp_sample: receives the time t (from the
+  initial point) and the point x of each sample, and the parameters par
+  given to \ref frtbp_sample. A non-zero return value stops the sampling.
+  */
+typedef int (*frtbp_out_t)(double t, const double x[DIM], void *par);
+
+/**
+  Sample a trajectory of the RTBP at equally spaced times.
+
+  Same integration as \ref frtbp, but the points $\phi(t,x)$ are passed to
+  out at the times $t=0,h,2h,\dots$ with $|t|<|t_1|$, and at the final time
+  $t_1$. The Taylor integrator takes its natural steps towards $t_1$, and the
+  samples that fall inside a step are evaluated on the Taylor polynomial of
+  the step, so the cost of the integration does not depend on $h$.
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] t1		integration time (positive or negative)
+  \param[in,out] x	initial condition; on return, the final point
+  \param[in] h		time between samples (with the sign of t1)
+  \param[in] out	output function
+  \param[in] par	parameters of the output function
+
+  \return
+  a non-zero error code to indicate an integration error or that out
+  stopped the sampling, and 0 to indicate success.
+
+  \remark
+  The Taylor coefficients of the step are recomputed at its initial point
+  with the automatic differentiation recurrences of the RTBP, up to the
+  order used by the integrator. Inside the sphere of radius LC_RADIUS
+  around Jupiter (see \ref frtbp), the regularized integration is stopped
+  at each sample time.
+ */
+
+int frtbp_sample(double mu, double t1, double x[DIM], double h,
+      frtbp_out_t out, void *par);
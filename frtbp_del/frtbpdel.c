@@ -6,13 +6,17 @@
 */
 
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
+#include <stdio.h>	// fprintf
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_odeiv.h>
+#include <tolprof.h>	// tolprof_tol
 #include "rtbpdel.h"	// rtbp_del
+#include "frtbpdel.h"	// frtbp_del_out_t
 
 int frtbp_del(double mu, double t1, double x[DIM])
 {
-   double eps_abs = 1.e-16;     /* absolute error for local error control */
+   /* absolute error for local error control */
+   double eps_abs = tolprof_tol(TOL_FLOW,1.e-16);
    double eps_rel = 0.0;        /* relative error for local error control */
 
    double t = 0.0;
@@ -65,3 +69,89 @@ int frtbp_del(double mu, double t1, double x[DIM])
    }
    return(0);
 }
+
+// NOTES
+// =====
+// The samples are the times ts=k*h, k=0,1,..., with |ts|<|t1|, and t1. The
+// rk8pd method has no dense output: the samples inside a step are obtained
+// by applying the step formula from the initial point of the step, with a
+// second stepper so that the state of the integration is not disturbed.
+
+int frtbp_del_sample(double mu, double t1, double x[DIM], double h,
+      frtbp_del_out_t out, void *par)
+{
+   /* absolute error for local error control */
+   double eps_abs = tolprof_tol(TOL_FLOW,1.e-16);
+   double eps_rel = 0.0;        /* relative error for local error control */
+
+   double t = 0.0, tk, ts;
+   double dir = (t1 >= 0 ? 1 : -1);
+   double hs = dir*1.e-6;	/* step size */
+   double xk[DIM], xs[DIM], xerr[DIM];	/* initial point of the step, sample */
+   long k = 1;		/* index of the next sample */
+   int status = GSL_SUCCESS;
+   int i;
+
+   if(h == 0 || h*t1 < 0)
+   {
+      fprintf(stderr, "frtbp_del_sample: invalid time between samples %e\n",
+	    h);
+      return(1);
+   }
+
+   const gsl_odeiv_step_type *T = gsl_odeiv_step_rk8pd;
+   gsl_odeiv_step *s = gsl_odeiv_step_alloc(T,DIM);
+   gsl_odeiv_step *sd = gsl_odeiv_step_alloc(T,DIM);	/* samples */
+   gsl_odeiv_control *c = gsl_odeiv_control_y_new(eps_abs,eps_rel);
+   gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIM);
+   gsl_odeiv_system sys = {rtbp_del,NULL,DIM,&mu};
+
+   if(out(0.0,x,par))
+      status = 1;
+   ts = (dir*(t1-h) > 0 ? h : t1);
+   while (status == GSL_SUCCESS && dir*(t1-t) > 0)
+   {
+      for(i=0; i<DIM; i++)
+	 xk[i] = x[i];
+      tk = t;
+      status = gsl_odeiv_evolve_apply(e,c,s,&sys,&t,t1,&hs,x);
+      if (status != GSL_SUCCESS)
+      {
+	 fprintf(stderr, "frtbp_del_sample: error integrating trajectory\n");
+	 break;
+      }
+
+      // Samples inside the step
+      while(dir*(t-ts) > 0)
+      {
+	 for(i=0; i<DIM; i++)
+	    xs[i] = xk[i];
+	 status = gsl_odeiv_step_apply(sd,tk,ts-tk,xs,xerr,NULL,NULL,&sys);
+	 if (status != GSL_SUCCESS)
+	 {
+	    fprintf(stderr, "frtbp_del_sample: error integrating trajectory\n");
+	    break;
+	 }
+	 if(out(ts,xs,par))
+	 {
+	    status = 1;
+	    break;
+	 }
+	 k++;
+	 ts = (dir*(t1-k*h) > 0 ? k*h : t1);
+      }
+      // The step ends exactly on a sample
+      if(status == GSL_SUCCESS && t == ts)
+      {
+	 if(out(ts,x,par))
+	    status = 1;
+	 k++;
+	 ts = (dir*(t1-k*h) > 0 ? k*h : t1);
+      }
+   }
+   gsl_odeiv_evolve_free(e);
+   gsl_odeiv_control_free(c);
+   gsl_odeiv_step_free(sd);
+   gsl_odeiv_step_free(s);
+   return(status != GSL_SUCCESS);
+}
@@ -41,3 +41,35 @@
  */
 
 int frtbp_del(double mu, double t1, double x[DIM]);
+
+/**
+  Output function of \ref frtbp_del_sample: receives the time t (from the
+  initial point), the point x of each sample, and the parameters par given
+  to \ref frtbp_del_sample. A non-zero return value stops the sampling.
+  */
+typedef int (*frtbp_del_out_t)(double t, const double x[DIM], void *par);
+
+/**
+  Sample a trajectory of the RTBP in Delaunay coords at equally spaced times.
+
+  Same integration as \ref frtbp_del, but the points $\phi(t,x)$ are passed
+  to out at the times $t=0,h,2h,\dots$ with $|t|<|t_1|$, and at the final
+  time $t_1$. The integrator takes its natural steps towards $t_1$, so the
+  step sizes are not limited by $h$. The samples that fall inside a step are
+  evaluated by applying the Runge-Kutta formula of the step from its initial
+  point (one extra step evaluation per sample, without error control).
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] t1		integration time (positive or negative)
+  \param[in,out] x	initial condition; on return, the final point
+  \param[in] h		time between samples (with the sign of t1)
+  \param[in] out	output function
+  \param[in] par	parameters of the output function
+
+  \return
+  a non-zero error code to indicate an integration error or that out
+  stopped the sampling, and 0 to indicate success.
+ */
+
+int frtbp_del_sample(double mu, double t1, double x[DIM], double h,
+      frtbp_del_out_t out, void *par);
@@ -8,6 +8,7 @@
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_odeiv.h>
+#include <tolprof.h>	// tolprof_tol
 #include "rtbpred.h"	// DIMRED, rtbp_red
 
 double EPS_ABS=1.e-16;     /* absolute error for local error control */
@@ -24,9 +25,10 @@ int frtbp_red_l(double mu, double s1, double x[DIMRED])
    gsl_odeiv_step *s = gsl_odeiv_step_alloc(T,DIMRED);
 
    // Control to determine optimal step size: keep the local error on each
-   // step within an absolute error of EPS_ABS and relative error of EPS_REL
-   // with respect to the solution.
-   gsl_odeiv_control *c = gsl_odeiv_control_y_new(EPS_ABS,EPS_REL);
+   // step within an absolute error of EPS_ABS (relaxed by the tolerance
+   // profile) and relative error of EPS_REL with respect to the solution.
+   gsl_odeiv_control *c =
+      gsl_odeiv_control_y_new(tolprof_tol(TOL_FLOW,EPS_ABS),EPS_REL);
    gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIMRED);
 
    // define system of equations (NULL = we don't provide the jacobian)
@@ -78,9 +80,10 @@ int frtbp_red_g(double mu, double s1, double x[DIMRED])
    gsl_odeiv_step *s = gsl_odeiv_step_alloc(T,DIMRED);
 
    // Control to determine optimal step size: keep the local error on each
-   // step within an absolute error of EPS_ABS and relative error of EPS_REL
-   // with respect to the solution.
-   gsl_odeiv_control *c = gsl_odeiv_control_y_new(EPS_ABS,EPS_REL);
+   // step within an absolute error of EPS_ABS (relaxed by the tolerance
+   // profile) and relative error of EPS_REL with respect to the solution.
+   gsl_odeiv_control *c =
+      gsl_odeiv_control_y_new(tolprof_tol(TOL_FLOW,EPS_ABS),EPS_REL);
    gsl_odeiv_evolve *e = gsl_odeiv_evolve_alloc(DIMRED);
 
    // define system of equations (NULL = we don't provide the jacobian)
@@ -19,6 +19,9 @@
 //    Invert Hamiltonian equation
 //       H(x,y,px,py)=H0,
 //    solving for the unknown py.
+//
+// hinv_batch
+//    Same as hinv, for n points in structure-of-arrays layout.
 
 #include <stdio.h>	// fprintf
 #include <math.h>	// sqrt, fabs
@@ -112,3 +115,68 @@ int hinv(double mu, section_t sec, double H,double p[DIM])
    p[3]=vy+x;
    return 0;
 }
+
+// name OF FUNCTION: hinv_batch
+// CREDIT: 
+//
+// PURPOSE
+// =======
+// Batch version of hinv: solve H(x_i,y_i,px_i,py_i)=H0 for py_i,
+// i=0,...,n-1.
+//
+// The loop has no branches, so that compilers can vectorize it. Points
+// with negative discriminant get py_i=NAN, and are reported through the
+// return value.
+//
+// PARAMETERS
+// ==========
+// mu
+//    mass parameter for the RTBP
+// sec
+//    type of Poincare section (sec = SEC1 or SEC2).
+// H
+//    energy value
+// n
+//    number of points
+// x, y, px
+//    known coordinates of the points
+// py
+//    On return, py[i] holds the value of p_y such that
+//    H(x[i],y[i],px[i],py[i])=H.
+// 
+// RETURN VALUE
+// ============
+// Returns 0 if all points were lifted, or ERR_CPLX_ROOTS if some
+// discriminant was negative.
+
+int hinv_batch(double mu, section_t sec, double H, int n,
+      const double *restrict x, const double *restrict y,
+      const double *restrict px, double *restrict py)
+{
+   // larger mass on the left of origin, smaller mass on the right
+   double mu1 = mu;	
+   double mu2 = 1.0-mu;
+   double sgn = (sec==SEC1 ? 1.0 : -1.0);	// sign of vy
+
+   // auxiliary variables
+   int i, nbad=0;
+   double r1, r2, vx, disc;
+
+   for(i=0; i<n; i++)
+   {
+      r1 = sqrt((x[i]-mu2)*(x[i]-mu2)+y[i]*y[i]);
+      r2 = sqrt((x[i]+mu1)*(x[i]+mu1)+y[i]*y[i]);
+      vx = px[i]+y[i];
+      disc = -vx*vx+(x[i]*x[i]+y[i]*y[i])+2*(mu1/r1+mu2/r2)+2*H;
+      nbad += (disc<0);
+
+      // sqrt of a negative discriminant gives NAN
+      py[i] = sgn*sqrt(disc)+x[i];
+   }
+   if(nbad)
+   {
+      fprintf(stderr, "hinv_batch: no real roots for %d points\n", nbad);
+      return(ERR_CPLX_ROOTS);
+   }
+   return 0;
+}
@@ -3,3 +3,6 @@
 
 extern const int ERR_CPLX_ROOTS;
 int hinv(double mu, section_t sec, double H,double p[DIM]);
+int hinv_batch(double mu, section_t sec, double H, int n,
+      const double *restrict x, const double *restrict y,
+      const double *restrict px, double *restrict py);
@@ -3,6 +3,7 @@
   */
 
 #include <stdio.h>
+#include <stdlib.h>     // malloc, free
 #include <rtbp.h>       // DIM
 #include <section.h>
 #include "hinv.h"
@@ -14,21 +15,42 @@ int lift(double mu, section_t sec, double H, int n, const double *l,
     int i, status;
     const double *p; 
     double *p4;
+    double *buf, *x, *y, *px, *py;
+
+    if(n<=0)
+        return(0);
+
+    // Points are lifted in one batch, in structure-of-arrays layout.
+    buf = malloc(4*n*sizeof(double));
+    if(buf==NULL)
+    {
+        fprintf(stderr, "lift: out of memory\n");
+        return(1);
+    }
+    x=buf; y=buf+n; px=buf+2*n; py=buf+3*n;
 
     for(i=0; i<n; i++)
     {
         p=l+2*i;
+        x[i]=p[0];  // x
+        y[i]=0;     // y
+        px[i]=p[1]; // p_x
+    }
+    status=hinv_batch(mu,sec,H,n,x,y,px,py);
+    if(status)
+    {
+        fprintf(stderr, "lift: error lifting point\n");
+        free(buf);
+        return(1);
+    }
+    for(i=0; i<n; i++)
+    {
         p4=l4+DIM*i;
-
-        p4[0]=p[0]; // x
-        p4[1]=0;    // y
-        p4[2]=p[1]; // p_x
-        status=hinv(mu,sec,H,p4);
-       if(status)
-       {
-          fprintf(stderr, "lift: error lifting point\n");
-          return(1);
-       }
+        p4[0]=x[i];
+        p4[1]=y[i];
+        p4[2]=px[i];
+        p4[3]=py[i];
     }
+    free(buf);
     return(0);
 }
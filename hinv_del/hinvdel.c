@@ -15,101 +15,34 @@
 // FUNCTIONS
 // =========
 //
-// hinv
+// hinv_del
 //    Invert Hamiltonian equation
 //       H(l,L,g,G)=H0,
 //    solving for the unknown L.
+//
+// hinv_del_batch
+//    Same as hinv_del, for n points in structure-of-arrays layout.
 
 #include <stdio.h>	// fprintf
-#include <math.h>	// pow
+#include <math.h>	// sqrt, sin, cos, fmod, fabs
 #include <rtbp.h>	// DIM
-#include <rtbpdel.h>	// Hamilt_del, rtbp_del
-#include <gsl/gsl_errno.h>
-#include <gsl/gsl_roots.h>	// root-finding routines
+#include <gsl/gsl_errno.h>	// GSL_SUCCESS, GSL_EMAXITER, GSL_EDOM
+#include "hinvdel.h"
 
 const double EPSABS_NEWTON = 1e-14;
 const int MAXITER_NEWTON = 100;
 
-struct DeltaH_params
-{
-   double mu, H0, l, g, G;
-};
+/// Tolerance and max iterations for Kepler's equation.
+const double EPSABS_KEPLER = 1e-15;
+const int MAXITER_KEPLER = 50;
 
-// name OF FUNCTION: DeltaH, DeltaH_deriv, DeltaH_fdf
-//
-// PURPOSE
-// =======
-// Given a point $(l,L,g,G)$ and an energy value $H_0$, compute the
-// difference function
-// \[ H(l,L,g,G) - H_0 \]
-// and the derivative of this function with respect to $L$.
-//
-// NOTES
-// =====
-// This function is used in the root-finding algorithm in hinv_del below.
-//
-// PARAMETERS
-// ==========
-// L
-//    L coordinate
-// params
-//    other parameters: mu, H0, l,g,G
-// 
-// RETURN VALUE
-// ============
-// Returns the difference $H(l,L,g,G) - H_0$.
-//
-// CALLS TO: Hamilt_del, rtbp_del
-//
-// CALLED FROM: hinv_del
-
-
-double DeltaH(double L, void *params)
-{
-   struct DeltaH_params *p = (struct DeltaH_params *)params;
-   double mu = p->mu;
-   double H0 = p->H0;
+/// Min relative distance of the first guess of L to |G|, so that the
+/// eccentricity is real (nearly circular orbits).
+static const double MARGIN_KEPLER = 1e-6;
 
-   double l = p->l;
-   double g = p->g;
-   double G = p->G;
-
-   double x[DIM] = {l,L,g,G};
-   return Hamilt_del(mu,x) - H0;
-}
-
-double DeltaH_deriv(double L, void *params)
-{
-   struct DeltaH_params *p = (struct DeltaH_params *)params;
-   double mu = p->mu;
-   double H0 = p->H0;
-
-   double l = p->l;
-   double g = p->g;
-   double G = p->G;
-
-   double x[DIM] = {l,L,g,G};
-
-   double y[DIM]; 	// vector field evaluated at x
-   int status;
-
-   // Note: for the moment, we do not code a separate function dot_l to
-   // compute $\partial H / \partial L$. Instead, we call rtbp_del to compute
-   // the whole vector field, and return the first component.
-   status = rtbp_del(0,x,y,&mu);
-   if(status != GSL_SUCCESS)
-   {
-      fprintf(stderr, "DeltaH_deriv: error computing vector field");
-      exit(EXIT_FAILURE);
-   }
-   return y[0];
-}
-
-void DeltaH_fdf(double L, void *params, double *y, double *dy)
-{
-   *y = DeltaH(L,params);
-   *dy = DeltaH_deriv(L,params);
-}
+double kepler(double e, double l);
+int energy_dL(double mu, double l, double L, double g, double G, double *H,
+      double *dH);
 
 // name OF FUNCTION: hinv_del
 // CREDIT: 
@@ -128,8 +61,17 @@ void DeltaH_fdf(double L, void *params, double *y, double *dy)
 // =====
 // Since the Hamiltonian equation is not solvable analytically for L (unlike
 // Cartesian coordinates), we solve it using a Newton method. 
-// For the 3:1 resonance, L is close to 3^{-1/3} so we use this value as a
-// first guess for the Newton method.
+// The first guess is the solution of the two body problem,
+// $-1/(2L^2)-G=H_0$, kept above $|G|(1+$MARGIN_KEPLER$)$. If it does not
+// exist, or Newton's method fails from it, we use the resonant value
+// $L=3^{-1/3}$ of the 3:1 resonance, as in the original implementation.
+// A Newton step that would leave the domain $L>|G|$ (nearly circular
+// orbits) is replaced by halving the distance to $|G|$.
+//
+// The function and its derivative $\partial H/\partial L$ are evaluated
+// together in closed form (see energy_dL), with a single solution of
+// Kepler's equation by Newton's method. Nothing is allocated, so the cost
+// is a few microseconds per point.
 //
 // PARAMETERS
 // ==========
@@ -145,52 +87,178 @@ void DeltaH_fdf(double L, void *params, double *y, double *dy)
 // 
 // RETURN VALUE
 // ============
-// Returns GSL_SUCCESS) to indicate success, and a non-zero error code
-// otherwise.
-// If an integration error is encountered, the function returns a non-zero
-// value, and p is unmodified.
+// Returns GSL_SUCCESS to indicate success, and a non-zero error code
+// otherwise, and p is unmodified:
+//
+// GSL_EMAXITER
+//    Newton's method did not converge.
+// GSL_EDOM
+//    Newton's method left the domain $L>|G|$.
 
 int hinv_del(double mu, double H,double p[DIM])
 {
-    int status;
-    int iter = 0;
-    const gsl_root_fdfsolver_type *T;
-    gsl_root_fdfsolver *s;
-    double L = pow(3.0, -1.0/3.0);
-    gsl_function_fdf FDF;
-    struct DeltaH_params params = {mu,H,p[0],p[2],p[3]};	// mu,H,l,g,G
+    return hinv_del_batch(mu, H, 1, p, p+1, p+2, p+3);
+}
 
+int hinv_del_batch(double mu, double H, int n, const double *l, double *L,
+      const double *g, const double *G)
+{
     // auxiliary variables
-    double residual;
-  
-    FDF.f = &DeltaH;
-    FDF.df = &DeltaH_deriv;
-    FDF.fdf = &DeltaH_fdf;
-    FDF.params = &params;
-  
-    T = gsl_root_fdfsolver_newton;
-    s = gsl_root_fdfsolver_alloc (T);
-    gsl_root_fdfsolver_set (s, &FDF, L);
-  
-    //printf ("%-5s %10s %10s\n", "iter", "root", "err(est)");
-    do
-      {
-	iter++;
-	status = gsl_root_fdfsolver_iterate (s);
-	L = gsl_root_fdfsolver_root (s);
-	residual = DeltaH(L,&params);
-	status = gsl_root_test_residual(residual, EPSABS_NEWTON);
-  
-	//if (status == GSL_SUCCESS)
-	//  printf ("Converged:\n");
-  
-	//printf ("%5d %10.7f %10.7f\n", iter, L, residual);
-      }
-    while (status == GSL_CONTINUE && iter < MAXITER_NEWTON);
-  
-    if(status == GSL_SUCCESS) 
-       p[1] = L;
-
-    gsl_root_fdfsolver_free (s);
-    return status;
+    int i, k, iter, status, ret = GSL_SUCCESS;
+    double Li, residual, dH;
+    double L0[2];	// first guesses: Kepler start, resonant value
+
+    L0[1] = pow(3.0, -1.0/3.0);
+    for(i=0; i<n; i++)
+    {
+	// Kepler start
+	L0[0] = (H+G[i] < 0 ? 1.0/sqrt(-2.0*(H+G[i])) : L0[1]);
+	if(L0[0] < fabs(G[i])*(1.0+MARGIN_KEPLER))
+	   L0[0] = fabs(G[i])*(1.0+MARGIN_KEPLER);
+
+	status = GSL_EMAXITER;
+	for(k=0; k<2 && status!=GSL_SUCCESS; k++)
+	{
+	   if(k == 1 && L0[0] == L0[1])
+	      break;
+	   Li = L0[k];
+	   status = GSL_EMAXITER;
+	   for(iter=0; iter<MAXITER_NEWTON; iter++)
+	   {
+	      if(energy_dL(mu, l[i], Li, g[i], G[i], &residual, &dH))
+	      {
+		 status = GSL_EDOM;
+		 break;
+	      }
+	      residual -= H;
+	      if(fabs(residual) < EPSABS_NEWTON)
+	      {
+		 status = GSL_SUCCESS;
+		 break;
+	      }
+	      // Newton step, halving the distance to |G| instead if it would
+	      // leave the domain (H behaves as $\sqrt{L-|G|}$ near circular
+	      // orbits).
+	      if(Li - residual/dH > fabs(G[i]))
+		 Li -= residual/dH;
+	      else
+		 Li = (Li + fabs(G[i]))/2;
+	   }
+	}
+
+	if(status == GSL_SUCCESS)
+	   L[i] = Li;
+	else
+	{
+	   if(ret == GSL_SUCCESS)
+	      ret = status;
+	   if(n>1)
+	      L[i] = NAN;
+	}
+    }
+    return ret;
+}
+
+// name OF FUNCTION: kepler
+//
+// PURPOSE
+// =======
+// Solve Kepler's equation $u-e\sin(u)=l$ for the eccentric anomaly $u$,
+// with Newton's method started at $u_0=l+0.85e$ sign$(\sin l)$ (Danby).
+// The angle $l$ is first normalized between $[-\pi,\pi)$.
+//
+// RETURN VALUE
+// ============
+// Returns the eccentric anomaly $u\in[-\pi,\pi]$.
+
+double kepler(double e, double l)
+{
+   double u, du;
+   int iter;
+
+   l = fmod(l, 2*M_PI);
+   if(l >= M_PI)
+      l -= 2*M_PI;
+   else if(l < -M_PI)
+      l += 2*M_PI;
+
+   u = l + (sin(l) >= 0 ? 0.85 : -0.85)*e;
+   for(iter=0; iter<MAXITER_KEPLER; iter++)
+   {
+      du = (u - e*sin(u) - l)/(1.0 - e*cos(u));
+      u -= du;
+      if(fabs(du) < EPSABS_KEPLER)
+	 break;
+   }
+   return u;
+}
+
+// name OF FUNCTION: energy_dL
+//
+// PURPOSE
+// =======
+// Evaluate the Hamiltonian $H(l,L,g,G)$ of the RTBP in rotating Delaunay
+// coordinates, and its derivative $\partial H/\partial L = \dot l$.
+// The formulas are the same as in Hamilt_del and rtbp_del, but the true
+// anomaly is obtained from $\cos v=(\cos u-e)/(1-e\cos u)$,
+// $\sin v=\sqrt{1-e^2}\sin u/(1-e\cos u)$.
+//
+// RETURN VALUE
+// ============
+// Returns GSL_SUCCESS, or GSL_EDOM if $L\le|G|$ (complex eccentricity).
+
+int energy_dL(double mu, double l, double L, double g, double G, double *H,
+      double *dH)
+{
+   double umu = 1.0-mu;
+   double Lsq = L*L;
+   double Gsq = G*G;
+   double esq, e, u, su, cu, den, sv, cv, r, cvg, svg, r1, r2, N1, N2;
+   double dN_r_mu, dN_v_mu, dN_r_umu, dN_v_umu, dr_L, dv_L;
+
+   if(!(Gsq < Lsq))
+      return(GSL_EDOM);
+
+   // eccentricity
+   esq = 1.0 - Gsq/Lsq;
+   e = sqrt(esq);
+
+   // eccentric and true anomalies
+   u = kepler(e, l);
+   su = sin(u);
+   cu = cos(u);
+   den = 1.0 - e*cu;
+   cv = (cu - e)/den;
+   sv = sqrt(1.0-esq)*su/den;
+
+   // modulus of asteroid r
+   r = Lsq*den;
+
+   // cos(v+g), sin(v+g)
+   cvg = cv*cos(g) - sv*sin(g);
+   svg = sv*cos(g) + cv*sin(g);
+
+   // N evaluated at -r/mu and r/(1-mu)
+   r1 = -r/mu;
+   r2 = r/umu;
+   N1 = 1.0/sqrt(r1*r1 + 1.0 - 2.0*r1*cvg);
+   N2 = 1.0/sqrt(r2*r2 + 1.0 - 2.0*r2*cvg);
+
+   *H = -1.0/(2*Lsq) - G - umu/mu*N1 - mu/umu*N2 + 1.0/r;
+
+   // partial derivatives of N
+   dN_r_mu = (cvg-r1)*N1*N1*N1;
+   dN_v_mu = -r1*svg*N1*N1*N1;
+   dN_r_umu = (cvg-r2)*N2*N2*N2;
+   dN_v_umu = -r2*svg*N2*N2*N2;
+
+   // partial derivatives of r, v wrt L
+   dr_L = 1.0/L*(2.0*r-Gsq*cv/e);
+   dv_L = sv/(1.0-esq)*(2.0+e*cv)*Gsq/(e*Lsq*L);
+
+   *dH = 1.0/(Lsq*L)
+      + (umu/(mu*mu)*dN_r_mu - mu/(umu*umu)*dN_r_umu)*dr_L
+      + (-umu/mu*dN_v_mu - mu/umu*dN_v_umu)*dv_L
+      - dr_L/(r*r);
+   return(GSL_SUCCESS);
 }
@@ -1,2 +1,18 @@
 #include <rtbp.h>	// DIM
 int hinv_del(double mu, double H,double p[DIM]);
+
+/**
+  Batch version of \ref hinv_del: solve $H(l_i,L_i,g_i,G_i)=H$ for $L_i$,
+  i=0,...,n-1, with the points in structure-of-arrays layout.
+
+  \param[in] mu	mass parameter for the RTBP
+  \param[in] H		energy value
+  \param[in] n		number of points
+  \param[in] l,g,G	known coordinates of the points
+  \param[out] L	solutions $L_i$ (NAN for the points that failed)
+
+  \returns GSL_SUCCESS if all points converged, or the error code of the
+  first point that failed.
+  */
+int hinv_del_batch(double mu, double H, int n, const double *l, double *L,
+      const double *g, const double *G);
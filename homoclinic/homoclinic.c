@@ -0,0 +1,508 @@
+/*! \file
+    \brief Homoclinic Pipeline: from Periodic Orbit to Splitting Angle
+
+    The homoclinic computation used to be a chain of programs (portbp,
+    hyper, approxint, intersec, splitting) communicating through text files.
+    Here the stages are chained in memory: each stage consumes the results of
+    the previous one from a \ref homoclinic_t structure.
+*/
+
+#include <stdio.h>	// fprintf
+#include <math.h>	// sqrt, hypot
+
+#include <rtbp.h>	// DIM, rtbp, rtbp_inv
+#include <frtbp.h>	// DIMV, dfrtbp, frtbp
+#include <section.h>	// SEC2, branch_t
+#include <hinv.h>	// hinv
+#include <prtbp_nl.h>	// prtbp_nl, prtbp_nl_inv
+#include <dprtbp_2d.h>	// set_dprtbp_2d
+#include <portbp.h>	// portbp
+#include <hyper.h>	// hyper
+#include <errmfld.h>	// h_opt
+#include <approxint.h>	// approxint_unst, approxint_st, approxint_track
+#include <intersec.h>	// intersec_h_unst, intersec_h_st
+#include <splitting.h>	// splitting_angle_unst, splitting_angle_st
+#include <pocache.h>	// pocache_porbit, pocache_h_opt
+#include <htraj.h>	// htraj_build
+#include <segjet.h>	// segjet_build, segjet_root
+#include <utils_module.h>	// dblcpy
+
+#include "homoclinic.h"
+
+const int ERR_HC_PORBIT=1;
+const int ERR_HC_HYPER=2;
+const int ERR_HC_APPROXINT=3;
+const int ERR_HC_INTERSEC=4;
+const int ERR_HC_ORBIT=5;
+const int ERR_HC_SYM=6;
+const int ERR_HC_CACHE=7;
+
+const double HC_SYM_TOL=1.e-10;
+
+/// Upper bound on the linear displacement along the manifold, used as the
+/// starting value of \ref h_opt (same as in approxint).
+const double HC_HMAX=1.e-2;
+
+int orbit_tanvec(homoclinic_t *hc);
+int homoclinic_sym(homoclinic_t *hc, double p[2]);
+void reversor(const double *x, double *y);
+
+void homoclinic_init(homoclinic_t *hc, double mu, double H, int k,
+      stability_t stable, branch_t branch, double a)
+{
+   hc->mu = mu;
+   hc->H = H;
+   hc->k = k;
+   hc->stable = stable;
+   hc->branch = branch;
+   hc->a = a;
+   hc->sym = 1;
+   hc->jet = 0;
+   hc->cache = NULL;
+   hc->track = NULL;
+
+   hc->n = 0;
+   hc->zapprox[0] = 0;
+   hc->zapprox[1] = 0;
+}
+
+int homoclinic_porbit(homoclinic_t *hc, double p[2])
+{
+   if(hc->cache != NULL)
+   {
+      // The cache also holds the hyperbolic splitting of stage 2.
+      hc->porbit.p[0] = p[0];
+      hc->porbit.p[1] = p[1];
+      if(pocache_porbit(hc->cache, hc->mu, SEC2, hc->H, hc->k, &(hc->porbit)))
+      {
+	 fprintf(stderr, "homoclinic: error computing periodic orbit\n");
+	 return(ERR_HC_PORBIT);
+      }
+      hc->p[0] = hc->porbit.p[0];
+      hc->p[1] = hc->porbit.p[1];
+      return(0);
+   }
+
+   hc->p[0] = p[0];
+   hc->p[1] = p[1];
+   if(portbp(hc->mu, SEC2, hc->H, hc->k, hc->p))
+   {
+      fprintf(stderr, "homoclinic: error computing periodic orbit\n");
+      return(ERR_HC_PORBIT);
+   }
+   return(0);
+}
+
+int homoclinic_hyper(homoclinic_t *hc)
+{
+   int i;	// index of the chosen eigenvalue
+
+   if(hc->cache != NULL)
+   {
+      dblcpy(hc->eval, hc->porbit.eval, 2);
+      dblcpy(hc->evec, hc->porbit.evec, 4);
+   }
+   else if(hyper(hc->mu, SEC2, hc->H, hc->k, hc->p, hc->eval, hc->evec))
+   {
+      fprintf(stderr, "homoclinic: error computing hyperbolic splitting\n");
+      return(ERR_HC_HYPER);
+   }
+
+   i = (hc->stable==UNSTABLE ? 0 : 1);
+   hc->lambda = hc->eval[i];
+   hc->v[0] = hc->evec[2*i];
+   hc->v[1] = hc->evec[2*i+1];
+   return(0);
+}
+
+int homoclinic_segment(homoclinic_t *hc)
+{
+   double h;
+   double rho;	// expansion factor along the fundamental segment
+
+   // By default we work with the RIGHT branch of the manifolds.
+   // To work with the LEFT branch of the manifolds instead,
+   // we just take the negative of the displacement h in the linear
+   // approximation.
+   h = (hc->branch==LEFT ? -HC_HMAX : HC_HMAX);
+   if(hc->cache != NULL)
+   {
+      if(pocache_h_opt(hc->cache, &(hc->porbit), hc->stable, hc->branch, h,
+	       &(hc->h)))
+      {
+	 fprintf(stderr, "homoclinic: error writing cache file\n");
+	 return(ERR_HC_CACHE);
+      }
+   }
+   else
+      hc->h = h_opt(hc->mu, SEC2, hc->H, hc->k, hc->p, hc->v, hc->lambda,
+	    hc->stable, h);
+
+   rho = (hc->stable==UNSTABLE ? hc->lambda : 1.0/hc->lambda);
+   hc->seg[0] = hc->p[0] + hc->h*hc->v[0];
+   hc->seg[1] = hc->p[1] + hc->h*hc->v[1];
+   hc->seg[2] = hc->p[0] + rho*hc->h*hc->v[0];
+   hc->seg[3] = hc->p[1] + rho*hc->h*hc->v[1];
+   return(0);
+}
+
+int homoclinic_approxint(homoclinic_t *hc)
+{
+   int status;
+
+   if(hc->track != NULL)
+      status = approxint_track(hc->track, hc->stable, hc->mu, hc->H, hc->k,
+	    hc->p, hc->v, hc->lambda, hc->h, hc->a, &(hc->n), &(hc->h1),
+	    &(hc->h2), hc->zapprox);
+   else if(hc->stable==UNSTABLE)
+      status = approxint_unst(hc->mu, hc->H, hc->k, hc->p, hc->v, hc->lambda,
+	    hc->h, hc->a, &(hc->n), &(hc->h1), &(hc->h2), hc->zapprox);
+   else
+      status = approxint_st(hc->mu, hc->H, hc->k, hc->p, hc->v, hc->lambda,
+	    hc->h, hc->a, &(hc->n), &(hc->h1), &(hc->h2), hc->zapprox);
+   if(status)
+   {
+      fprintf(stderr,
+	    "homoclinic: couldn't find approx. intersection point\n");
+      return(ERR_HC_APPROXINT);
+   }
+   return(0);
+}
+
+int homoclinic_intersec(homoclinic_t *hc)
+{
+   segjet_t sj;
+   int status = 1;
+
+   // Newton's method on the jet transport of the segment
+   if(hc->jet)
+   {
+      if(segjet_build(&sj, hc->mu, hc->H, hc->p, hc->v, hc->n*hc->k,
+	       hc->stable==UNSTABLE, hc->h1, hc->h2, SEGJET_TOL) == 0)
+	 status = segjet_root(&sj, hc->a, &(hc->hroot));
+      if(status)
+	 fprintf(stderr, "homoclinic: jet failed, using Brent's method\n");
+   }
+
+   // Brent's method on the distance function
+   if(status && hc->stable==UNSTABLE)
+      status = intersec_h_unst(hc->mu, hc->H, hc->p, hc->v, hc->n, hc->k,
+	    hc->h1, hc->h2, hc->a, &(hc->hroot));
+   else if(status)
+      status = intersec_h_st(hc->mu, hc->H, hc->p, hc->v, hc->n, hc->k,
+	    hc->h1, hc->h2, hc->a, &(hc->hroot));
+   if(status)
+   {
+      fprintf(stderr, "homoclinic: error computing intersection point\n");
+      return(ERR_HC_INTERSEC);
+   }
+
+   if(orbit_tanvec(hc))
+      return(ERR_HC_ORBIT);
+   return(0);
+}
+
+int homoclinic_splitting(homoclinic_t *hc)
+{
+   if(hc->stable==UNSTABLE)
+      hc->angle = splitting_angle_unst(hc->w);
+   else
+      hc->angle = splitting_angle_st(hc->w);
+   return(0);
+}
+
+int homoclinic(homoclinic_t *hc, double p[2])
+{
+   int status;
+
+   if(hc->stable==STABLE && hc->sym)
+   {
+      status = homoclinic_sym(hc,p);
+      if(status != ERR_HC_SYM)
+	 return(status ? status : homoclinic_splitting(hc));
+      fprintf(stderr,
+	    "homoclinic: computing the stable manifold directly\n");
+   }
+
+   if((status=homoclinic_porbit(hc,p)))
+      return(status);
+   if((status=homoclinic_hyper(hc)))
+      return(status);
+   if((status=homoclinic_segment(hc)))
+      return(status);
+   if((status=homoclinic_approxint(hc)))
+      return(status);
+   if((status=homoclinic_intersec(hc)))
+      return(status);
+   return(homoclinic_splitting(hc));
+}
+
+int homoclinic_reverse(const homoclinic_t *hu, homoclinic_t *hs)
+{
+   double x[DIM];	// R(q), lifted to the section
+   double t;
+   int i;
+
+   // Reversibility check: R(q) is a fixed point of P^k.
+   x[0] = hu->p[0];	// x
+   x[1] = 0;		// y
+   x[2] = -hu->p[1];	// px
+   if(hinv(hu->mu,SEC2,hu->H,x) || prtbp_nl(hu->mu,SEC2,hu->k,x,&t))
+   {
+      fprintf(stderr, "homoclinic: error checking reversibility\n");
+      return(ERR_HC_ORBIT);
+   }
+   if(hypot(x[0]-hu->p[0], x[2]+hu->p[1]) > HC_SYM_TOL)
+   {
+      fprintf(stderr, "homoclinic: reversibility check failed, "
+	    "|P^k(R(p))-R(p)| = %e\n", hypot(x[0]-hu->p[0], x[2]+hu->p[1]));
+      return(ERR_HC_SYM);
+   }
+
+   hs->mu = hu->mu;
+   hs->H = hu->H;
+   hs->k = hu->k;
+   hs->stable = STABLE;
+   hs->branch = hu->branch;
+   hs->a = -hu->a;
+   hs->sym = 1;
+   hs->jet = hu->jet;
+
+   // R maps the unstable eigenvector of q to the stable one of R(q) (and
+   // keeps its first component, so it still points "to the right").
+   hs->p[0] = hu->p[0];
+   hs->p[1] = -hu->p[1];
+   hs->eval[0] = hu->eval[0];
+   hs->eval[1] = hu->eval[1];
+   hs->evec[0] = hu->evec[2];
+   hs->evec[1] = -hu->evec[3];
+   hs->evec[2] = hu->evec[0];
+   hs->evec[3] = -hu->evec[1];
+   hs->lambda = hu->eval[1];
+   hs->v[0] = hu->v[0];
+   hs->v[1] = -hu->v[1];
+
+   hs->h = hu->h;
+   for(i=0; i<4; i+=2)
+   {
+      hs->seg[i] = hu->seg[i];
+      hs->seg[i+1] = -hu->seg[i+1];
+   }
+   hs->n = hu->n;
+   hs->h1 = hu->h1;
+   hs->h2 = hu->h2;
+   hs->zapprox[0] = hu->zapprox[0];
+   hs->zapprox[1] = -hu->zapprox[1];
+
+   // P^{-i}(p_s) = R(P^i(p_u))
+   hs->hroot = hu->hroot;
+   for(i=0; i<=hu->n; i++)
+      reversor(hu->orbit+DIM*i, hs->orbit+DIM*i);
+   hs->t = -hu->t;
+   reversor(hu->z, hs->z);
+   hs->w[0] = hu->w[0];
+   hs->w[1] = -hu->w[1];
+   return(0);
+}
+
+int homoclinic_pair(homoclinic_t *hu, homoclinic_t *hs, double p[2])
+{
+   double q[2];	// R(p)
+   int status;
+
+   if((status=homoclinic(hu,p)))
+      return(status);
+   status = homoclinic_reverse(hu,hs);
+   if(status == 0)
+      return(homoclinic_splitting(hs));
+   if(status != ERR_HC_SYM)
+      return(status);
+
+   fprintf(stderr, "homoclinic: computing the stable manifold directly\n");
+   homoclinic_init(hs, hu->mu, hu->H, hu->k, STABLE, hu->branch, -hu->a);
+   hs->cache = hu->cache;
+   hs->sym = 0;
+   hs->jet = hu->jet;
+   q[0] = hu->p[0];
+   q[1] = -hu->p[1];
+   return(homoclinic(hs,q));
+}
+
+int homoclinic_htraj(const homoclinic_t *hc, htraj_t *tr)
+{
+   if(htraj_build(tr, hc->mu, frtbp, DIM, 1, hc->orbit, hc->t, HTRAJ_SEGLEN))
+   {
+      fprintf(stderr, "homoclinic: error storing homoclinic orbit\n");
+      return(ERR_HC_ORBIT);
+   }
+   return(0);
+}
+
+// name OF FUNCTION: orbit_tanvec
+//
+// PURPOSE
+// =======
+// Integrate the homoclinic orbit $x_i = P^i(p_u)$, i=0,...,n, of the
+// homoclinic preimage $p_u=p+h^* v$ (resp. $P^{-i}$ for the stable
+// manifold), and transport the tangent vector $v$ along it.
+//
+// For each iterate, the Poincare map gives the point $x_{i+1}$ and the
+// return time $t_i$, and the variational equations are integrated for the
+// same time to obtain $DP(x_i)$.
+// This replaces the four integrations per iterate that were needed when
+// intersec and splitting (tanvec_u/tanvec_s) were run one after the other.
+//
+// PARAMETERS
+// ==========
+// hc
+//    Pipeline state. On entry, the fields p, v, h, n, k and hroot must be
+//    set. On exit, the fields orbit, t, z and w are set.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+//
+// NOTES
+// =====
+// Since the tangent vector is expanded a lot due to multiplication by the
+// Jacobian, we normalize it to norm 1: ||w||=1
+
+int orbit_tanvec(homoclinic_t *hc)
+{
+   double mu = hc->mu;
+   double *x, *y;	// consecutive points in the homoclinic orbit
+   double x0[DIM];	// aux copy of x
+   double dp[DIMV];	// 4D variationals
+   double dp2d[4];	// Jacobian of 2d Poincare map
+   double f[DIM];	// vectorfield at x
+   double g[DIM];	// vectorfield at y
+   double v[2];		// tangent vector to the manifold
+   double norm;		// norm of the tangent vector
+
+   // auxiliary variables
+   int i, status;
+   double ti;
+
+   // homoclinic preimage $p_u$
+   x = hc->orbit;
+   x[0] = hc->p[0] + hc->hroot*hc->v[0];	// x
+   x[1] = 0;					// y
+   x[2] = hc->p[1] + hc->hroot*hc->v[1];	// px
+   if(hinv(mu,SEC2,hc->H,x))
+   {
+      fprintf(stderr, "homoclinic: error lifting point\n");
+      return(1);
+   }
+
+   // At $p_u$, the linear approximation is good enough, so we take the
+   // eigenvector (pointing along the branch) as tangent vector.
+   v[0] = (hc->h < 0 ? -hc->v[0] : hc->v[0]);
+   v[1] = (hc->h < 0 ? -hc->v[1] : hc->v[1]);
+
+   hc->t = 0;
+   for(i=0; i<hc->n; i++)
+   {
+      x = hc->orbit + DIM*i;
+      y = x + DIM;
+
+      // y = P(x), and return time ti
+      dblcpy(y, x, DIM);
+      if(hc->stable==UNSTABLE)
+	 status = prtbp_nl(mu,SEC2,hc->k,y,&ti);
+      else
+	 status = prtbp_nl_inv(mu,SEC2,hc->k,y,&ti);
+      if(status)
+      {
+	 fprintf(stderr, "homoclinic: error computing Poincare map\n");
+	 return(1);
+      }
+      hc->t += ti;
+
+      // Variationals along the same piece of orbit (ti<0 for the stable
+      // manifold).
+      dblcpy(x0, x, DIM);
+      if(dfrtbp(mu,ti,x0,dp))
+      {
+	 fprintf(stderr,
+	       "homoclinic: error integrating variational equations\n");
+	 return(1);
+      }
+      if(hc->stable==UNSTABLE)
+	 status = (rtbp(0.0,x,f,&mu) || rtbp(0.0,y,g,&mu));
+      else
+	 status = (rtbp_inv(0.0,x,f,&mu) || rtbp_inv(0.0,y,g,&mu));
+      if(status)
+      {
+	 fprintf(stderr, "homoclinic: error computing vectorfield\n");
+	 return(1);
+      }
+      if(set_dprtbp_2d(dp,f,g,dp2d))
+      {
+	 fprintf(stderr, "homoclinic: error computing 2D derivative\n");
+	 return(1);
+      }
+
+      // w = DP*v, normalized
+      hc->w[0]=dp2d[0]*v[0]+dp2d[1]*v[1];
+      hc->w[1]=dp2d[2]*v[0]+dp2d[3]*v[1];
+      norm=sqrt(hc->w[0]*hc->w[0]+hc->w[1]*hc->w[1]);
+      v[0]=hc->w[0]/norm;
+      v[1]=hc->w[1]/norm;
+   }
+   hc->w[0] = v[0];
+   hc->w[1] = v[1];
+
+   // homoclinic point $z = P^{\pm n}(p_u)$
+   dblcpy(hc->z, hc->orbit+DIM*hc->n, DIM);
+   return(0);
+}
+
+// name OF FUNCTION: homoclinic_sym
+//
+// PURPOSE
+// =======
+// Stages 1 to 5 of the pipeline for the stable manifold of p and the line
+// p_x=a, obtained by reversibility: run them for the unstable manifold of
+// R(p) and the line p_x=-a, and map the results back with
+// homoclinic_reverse.
+//
+// RETURN VALUE
+// ============
+// Returns ERR_HC_SYM if the reversibility check failed, the error code of
+// the stage that failed, or 0 on success.
+
+int homoclinic_sym(homoclinic_t *hc, double p[2])
+{
+   homoclinic_t hu;	// pipeline for the unstable manifold of R(p)
+   double q[2];		// R(p)
+   int status;
+
+   homoclinic_init(&hu, hc->mu, hc->H, hc->k, UNSTABLE, hc->branch, -hc->a);
+   hu.cache = hc->cache;
+   hu.track = hc->track;
+   hu.jet = hc->jet;
+   q[0] = p[0];
+   q[1] = -p[1];
+   if((status=homoclinic_porbit(&hu,q)) || (status=homoclinic_hyper(&hu))
+	 || (status=homoclinic_segment(&hu))
+	 || (status=homoclinic_approxint(&hu))
+	 || (status=homoclinic_intersec(&hu)))
+      return(status);
+   return(homoclinic_reverse(&hu, hc));
+}
+
+// name OF FUNCTION: reversor
+//
+// PURPOSE
+// =======
+// Apply the reversor $R(x,y,p_x,p_y)=(x,-y,-p_x,p_y)$ of the RTBP to the
+// point x. On return, y holds R(x) (y may be equal to x).
+
+void reversor(const double *x, double *y)
+{
+   y[0] = x[0];
+   y[1] = -x[1];
+   y[2] = -x[2];
+   y[3] = x[3];
+}
@@ -0,0 +1,271 @@
+/*! \file
+    \brief Homoclinic Pipeline: from Periodic Orbit to Splitting Angle
+
+    The Poincare map $P$ on SEC2 is reversible with respect to the symmetry
+    line $p_x=0$: with $R(x,p_x)=(x,-p_x)$ (and $R(x,y,p_x,p_y)=
+    (x,-y,-p_x,p_y)$ in the phase space), $R\circ P\circ R = P^{-1}$. Thus,
+    if $p$ is a fixed point of $P^k$, so is $R(p)$, and
+    $W^s(R(p)) = R(W^u(p))$. By default, the stable manifold objects are
+    obtained this way from the unstable ones (see \ref homoclinic_reverse),
+    after checking at runtime that the symmetry holds.
+
+    The work is only saved when both manifolds are needed (\ref
+    homoclinic_pair, option -b of the main prog). The stand-alone programs
+    (invmfld with stable=1, approxint, intersec, splitting) still integrate
+    the stable manifold backwards.
+*/
+
+#ifndef HOMOCLINIC_H_INCLUDED
+#define HOMOCLINIC_H_INCLUDED
+
+#include <rtbp.h>	// DIM
+#include <section.h>	// branch_t
+#include <approxint.h>	// stability_t, approxint_track_t
+#include <pocache.h>	// pocache_t, pocache_rec
+#include <htraj.h>	// htraj_t
+
+/// Max number of iterates of the Poincare map along the homoclinic orbit.
+/// It matches the max number of iterations in \ref approxint_unst.
+#define HC_MAXITER 100
+
+/** Error computing the periodic orbit (fixed point). */
+extern const int ERR_HC_PORBIT;
+
+/** Error computing the hyperbolic splitting of the fixed point. */
+extern const int ERR_HC_HYPER;
+
+/** Error computing the approximate intersection of the manifolds. */
+extern const int ERR_HC_APPROXINT;
+
+/** Error refining the homoclinic point. */
+extern const int ERR_HC_INTERSEC;
+
+/** Error integrating the homoclinic orbit. */
+extern const int ERR_HC_ORBIT;
+
+/** The reversibility check failed. */
+extern const int ERR_HC_SYM;
+
+/** Error writing the cache of periodic orbits. */
+extern const int ERR_HC_CACHE;
+
+/// Tolerance of the reversibility check: $R(p)$ must be a fixed point of
+/// $P^k$ up to this distance.
+extern const double HC_SYM_TOL;
+
+/**
+  State of the homoclinic pipeline for a given (mu, H, branch).
+
+  Each stage of the pipeline fills in some fields, which are then consumed
+  directly by the next stage.
+  */
+typedef struct
+{
+   // Input parameters
+   double mu;		///< mass parameter
+   double H;		///< energy value
+   int k;		///< number of cuts with SEC2 per iterate
+   stability_t stable;	///< unstable/stable manifold
+   branch_t branch;	///< left/right branch of the manifold
+   double a;		///< axis line $p_x=a$
+
+   /// Compute the stable manifold by reversibility (set by default). If
+   /// the reversibility check fails, it is computed directly.
+   int sym;
+
+   /// Find the homoclinic point on the jet transport of the segment (see
+   /// \ref segjet_build) instead of Brent's method (not set by default).
+   int jet;
+
+   /// Cache of periodic orbits (NULL if not used). If set, stages 1 to 3
+   /// are looked up in the cache before being computed.
+   pocache_t *cache;
+   pocache_rec porbit;	///< cached record for (mu, H, SEC2, k, p)
+
+   /// Tracker of the energy sweep (NULL if not used). If set, stage 4 is
+   /// warm started from the previous energy levels (see \ref
+   /// approxint_track).
+   approxint_track_t *track;
+
+   // Stage 1: periodic orbit (portbp)
+   double p[2];		///< fixed point $p=(x,p_x)$ of $P^k$
+
+   // Stage 2: hyperbolic splitting (hyper)
+   double eval[2];	///< unstable, stable eigenvalues
+   double evec[4];	///< unstable, stable eigenvectors
+   double lambda;	///< eigenvalue of the chosen manifold
+   double v[2];		///< eigenvector of the chosen manifold
+
+   // Stage 3: fundamental segment (h_opt)
+   double h;		///< optimal linear displacement (signed by branch)
+   double seg[4];	///< endpoints $p+hv$ and $p+\lambda^{\pm 1} hv$
+
+   // Stage 4: bracketing iterates (approxint)
+   int n;		///< num. of iterates to reach the homoclinic point
+   double h1, h2;	///< displacements bracketing the root
+   double zapprox[2];	///< approximate homoclinic point
+
+   // Stage 5: homoclinic orbit (intersec)
+   double hroot;	///< displacement of the homoclinic preimage
+   double orbit[DIM*(HC_MAXITER+1)];	///< $P^{\pm i}(p_u)$, i=0,...,n
+   double t;		///< integration time from $p_u$ to $z$
+   double z[DIM];	///< homoclinic point $z=P^{\pm n}(p_u)$
+   double w[2];		///< tangent vector to the manifold at $z$
+
+   // Stage 6: splitting angle (splitting)
+   double angle;	///< splitting angle at $z$
+} homoclinic_t;
+
+/**
+  Initialize the pipeline state for a given (mu, H, branch).
+
+  \param[out] hc	pipeline state
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] H		energy value
+  \param[in] k		number of cuts with the section SEC2 per iterate
+  \param[in] stable	work on the unstable or stable manifold
+  \param[in] branch	work on the left or right branch of the manifold
+  \param[in] a		line $p_x=a$ parallel to the $x$ axis
+
+  \remark The cache of periodic orbits is not used; set hc->cache to use
+  it. Neither is the tracker of the energy sweep; set hc->track to use it.
+
+  \remark The stable manifold is computed by reversibility (hc->sym=1).
+
+  \remark The jet transport of stage 5 is not used; set hc->jet to use it.
+  */
+void homoclinic_init(homoclinic_t *hc, double mu, double H, int k,
+      stability_t stable, branch_t branch, double a);
+
+/**
+  Stage 1: refine the fixed point of $P^k$ with \ref portbp.
+
+  \param[in,out] hc	pipeline state
+  \param[in] p		approximate fixed point $p=(x,p_x)$
+
+  \retval ERR_HC_PORBIT	Error computing the periodic orbit.
+  */
+int homoclinic_porbit(homoclinic_t *hc, double p[2]);
+
+/**
+  Stage 2: hyperbolic splitting of the fixed point, with \ref hyper.
+
+  \retval ERR_HC_HYPER	Error computing eigenvalues/vectors.
+  */
+int homoclinic_hyper(homoclinic_t *hc);
+
+/**
+  Stage 3: fundamental segment, with the optimal displacement of \ref h_opt.
+
+  The segment is the linear approximation to the manifold between $p+hv$
+  and $p+\lambda hv$ (resp. $p+\lambda^{-1} hv$ for the stable manifold).
+  For the LEFT branch, the displacement $h$ is negative.
+
+  \retval ERR_HC_CACHE	Error writing the cache file.
+  */
+int homoclinic_segment(homoclinic_t *hc);
+
+/**
+  Stage 4: interval $(h_1,h_2)$ bracketing the homoclinic point, with \ref
+  approxint_unst or \ref approxint_st. If hc->track is set, the bracket
+  is predicted from the previous energy levels with \ref approxint_track,
+  and the full search is only done if the prediction fails.
+
+  \retval ERR_HC_APPROXINT	No approximate intersection found.
+  */
+int homoclinic_approxint(homoclinic_t *hc);
+
+/**
+  Stage 5: homoclinic point and orbit.
+
+  The root $h^*$ is found with \ref intersec_h_unst (or \ref intersec_h_st).
+  If hc->jet is set, the segment $[h_1,h_2]$ is integrated once as a
+  polynomial in $h$ (\ref segjet_build), and $h^*$ is found by Newton's
+  method on it, checked on the map (\ref segjet_root); if this fails,
+  Brent's method is used.
+  Then the orbit $P^i(p_u)$, $i=0,\dots,n$, of the homoclinic preimage
+  $p_u=p+h^* v$ is integrated only once, together with the variational
+  equations, so that we obtain in the same pass the homoclinic point $z$ and
+  the tangent vector $w$ to the manifold at $z$.
+
+  \retval ERR_HC_INTERSEC	Bisection procedure did not converge.
+  \retval ERR_HC_ORBIT		Error integrating the homoclinic orbit.
+  */
+int homoclinic_intersec(homoclinic_t *hc);
+
+/**
+  Stage 6: splitting angle at $z$, from the tangent vector of stage 5.
+  */
+int homoclinic_splitting(homoclinic_t *hc);
+
+/**
+  Run all stages of the pipeline, from the approximate fixed point $p$ to
+  the splitting angle.
+
+  For the stable manifold with hc->sym set, stages 1 to 5 are run for the
+  unstable manifold of $R(p)$ and the line $p_x=-a$, and the results are
+  mapped back with \ref homoclinic_reverse, so only forward integrations
+  are done.
+
+  \returns 0 on success, or the error code of the first stage that failed.
+  */
+int homoclinic(homoclinic_t *hc, double p[2]);
+
+/**
+  Stable manifold objects from unstable ones, by reversibility.
+
+  Given the state hu of the pipeline for the unstable manifold of $q$ and
+  the line $p_x=a$ (after stage 5), set the state hs for the stable manifold
+  of $p=R(q)$ and the line $p_x=-a$, without integrating the manifold:
+  fixed point, eigenvalues and eigenvectors, fundamental segment, bracket,
+  homoclinic orbit $P^{-i}(p_s)=R(P^i(p_u))$, integration time (with
+  opposite sign), homoclinic point $z_s=R(z_u)$ and tangent vector
+  $w_s=R(w_u)$. All the fields of hs are set, except the cache fields, the
+  tracker and the splitting angle (stage 6).
+
+  Before that, the symmetry is checked at runtime: $R(q)$ must be a fixed
+  point of $P^k$ up to HC_SYM_TOL. This costs a single period.
+
+  \param[in] hu	pipeline state for the unstable manifold
+  \param[out] hs	pipeline state for the stable manifold
+
+  \retval ERR_HC_SYM	The reversibility check failed (hs is not set).
+  \retval ERR_HC_ORBIT	Error integrating the check.
+  */
+int homoclinic_reverse(const homoclinic_t *hu, homoclinic_t *hs);
+
+/**
+  Unstable and stable manifolds at once.
+
+  Run the pipeline hu (unstable manifold of $p$, line $p_x=a$), and obtain
+  the pipeline hs for the stable manifold of $R(p)$ and the line $p_x=-a$
+  by reversibility, halving the manifold work. For $a=0$ (the symmetry
+  line), both share the homoclinic point $z$, and the splitting angle is
+  the angle between hu->w and hs->w.
+  If the reversibility check fails, hs is computed directly.
+
+  \param[in,out] hu	pipeline state for the unstable manifold (initialized)
+  \param[out] hs	pipeline state for the stable manifold
+  \param[in] p		approximate fixed point $p=(x,p_x)$
+
+  \returns 0 on success, or the error code of the first stage that failed.
+  */
+int homoclinic_pair(homoclinic_t *hu, homoclinic_t *hs, double p[2]);
+
+/**
+  Store the homoclinic orbit from $p_u$ to $z$ (after stage 5).
+
+  The orbit is integrated once more, and stored as a piecewise Chebyshev
+  interpolant in Cartesian and Delaunay coordinates (see \ref htraj_build),
+  so that positions, Delaunay elements and integrands along it can be
+  evaluated without integrating again (e.g. by \ref Lbound_htraj).
+  The time along the store runs from 0 (at $p_u$) to hc->t (at $z$).
+
+  \param[in] hc	pipeline state
+  \param[out] tr	trajectory store (free it with \ref htraj_free)
+
+  \retval ERR_HC_ORBIT	Error integrating the homoclinic orbit.
+  */
+int homoclinic_htraj(const homoclinic_t *hc, htraj_t *tr);
+
+#endif // HOMOCLINIC_H_INCLUDED
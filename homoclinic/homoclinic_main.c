@@ -0,0 +1,303 @@
+/*! \file
+    \brief Homoclinic Pipeline: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, strtod
+#include <string.h>		// strcmp
+#include <gsl/gsl_errno.h>	// gsl_set_error_handler_off
+#include <rtbp.h>		// DIM
+#include <section.h>		// branch_t
+#include <utils_module.h>	// dblprint
+#include <tolprof.h>		// tolprof_getenv, tolprof_calibrate
+#include <htraj.h>		// htraj_t, htraj_write
+#include "homoclinic.h"		// homoclinic_t, homoclinic
+
+/**
+   Homoclinic Pipeline: main prog
+
+   This program replaces the chain of programs portbp, hyper, approxint,
+   intersec and splitting. Everything is computed in memory, so that no
+   intermediate results are written to (or read from) text files.
+
+   Usage: homoclinic [-c target | -b] [-j] [-s storefile] [cachefile]
+
+   If a cache file is given, the periodic orbits, hyperbolic splittings and
+   optimal displacements are looked up there (and stored there when they are
+   computed), see \ref pocache_open.
+
+   Along the sweep in H, the number of iterates and the bracket of the
+   homoclinic point are predicted from the previous energy levels, and
+   checked with a single evaluation of the map (see \ref approxint_track).
+   The full search of approxint is only done when the check fails.
+
+   The tolerances are those of the profile in the environment variable
+   RTBP_TOLPROF, if it is defined (see \ref tolprof_parse).
+
+   With option -c, the splitting angle of each energy level is computed with
+   every tolerance profile (see \ref tolprof_calibrate), and the cheapest
+   profile with error at most "target" is reported to stderr. The output
+   line is that of the publication profile. The cache is not used, so that
+   all the stages are computed (and timed) with each profile.
+
+   With option -b, both manifolds are computed for each energy level (see
+   \ref homoclinic_pair): the unstable manifold of p and the line $p_x=a$,
+   and the stable manifold of $R(p)=(x,-p_x)$ and the line $p_x=-a$, which
+   is obtained from the unstable one by reversibility, without integrating
+   the manifold again. The "stable" flag of the input is ignored, and two
+   lines are output per energy level: first the unstable, then the stable.
+
+   With option -j, the homoclinic point is found on the jet transport of
+   the segment that brackets it (see \ref segjet_build): the segment is
+   integrated once as a polynomial in h, and the root is found by Newton's
+   method on it and checked on the map, instead of Brent's method.
+
+   With option -s, the homoclinic orbit from p_u to z of each output line is
+   appended to the store file (see \ref homoclinic_htraj), in the format of
+   the store files of intersec, so that Lbound, ebound and outer_circ_stoch
+   can evaluate it instead of integrating it again.
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin:
+
+      - mass parameter
+      - number of cuts "k" with Poincare section SEC2
+      - "stable" flag (unstable=0, stable=1)
+      - "branch" flag (left=0, right=1)
+      - axis line "a"
+
+   2. For each input line, do
+
+      2.1. Input parameters from stdin:
+         - energy value "H"
+         - approximate fixed point "p"
+
+      2.2. Run the pipeline: fixed point, hyperbolic splitting, fundamental
+      segment, approximate intersection, homoclinic point, splitting angle.
+
+      2.3. Output the following line to stdout:
+         H, p, lambda, v, h, n, h_1, h_2, p_u, t, z, angle.
+ */
+
+// Parameters of the calibration of the splitting angle.
+struct calib
+{
+   homoclinic_t hc;	// initialized pipeline
+   double p[2];		// approximate fixed point
+   homoclinic_t ref;	// pipeline run with the publication profile
+};
+
+int calib_angle(void *par, double *q);
+void print_hc(const homoclinic_t *hc);
+int store_hc(const homoclinic_t *hc, FILE *fp);
+
+int main(int argc, char *argv[])
+{
+   double mu, H;
+   int k;
+   int stable, branch;
+   double a;		// horizontal axis line $p_x=a$
+   double p[2];		// approximate fixed point
+
+   homoclinic_t hc;
+   homoclinic_t hs;	// stable manifold of R(p), with option -b
+   int both = 0;	// compute both manifolds (option -b)
+   int jet = 0;		// jet transport in stage 5 (option -j)
+   FILE *fstore = NULL;	// store file (option -s)
+   pocache_t cache;
+   int use_cache;
+   approxint_track_t track;	// tracker of the energy sweep
+   double target = 0;	// target error of the calibration (0 if not used)
+   struct calib cal;
+   tolprof_name_t best;
+   int arg = 1;
+
+   while(arg < argc && argv[arg][0] == '-')
+   {
+      if(strcmp(argv[arg], "-c") == 0 && arg+1 < argc && !both)
+      {
+	 target = strtod(argv[arg+1], NULL);
+	 arg += 2;
+      }
+      else if(strcmp(argv[arg], "-b") == 0 && target == 0)
+      {
+	 both = 1;
+	 arg++;
+      }
+      else if(strcmp(argv[arg], "-j") == 0)
+      {
+	 jet = 1;
+	 arg++;
+      }
+      else if(strcmp(argv[arg], "-s") == 0 && arg+1 < argc && fstore == NULL)
+      {
+	 if((fstore = fopen(argv[arg+1], "wb")) == NULL)
+	 {
+	    perror("main: error opening store file");
+	    exit(EXIT_FAILURE);
+	 }
+	 arg += 2;
+      }
+      else
+      {
+	 fprintf(stderr, "Usage: %s [-c target | -b] [-j] [-s storefile] "
+	       "[cachefile]\n", argv[0]);
+	 exit(EXIT_FAILURE);
+      }
+   }
+   use_cache = (argc > arg && target == 0);
+   if(tolprof_getenv())
+      exit(EXIT_FAILURE);
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %d %d %d %le", &mu, &k, &stable, &branch, &a) < 5)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+
+   if(use_cache && pocache_open(&cache, argv[arg]))
+   {
+      fprintf(stderr, "main: error opening cache file %s\n", argv[arg]);
+      exit(EXIT_FAILURE);
+   }
+
+   // Stop GSL default error handler from aborting the program
+   gsl_set_error_handler_off();
+
+   approxint_track_init(&track);
+
+   // For each energy level H in the range, do
+   while(scanf("%le %le %le", &H, p, p+1)==3)
+   {
+      fprintf(stderr, "\nH: %e\n", H);
+
+      homoclinic_init(&hc, mu, H, k, (stable && !both ? STABLE : UNSTABLE),
+	    (branch==0 ? LEFT : RIGHT), a);
+      hc.jet = jet;
+      if(use_cache)
+	 hc.cache = &cache;
+      if(target == 0)
+	 hc.track = &track;
+      if(target > 0)
+      {
+	 cal.hc = hc;
+	 cal.p[0] = p[0];
+	 cal.p[1] = p[1];
+	 if(tolprof_calibrate(calib_angle, &cal, target, &best, &hc.angle))
+	 {
+	    fprintf(stderr, "H=%e: couldn't compute homoclinic point\n", H);
+	    continue;
+	 }
+	 fprintf(stderr, "H=%e: cheapest profile for error %e: %s\n", H,
+	       target, TOLPROF_NAMES[best]);
+	 hc = cal.ref;
+      }
+      else if(both)
+      {
+	 if(homoclinic_pair(&hc, &hs, p))
+	 {
+	    fprintf(stderr, "H=%e: couldn't compute homoclinic points\n", H);
+	    continue;
+	 }
+      }
+      else if(homoclinic(&hc, p))
+      {
+	 fprintf(stderr, "H=%e: couldn't compute homoclinic point\n", H);
+	 continue;
+      }
+
+      // 3. Output the following data to stdout.
+      print_hc(&hc);
+      if(both)
+	 print_hc(&hs);
+      fflush(NULL);
+
+      // 4. Store the homoclinic orbits.
+      if(fstore != NULL && (store_hc(&hc, fstore) ||
+	       (both && store_hc(&hs, fstore))))
+	 exit(EXIT_FAILURE);
+   }
+   if(fstore != NULL && fclose(fstore))
+   {
+      perror("main: error writing store file");
+      exit(EXIT_FAILURE);
+   }
+   if(use_cache)
+      pocache_close(&cache);
+   if(target == 0)
+      fprintf(stderr, "\nTracker: %d predictions accepted, %d full searches\n",
+	    track.hits, track.misses);
+   exit(EXIT_SUCCESS);
+}
+
+// name OF FUNCTION: calib_angle
+//
+// PURPOSE
+// =======
+// Run the pipeline par->hc from the approximate fixed point par->p with the
+// current tolerance profile, and return the splitting angle in *q. The run
+// with the publication profile is saved in par->ref.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the pipeline fails, and 0 otherwise.
+
+int calib_angle(void *par, double *q)
+{
+   struct calib *c = (struct calib *)par;
+   homoclinic_t hc = c->hc;
+   double p[2] = {c->p[0], c->p[1]};
+
+   if(homoclinic(&hc, p))
+      return(1);
+   *q = hc.angle;
+   if(tolprof.name == TOLPROF_PUBLICATION)
+      c->ref = hc;
+   return(0);
+}
+
+// name OF FUNCTION: print_hc
+//
+// PURPOSE
+// =======
+// Output the results of the pipeline hc to stdout, in one line:
+//    H, p, lambda, v, h, n, h_1, h_2, p_u, t, z, angle.
+
+void print_hc(const homoclinic_t *hc)
+{
+   printf("%.15e ", hc->H);
+   dblprint(hc->p, 2);
+   printf("%.15e ", hc->lambda);
+   dblprint(hc->v, 2);
+   printf("%.15e %d %.15e %.15e ", hc->h, hc->n, hc->h1, hc->h2);
+   dblprint(hc->orbit, DIM);
+   printf("%.15e ", hc->t);
+   dblprint(hc->z, DIM);
+   printf("%.15e\n", hc->angle);
+}
+
+// name OF FUNCTION: store_hc
+//
+// PURPOSE
+// =======
+// Append the homoclinic orbit of the pipeline hc to the store file fp.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the orbit could not be integrated or written,
+// and 0 otherwise.
+
+int store_hc(const homoclinic_t *hc, FILE *fp)
+{
+   htraj_t tr;
+   int status;
+
+   if(homoclinic_htraj(hc, &tr))
+      return(1);
+   status = htraj_write(fp, &tr);
+   htraj_free(&tr);
+   return(status);
+}
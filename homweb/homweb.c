@@ -0,0 +1,173 @@
+/*! \file
+    \brief Homoclinic Web: Two-Parameter Newton for Homoclinic Points
+*/
+
+#include <stdio.h>	// fprintf
+#include <stdbool.h>	// bool
+#include <math.h>	// fabs, hypot
+#include <gsl/gsl_errno.h>	// GSL_SUCCESS
+
+#include <rtbp.h>	// DIM, rtbp
+#include <frtbp.h>	// DIMV, frtbp_rk, dfrtbp_rk
+#include <section.h>	// SEC2
+#include <hinv.h>	// hinv
+#include <psec.h>	// psec_map
+#include <dprtbp_2d.h>	// set_dprtbp_2d
+#include <rootstop.h>	// rootstop_delta
+#include <tolprof.h>	// tolprof_tol
+#include <utils_module.h>	// dblcpy
+
+#include "homweb.h"
+
+const int ERR_HOMWEB_MAP=1;
+const int ERR_HOMWEB_SING=2;
+const int ERR_HOMWEB_BRACKET=3;
+const int ERR_HOMWEB_MAXITER=4;
+
+/// Tolerance of the Poincare map (as POINCARE_TOL_NL in prtbp_nl).
+static const double HOMWEB_TOL_MAP=1.e-16;
+
+/// Tolerance on the Newton correction (as BISECT_TOL in intersec).
+static const double HOMWEB_TOL=1.e-15;
+
+/// Max number of Newton iterations.
+static const int HOMWEB_MAXITER=30;
+
+int homweb_image(const homweb_t *hw, bool fwd, int n, double h, double q[2],
+      double dq[2], double *t);
+
+int homweb_newton(const homweb_t *hw, const homweb_start_t *st,
+      homweb_pt_t *pt)
+{
+   double qu[2], dqu[2];	// $P^{n_u}(p_u+h_u v_u)$ and its derivative
+   double qs[2], dqs[2];	// $P^{-n_s}(p_s+h_s v_s)$ and its derivative
+   double tu, ts;
+   double f[2];			// $F(h_u,h_s)$
+   double det, du, ds;
+   double tol = tolprof_tol(TOL_ROOT, HOMWEB_TOL);
+   rootstop_t rsu, rss;
+   int status = 0;
+
+   rootstop_init(&rsu, tol);
+   rootstop_init(&rss, tol);
+   pt->hu = (st->hu[0]+st->hu[1])/2;
+   pt->hs = (st->hs[0]+st->hs[1])/2;
+   for(pt->iter=0; pt->iter<HOMWEB_MAXITER; pt->iter++)
+   {
+      if(homweb_image(hw, true, st->nu, pt->hu, qu, dqu, &tu) ||
+	    homweb_image(hw, false, st->ns, pt->hs, qs, dqs, &ts))
+      {
+	 status = ERR_HOMWEB_MAP;
+	 break;
+      }
+      f[0] = qu[0]-qs[0];
+      f[1] = qu[1]-qs[1];
+      pt->z[0] = qu[0];
+      pt->z[1] = qu[1];
+      pt->t = tu;
+      pt->res = hypot(f[0], f[1]);
+
+      // Solve [dqu, -dqs] (du, ds)^T = -f
+      det = -dqu[0]*dqs[1] + dqs[0]*dqu[1];
+      if(det == 0)
+      {
+	 status = ERR_HOMWEB_SING;
+	 break;
+      }
+      du = (f[0]*dqs[1] - dqs[0]*f[1])/det;
+      ds = (f[0]*dqu[1] - dqu[0]*f[1])/det;
+
+      // Converged to the tolerance, or to machine precision.
+      if((fabs(du) < tol && fabs(ds) < tol) ||
+	    (rootstop_delta(&rsu, pt->hu, pt->hu+du) == GSL_SUCCESS &&
+	     rootstop_delta(&rss, pt->hs, pt->hs+ds) == GSL_SUCCESS))
+	 break;
+
+      pt->hu += du;
+      pt->hs += ds;
+      if((pt->hu-st->hu[0])*(pt->hu-st->hu[1]) > 0 ||
+	    (pt->hs-st->hs[0])*(pt->hs-st->hs[1]) > 0)
+      {
+	 status = ERR_HOMWEB_BRACKET;
+	 break;
+      }
+   }
+   if(status == 0 && pt->iter == HOMWEB_MAXITER)
+      status = ERR_HOMWEB_MAXITER;
+   pt->status = status;
+   return(status);
+}
+
+int homweb(const homweb_t *hw, int m, const homweb_start_t *st,
+      homweb_pt_t *pt)
+{
+   int nok = 0;		// number of brackets that converged
+   int i;
+
+   #pragma omp parallel for schedule(dynamic,1) reduction(+:nok)
+   for(i=0; i<m; i++)
+   {
+      if(homweb_newton(hw, st+i, pt+i) == 0)
+	 nok++;
+   }
+   return(nok);
+}
+
+// name OF FUNCTION: homweb_image
+//
+// PURPOSE
+// =======
+// Image $q=P^n(p_u+h v_u)$ (fwd=true) or $q=P^{-n}(p_s+h v_s)$ (fwd=false) of
+// a point of the linearized manifold, in coordinates $(x,p_x)$, and its
+// derivative $dq = DP^{\pm n}\,v$ with respect to h.
+//
+// The point is lifted to SEC2 with hinv, and mapped n*k times with the
+// section engine on the reentrant flow frtbp_rk. The variational equations
+// are integrated (dfrtbp_rk) for the total time t of the n iterates, and
+// the derivative of the 2D map is obtained from them with set_dprtbp_2d, as
+// for a single iterate.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the point could not be lifted or mapped, and 0
+// otherwise.
+
+int homweb_image(const homweb_t *hw, bool fwd, int n, double h, double q[2],
+      double dq[2], double *t)
+{
+   psec_flow_t fl = {frtbp_rk, rtbp, DIM, PSEC_STEP_CAR};
+   psec_t s = {psec_y, psec_y_grad, NULL, 0, 0, psec_side_x};
+   const double *p = (fwd ? hw->pu : hw->ps);
+   const double *v = (fwd ? hw->vu : hw->vs);
+   double mu = hw->mu;
+   double x[DIM], x0[DIM];
+   double dp[DIMV], dp2d[4];
+   double f[DIM], g[DIM];	// vector field at x0 and x
+
+   x[0] = p[0] + h*v[0];	// x
+   x[1] = 0;			// y
+   x[2] = p[1] + h*v[1];	// px
+   if(hinv(mu,SEC2,hw->H,x))
+   {
+      fprintf(stderr, "homweb: error lifting point\n");
+      return(1);
+   }
+   dblcpy(x0, x, DIM);
+   if(psec_map(mu, &fl, &s, n*hw->k, fwd, HOMWEB_TOL_MAP, x, t))
+   {
+      fprintf(stderr, "homweb: error computing Poincare map\n");
+      return(1);
+   }
+   x[1] = 0;	// y
+   if(dfrtbp_rk(mu, *t, x0, dp) || rtbp(0.0,x0,f,&mu) || rtbp(0.0,x,g,&mu)
+	 || set_dprtbp_2d(dp,f,g,dp2d))
+   {
+      fprintf(stderr, "homweb: error computing derivative of the map\n");
+      return(1);
+   }
+   q[0] = x[0];
+   q[1] = x[2];
+   dq[0] = dp2d[0]*v[0] + dp2d[1]*v[1];
+   dq[1] = dp2d[2]*v[0] + dp2d[3]*v[1];
+   return(0);
+}
@@ -0,0 +1,129 @@
+/*! \file
+    \brief Homoclinic Web: Two-Parameter Newton for Homoclinic Points
+
+    A homoclinic point $z$ of the fixed point $p$ of the Poincare map $P$ on
+    SEC2 (or heteroclinic, between two fixed points) is a solution of
+    \f[ F(h_u,h_s) = P^{n_u}(p_u+h_u v_u) - P^{-n_s}(p_s+h_s v_s) = 0, \f]
+    where $v_u$, $v_s$ are the unstable and stable eigenvectors, and $h_u$,
+    $h_s$ the segment parameters along the (linearized) local manifolds.
+    Unlike \ref intersec_h_unst, the point need not lie on a given line
+    $p_x=a$, so the secondary homoclinic points away from the symmetry line
+    are found as well.
+
+    The system is solved by Newton's method on $(h_u,h_s)$. The Jacobian
+    $\partial F/\partial h_u = DP^{n_u}\,v_u$, $\partial F/\partial h_s =
+    -DP^{-n_s}\,v_s$ is obtained from the variational equations integrated
+    along the same orbits (see \ref set_dprtbp_2d), so the convergence is
+    quadratic.
+
+    All the integrations are done with the reentrant flows \ref frtbp_rk and
+    \ref dfrtbp_rk, and the Poincare map is that of \ref prtbp_nl (section
+    $\{y=0\}$ with its loop filter), so many starting brackets are solved
+    concurrently with OpenMP (see \ref homweb).
+*/
+
+#ifndef HOMWEB_H_INCLUDED
+#define HOMWEB_H_INCLUDED
+
+/** Error lifting a point or computing the Poincare map. */
+extern const int ERR_HOMWEB_MAP;
+
+/** Singular Jacobian. */
+extern const int ERR_HOMWEB_SING;
+
+/** The Newton iterate left the starting bracket. */
+extern const int ERR_HOMWEB_BRACKET;
+
+/** Newton's method did not converge. */
+extern const int ERR_HOMWEB_MAXITER;
+
+/**
+  Homoclinic problem at a given energy level.
+
+  The unstable manifold is that of the fixed point pu of $P^k$, and the
+  stable manifold that of ps (ps=pu for homoclinic points; for the
+  reversible map, ps=R(pu) gives the symmetric partner, see \ref
+  homoclinic_reverse).
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   double H;		///< energy value
+   int k;		///< number of cuts with SEC2 per iterate
+   double pu[2];	///< fixed point $p_u=(x,p_x)$ of the unstable manifold
+   double vu[2];	///< unstable eigenvector
+   double ps[2];	///< fixed point $p_s=(x,p_x)$ of the stable manifold
+   double vs[2];	///< stable eigenvector
+} homweb_t;
+
+/**
+  Starting bracket of Newton's method.
+
+  The Newton iteration starts at the center of the box
+  $[h_{u,1},h_{u,2}]\times[h_{s,1},h_{s,2}]$, and fails if it leaves the
+  box.
+  */
+typedef struct
+{
+   int nu;		///< number of iterates $n_u$ of $P$ on the unstable side
+   int ns;		///< number of iterates $n_s$ of $P^{-1}$ on the stable side
+   double hu[2];	///< bracket of $h_u$
+   double hs[2];	///< bracket of $h_s$
+} homweb_start_t;
+
+/**
+  Homoclinic point found from a starting bracket.
+  */
+typedef struct
+{
+   int status;		///< 0 on success, or the error code of \ref homweb_newton
+   int iter;		///< number of Newton iterations
+   double hu, hs;	///< segment parameters of the root
+   double z[2];		///< homoclinic point $z=(x,p_x)$
+   double t;		///< integration time from $p_u+h_u v_u$ to $z$
+   double res;		///< residual $|F(h_u,h_s)|$ at the root
+} homweb_pt_t;
+
+/**
+  Homoclinic point by Newton's method on $(h_u,h_s)$.
+
+  The iteration stops when the Newton correction is below the root
+  tolerance (relative to the size of $h$; see \ref tolprof_tol, stage
+  TOL_ROOT), or when $|F|$ stops decreasing at machine precision.
+
+  \param[in] hw		homoclinic problem
+  \param[in] st		starting bracket
+  \param[out] pt	homoclinic point
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success (also stored in pt->status).
+
+  \retval ERR_HOMWEB_MAP	Error lifting a point or computing the map.
+  \retval ERR_HOMWEB_SING	Singular Jacobian (tangency of the manifolds).
+  \retval ERR_HOMWEB_BRACKET	The iterate left the starting bracket.
+  \retval ERR_HOMWEB_MAXITER	No convergence.
+
+  \remark
+  It keeps no global state, so it can be called from several threads at
+  once.
+  */
+int homweb_newton(const homweb_t *hw, const homweb_start_t *st,
+      homweb_pt_t *pt);
+
+/**
+  Homoclinic points from many starting brackets.
+
+  Run \ref homweb_newton from each of the m starting brackets. The brackets
+  are distributed dynamically among the OpenMP threads.
+
+  \param[in] hw		homoclinic problem
+  \param[in] m		number of starting brackets
+  \param[in] st		starting brackets (m of them)
+  \param[out] pt	homoclinic points (m of them)
+
+  \returns the number of brackets where Newton's method converged.
+  */
+int homweb(const homweb_t *hw, int m, const homweb_start_t *st,
+      homweb_pt_t *pt);
+
+#endif // HOMWEB_H_INCLUDED
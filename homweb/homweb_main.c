@@ -0,0 +1,121 @@
+/*! \file
+    \brief Homoclinic Web: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, realloc
+#include <math.h>		// fabs
+#include <gsl/gsl_errno.h>	// gsl_set_error_handler_off
+#include <tolprof.h>		// tolprof_getenv
+#include "homweb.h"		// homweb_t, homweb
+
+/// Two roots are the same homoclinic point if they have the same iterates
+/// and their segment parameters differ by less than this.
+static const double HOMWEB_SAME=1.e-10;
+
+/**
+   Homoclinic Web: main prog
+
+   This program lists the homoclinic points of the manifolds at an energy
+   level, including the secondary ones away from the symmetry line, which
+   used to be found by hand (see intersecs_*.plt, tangencies.txt). Each
+   point is found by Newton's method on the segment parameters $(h_u,h_s)$
+   (see \ref homweb_newton), and the starting brackets are solved in
+   parallel.
+
+   The tolerances are those of the profile in the environment variable
+   RTBP_TOLPROF, if it is defined (see \ref tolprof_parse).
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin:
+
+      - mass parameter
+      - number of cuts "k" with Poincare section SEC2
+      - energy value "H"
+      - fixed point "p_u" and unstable eigenvector "v_u"
+      - fixed point "p_s" and stable eigenvector "v_s"
+
+   2. For each input line, input a starting bracket:
+      - number of iterates "n_u", "n_s"
+      - bracket of $h_u$: $h_{u,1}$, $h_{u,2}$
+      - bracket of $h_s$: $h_{s,1}$, $h_{s,2}$
+
+   3. Solve all the brackets, in parallel.
+
+   4. For each homoclinic point found (repeated points are output once),
+   output the following line to stdout:
+      n_u, n_s, h_u, h_s, z, t, residual, Newton iterations.
+ */
+
+int main( )
+{
+   homweb_t hw;
+   homweb_start_t *st = NULL, *q;
+   homweb_pt_t *pt;
+   homweb_start_t s;
+   int m = 0, nok, i, j;
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %d %le %le %le %le %le %le %le %le %le", &hw.mu, &hw.k,
+	    &hw.H, hw.pu, hw.pu+1, hw.vu, hw.vu+1, hw.ps, hw.ps+1, hw.vs,
+	    hw.vs+1) < 11)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+
+   // Stop GSL default error handler from aborting the program
+   gsl_set_error_handler_off();
+   if(tolprof_getenv())
+      exit(EXIT_FAILURE);
+
+   // 2. Starting brackets.
+   while(scanf("%d %d %le %le %le %le", &s.nu, &s.ns, s.hu, s.hu+1, s.hs,
+	    s.hs+1)==6)
+   {
+      q = realloc(st, (m+1)*sizeof(homweb_start_t));
+      if(q == NULL)
+      {
+	 fprintf(stderr, "main: out of memory\n");
+	 exit(EXIT_FAILURE);
+      }
+      st = q;
+      st[m++] = s;
+   }
+   pt = malloc((m > 0 ? m : 1)*sizeof(homweb_pt_t));
+   if(pt == NULL)
+   {
+      fprintf(stderr, "main: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   // 3. Solve the brackets.
+   nok = homweb(&hw, m, st, pt);
+   fprintf(stderr, "main: %d of %d brackets converged\n", nok, m);
+
+   // 4. Output the homoclinic points.
+   for(i=0; i<m; i++)
+   {
+      if(pt[i].status)
+      {
+	 fprintf(stderr, "main: bracket %d failed (error %d)\n", i,
+	       pt[i].status);
+	 continue;
+      }
+      for(j=0; j<i; j++)
+	 if(pt[j].status == 0 && st[j].nu == st[i].nu && st[j].ns == st[i].ns
+	       && fabs(pt[j].hu-pt[i].hu) < HOMWEB_SAME
+	       && fabs(pt[j].hs-pt[i].hs) < HOMWEB_SAME)
+	    break;
+      if(j < i)
+	 continue;
+      printf("%d %d %.15e %.15e %.15e %.15e %.15e %.15e %d\n", st[i].nu,
+	    st[i].ns, pt[i].hu, pt[i].hs, pt[i].z[0], pt[i].z[1], pt[i].t,
+	    pt[i].res, pt[i].iter);
+   }
+   free(st);
+   free(pt);
+   exit(EXIT_SUCCESS);
+}
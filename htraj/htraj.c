@@ -0,0 +1,371 @@
+/*! \file
+    \brief Trajectory Store: Piecewise Chebyshev Interpolant of a Trajectory
+
+    On each segment, the trajectory is sampled at the deg+1 Chebyshev nodes
+    (of the first kind), and the coefficients of the interpolating
+    polynomial are obtained with the discrete cosine transform. The
+    expansions are evaluated with Clenshaw's recurrence.
+*/
+
+#include <stdio.h>	// fprintf, fread, fwrite
+#include <stdlib.h>	// malloc, free
+#include <string.h>	// memcmp
+#include <math.h>	// cos, ceil, floor, round, fabs, M_PI
+
+#include <rtbp.h>	// DIM
+#include <cardel.h>	// cardel_batch
+#include <utils_module.h>	// dblcpy, TWOPI
+
+#include "htraj.h"
+
+const int ERR_HTRAJ_FLOW=1;
+const int ERR_HTRAJ_RANGE=2;
+const int ERR_HTRAJ_IO=3;
+
+const double HTRAJ_SEGLEN=0.1;
+const double HTRAJ_SEGLEN_RED=M_PI/16;
+
+/// Times slightly outside the interval (relative to dt) are accepted.
+static const double HTRAJ_EPS=1.e-10;
+
+/// Magic string at the beginning of a trajectory file.
+static const char HTRAJ_MAGIC[8] = {'R','T','B','P','T','R','J','1'};
+
+// Cached periodic orbit (see htraj_periodic).
+struct htraj_periodic_entry
+{
+   // key
+   double mu;
+   htraj_flow_t flow;
+   int dim;
+   double x0[HTRAJ_MAXDIM];
+   double T;
+   double seglen;
+
+   htraj_t tr;		/* stored orbit */
+};
+
+static struct htraj_periodic_entry htraj_po[HTRAJ_NPERIODIC];
+static int htraj_po_n = 0;	/* entries in use */
+static int htraj_po_next = 0;	/* entry to be replaced next */
+
+void htraj_cheb(int ncomp, int n, double f[][HTRAJ_DEG+1], double *coef);
+int htraj_seg(const htraj_t *tr, double t, int *j, double *tau);
+double htraj_clenshaw(const double *a, int deg, double tau);
+int htraj_periodic_find(double mu, htraj_flow_t flow, int dim,
+      const double *x0, double T, double seglen);
+
+int htraj_build(htraj_t *tr, double mu, htraj_flow_t flow, int dim, int del,
+      const double *x0, double t1, double seglen)
+{
+   int n = HTRAJ_DEG+1;		// number of nodes per segment
+   double f[HTRAJ_MAXCOMP][HTRAJ_DEG+1];	// values at the nodes
+   double x[HTRAJ_MAXDIM];	// current point
+   double tc;			// current time
+   double tn;			// time of next node
+   double lprev=0, gprev=0;	// previous values of angles l, g
+
+   // auxiliary variables
+   int i, j, m, c;
+
+   tr->coef = NULL;
+   if(dim < 1 || dim > HTRAJ_MAXDIM || (del && dim < DIM) || t1 == 0
+	 || !(seglen > 0))
+   {
+      fprintf(stderr, "htraj_build: invalid arguments\n");
+      return(ERR_HTRAJ_IO);
+   }
+
+   tr->dim = dim;
+   tr->del = (del ? 1 : 0);
+   tr->ncomp = (del ? dim+DIM : dim);
+   tr->deg = HTRAJ_DEG;
+   tr->nseg = (int)ceil(fabs(t1)/seglen);
+   tr->t1 = t1;
+   tr->dt = t1/tr->nseg;
+   tr->coef = malloc(tr->nseg*tr->ncomp*n*sizeof(double));
+   if(tr->coef == NULL)
+   {
+      fprintf(stderr, "htraj_build: out of memory\n");
+      return(ERR_HTRAJ_IO);
+   }
+
+   dblcpy(x, x0, dim);
+   tc = 0;
+   for(j=0; j<tr->nseg; j++)
+   {
+      // Nodes $\tau_i=\cos(\pi(i+1/2)/n)$ are visited in increasing time,
+      // i.e. from i=n-1 down to i=0.
+      for(m=0; m<n; m++)
+      {
+	 i = n-1-m;
+	 tn = (j + 0.5*(1+cos(M_PI*(i+0.5)/n)))*tr->dt;
+	 if(flow(mu, tn-tc, x))
+	 {
+	    fprintf(stderr, "htraj_build: integration error at t=%e\n", tn);
+	    htraj_free(tr);
+	    return(ERR_HTRAJ_FLOW);
+	 }
+	 tc = tn;
+	 for(c=0; c<dim; c++)
+	    f[c][i] = x[c];
+      }
+      if(del)
+      {
+	 // Delaunay elements of all the nodes of the segment at once.
+	 cardel_batch(n, f[0], f[1], f[2], f[3], f[dim], f[dim+1], f[dim+2],
+	       f[dim+3]);
+
+	 // Make the angles continuous along the trajectory.
+	 for(m=0; m<n; m++)
+	 {
+	    i = n-1-m;
+	    if(j>0 || m>0)
+	    {
+	       f[dim][i] += TWOPI*round((lprev-f[dim][i])/TWOPI);
+	       f[dim+2][i] += TWOPI*round((gprev-f[dim+2][i])/TWOPI);
+	    }
+	    lprev = f[dim][i];
+	    gprev = f[dim+2][i];
+	 }
+      }
+      htraj_cheb(tr->ncomp, n, f, tr->coef + j*tr->ncomp*n);
+   }
+   return(0);
+}
+
+int htraj_eval(const htraj_t *tr, double t, double *x)
+{
+   int j, c;
+   double tau;
+   const double *a;
+
+   if(htraj_seg(tr, t, &j, &tau))
+      return(ERR_HTRAJ_RANGE);
+   a = tr->coef + j*tr->ncomp*(tr->deg+1);
+   for(c=0; c<tr->dim; c++)
+      x[c] = htraj_clenshaw(a + c*(tr->deg+1), tr->deg, tau);
+   return(0);
+}
+
+int htraj_eval_del(const htraj_t *tr, double t, double y[DIM])
+{
+   int j, c;
+   double tau;
+   const double *a;
+
+   if(!tr->del)
+   {
+      fprintf(stderr, "htraj_eval_del: Delaunay elements were not stored\n");
+      return(ERR_HTRAJ_RANGE);
+   }
+   if(htraj_seg(tr, t, &j, &tau))
+      return(ERR_HTRAJ_RANGE);
+   a = tr->coef + (j*tr->ncomp + tr->dim)*(tr->deg+1);
+   for(c=0; c<DIM; c++)
+      y[c] = htraj_clenshaw(a + c*(tr->deg+1), tr->deg, tau);
+   return(0);
+}
+
+int htraj_write(FILE *fp, const htraj_t *tr)
+{
+   size_t len = (size_t)tr->nseg*tr->ncomp*(tr->deg+1);
+
+   if(fwrite(HTRAJ_MAGIC, sizeof(HTRAJ_MAGIC), 1, fp) != 1
+	 || fwrite(tr, sizeof(*tr), 1, fp) != 1
+	 || fwrite(tr->coef, sizeof(double), len, fp) != len)
+   {
+      perror("htraj_write: error writing trajectory");
+      return(ERR_HTRAJ_IO);
+   }
+   return(0);
+}
+
+int htraj_read(FILE *fp, htraj_t *tr)
+{
+   char magic[8];
+   size_t len;
+
+   if(fread(magic, sizeof(magic), 1, fp) != 1
+	 || memcmp(magic, HTRAJ_MAGIC, sizeof(magic))
+	 || fread(tr, sizeof(*tr), 1, fp) != 1)
+   {
+      fprintf(stderr, "htraj_read: not a trajectory file\n");
+      tr->coef = NULL;
+      return(ERR_HTRAJ_IO);
+   }
+   len = (size_t)tr->nseg*tr->ncomp*(tr->deg+1);
+   tr->coef = malloc(len*sizeof(double));
+   if(tr->coef == NULL || fread(tr->coef, sizeof(double), len, fp) != len)
+   {
+      fprintf(stderr, "htraj_read: error reading trajectory\n");
+      htraj_free(tr);
+      return(ERR_HTRAJ_IO);
+   }
+   return(0);
+}
+
+void htraj_free(htraj_t *tr)
+{
+   free(tr->coef);
+   tr->coef = NULL;
+}
+
+const htraj_t *htraj_periodic(double mu, htraj_flow_t flow, int dim,
+      const double *x0, double T, double seglen)
+{
+   struct htraj_periodic_entry *e;
+   int k;
+
+   if((k=htraj_periodic_find(mu, flow, dim, x0, T, seglen)) >= 0)
+      return(&htraj_po[k].tr);
+
+   if(dim < 1 || dim > HTRAJ_MAXDIM)
+   {
+      fprintf(stderr, "htraj_periodic: invalid arguments\n");
+      return(NULL);
+   }
+
+   // Replace the oldest entry
+   e = &htraj_po[htraj_po_next];
+   if(htraj_po_next < htraj_po_n)
+      htraj_free(&e->tr);
+   if(htraj_build(&e->tr, mu, flow, dim, 0, x0, T, seglen))
+   {
+      fprintf(stderr, "htraj_periodic: error building periodic orbit\n");
+      // Keep the cache compact: move the last entry into the hole.
+      if(htraj_po_next < htraj_po_n)
+      {
+	 htraj_po_n--;
+	 if(htraj_po_next < htraj_po_n)
+	    *e = htraj_po[htraj_po_n];
+      }
+      return(NULL);
+   }
+   e->mu = mu;
+   e->flow = flow;
+   e->dim = dim;
+   dblcpy(e->x0, x0, dim);
+   e->T = T;
+   e->seglen = seglen;
+
+   if(htraj_po_next == htraj_po_n)
+      htraj_po_n++;
+   htraj_po_next = (htraj_po_next+1) % HTRAJ_NPERIODIC;
+   return(&e->tr);
+}
+
+void htraj_periodic_free(void)
+{
+   int k;
+
+   for(k=0; k<htraj_po_n; k++)
+      htraj_free(&htraj_po[k].tr);
+   htraj_po_n = 0;
+   htraj_po_next = 0;
+}
+
+// name OF FUNCTION: htraj_cheb
+//
+// PURPOSE
+// =======
+// Chebyshev coefficients of the interpolating polynomials of degree n-1,
+// from the values f[c][i] at the nodes $\tau_i=\cos(\pi(i+1/2)/n)$,
+// i=0,...,n-1. The coefficient $a_0$ is halved, so that the expansion is
+// simply $\sum_k a_k T_k$.
+
+void htraj_cheb(int ncomp, int n, double f[][HTRAJ_DEG+1], double *coef)
+{
+   int c, i, k;
+   double s;
+
+   for(c=0; c<ncomp; c++)
+      for(k=0; k<n; k++)
+      {
+	 s = 0;
+	 for(i=0; i<n; i++)
+	    s += f[c][i]*cos(M_PI*k*(i+0.5)/n);
+	 coef[c*n+k] = (k==0 ? 1.0 : 2.0)*s/n;
+      }
+}
+
+// name OF FUNCTION: htraj_seg
+//
+// PURPOSE
+// =======
+// Find the segment j that contains time t, and the rescaled time
+// $\tau\in[-1,1]$ in that segment.
+//
+// RETURN VALUE
+// ============
+// Returns ERR_HTRAJ_RANGE if t is outside the integration interval, and 0
+// otherwise.
+
+int htraj_seg(const htraj_t *tr, double t, int *j, double *tau)
+{
+   double u = t/tr->dt;		// time in units of segments
+
+   if(!(u >= -HTRAJ_EPS && u <= tr->nseg + HTRAJ_EPS))
+   {
+      fprintf(stderr, "htraj: time %e is outside the trajectory [0,%e]\n",
+	    t, tr->t1);
+      return(ERR_HTRAJ_RANGE);
+   }
+   *j = (int)floor(u);
+   if(*j < 0)
+      *j = 0;
+   if(*j > tr->nseg-1)
+      *j = tr->nseg-1;
+   *tau = 2*(u-*j)-1;
+   return(0);
+}
+
+// name OF FUNCTION: htraj_clenshaw
+//
+// PURPOSE
+// =======
+// Evaluate $\sum_{k=0}^{deg} a_k T_k(\tau)$ with Clenshaw's recurrence.
+
+double htraj_clenshaw(const double *a, int deg, double tau)
+{
+   double b1 = 0, b2 = 0, b;
+   int k;
+
+   for(k=deg; k>=1; k--)
+   {
+      b = a[k] + 2*tau*b1 - b2;
+      b2 = b1;
+      b1 = b;
+   }
+   return(a[0] + tau*b1 - b2);
+}
+
+// name OF FUNCTION: htraj_periodic_find
+//
+// PURPOSE
+// =======
+// Look for the periodic orbit with key (mu, flow, dim, x0, T, seglen) in the
+// cache. Doubles are compared bitwise.
+//
+// RETURN VALUE
+// ============
+// Returns the index of the entry, or -1 if it is not in the cache.
+
+int htraj_periodic_find(double mu, htraj_flow_t flow, int dim,
+      const double *x0, double T, double seglen)
+{
+   const struct htraj_periodic_entry *e;
+   int k;
+
+   for(k=0; k<htraj_po_n; k++)
+   {
+      e = &htraj_po[k];
+      if(e->flow == flow && e->dim == dim
+	    && !memcmp(&e->mu, &mu, sizeof(double))
+	    && !memcmp(&e->T, &T, sizeof(double))
+	    && !memcmp(&e->seglen, &seglen, sizeof(double))
+	    && !memcmp(e->x0, x0, dim*sizeof(double)))
+	 return(k);
+   }
+   return(-1);
+}
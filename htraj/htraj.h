@@ -0,0 +1,178 @@
+/*! \file
+    \brief Trajectory Store: Piecewise Chebyshev Interpolant of a Trajectory
+
+    A trajectory (typically the homoclinic orbit from \f$z_u\f$ to \f$z\f$,
+    or a piece of periodic orbit) is integrated once, and stored as a
+    sequence of Chebyshev expansions on consecutive time segments. Positions
+    (and, optionally, Delaunay elements) at any time in the integration
+    interval are then obtained by evaluating the expansions, without
+    integrating the ODE again.
+*/
+
+#ifndef HTRAJ_H_INCLUDED
+#define HTRAJ_H_INCLUDED
+
+#include <stdio.h>	// FILE
+#include <rtbp.h>	// DIM
+
+/// Max dimension of the stored flow (DIMRED=6 for the reduced flow).
+#define HTRAJ_MAXDIM 6
+
+/// Max number of stored components (flow + Delaunay elements).
+#define HTRAJ_MAXCOMP (HTRAJ_MAXDIM+DIM)
+
+/// Degree of the Chebyshev expansion on each segment.
+#define HTRAJ_DEG 16
+
+/** Integration error while building the store. */
+extern const int ERR_HTRAJ_FLOW;
+
+/** Time is outside the integration interval of the store. */
+extern const int ERR_HTRAJ_RANGE;
+
+/** Error reading/writing the store, or out of memory. */
+extern const int ERR_HTRAJ_IO;
+
+/// Default length of the time segments (for the Cartesian flow).
+extern const double HTRAJ_SEGLEN;
+
+/// Default length of the segments for the reduced flow, where time is the
+/// angle $g$ (or $l$).
+extern const double HTRAJ_SEGLEN_RED;
+
+/**
+  Flow function, as \ref frtbp, \ref frtbp_del or \ref frtbp_red_g: on
+  return, x holds the point $\phi(t,x)$.
+  */
+typedef int (*htraj_flow_t)(double mu, double t, double *x);
+
+/**
+  Trajectory store.
+
+  The interval $[0,t_1]$ (or $[t_1,0]$ if $t_1<0$) is divided in nseg
+  segments of length dt (with the sign of $t_1$). On segment $j$, component
+  $c$ is $\sum_{k=0}^{deg} a_k T_k(\tau)$, where
+  $\tau\in[-1,1]$ is the rescaled time, and the coefficients $a_k$ are
+  stored at coef[(j*ncomp+c)*(deg+1)+k].
+  */
+typedef struct
+{
+   int dim;		///< dimension of the flow
+   int ncomp;		///< stored components: dim, or dim+DIM if del is set
+   int del;		///< also store Delaunay elements (l,L,g,G)
+   int deg;		///< degree of the Chebyshev expansions
+   int nseg;		///< number of segments
+   double t1;		///< final time
+   double dt;		///< (signed) length of segments
+   double *coef;	///< Chebyshev coefficients
+} htraj_t;
+
+/**
+  Integrate a trajectory once, and store it.
+
+  The trajectory is integrated sequentially through the Chebyshev nodes of
+  each segment, so the cost is that of a single integration from 0 to $t_1$
+  (with nseg*(deg+1) restarts of the integrator).
+
+  \param[out] tr	trajectory store (free it with \ref htraj_free)
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] flow	flow function
+  \param[in] dim	dimension of the flow (DIM, or DIMRED)
+  \param[in] del
+     If set, also store the Delaunay elements of the Cartesian point
+     (x[0],...,x[3]). The angles $l$, $g$ are made continuous along the
+     trajectory, so they are not normalized.
+  \param[in] x0		initial point at $t=0$
+  \param[in] t1		final time (positive or negative)
+  \param[in] seglen	length of the segments (e.g. HTRAJ_SEGLEN)
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_HTRAJ_FLOW	Integration error.
+  \retval ERR_HTRAJ_IO		Out of memory, or invalid arguments.
+  */
+int htraj_build(htraj_t *tr, double mu, htraj_flow_t flow, int dim, int del,
+      const double *x0, double t1, double seglen);
+
+/**
+  Evaluate the stored flow at time $t$.
+
+  \param[in] tr		trajectory store
+  \param[in] t		time, between 0 and tr->t1
+  \param[out] x		point $\phi(t,x_0)$ (tr->dim coordinates)
+
+  \retval ERR_HTRAJ_RANGE	t is outside the integration interval.
+  */
+int htraj_eval(const htraj_t *tr, double t, double *x);
+
+/**
+  Evaluate the stored Delaunay elements at time $t$.
+
+  \param[in] tr		trajectory store, built with del set
+  \param[in] t		time, between 0 and tr->t1
+  \param[out] y		Delaunay elements (l,L,g,G) of $\phi(t,x_0)$
+
+  \retval ERR_HTRAJ_RANGE	t is outside the integration interval, or
+  Delaunay elements were not stored.
+  */
+int htraj_eval_del(const htraj_t *tr, double t, double y[DIM]);
+
+/**
+  Write a trajectory store to a binary file.
+
+  Several stores can be written to the same file one after the other (e.g.
+  one per energy level, as intersec and homoclinic do), and read back in
+  the same order with \ref htraj_read.
+
+  \retval ERR_HTRAJ_IO		Error writing the file.
+  */
+int htraj_write(FILE *fp, const htraj_t *tr);
+
+/**
+  Read a trajectory store written by \ref htraj_write.
+
+  \retval ERR_HTRAJ_IO		Error reading the file, or out of memory.
+  */
+int htraj_read(FILE *fp, htraj_t *tr);
+
+/** Free the memory used by a trajectory store. */
+void htraj_free(htraj_t *tr);
+
+/// Number of periodic orbits kept by \ref htraj_periodic.
+#define HTRAJ_NPERIODIC 4
+
+/**
+  Stored periodic orbit, built once and cached.
+
+  Return the store of $\phi(t,x_0)$, $t\in[0,T]$, where $T$ is the period
+  (positive or negative) of the orbit through $x_0$. The last
+  HTRAJ_NPERIODIC stores are kept in memory, keyed by
+  (mu, flow, dim, x0, T, seglen) compared bitwise, so the integrals over
+  many periods of the same orbit (e.g. all Melnikov integrands at one
+  energy level) evaluate $\gamma_p$ by interpolation, without integrating
+  the ODE again. If the flow has an additive time component (as $t$ in the
+  reduced flow), its value over the i-th period is the stored one plus i
+  times its increment over one period.
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] flow	flow function
+  \param[in] dim	dimension of the flow (DIM, or DIMRED)
+  \param[in] x0		initial point at $t=0$
+  \param[in] T		period (positive or negative)
+  \param[in] seglen	length of the segments (e.g. HTRAJ_SEGLEN_RED)
+
+  \returns the cached store (owned by the cache; do not free it), or NULL if
+  it could not be built.
+
+  \remark
+  The cache is not thread-safe. Call this function before entering a
+  parallel region; the returned store may then be evaluated concurrently.
+  */
+const htraj_t *htraj_periodic(double mu, htraj_flow_t flow, int dim,
+      const double *x0, double T, double seglen);
+
+/** Free all the stores kept by \ref htraj_periodic. */
+void htraj_periodic_free(void);
+
+#endif // HTRAJ_H_INCLUDED
@@ -7,10 +7,11 @@
 
 #include <stdio.h>	// perror
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
+#include <math.h>	// M_PI
 
-#include <gsl/gsl_integration.h>	// gsl_integration_qags
 #include <rtbpdel.h>			// dot_g, f0
 #include <frtbpred.h>
+#include <pquad.h>			// pquad
 
 #include "inner_circ.h" 	// iparams_omega_in
 
@@ -30,13 +31,6 @@
 // \[ 2\pi + \mu T_0 = period of p.o. \]
 //
 
-// Parameters to \ref inner_circ function.
-struct iparams_inner_circ
-{
-   double mu;
-   double x[DIM];
-};
-
 double integrand_omega_in(double s, void *params)
 {
    double mu;
@@ -79,65 +73,49 @@ double integrand_omega_in(double s, void *params)
 int omega_in_f(double mu, double x[DIM], double *omega)
 {
    double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_omega_in params;
-
-   params.mu = mu;
-   
-   params.x[0] = x[0];
-   params.x[1] = x[1];
-   params.x[2] = x[2];
-   params.x[3] = x[3];
-
-   gsl_function F;
-   F.function = &integrand_omega_in;
-   F.params = &params;
-
-   // Integrate integrand function from 0 to 4\pi. 
-   // We request a absolute error of 0 and a relative error $10^{-13}$.
-   // We request a absolute error of 0 and a relative error $10^{-10}$, since
-   // 10^{-13} seems to be too much...
-   gsl_integration_qags (&F, 0, 4*M_PI, 0, 1.e-10, 1000, w, &result, &error);
+   double y[DIMRED];
+   int status;
+
+   y[0] = x[0];		// l
+   y[1] = x[1];		// L
+   y[2] = x[2];		// g
+   y[3] = x[3];		// G
+   y[4] = 0;		// t
+   y[5] = 0;		// I (not used).
+
+   // Integrate f0 along the trajectory from 0 to 4\pi, in a single pass.
+   // We request a relative error $10^{-10}$, since 10^{-13} seems to be too
+   // much...
+   status = pquad(mu, frtbp_red_l, DIMRED, y, 4*M_PI, 0, f0, &mu, 1.e-10,
+	 &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
-   gsl_integration_workspace_free (w);
-
    *omega = result;		// \omega_in^f
-   return 0;
+   return status;
 }
 
 int omega_in_b(double mu, double x[DIM], double *omega)
 {
    double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_omega_in params;
-
-   params.mu = mu;
-   
-   params.x[0] = x[0];
-   params.x[1] = x[1];
-   params.x[2] = x[2];
-   params.x[3] = x[3];
-
-   gsl_function F;
-   F.function = &integrand_omega_in;
-   F.params = &params;
-
-   // Integrate integrand function from 0 to 2\pi. 
-   // We request a absolute error of 0 and a relative error $10^{-13}$.
-   // We request a absolute error of 0 and a relative error $10^{-10}$, since
-   // 10^{-13} seems to be too much...
-   gsl_integration_qags (&F, 0, 2*M_PI, 0, 1.e-10, 1000, w, &result, &error);
+   double y[DIMRED];
+   int status;
+
+   y[0] = x[0];		// l
+   y[1] = x[1];		// L
+   y[2] = x[2];		// g
+   y[3] = x[3];		// G
+   y[4] = 0;		// t
+   y[5] = 0;		// I (not used).
+
+   // Integrate f0 along the trajectory from 0 to 2\pi, in a single pass.
+   // We request a relative error $10^{-10}$, since 10^{-13} seems to be too
+   // much...
+   status = pquad(mu, frtbp_red_l, DIMRED, y, 2*M_PI, 0, f0, &mu, 1.e-10,
+	 &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
-   gsl_integration_workspace_free (w);
-
    *omega = result;		// \omega_in^b
-   return 0;
+   return status;
 }
 
 // name OF FUNCTION: integrand_inner_circ
@@ -158,6 +136,9 @@ int omega_in_b(double mu, double x[DIM], double *omega)
 //
 //    \frac{1}{L^{-3}+\mu\partial_L \Delta H_{circ}(\gamma(s))}.
 //
+// The integrand is evaluated at the point x=\gamma(s) of the trajectory, as
+// required by pquad.
+//
 // NOTE: This function is not used anymore, since $T_0$ (inner map of circular
 // problem) is actually computed from the period of the periodic orbit:
 //
@@ -165,65 +146,41 @@ int omega_in_b(double mu, double x[DIM], double *omega)
 //
 // PARAMETERS
 // ==========
-// s
-//    integration time in the periodic trajectory.
-// mu
-//    mass parameter for the RTBP
 // x
-//    periodic point, 4 coordinates:
+//    point \gamma(s) of the periodic trajectory, 4 coordinates:
 //    (l,L,g,G). 
+// f
+//    On return, the integrand
+//    $\frac{1}{L^{-3}+\mu\partial_L \Delta H_{circ}}$ evaluated at x.
+// params
+//    pointer to mu, mass parameter for the RTBP
 // 
 // RETURN VALUE
 // ============
-// Returns the integrand $\frac{1}{L^{-3}+\mu\partial_L \Delta H_{circ}}$
-// evaluated at the point $\gamma(s)$.
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
 //
 // NOTES
 // =====
 //
-// CALLS TO: frtbp_red, dot_l
+// CALLS TO: dot_l
 
 /**
   Integrand of inner circular problem.
   */
-double integrand_inner_circ(double s, void *params)
+int integrand_inner_circ(const double *x, double *f, void *params)
 {
-   double mu;
-   double x[DIMRED];
-
-   // auxiliary variables
-   int i,status;
-   double x2[DIM];
    double dl;		// \dot l
 
-   mu = ((struct iparams_inner_circ *)params)->mu;
-
-   x[0] = ((struct iparams_inner_circ *)params)->x[0]; 	// l
-   x[1] = ((struct iparams_inner_circ *)params)->x[1]; 	// L
-   x[2] = ((struct iparams_inner_circ *)params)->x[2]; 	// g
-   x[3] = ((struct iparams_inner_circ *)params)->x[3]; 	// G
-
-   x[4] = 0;	// t
-   x[5] = 0;	// I (not used).
-
-   // Compute x = \gamma(s)
-   status = frtbp_red_l(mu,s,x);
-   if(status)
-   {
-      fprintf(stderr, "integrand: error integrating trajectory");
-      exit(EXIT_FAILURE);
-   }
-
    // Compute the denominator $L^{-3}+\mu\partial_L \Delta H_{circ}}$.
    // This is just the $\dot l$ component in the nonreduced vector field.
-   for(i=0;i<DIM;i++) x2[i]=x[i];
-   status = dot_l(x2,&dl,&mu);
-   if(status)
+   if(dot_l(x,&dl,params))
    {
       fprintf(stderr, "integrand_inner_circ: error computing dot_l");
-      exit(EXIT_FAILURE);
+      return(1);
    }
-   return 1.0/dl;
+   *f = 1.0/dl;
+   return(0);
 }
 
 // NOTE: This function is not used anymore, since $T_0$ (inner map of circular
@@ -237,30 +194,25 @@ double integrand_inner_circ(double s, void *params)
 int inner_circ(double mu, double x[DIM], double *T)
 {
    double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_inner_circ params;
+   double y[DIMRED];
+   int status;
 
-   params.mu = mu;
-   
-   params.x[0] = x[0];
-   params.x[1] = x[1];
-   params.x[2] = x[2];
-   params.x[3] = x[3];
-
-   gsl_function F;
-   F.function = &integrand_inner_circ;
-   F.params = &params;
+   y[0] = x[0];		// l
+   y[1] = x[1];		// L
+   y[2] = x[2];		// g
+   y[3] = x[3];		// G
+   y[4] = 0;		// t
+   y[5] = 0;		// I (not used).
 
    // Integrate integrand function from 0 to 6\pi. 
-   // We request a absolute error of 0 and a relative error $10^{-13}$.
-   gsl_integration_qags (&F, 0, 6*M_PI, 0, 1.e-13, 1000, w, &result, &error);
+   // The integrand is periodic along the periodic orbit, so the trapezoidal
+   // rule converges exponentially.
+   // We request a relative error $10^{-13}$.
+   status = pquad(mu, frtbp_red_l, DIMRED, y, 6*M_PI, 1,
+	 integrand_inner_circ, &mu, 1.e-13, &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
-   gsl_integration_workspace_free (w);
-
    // WARNING! this returns \mu T_0, not T_0!
    *T = result-2*M_PI;		// T_0
-   return 0;
+   return status;
 }
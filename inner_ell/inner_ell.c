@@ -56,6 +56,7 @@
 #include <gsl/gsl_integration.h>	// gsl_integration_qags
 #include <rtbpdel.h>			// rtbp_del, re_dDHell, im_dDHell
 #include <frtbpred.h>
+#include <tolprof.h>	// tolprof_tol
 
 struct iparams_inner_ell
 {
@@ -356,7 +357,8 @@ int re_inner_ell(double mu, double T, double x[DIM], double *re_A)
    // Integrate integrand function from 0 to -T. 
    // We request a absolute error of 0 and a relative error $10^{-9}$.
    // NOTE: this relative error is the same as the one used for outer_circ.
-   gsl_integration_qags (&F, 0, -T, 0, 1.e-9, 1000, w, &result, &error);
+   gsl_integration_qags (&F, 0, -T, 0, tolprof_tol(TOL_QUAD,1.e-9), 1000, w,
+	 &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
    gsl_integration_workspace_free (w);
@@ -425,7 +427,8 @@ int im_inner_ell(double mu, double T, double x[DIM], double *im_A)
    // Integrate integrand function from 0 to -T. 
    // We request a absolute error of 0 and a relative error $10^{-9}$.
    // NOTE: this relative error is the same as the one used for outer_circ.
-   gsl_integration_qags (&F, 0, -T, 0, 1.e-9, 1000, w, &result, &error);
+   gsl_integration_qags (&F, 0, -T, 0, tolprof_tol(TOL_QUAD,1.e-9), 1000, w,
+	 &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
    gsl_integration_workspace_free (w);
@@ -47,12 +47,12 @@
 
 #include <stdio.h>	// perror
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
-
-#include <gsl/gsl_integration.h>	// gsl_integration_qags
+#include <math.h>	// sin, cos
 
 #include <utils_module.h>	// dblcpy
 #include <rtbpdel.h>		// dot_g, re_DHell, im_DHell
 #include <frtbpred.h>
+#include <pquad.h>		// pquad
 
 struct iparams_inner_ell_stoch
 {
@@ -60,6 +60,9 @@ struct iparams_inner_ell_stoch
    double x[DIM];
 };
 
+int re_f_inner_ell_stoch(const double *x, double *f, void *params);
+int im_f_inner_ell_stoch(const double *x, double *f, void *params);
+
 // name OF FUNCTION: re_f_integrand_stoch
 //
 // PURPOSE
@@ -297,6 +300,65 @@ double im_integrand_inner_ell_stoch(double s, void *params)
    return re_f*cos(t) - im_f*sin(t);
 }
 
+// name OF FUNCTION: re_f_inner_ell_stoch
+//
+// PURPOSE
+// =======
+// Same as re_integrand_inner_ell_stoch, but evaluated at the point
+// x=\lambda(s)=(l,L,g,G,t,I) of the periodic trajectory, as required by
+// pquad. Notice that x[4] is the original time t(s).
+//
+// PARAMETERS
+// ==========
+// x
+//    point of the trajectory, 6 coordinates: (l,L,g,G,t,I).
+// f
+//    On return, the REAL part of the integrand $f(\lambda(s)) e^{it(s)}$.
+// params
+//    pointer to mu, mass parameter for the RTBP
+// 
+// RETURN VALUE
+// ============
+// Returns 0 (success).
+//
+// CALLS TO: re_f_integrand_stoch, im_f_integrand_stoch
+
+int re_f_inner_ell_stoch(const double *x, double *f, void *params)
+{
+   double mu = *(double *)params;
+   double x2[DIM];
+   double re_f, im_f;	// f(\lambda(s))
+   double t = x[4];	// original time
+
+   dblcpy(x2,x,DIM);
+   re_f = re_f_integrand_stoch(mu,x2);
+   im_f = im_f_integrand_stoch(mu,x2);
+   *f = -(re_f*sin(t) + im_f*cos(t));
+   return(0);
+}
+
+// name OF FUNCTION: im_f_inner_ell_stoch
+//
+// PURPOSE
+// =======
+// Same as im_integrand_inner_ell_stoch, but evaluated at the point
+// x=\lambda(s)=(l,L,g,G,t,I) of the periodic trajectory (see
+// re_f_inner_ell_stoch).
+
+int im_f_inner_ell_stoch(const double *x, double *f, void *params)
+{
+   double mu = *(double *)params;
+   double x2[DIM];
+   double re_f, im_f;	// f(\lambda(s))
+   double t = x[4];	// original time
+
+   dblcpy(x2,x,DIM);
+   re_f = re_f_integrand_stoch(mu,x2);
+   im_f = im_f_integrand_stoch(mu,x2);
+   *f = re_f*cos(t) - im_f*sin(t);
+   return(0);
+}
+
 // name OF FUNCTION: re_inner_ell_stoch
 // CREDIT: 
 //
@@ -333,38 +395,29 @@ double im_integrand_inner_ell_stoch(double s, void *params)
 // Returns a non-zero error code to indicate an error and 0 to indicate
 // success.
 //
-// CALLS TO: re_integrand_inner_ell_stoch
+// CALLS TO: pquad, re_f_inner_ell_stoch
 
 int re_inner_ell_stoch(double mu, double T, double x[DIM], double *re_A)
 {
    double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_inner_ell_stoch params;
-
-   params.mu = mu;
-   
-   params.x[0] = x[0];
-   params.x[1] = x[1];
-   params.x[2] = x[2];
-   params.x[3] = x[3];
+   double y[DIMRED];
+   int status;
 
-   gsl_function F;
-   F.function = &re_integrand_inner_ell_stoch;
-   F.params = &params;
+   dblcpy(y,x,DIM);
+   y[4] = 0;	// t
+   y[5] = 0;	// I (not used).
 
-   // Integrate integrand function from 0 to T. 
-   // We request a absolute error of 0 and a relative error $10^{-9}$.
+   // Integrate integrand function from 0 to T, in a single pass along the
+   // periodic trajectory. Since t(s) is not periodic, the trapezoidal rule
+   // is accelerated with Romberg's extrapolation.
+   // We request a relative error $10^{-9}$.
    // NOTE: this relative error is the same as the one used for outer_circ.
-   gsl_integration_qag (&F, 0, T, 0, 1.e-9, 1000, GSL_INTEG_GAUSS61, w,
-           &result, &error);
+   status = pquad(mu, frtbp_red_g, DIMRED, y, T, 0, re_f_inner_ell_stoch, &mu,
+	 1.e-9, &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
-   gsl_integration_workspace_free (w);
-
    *re_A = result;		// real(A^+)
-   return 0;
+   return status;
 }
 
 // name OF FUNCTION: im_inner_ell_stoch
@@ -379,31 +432,22 @@ int re_inner_ell_stoch(double mu, double T, double x[DIM], double *re_A)
 int im_inner_ell_stoch(double mu, double T, double x[DIM], double *im_A)
 {
    double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_inner_ell_stoch params;
-
-   params.mu = mu;
-   
-   params.x[0] = x[0];
-   params.x[1] = x[1];
-   params.x[2] = x[2];
-   params.x[3] = x[3];
+   double y[DIMRED];
+   int status;
 
-   gsl_function F;
-   F.function = &im_integrand_inner_ell_stoch;
-   F.params = &params;
+   dblcpy(y,x,DIM);
+   y[4] = 0;	// t
+   y[5] = 0;	// I (not used).
 
-   // Integrate integrand function from 0 to T. 
-   // We request a absolute error of 0 and a relative error $10^{-9}$.
+   // Integrate integrand function from 0 to T, in a single pass along the
+   // periodic trajectory. Since t(s) is not periodic, the trapezoidal rule
+   // is accelerated with Romberg's extrapolation.
+   // We request a relative error $10^{-9}$.
    // NOTE: this relative error is the same as the one used for outer_circ.
-   gsl_integration_qag (&F, 0, T, 0, 1.e-9, 1000, GSL_INTEG_GAUSS61, w,
-           &result, &error);
+   status = pquad(mu, frtbp_red_g, DIMRED, y, T, 0, im_f_inner_ell_stoch, &mu,
+	 1.e-9, &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
-   gsl_integration_workspace_free (w);
-
    *im_A = result;		// imaginary(A^+)
-   return 0;
+   return status;
 }
@@ -15,6 +15,9 @@
 #include <prtbp_nl_2d_module.h>	// prtbp_nl_2d, prtbp_nl_2d_inv
 
 #include <utils_module.h>   // dblcpy
+#include <rootstop.h>	// rootstop_t, rootstop_interval
+#include <tolprof.h>	// tolprof_tol
+#include "intersec.h"	// intersec_h_unst, intersec_h_st
 
 /// Tolerance (precision) for bisection method 
 const double BISECT_TOL=1.e-15;
@@ -27,6 +30,7 @@ struct dparams
    double p[2];		// fixed point
    double v[2];		// unstable/stable vector
    double n;		// num. of iteration in the unstable/stable dir.
+   int cuts;		// num. of cuts with the section per iteration
    double l;		// axis line
 };
 
@@ -34,6 +38,8 @@ double
 distance_f_unst (double h, void *params);
 double
 distance_f_st (double h, void *params);
+int
+bisect_distance (gsl_function *f, double h1, double h2, double *h);
 
 int
 print_state (size_t iter, gsl_root_fsolver * s)
@@ -136,75 +142,18 @@ int intersec_unst(double mu, double H, double p[2], double v[2],
       double lambda, int n, double h1, double h2, double l,
       double *h, double p_u[DIM], double *t, double z[DIM])
 {
-   const gsl_root_fsolver_type *T;
-   gsl_root_fsolver *s;
-
-   struct dparams params;
-   params.mu = mu;
-   params.H = H;
-   params.p[0] = p[0];
-   params.p[1] = p[1];
-   params.v[0] = v[0];
-   params.v[1] = v[1];
-   params.n = n;
-   params.l = l;
-   gsl_function f = {&distance_f_unst, &params};
-
-   // auxiliary variables
-   double htmp;
-
-   // For some reason, bisection method complains that interval [h1,h2] does
-   // not straddle 0, so we try to enlarge it a little bit.
-   //h1 *= 0.999;
-   //h2 /= 0.999;
-
-   if(h2<h1)
-   {
-	   htmp = h1;
-	   h1 = h2;
-	   h2 = htmp;
-   }
-
-   T = gsl_root_fsolver_brent;
-   s = gsl_root_fsolver_alloc (T);
-   gsl_root_fsolver_set (s, &f, h1, h2);
-
    // auxiliary vars
    int status;
-   size_t iter = 0;
-   double x_lo, x_hi;
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
-   //print_state (iter, s);
-
-    do
-      {
-	iter++;
-	status = gsl_root_fsolver_iterate (s);
-	if (status)   /* check if solver is stuck */
-	  break;
-  
-	x_lo = gsl_root_fsolver_x_lower(s);
-	x_hi = gsl_root_fsolver_x_upper(s);
+   status = intersec_h_unst(mu, H, p, v, n, 4, h1, h2, l, h);
 
-	// epsabs=BISECT_TOL, epsrel=0
-	status =
-	  gsl_root_test_interval (x_lo, x_hi, BISECT_TOL, 0);
-        //print_state (iter, s);
-      }
-    while (status == GSL_CONTINUE && iter < 1000);
-
-    //fprintf (stderr, "status = %s\n", gsl_strerror (status));
-
-    // the root is:
-    *h = gsl_root_fsolver_root(s);
-
-    // If bisection did not converge, warn calling function.
-    // In this case, the root is updated to the closest zero, 
-    // but we don't compute further results, which would be unaccurate (ps,
-    // pu, z)
-    if(status != GSL_SUCCESS)
+   // If bisection did not converge, warn calling function.
+   // In this case, the root is updated to the closest zero, 
+   // but we don't compute further results, which would be unaccurate (ps,
+   // pu, z)
+   if(status)
        return(2);
 
    // Compute the following:
@@ -243,9 +192,79 @@ int intersec_st(double mu, double H, double p[2], double v[2],
       double lambda, int n, double h1, double h2, double l,
       double *h, double p_s[DIM], double *t, double z[DIM])
 {
-   const gsl_root_fsolver_type *T;
-   gsl_root_fsolver *s;
+   // auxiliary vars
+   int status;
+
+   // Find a root of the distance function, i.e. an intersection point of
+   // the manifolds (using a bisection method).
+   status = intersec_h_st(mu, H, p, v, n, 4, h1, h2, l, h);
+
+   // If bisection did not converge, warn calling function.
+   // In this case, the root is updated to the closest zero, 
+   // but we don't compute further results, which would be unaccurate (ps,
+   // pu, z)
+   if(status)
+       return(2);
+
+   // Compute the following:
+   // - point p_s
+
+   p_s[0] = p[0] + (*h) * v[0];	// x
+   p_s[1] = 0;					// y
+   p_s[2] = p[1] + (*h) * v[1];	// px
+   status=hinv(mu,SEC2,H,p_s);
+   if(status)
+   {
+      fprintf(stderr, "intersec: error lifting point\n");
+      return(1);
+   }
+
+   // - intersection point z = P^{-1}(p_s),
+   // - t: integration time to reach homoclinic point $z$.
+
+   dblcpy(z, p_s, DIM);
+   status=prtbp_nl_inv(mu,SEC2,4*n,z,t); 	// $z = P^{-n}(z)$
+   if(status)
+      {
+	 fprintf(stderr, "intersec: error computing intersection point\n");
+	 return(1);
+      }
+   return(0);
+}
+
+/**
+  Root of the distance function along the unstable segment.
 
+  This is the root-finding part of \ref intersec_unst: it computes the
+  displacement $h^*$ such that
+     \f[ p_x(P^n(p+h^* v))=l, \f]
+  but it does not lift $p_u$ nor integrate the homoclinic orbit. 
+  Callers that need the orbit (e.g. the homoclinic pipeline, which also
+  integrates the variational equations along it) can then integrate it once
+  themselves.
+
+  \param[in] mu         mass parameter for the RTBP
+  \param[in] H          energy value
+  \param[in] p          fixed point $p=(x,p_x)$
+  \param[in] v          eigenvector associated to unstable direction
+  \param[in] n          number of iterations by the Poincare map
+  \param[in] cuts       number of cuts with the section per iteration
+  \param[in] h1,h2      interval bracketing the root
+  \param[in] l          line $p_x=l$ parallel to the $x$ axis.
+
+  \param[out] h
+  On exit, it contains the root found by numerical method.
+
+  \returns 
+  a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval 2 	Bisection procedure did not converge
+*/
+
+int intersec_h_unst(double mu, double H, double p[2], double v[2], int n,
+      int cuts, double h1, double h2, double l, double *h)
+{
    struct dparams params;
    params.mu = mu;
    params.H = H;
@@ -254,16 +273,67 @@ int intersec_st(double mu, double H, double p[2], double v[2],
    params.v[0] = v[0];
    params.v[1] = v[1];
    params.n = n;
+   params.cuts = cuts;
+   params.l = l;
+   gsl_function f = {&distance_f_unst, &params};
+
+   return(bisect_distance(&f, h1, h2, h));
+}
+
+/**
+  Root of the distance function along the stable segment.
+
+  Exactly as \ref intersec_h_unst.
+  */
+
+int intersec_h_st(double mu, double H, double p[2], double v[2], int n,
+      int cuts, double h1, double h2, double l, double *h)
+{
+   struct dparams params;
+   params.mu = mu;
+   params.H = H;
+   params.p[0] = p[0];
+   params.p[1] = p[1];
+   params.v[0] = v[0];
+   params.v[1] = v[1];
+   params.n = n;
+   params.cuts = cuts;
    params.l = l;
    gsl_function f = {&distance_f_st, &params};
 
-   // auxiliary variables
+   return(bisect_distance(&f, h1, h2, h));
+}
+
+// name OF FUNCTION: bisect_distance
+//
+// PURPOSE
+// =======
+// Find a root of the distance function "f" in the interval (h1,h2) using
+// Brent's method, up to a precision of BISECT_TOL, or until the bracket
+// stagnates at machine precision (see rootstop_interval).
+//
+// RETURN VALUE
+// ============
+// Returns 0 if the method converged, and 2 otherwise. In both cases, "h"
+// holds the best approximation to the root found so far.
+
+int
+bisect_distance (gsl_function *f, double h1, double h2, double *h)
+{
+   const gsl_root_fsolver_type *T;
+   gsl_root_fsolver *s;
+
+   // auxiliary vars
+   int status;
+   size_t iter = 0;
+   double x_lo, x_hi;
    double htmp;
+   rootstop_t rs;
 
    // For some reason, bisection method complains that interval [h1,h2] does
    // not straddle 0, so we try to enlarge it a little bit.
-   //h1 *= 0.9;
-   //h2 /= 0.9;
+   //h1 *= 0.999;
+   //h2 /= 0.999;
 
    if(h2<h1)
    {
@@ -274,12 +344,8 @@ int intersec_st(double mu, double H, double p[2], double v[2],
 
    T = gsl_root_fsolver_brent;
    s = gsl_root_fsolver_alloc (T);
-   gsl_root_fsolver_set (s, &f, h1, h2);
-
-   // auxiliary vars
-   int status;
-   size_t iter = 0;
-   double x_lo, x_hi;
+   gsl_root_fsolver_set (s, f, h1, h2);
+   rootstop_init(&rs, tolprof_tol(TOL_ROOT, BISECT_TOL));
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
@@ -296,48 +362,23 @@ int intersec_st(double mu, double H, double p[2], double v[2],
 	x_hi = gsl_root_fsolver_x_upper(s);
 
 	// epsabs=BISECT_TOL, epsrel=0
-	status =
-	  gsl_root_test_interval (x_lo, x_hi, BISECT_TOL, 0);
+	status = rootstop_interval (&rs, x_lo, x_hi);
         //print_state (iter, s);
       }
     while (status == GSL_CONTINUE && iter < 1000);
 
     //fprintf (stderr, "status = %s\n", gsl_strerror (status));
+    if (status == GSL_SUCCESS && rs.flag == ROOTSTOP_PREC)
+      fprintf (stderr, "bisect_distance: converged to machine precision, "
+	    "bracket width %e\n", x_hi-x_lo);
 
     // the root is:
     *h = gsl_root_fsolver_root(s);
+    gsl_root_fsolver_free (s);
 
-    // If bisection did not converge, warn calling function.
-    // In this case, the root is updated to the closest zero, 
-    // but we don't compute further results, which would be unaccurate (ps,
-    // pu, z)
     if(status != GSL_SUCCESS)
        return(2);
-
-   // Compute the following:
-   // - point p_s
-
-   p_s[0] = p[0] + (*h) * v[0];	// x
-   p_s[1] = 0;					// y
-   p_s[2] = p[1] + (*h) * v[1];	// px
-   status=hinv(mu,SEC2,H,p_s);
-   if(status)
-   {
-      fprintf(stderr, "intersec: error lifting point\n");
-      return(1);
-   }
-
-   // - intersection point z = P^{-1}(p_s),
-   // - t: integration time to reach homoclinic point $z$.
-
-   dblcpy(z, p_s, DIM);
-   status=prtbp_nl_inv(mu,SEC2,4*n,z,t); 	// $z = P^{-n}(z)$
-   if(status)
-      {
-	 fprintf(stderr, "intersec: error computing intersection point\n");
-	 return(1);
-      }
-   return(0);
+    return(0);
 }
 
 // name OF FUNCTION: distance_f
@@ -365,6 +406,7 @@ int intersec_st(double mu, double H, double p[2], double v[2],
 //    p: fixed point
 //    v_u: unstable vector
 //    n: number of iterations of the Poincare map.
+//    cuts: number of cuts with the section per iteration.
 //    l: axis line
 // f
 //    On return of the this function, it holds the value
@@ -387,6 +429,7 @@ distance_f_unst (double h, void *params)
    double v[2];		// unstable vector
 
    double n; 			// num. of interations in the unstable dir.
+   int cuts;			// num. of cuts per iteration
    double l;		// axis line
 
    double p_u[DIM]; 		// point in the unstable segment
@@ -407,6 +450,7 @@ distance_f_unst (double h, void *params)
    v[1] = (((struct dparams *)params)->v)[1];
 
    n = ((struct dparams *)params)->n;
+   cuts = ((struct dparams *)params)->cuts;
    l = ((struct dparams *)params)->l;
 
    // Set up point in the unstable segment
@@ -421,7 +465,7 @@ distance_f_unst (double h, void *params)
    }
 
    // unstable manifold
-   status=prtbp_nl(mu,SEC2,4*n,p_u,&t);       // $p_u = P^{n}(p_u)$
+   status=prtbp_nl(mu,SEC2,cuts*n,p_u,&t);       // $p_u = P^{n}(p_u)$
    if(status)
    {
       fprintf(stderr, "distance_f: error computing Poincare map\n");
@@ -441,6 +485,7 @@ distance_f_st (double h, void *params)
    double v[2];			// stable vector
 
    double n; 			// num. of interations in the stable dir.
+   int cuts;			// num. of cuts per iteration
    double l; 			// axis line
 
    double p_s[DIM]; 		// point in the stable segment
@@ -461,6 +506,7 @@ distance_f_st (double h, void *params)
    v[1] = (((struct dparams *)params)->v)[1];
 
    n = ((struct dparams *)params)->n;
+   cuts = ((struct dparams *)params)->cuts;
    l = ((struct dparams *)params)->l;
 
    // Set up point in the stable segment
@@ -475,7 +521,7 @@ distance_f_st (double h, void *params)
    }
 
    // stable manifold
-   status=prtbp_nl_inv(mu,SEC2,4*n,p_s,&t);       // $p_s = P^{-n}(p_s)$
+   status=prtbp_nl_inv(mu,SEC2,cuts*n,p_s,&t);       // $p_s = P^{-n}(p_s)$
    if(status)
    {
       fprintf(stderr, "distance_f: error computing Poincare map\n");
@@ -6,3 +6,7 @@ int intersec_unst(double mu, double H, double p[2], double v[2],
 int intersec_st(double mu, double H, double p[2], double v[2], 
       double lambda, int n, double h1, double h2, double l,
       double *h, double p_s[DIM], double *t, double z[DIM]);
+int intersec_h_unst(double mu, double H, double p[2], double v[2], int n,
+      int cuts, double h1, double h2, double l, double *h);
+int intersec_h_st(double mu, double H, double p[2], double v[2], int n,
+      int cuts, double h1, double h2, double l, double *h);
@@ -48,15 +48,23 @@
 //    - point p_u,
 //    - integration time t_u to reach the intersection point z, 
 //    - intersection point z = P(p_u).
+//
+// 2.4. If a store file is given (usage: intersec [storefile]), integrate the
+// homoclinic orbit from p_u to z once more, and append it to the store file
+// as a trajectory store with Delaunay elements (see htraj_build). There is
+// one store per output line, so Lbound, ebound and outer_circ_stoch can
+// evaluate the orbit from the store instead of integrating it again.
 
 #include <stdio.h>
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
 #include <rtbp.h>	// DIM
+#include <frtbp.h>	// frtbp
+#include <htraj.h>	// htraj_t, htraj_build, htraj_write
 #include <utils_module.h>	// dblprint
 
 #include "intersec.h"
 
-int main( )
+int main(int argc, char *argv[])
 {
    double mu, H;
 
@@ -84,6 +92,9 @@ int main( )
 
    double t;		// integration time to reach z from p_u/p_s
 
+   FILE *fstore = NULL;	// store file (if given)
+   htraj_t tr;		// homoclinic orbit from p_u to z
+
    // auxiliary vars
    int status;
 
@@ -94,6 +105,12 @@ int main( )
       exit(EXIT_FAILURE);
    }
 
+   if(argc > 1 && (fstore = fopen(argv[1], "wb")) == NULL)
+   {
+      perror("main: error opening store file");
+      exit(EXIT_FAILURE);
+   }
+
    while(scanf("%le %le %le %le %le %le %d %le %le", 
 	    &H, p, p+1, v, v+1, &lambda, &n, &h1, &h2) == 9)
    {
@@ -128,6 +145,25 @@ int main( )
       printf("%.15le ", t);
       dblprint(z,DIM);
       printf("\n");
+
+      // 4. Store the homoclinic orbit.
+      if(fstore != NULL)
+      {
+	 if(htraj_build(&tr, mu, frtbp, DIM, 1, p_u, t, HTRAJ_SEGLEN))
+	 {
+	    fprintf(stderr, "main: error storing homoclinic orbit\n");
+	    exit(EXIT_FAILURE);
+	 }
+	 status = htraj_write(fstore, &tr);
+	 htraj_free(&tr);
+	 if(status)
+	    exit(EXIT_FAILURE);
+      }
+   }
+   if(fstore != NULL && fclose(fstore))
+   {
+      perror("main: error writing store file");
+      exit(EXIT_FAILURE);
    }
    exit(EXIT_SUCCESS);
 }
@@ -31,6 +31,8 @@
 
 #include <rtbp.h>		// DIM
 #include <prtbpdel_2d.h>	// prtbp_del_2d, prtbp_del_2d_inv
+#include <rootstop.h>		// rootstop_t, rootstop_interval
+#include <tolprof.h>		// tolprof_tol
 
 // Tolerance (precision) for bisection method 
 const double BISECT_TOL=1.e-15;
@@ -170,9 +172,11 @@ int intersec_del_unst(double mu, double H, double p[2], double v[2],
    int status;
    size_t iter = 0;
    double x_lo, x_hi;
+   rootstop_t rs;
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
+   rootstop_init(&rs, tolprof_tol(TOL_ROOT, BISECT_TOL));
    print_state (iter, s);
 
     do
@@ -186,13 +190,14 @@ int intersec_del_unst(double mu, double H, double p[2], double v[2],
 	x_hi = gsl_root_fsolver_x_upper(s);
 
 	// epsabs=BISECT_TOL, epsrel=0
-	status =
-	  gsl_root_test_interval (x_lo, x_hi, BISECT_TOL, 0);
+	status = rootstop_interval (&rs, x_lo, x_hi);
         print_state (iter, s);
       }
     while (status == GSL_CONTINUE && iter < 1000);
 
     fprintf (stderr, "status = %s\n", gsl_strerror (status));
+    if (rs.flag == ROOTSTOP_PREC)
+      fprintf (stderr, "converged to machine precision\n");
 
     // the root is:
     *h = gsl_root_fsolver_root(s);
@@ -250,9 +255,11 @@ int intersec_del_st(double mu, double H, double p[2], double v[2],
    int status;
    size_t iter = 0;
    double x_lo, x_hi;
+   rootstop_t rs;
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
+   rootstop_init(&rs, tolprof_tol(TOL_ROOT, BISECT_TOL));
    print_state (iter, s);
 
     do
@@ -266,13 +273,14 @@ int intersec_del_st(double mu, double H, double p[2], double v[2],
 	x_hi = gsl_root_fsolver_x_upper(s);
 
 	// epsabs=BISECT_TOL, epsrel=0
-	status =
-	  gsl_root_test_interval (x_lo, x_hi, BISECT_TOL, 0);
+	status = rootstop_interval (&rs, x_lo, x_hi);
         print_state (iter, s);
       }
     while (status == GSL_CONTINUE && iter < 1000);
 
     fprintf (stderr, "status = %s\n", gsl_strerror (status));
+    if (rs.flag == ROOTSTOP_PREC)
+      fprintf (stderr, "converged to machine precision\n");
 
     // the root is:
     *h = gsl_root_fsolver_root(s);
@@ -18,6 +18,8 @@
 #include <lift.h>
 #include <utils_module.h>	// dblcpy
 #include <section.h>	    // section_t, branch_t
+#include <rootstop.h>	    // rootstop_t, rootstop_residual
+#include <tolprof.h>	    // tolprof_tol
 
 /// Tolerance (precision) for bisection method.
 //
@@ -261,7 +263,9 @@ int iterate_del_car_st(double mu, section_t sec, double H, int n,
      distance(h_u) = l - p_x(P^n(p+h_u v_u)).
 
   \remark
-  We ask for precision of BISECT_TOL in the homoclinc point.
+  We ask for precision of BISECT_TOL in the homoclinc point. The bisection
+  also stops (successfully) when the root has converged to machine
+  precision, see \ref rootstop_residual.
   
   \param[in] mu         mass parameter for the RTBP
   \param[in] sec        Poincare section: sec={SEC1,SEC2}
@@ -342,6 +346,7 @@ int intersec_del_car_unst(double mu, section_t sec, branch_t br, double H,
    size_t iter = 0;
    double d;    // distance to symmetry line
    double x_lo, x_hi;
+   rootstop_t rs;
 
    /*
 	fprintf(stderr, "P(0): %.15le, P(1): %.15le\n", p0[0] + h1*(p1[0]-p0[0]), 
@@ -354,6 +359,7 @@ int intersec_del_car_unst(double mu, section_t sec, branch_t br, double H,
    s = gsl_root_fsolver_alloc (T);
 
    gsl_root_fsolver_set (s, &f, h1, h2);
+   rootstop_init(&rs, tolprof_tol(TOL_ROOT, BISECT_TOL));
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
@@ -370,7 +376,7 @@ int intersec_del_car_unst(double mu, section_t sec, branch_t br, double H,
 		*h = gsl_root_fsolver_root(s);
 
 		d=distance_f_unst(*h,&params);
-		status = gsl_root_test_residual(d,BISECT_TOL);
+		status = rootstop_residual(&rs,*h,d);
 
 
         /*
@@ -387,6 +393,9 @@ int intersec_del_car_unst(double mu, section_t sec, branch_t br, double H,
     gsl_root_fsolver_free (s);
 
     //fprintf (stderr, "status = %s\n", gsl_strerror (status));
+    if(status == GSL_SUCCESS && rs.flag == ROOTSTOP_PREC)
+       fprintf(stderr, "intersec_del_car_unst: converged to machine "
+	     "precision, latest residual: %.15e\n", d);
 
     // If bisection did not converge, warn calling function.
     // In this case, the root is updated to the closest zero, 
@@ -453,6 +462,7 @@ int intersec_del_car_st(double mu, section_t sec, branch_t br, double H,
    size_t iter = 0;
    double d;    // distance to symmetry line
    double x_lo, x_hi;
+   rootstop_t rs;
 
    /*
 	fprintf(stderr, "P(0): %.15le, P(1): %.15le\n", p0[0] + h1*(p1[0]-p0[0]), 
@@ -465,6 +475,7 @@ int intersec_del_car_st(double mu, section_t sec, branch_t br, double H,
    s = gsl_root_fsolver_alloc (T);
 
    gsl_root_fsolver_set (s, &f, h1, h2);
+   rootstop_init(&rs, tolprof_tol(TOL_ROOT, BISECT_TOL));
 
    // Find a root of the distance function, i.e. an intersection point of
    // the manifolds (using a bisection method).
@@ -481,7 +492,7 @@ int intersec_del_car_st(double mu, section_t sec, branch_t br, double H,
 		*h = gsl_root_fsolver_root(s);
 
 		d=distance_f_unst(*h,&params);
-		status = gsl_root_test_residual(d,BISECT_TOL);
+		status = rootstop_residual(&rs,*h,d);
 
 
         /*
@@ -498,6 +509,9 @@ int intersec_del_car_st(double mu, section_t sec, branch_t br, double H,
     gsl_root_fsolver_free (s);
 
     //fprintf (stderr, "status = %s\n", gsl_strerror (status));
+    if(status == GSL_SUCCESS && rs.flag == ROOTSTOP_PREC)
+       fprintf(stderr, "intersec_del_car_st: converged to machine "
+	     "precision, latest residual: %.15e\n", d);
 
     // If bisection did not converge, warn calling function.
     // In this case, the root is updated to the closest zero, 
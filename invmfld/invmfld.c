@@ -24,6 +24,8 @@
 #include <prtbp_nl.h>	// prtbp_nl, prtbp_nl_inv
 #include <errmfld.h>
 #include "disc.h"	// disc
+#include <pmfld.h>	// pmfld_build, pmfld_domain, pmfld_eval
+#include "mfldset.h"	// mfldset_t, mfldset_open, mfldset_write
 
 /// Number of points in discretization of linear segment
 const int NPOINTS = 100; 
@@ -49,6 +51,24 @@ const int NPOINTS = 100;
 
   Output params (stdout): sequence of points approximating the manifold.
 
+  Usage: invmfld [-p order] [dataset]
+
+  With option -p, the linear segment from $p+hv$ to $P(p+hv)$ is replaced by
+  a fundamental domain of the parameterization $W(s)$ of the local manifold
+  of the given order (see \ref pmfld_build), with scale $\tau=|h|$: the
+  points are $W(s)$, with s equally spaced in $[\sigma/\lambda,\sigma]$
+  (resp. $[\sigma\lambda,\sigma]$ for the stable manifold), where
+  $\sigma$ (with the sign of h) is the largest parameter with invariance
+  error below PMFLD_TOL (see \ref pmfld_domain). The fundamental domain is
+  then much farther from $p$, and fewer iterates are needed.
+
+  If the name of a manifold dataset is given (see \ref mfldset.h), the
+  iterates are appended to it instead of printed to stdout. If the dataset
+  already holds m iterates of the same manifold (same mu, sec, H, k, h,
+  stable and NPOINTS; with option -p, h is the displacement $\sigma\tau$
+  of the end of the fundamental domain), only the iterates m+1,...,n are
+  computed, starting from the last stored one.
+
   \remark
   If the flag "stable" specifies the unstable manifold (0), we iterate the
   forward Poincare map $P$.
@@ -61,7 +81,7 @@ const int NPOINTS = 100;
 // NOTE: instead of passing h as a parameter, it would be better to call
 // h_opt().
 
-int main( )
+int main(int argc, char *argv[])
 {
    double mu, H;
    section_t sec;
@@ -91,6 +111,15 @@ int main( )
 
    double err;		// error commited in approximating the manifold
 
+   mfldset_t ms;	// parameters of the dataset
+   FILE *fp = NULL;	// dataset (NULL: print to stdout)
+   int start = 0;	// number of iterates already in the dataset
+
+   int order = 0;	// order of the parameterization (0: linear segment)
+   pmfld_t pm;		// parameterization of the local manifold
+   double sigma = 0;	// end of the fundamental domain $W([sigma/rho,sigma])$
+   int arg = 1;
+
    // Auxiliary variables
    int status, iter, i, j;
    double ti;
@@ -114,8 +143,49 @@ int main( )
       exit(EXIT_FAILURE);
    }
 
-   // Estimate error commited in the linear approximation of the manifold
-   err = err_mfld(mu,sec,H,k,p,v,lambda,stable,h);
+   // Parameterization of the local manifold
+   if(argc > 2 && strcmp(argv[1], "-p") == 0)
+   {
+      order = atoi(argv[2]);
+      arg = 3;
+      if(pmfld_build(&pm, mu, sec, H, k, p, v, lambda, stable, fabs(h), order))
+      {
+	 fprintf(stderr, "main: error computing parameterization\n");
+	 exit(EXIT_FAILURE);
+      }
+      sigma = pmfld_domain(&pm, PMFLD_TOL, (h < 0 ? -1 : 1));
+      if(sigma == 0)
+	 exit(EXIT_FAILURE);
+      fprintf(stderr, "main: fundamental domain up to s=%e (h=%e)\n", sigma,
+	    sigma*fabs(h));
+   }
+
+   // Resume the iteration from an existing dataset
+   if(argc > arg)
+   {
+      ms.mu = mu;
+      ms.H = H;
+      ms.sec = sec;
+      ms.k = k;
+      ms.h = (order ? sigma*fabs(h) : h);
+      ms.npoints = NPOINTS;
+      ms.stable = stable;
+      ms.ifp = 0;	// not used
+      ms.dim = DIM;
+      ms.order = order;
+      if(mfldset_open(argv[arg], &ms, l4, &start, &fp))
+      {
+	 fprintf(stderr, "main: error opening dataset %s\n", argv[arg]);
+	 exit(EXIT_FAILURE);
+      }
+      fprintf(stderr, "main: %d iterates found in dataset\n", start);
+   }
+
+   // Estimate error commited in the approximation of the manifold
+   if(order)
+      err = pmfld_err(&pm, sigma);
+   else
+      err = err_mfld(mu,sec,H,k,p,v,lambda,stable,h);
    fprintf(stderr,"Estimated error of manifold: %le\n", err);
 
    // 2. Discretize the linear segment between $p0=p+hv$ and $p1=P(p0)$ into
@@ -126,37 +196,55 @@ int main( )
    //h=1.e-6;
    //fprintf(stderr, "h: %le\n", h);
 
-   // Compute $p_0$
-   p0[0] = p[0] + h*v[0]; 
-   p0[1] = p[1] + h*v[1];
-
-   // Compute $p_1$
-   p1[0] = p0[0];
-   p1[1] = p0[1];
-   if(!stable) 	// unstable manifold
-      status=prtbp_nl_2d(mu,sec,H,k,p1,&ti); 	// $p_1 = P(p_0)$
-   else 	// stable manifold
-      status=prtbp_nl_2d_inv(mu,sec,H,k,p1,&ti);	// $p_1 = P^{-1}(p_0)$
-   if(status)
+   // The segment is only needed if the iteration is not resumed from the
+   // dataset.
+   if(start == 0 && order)
    {
-      fprintf(stderr, "main: error computing Poincare map\n");
-      return(1);
+      // Fundamental domain of the parameterization
+      for(i=0; i<NPOINTS; i++)
+	 pmfld_eval(&pm, sigma/pm.rho + i*(sigma-sigma/pm.rho)/(NPOINTS-1),
+	       l+2*i);
+      status = lift(mu, sec, H, NPOINTS, l, l4);
+      if(status)
+      {
+	 fprintf(stderr, "main: error lifting point\n");
+	 return(1);
+      }
    }
+   else if(start == 0)
+   {
+      // Compute $p_0$
+      p0[0] = p[0] + h*v[0]; 
+      p0[1] = p[1] + h*v[1];
 
-   // Discretize linear segment
-   disc(p0, p1, NPOINTS, l);
+      // Compute $p_1$
+      p1[0] = p0[0];
+      p1[1] = p0[1];
+      if(!stable) 	// unstable manifold
+	 status=prtbp_nl_2d(mu,sec,H,k,p1,&ti); 	// $p_1 = P(p_0)$
+      else 	// stable manifold
+	 status=prtbp_nl_2d_inv(mu,sec,H,k,p1,&ti);	// $p_1 = P^{-1}(p_0)$
+      if(status)
+      {
+	 fprintf(stderr, "main: error computing Poincare map\n");
+	 return(1);
+      }
 
-   // Lift points in linear segment from 2d to 4d
-   status = lift(mu, sec, H, NPOINTS, l, l4);
-   if(status)
-   {
-      fprintf(stderr, "main: error lifting point\n");
-      return(1);
+      // Discretize linear segment
+      disc(p0, p1, NPOINTS, l);
+
+      // Lift points in linear segment from 2d to 4d
+      status = lift(mu, sec, H, NPOINTS, l, l4);
+      if(status)
+      {
+	 fprintf(stderr, "main: error lifting point\n");
+	 return(1);
+      }
    }
 
    // 3. Iterate the (discretized) linear segment "n" times by the Poincare map,
    // i.e. compute its orbit (and print it to stdout). 
-   for(iter=0;iter<n;iter++)
+   for(iter=start;iter<n;iter++)
    {
 	 if(!stable)	// unstable manifold
 	 {
@@ -182,6 +270,12 @@ int main( )
 	 }
 
 	 // Print iteration of linear segment
+	 if(fp != NULL)
+	 {
+		if(mfldset_write(fp, &ms, l4))
+		   exit(EXIT_FAILURE);
+		continue;
+	 }
 	 for(i=0;i<NPOINTS;i++)
 	 {
 		dblprint(l4+DIM*i, DIM);
@@ -189,6 +283,8 @@ int main( )
 	 }
 	 printf("\n");
    }
+   if(fp != NULL)
+      fclose(fp);
 
    exit(EXIT_SUCCESS);
 }
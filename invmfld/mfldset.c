@@ -0,0 +1,196 @@
+/*! \file
+  \brief Manifold Datasets: Resume the Iteration of a Manifold
+  */
+
+#include <stdio.h>	// FILE, fopen, fscanf, fprintf
+#include <stdlib.h>	// realloc, free
+#include <string.h>	// strcmp
+
+#include <section.h>	// section_t
+
+#include "mfldset.h"
+
+const int ERR_MFLDSET_IO=1;
+const int ERR_MFLDSET_FORMAT=2;
+const int ERR_MFLDSET_PARAM=3;
+
+/// Names of the sections, in the order of section_t.
+static const char *MFLDSET_SEC[] = {"SEC1", "SEC2", "SECg", "SECg2"};
+
+int mfldset_header(FILE *fp, mfldset_t *ms);
+
+int mfldset_open(const char *fname, const mfldset_t *ms, double *last,
+      int *nblocks, FILE **fp)
+{
+   const int m = ms->npoints*ms->dim;	// doubles per block
+   mfldset_t fs;	// parameters of the file
+   long n = 0;		// number of doubles read
+   double val;
+   int status;
+
+   *nblocks = 0;
+   *fp = fopen(fname, "r");
+   if(*fp != NULL)
+   {
+      status = mfldset_header(*fp, &fs);
+      if(status == 0)
+      {
+	 if(fs.mu != ms->mu || fs.H != ms->H || fs.sec != ms->sec ||
+	       fs.k != ms->k || fs.h != ms->h || fs.npoints != ms->npoints ||
+	       fs.stable != ms->stable || fs.ifp != ms->ifp ||
+	       fs.dim != ms->dim || fs.order != ms->order)
+	 {
+	    fprintf(stderr, "mfldset_open: parameters of %s do not match\n",
+		  fname);
+	    fclose(*fp);
+	    return(ERR_MFLDSET_PARAM);
+	 }
+	 // Keep the last block (the buffer is overwritten cyclically).
+	 while(fscanf(*fp, "%le", &val) == 1)
+	    last[n++ % m] = val;
+	 if(!feof(*fp) || n % m != 0)
+	 {
+	    fprintf(stderr, "mfldset_open: incomplete block in %s\n", fname);
+	    fclose(*fp);
+	    return(ERR_MFLDSET_FORMAT);
+	 }
+	 *nblocks = n/m;
+      }
+      fclose(*fp);
+      if(status > 0)
+      {
+	 fprintf(stderr, "mfldset_open: invalid header in %s\n", fname);
+	 return(ERR_MFLDSET_FORMAT);
+      }
+      if(status == 0)
+      {
+	 *fp = fopen(fname, "a");
+	 if(*fp == NULL)
+	 {
+	    fprintf(stderr, "mfldset_open: cannot open file %s\n", fname);
+	    return(ERR_MFLDSET_IO);
+	 }
+	 return(0);
+      }
+   }
+
+   // New (or empty) dataset
+   *fp = fopen(fname, "w");
+   if(*fp == NULL || fprintf(*fp, "# mfldset %.17g %.17g %s %d %.17g %d %d "
+	    "%d %d %d\n", ms->mu, ms->H, MFLDSET_SEC[ms->sec], ms->k, ms->h,
+	    ms->npoints, ms->stable, ms->ifp, ms->dim, ms->order) < 0)
+   {
+      fprintf(stderr, "mfldset_open: cannot create file %s\n", fname);
+      return(ERR_MFLDSET_IO);
+   }
+   return(0);
+}
+
+int mfldset_write(FILE *fp, const mfldset_t *ms, const double *pts)
+{
+   int i, j, ok = 1;
+
+   for(i=0; i<ms->npoints; i++)
+   {
+      for(j=0; j<ms->dim; j++)
+	 ok = ok && fprintf(fp, "% .16le ", pts[ms->dim*i+j]) > 0;
+      ok = ok && fprintf(fp, "\n") > 0;
+   }
+   ok = ok && fprintf(fp, "\n") > 0 && fflush(fp) == 0;
+   if(!ok)
+   {
+      fprintf(stderr, "mfldset_write: error writing dataset\n");
+      return(ERR_MFLDSET_IO);
+   }
+   return(0);
+}
+
+int mfldset_load(const char *fname, mfldset_t *ms, double **pts,
+      int *nblocks)
+{
+   FILE *fp;
+   long n = 0;		// number of doubles read
+   long size = 0;	// size of the array
+   long m;		// doubles per block
+   double *q;
+   double val;
+   int status = 0;
+
+   *pts = NULL;
+   *nblocks = 0;
+   fp = fopen(fname, "r");
+   if(fp == NULL)
+   {
+      fprintf(stderr, "mfldset_load: cannot open file %s\n", fname);
+      return(ERR_MFLDSET_IO);
+   }
+   if(mfldset_header(fp, ms) || ms->npoints < 1 || ms->dim < 1)
+   {
+      fprintf(stderr, "mfldset_load: invalid header in %s\n", fname);
+      fclose(fp);
+      return(ERR_MFLDSET_FORMAT);
+   }
+   m = (long)ms->npoints*ms->dim;
+   while(fscanf(fp, "%le", &val) == 1)
+   {
+      if(n == size)	// room for one more block
+      {
+	 q = realloc(*pts, (size+m)*sizeof(double));
+	 if(q == NULL)
+	 {
+	    fprintf(stderr, "mfldset_load: out of memory\n");
+	    status = ERR_MFLDSET_IO;
+	    break;
+	 }
+	 *pts = q;
+	 size += m;
+      }
+      (*pts)[n++] = val;
+   }
+   if(status == 0 && (!feof(fp) || n % m != 0))
+   {
+      fprintf(stderr, "mfldset_load: incomplete block in %s\n", fname);
+      status = ERR_MFLDSET_FORMAT;
+   }
+   fclose(fp);
+   if(status)
+   {
+      free(*pts);
+      *pts = NULL;
+      return(status);
+   }
+   *nblocks = n/m;
+   return(0);
+}
+
+// name OF FUNCTION: mfldset_header
+//
+// PURPOSE
+// =======
+// Read the header line of a dataset into fs.
+//
+// RETURN VALUE
+// ============
+// 0 if the header was read, -1 if the file is empty, and 1 if the header is
+// invalid. A header without the field order has order 0.
+
+int mfldset_header(FILE *fp, mfldset_t *fs)
+{
+   char line[256], sec[8];
+   int i;
+
+   if(fgets(line, sizeof(line), fp) == NULL)
+      return(-1);
+   fs->order = 0;
+   if(sscanf(line, "# mfldset %le %le %7s %d %le %d %d %d %d %d", &fs->mu,
+	    &fs->H, sec, &fs->k, &fs->h, &fs->npoints, &fs->stable, &fs->ifp,
+	    &fs->dim, &fs->order) < 9)
+      return(1);
+   for(i=0; i<4; i++)
+      if(strcmp(sec, MFLDSET_SEC[i]) == 0)
+	 break;
+   if(i == 4)
+      return(1);
+   fs->sec = (section_t)i;
+   return(0);
+}
@@ -0,0 +1,102 @@
+/*! \file
+  \brief Manifold Datasets: Resume the Iteration of a Manifold
+
+  A manifold dataset is the text output of \ref invmfld (blocks of npoints
+  points, one block per iterate of the fundamental segment, separated by
+  blank lines), preceded by a header line that records the parameters of
+  the computation:
+
+     # mfldset mu H sec k h npoints stable ifp dim order
+
+  The header is a comment for gnuplot. When more iterates are needed, the
+  dataset is reopened, its parameters are checked against the new run, and
+  the iteration goes on from the last stored block; only the new blocks are
+  appended.
+
+  The field order tells how the first block was seeded: 0 for the linear
+  segment from $p+hv$ to $P^{\pm 1}(p+hv)$, or the order of the
+  parameterization of the local manifold (\ref invmfld -p). Headers written
+  before this field existed have no order, and are read as order 0.
+  */
+
+#ifndef MFLDSET_H_INCLUDED
+#define MFLDSET_H_INCLUDED
+
+#include <stdio.h>	// FILE
+#include <section.h>	// section_t
+
+/** Error opening, reading or writing the dataset. */
+extern const int ERR_MFLDSET_IO;
+
+/** Invalid header, or the blocks are incomplete. */
+extern const int ERR_MFLDSET_FORMAT;
+
+/** The parameters of the dataset do not match those of the run. */
+extern const int ERR_MFLDSET_PARAM;
+
+/**
+  Parameters of a manifold dataset.
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   double H;		///< energy value
+   section_t sec;	///< Poincare section
+   int k;		///< number of cuts of the Poincare map
+   double h;		///< increment in the direction of the eigenvector
+   int npoints;		///< number of points in the fundamental segment
+   int stable;		///< 0 for the unstable manifold, 1 for the stable one
+   int ifp;		///< iterate of the fixed point printed (-1 for all)
+   int dim;		///< number of coordinates of each point
+   int order;		///< order of the parameterization (0: linear segment)
+} mfldset_t;
+
+/**
+  Open a manifold dataset for appending.
+
+  If the file does not exist (or is empty), it is created and the header is
+  written. Otherwise the header is checked against ms (the doubles must be
+  equal, since both come from the same input), and the last block is read.
+
+  \param[in] fname	name of the dataset
+  \param[in] ms		parameters of the run
+  \param[out] last	last block (npoints*dim doubles), if nblocks>0
+  \param[out] nblocks	number of blocks in the dataset
+  \param[out] fp	dataset, open for appending
+
+  \retval ERR_MFLDSET_IO	Error opening or reading the file.
+  \retval ERR_MFLDSET_FORMAT	Invalid header or incomplete block.
+  \retval ERR_MFLDSET_PARAM	The parameters do not match.
+  */
+int mfldset_open(const char *fname, const mfldset_t *ms, double *last,
+      int *nblocks, FILE **fp);
+
+/**
+  Append a block (npoints*dim doubles) to a dataset.
+
+  The points are printed with 17 significant digits, so that the iteration
+  can be resumed exactly from them.
+
+  \retval ERR_MFLDSET_IO	Error writing the file.
+  */
+int mfldset_write(FILE *fp, const mfldset_t *ms, const double *pts);
+
+/**
+  Load a whole manifold dataset.
+
+  The header is read into ms, and all the complete blocks into an array
+  allocated with malloc (nblocks*npoints*dim doubles), which the caller must
+  free.
+
+  \param[in] fname	name of the dataset
+  \param[out] ms	parameters of the dataset
+  \param[out] pts	points of the dataset, block after block
+  \param[out] nblocks	number of blocks in the dataset
+
+  \retval ERR_MFLDSET_IO	Error opening the file, or out of memory.
+  \retval ERR_MFLDSET_FORMAT	Invalid header or incomplete block.
+  */
+int mfldset_load(const char *fname, mfldset_t *ms, double **pts,
+      int *nblocks);
+
+#endif // MFLDSET_H_INCLUDED
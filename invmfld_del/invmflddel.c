@@ -43,6 +43,16 @@
 // i.e. compute its orbit (and print it to stdout). 
 //
 // 4. Estimate error commited in the linear approximation of the manifold
+//
+// USAGE
+// =====
+// invmflddel [dataset]
+//
+// If the name of a manifold dataset is given (see mfldset.h), the blocks are
+// appended to it instead of printed to stdout. If the dataset already holds
+// blocks of the same manifold (same mu, sec, H, k, h, stable, ifp and
+// NPOINTS), the iteration is resumed from the last stored block, and only
+// the missing blocks are computed.
 
 // NOTES
 // =====
@@ -71,6 +81,7 @@
 #include <prtbpdel.h>	// section_t
 #include <prtbpdel_2d.h>	// prtbp_del_2d, prtbp_del_2d_inv
 #include <disc.h>	// disc
+#include <mfldset.h>	// mfldset_t, mfldset_open, mfldset_write
 
 // Number of points in discretization of linear segment
 const int NPOINTS = 100; 
@@ -78,7 +89,7 @@ const int NPOINTS = 100;
 int err_mfld(double mu, section_t sec, double H, int k, double p[2], 
       double v[2], double lambda, int stable, double h);
 
-int main( )
+int main(int argc, char *argv[])
 {
    double mu, H;
    section_t sec;
@@ -105,8 +116,13 @@ int main( )
    // Linear segment approximating local invariant manifold
    double l[2*NPOINTS];
 
+   mfldset_t ms;	// parameters of the dataset
+   FILE *fp = NULL;	// dataset (NULL: print to stdout)
+   int start = 0;	// number of blocks already in the dataset
+   int c0 = 0;		// number of cuts already computed
+
    // Auxiliary variables
-   int status, iter, i, j;
+   int status, c, i, j;
    double ti;
    char section_str[10];        // holds input string "SEC1", "SEC2" etc
 
@@ -128,75 +144,111 @@ int main( )
       exit(EXIT_FAILURE);
    }
 
-   // 2. Discretize the linear segment between $p0=p+hv$ and $p1=P(p0)$ into
-   // a set of NPOINTS points.
+   // Resume the iteration from an existing dataset. Each block is printed
+   // after one cut (ifp==-1) or after the cuts j==ifp of each iterate.
+   if(argc > 1)
+   {
+      ms.mu = mu;
+      ms.H = H;
+      ms.sec = sec;
+      ms.k = k;
+      ms.h = h;
+      ms.npoints = NPOINTS;
+      ms.stable = stable;
+      ms.ifp = ifp;
+      ms.dim = 2;
+      ms.order = 0;	// linear segment
+      if(mfldset_open(argv[1], &ms, l, &start, &fp))
+      {
+	 fprintf(stderr, "main: error opening dataset %s\n", argv[1]);
+	 exit(EXIT_FAILURE);
+      }
+      fprintf(stderr, "main: %d blocks found in dataset\n", start);
+      if(start > 0)
+	 c0 = (ifp==-1 ? start : (start-1)*k+ifp);
+   }
 
-   // We choose the small increment $h$ such that the estimated error commited
-   // in the linear approximation of the manifold is smaller than 10^{-8}.
-   //h=1.e-6;
-   //fprintf(stderr, "h: %le\n", h);
+   if(c0 == 0)
+   {
+      // 2. Discretize the linear segment between $p0=p+hv$ and $p1=P(p0)$
+      // into a set of NPOINTS points.
 
-   // Compute $p_0$
-   p0[0] = p[0] + h*v[0]; 
-   p0[1] = p[1] + h*v[1];
+      // We choose the small increment $h$ such that the estimated error
+      // commited in the linear approximation of the manifold is smaller than
+      // 10^{-8}.
+      //h=1.e-6;
+      //fprintf(stderr, "h: %le\n", h);
 
-   // Compute $p_1$
-   p1[0] = p0[0];
-   p1[1] = p0[1];
-   if(!stable) 	// unstable manifold
-      status=prtbp_del_2d(mu,sec,H,k,p1,&ti); 	// $p_1 = P(p_0)$
-   else 	// stable manifold
-      status=prtbp_del_2d_inv(mu,sec,H,k,p1,&ti);	// $p_1 = P^{-1}(p_0)$
-   if(status)
-   {
-      fprintf(stderr, "main: error computing Poincare map\n");
-      return(1);
-   }
+      // Compute $p_0$
+      p0[0] = p[0] + h*v[0]; 
+      p0[1] = p[1] + h*v[1];
+
+      // Compute $p_1$
+      p1[0] = p0[0];
+      p1[1] = p0[1];
+      if(!stable) 	// unstable manifold
+	 status=prtbp_del_2d(mu,sec,H,k,p1,&ti); 	// $p_1 = P(p_0)$
+      else 	// stable manifold
+	 status=prtbp_del_2d_inv(mu,sec,H,k,p1,&ti);	// $p_1 = P^{-1}(p_0)$
+      if(status)
+      {
+	 fprintf(stderr, "main: error computing Poincare map\n");
+	 return(1);
+      }
 
-   // Discretize linear segment
-   disc(p0, p1, NPOINTS, l);
+      // Discretize linear segment
+      disc(p0, p1, NPOINTS, l);
+   }
 
    // 3. Iterate the (discretized) linear segment "n" times by the Poincare map,
-   // i.e. compute its orbit (and print it to stdout). 
-   for(iter=0;iter<n;iter++)
+   // i.e. compute its orbit (and print it to stdout). The cuts c=1,...,n*k
+   // are counted along the whole orbit, so that the iteration can be resumed
+   // at cut c0.
+   for(c=c0+1;c<=n*k;c++)
    {
-      for(j=1;j<=k;j++)
+      j = (c-1)%k+1;	// cut within the current iterate
+      for(i=0;i<NPOINTS;i++)
       {
-	 for(i=0;i<NPOINTS;i++)
+	 if(!stable)	// unstable manifold
 	 {
-	    if(!stable)	// unstable manifold
+	    if(prtbp_del_2d(mu,sec,H,1,l+2*i,&ti))
 	    {
-	       if(prtbp_del_2d(mu,sec,H,1,l+2*i,&ti))
-	       {
-		  fprintf(stderr, "main: error computing Poincare map\n");
-		  exit(EXIT_FAILURE);
-	       }
+	       fprintf(stderr, "main: error computing Poincare map\n");
+	       exit(EXIT_FAILURE);
 	    }
-	    else		// stable manifold
+	 }
+	 else		// stable manifold
+	 {
+	    if(prtbp_del_2d_inv(mu,sec,H,1,l+2*i,&ti))
 	    {
-	       if(prtbp_del_2d_inv(mu,sec,H,1,l+2*i,&ti))
-	       {
-		  fprintf(stderr, "main: error computing inverse Poincare map\n");
-		  exit(EXIT_FAILURE);
-	       }
+	       fprintf(stderr, "main: error computing inverse Poincare map\n");
+	       exit(EXIT_FAILURE);
 	    }
 	 }
+      }
 
-	 if(ifp==-1 || j==ifp)	// print only manifold of i-th fixed point p_i
+      if(ifp==-1 || j==ifp)	// print only manifold of i-th fixed point p_i
+      {
+	 if(fp != NULL)
+	 {
+	    if(mfldset_write(fp, &ms, l))
+	       exit(EXIT_FAILURE);
+	    continue;
+	 }
+	 // Print iteration of linear segment
+	 for(i=0;i<NPOINTS;i++)
 	 {
-	    // Print iteration of linear segment
-	    for(i=0;i<NPOINTS;i++)
+	    if(printf("% .15le % .15le\n", l[2*i], l[2*i+1])<0)
 	    {
-	       if(printf("% .15le % .15le\n", l[2*i], l[2*i+1])<0)
-	       {
-		  perror("main: error writting output");
-		  exit(EXIT_FAILURE);
-	       }
+	       perror("main: error writting output");
+	       exit(EXIT_FAILURE);
 	    }
-	    printf("\n");
 	 }
+	 printf("\n");
       }
    }
+   if(fp != NULL)
+      fclose(fp);
 
    // 4. Estimate error commited in the linear approximation of the manifold
    err_mfld(mu,sec,H,k,p,v,lambda,stable,h);
@@ -0,0 +1,260 @@
+/*! \file
+    \brief Monte Carlo Diffusion: Random Iteration of the Outer Maps
+*/
+
+#include <stdio.h>	// fprintf, fscanf
+#include <stdlib.h>	// malloc, realloc, free
+#include <stdint.h>	// uint32_t, uint64_t
+#include <math.h>	// cos, sin, floor, sqrt, fabs, M_PI
+
+#include "mcdiff.h"
+
+const int ERR_MCDIFF_TABLE=1;
+const int ERR_MCDIFF_MEM=2;
+
+/// Trajectories iterated together, step by step, by one thread.
+#define MCDIFF_BATCH 64
+
+/// Random bits per call to the generator, i.e. steps per counter value.
+#define MCDIFF_BITS 128
+
+/// Max deviation of the energies of the table from the uniform grid,
+/// relative to the step (the tables are printed with 7 digits).
+static const double MCDIFF_TOL_GRID=1.e-3;
+
+/// Quantile of the normal distribution for the 95% confidence intervals.
+static const double MCDIFF_Z95=1.959963984540054;
+
+long mcdiff_batch(const mcdiff_t *mc, const mcdiff_table_t *tab, int ih,
+      double H0, long t0, int nb, double *dh);
+
+int mcdiff_table_read(FILE *fp, mcdiff_table_t *tab)
+{
+   double H, an1, ap2;
+   double (*row)[MCDIFF_NCOL];
+   double *h = NULL;	// energies
+   double *tmp;
+   int size = 0;
+   int i;
+   double *c;
+
+   tab->n = 0;
+   tab->c = NULL;
+   for(;;)
+   {
+      if(tab->n == size)
+      {
+	 size = (size > 0 ? 2*size : 256);
+	 tmp = realloc(h, size*sizeof(double));
+	 row = realloc(tab->c, size*sizeof(*row));
+	 if(tmp != NULL)
+	    h = tmp;
+	 if(row != NULL)
+	    tab->c = row;
+	 if(tmp == NULL || row == NULL)
+	 {
+	    fprintf(stderr, "mcdiff_table_read: out of memory\n");
+	    free(h);
+	    free(tab->c);
+	    tab->c = NULL;
+	    return(ERR_MCDIFF_MEM);
+	 }
+      }
+      c = tab->c[tab->n];
+      if(fscanf(fp, "%le %le %le %le %le %le %le %le", &H, c, &an1, &ap2,
+	       c+3, c+4, c+5, c+6) != 8)
+	 break;
+      c[1] = -2*an1;	// $\alpha_1$
+      c[2] = 2*ap2;	// $\alpha_2$
+      h[tab->n++] = H;
+   }
+   if(tab->n < 2 || h[tab->n-1] <= h[0])
+   {
+      fprintf(stderr, "mcdiff_table_read: less than two energies\n");
+      free(h);
+      return(ERR_MCDIFF_TABLE);
+   }
+   tab->H0 = h[0];
+   tab->dH = (h[tab->n-1]-h[0])/(tab->n-1);
+   for(i=0; i<tab->n; i++)
+      if(fabs(h[i]-(tab->H0+i*tab->dH)) > MCDIFF_TOL_GRID*tab->dH)
+      {
+	 fprintf(stderr, "mcdiff_table_read: energy %e is off the uniform "
+	       "grid\n", h[i]);
+	 free(h);
+	 return(ERR_MCDIFF_TABLE);
+      }
+   free(h);
+   return(0);
+}
+
+int mcdiff_table_eval(const mcdiff_table_t *tab, double H,
+      double c[MCDIFF_NCOL])
+{
+   const double u = (H-tab->H0)/tab->dH;
+   double f;
+   int i, k;
+
+   if(!(u >= 0 && u <= tab->n-1))
+      return(1);
+   i = (int)u;
+   if(i == tab->n-1)
+      i--;
+   f = u-i;
+   for(k=0; k<MCDIFF_NCOL; k++)
+      c[k] = (1-f)*tab->c[i][k] + f*tab->c[i+1][k];
+   return(0);
+}
+
+int mcdiff_run(const mcdiff_t *mc, const mcdiff_table_t *tab, int ih,
+      double H0, mcdiff_stats_t *stats)
+{
+   const long nbatch = (mc->m + MCDIFF_BATCH-1)/MCDIFF_BATCH;
+   const double scale = mc->n*mc->eps*mc->eps;
+   double *dh;		// displacement of each trajectory
+   double mean, s2, m4, d;
+   long nesc = 0;	// number of escaped trajectories
+   long ib, i;
+
+   dh = malloc(mc->m*sizeof(double));
+   if(dh == NULL)
+   {
+      fprintf(stderr, "mcdiff_run: out of memory\n");
+      return(ERR_MCDIFF_MEM);
+   }
+
+   #pragma omp parallel for schedule(dynamic,1) reduction(+:nesc)
+   for(ib=0; ib<nbatch; ib++)
+   {
+      nesc += mcdiff_batch(mc, tab, ih, H0, ib*MCDIFF_BATCH,
+	    (int)(ib < nbatch-1 ? MCDIFF_BATCH : mc->m-ib*MCDIFF_BATCH),
+	    dh+ib*MCDIFF_BATCH);
+   }
+
+   // Sample mean, variance and fourth central moment of the displacement
+   mean = 0;
+   for(i=0; i<mc->m; i++)
+      mean += dh[i];
+   mean /= mc->m;
+   s2 = m4 = 0;
+   for(i=0; i<mc->m; i++)
+   {
+      d = (dh[i]-mean)*(dh[i]-mean);
+      s2 += d;
+      m4 += d*d;
+   }
+   m4 /= mc->m;
+   s2 = (mc->m > 1 ? s2/(mc->m-1) : 0);
+   free(dh);
+
+   stats->H0 = H0;
+   stats->drift = mean/scale;
+   stats->drift_ci = MCDIFF_Z95*sqrt(s2/mc->m)/scale;
+   stats->var = s2/scale;
+   stats->var_ci = MCDIFF_Z95*sqrt(fmax(m4-s2*s2, 0)/mc->m)/scale;
+   stats->escaped = (double)nesc/mc->m;
+   return(0);
+}
+
+void mcdiff_philox(const uint32_t ctr[4], const uint32_t key[2],
+      uint32_t out[4])
+{
+   const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;	// multipliers
+   const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;	// Weyl key increments
+   uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+   uint32_t k0 = key[0], k1 = key[1];
+   uint64_t p0, p1;
+   int r;
+
+   for(r=0; r<10; r++)
+   {
+      if(r > 0)
+      {
+	 k0 += W0;
+	 k1 += W1;
+      }
+      p0 = (uint64_t)M0*x0;
+      p1 = (uint64_t)M1*x2;
+      x0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+      x1 = (uint32_t)p1;
+      x2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+      x3 = (uint32_t)p0;
+   }
+   out[0] = x0;
+   out[1] = x1;
+   out[2] = x2;
+   out[3] = x3;
+}
+
+// name OF FUNCTION: mcdiff_batch
+//
+// PURPOSE
+// =======
+// Iterate the nb trajectories t0,...,t0+nb-1 from the energy H0, and store
+// their displacements in dh. The trajectories are advanced together, one
+// step at a time, so that the loop over the batch runs over contiguous
+// arrays.
+//
+// Trajectory t uses the counters (t, ih, b), with 64-bit t split in two
+// words: block b=0 gives the initial angle, and block b>0 the choices of
+// channel (one bit each) of the steps MCDIFF_BITS*(b-1),...,MCDIFF_BITS*b-1.
+//
+// RETURN VALUE
+// ============
+// Number of trajectories of the batch that left the range of the table.
+
+long mcdiff_batch(const mcdiff_t *mc, const mcdiff_table_t *tab, int ih,
+      double H0, long t0, int nb, double *dh)
+{
+   const uint32_t key[2] = {(uint32_t)mc->seed, (uint32_t)(mc->seed >> 32)};
+   double H[MCDIFF_BATCH], th[MCDIFF_BATCH];
+   uint32_t bits[MCDIFF_BATCH][4];	// random bits of the current block
+   uint32_t ctr[4];
+   double c[MCDIFF_NCOL];
+   long step, nesc = 0;
+   int b, j, w;
+
+   for(b=0; b<nb; b++)
+   {
+      ctr[0] = (uint32_t)(t0+b);
+      ctr[1] = (uint32_t)((uint64_t)(t0+b) >> 32);
+      ctr[2] = (uint32_t)ih;
+      ctr[3] = 0;
+      mcdiff_philox(ctr, key, bits[b]);
+      // 53 random bits, uniform in [0,1)
+      th[b] = 2*M_PI*((((uint64_t)bits[b][0] << 21) | (bits[b][1] >> 11))
+	    * 0x1p-53);
+      H[b] = H0;
+   }
+
+   for(step=0; step<mc->n; step++)
+   {
+      w = (int)(step % MCDIFF_BITS);
+      if(w == 0)
+	 for(b=0; b<nb; b++)
+	 {
+	    ctr[0] = (uint32_t)(t0+b);
+	    ctr[1] = (uint32_t)((uint64_t)(t0+b) >> 32);
+	    ctr[2] = (uint32_t)ih;
+	    ctr[3] = (uint32_t)(1 + step/MCDIFF_BITS);
+	    mcdiff_philox(ctr, key, bits[b]);
+	 }
+      for(b=0; b<nb; b++)
+      {
+	 if(mcdiff_table_eval(tab, H[b], c))	// escaped
+	    continue;
+	 j = (bits[b][w >> 5] >> (w & 31)) & 1;	// channel 1 or 2
+	 H[b] += mc->eps*(c[3+2*j]*cos(th[b]) - c[4+2*j]*sin(th[b]));
+	 th[b] += c[0] + c[1+j];
+	 th[b] -= 2*M_PI*floor(th[b]/(2*M_PI));
+      }
+   }
+
+   for(b=0; b<nb; b++)
+   {
+      dh[b] = H[b]-H0;
+      if(mcdiff_table_eval(tab, H[b], c))
+	 nesc++;
+   }
+   return(nesc);
+}
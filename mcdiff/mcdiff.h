@@ -0,0 +1,144 @@
+/*! \file
+    \brief Monte Carlo Diffusion: Random Iteration of the Outer Maps
+
+    The stochastic model of the diffusion in energy (see Ansatz 2 of the
+    second paper Stochastic3BP/Paper2NHIL3BP) iterates, at random, the outer
+    maps of the two homoclinic channels $j=1,2$:
+    \f[ H \mapsto H + \epsilon\,\mathrm{Re}\left(B_j(H)e^{i\theta}\right),
+    \quad \theta \mapsto \theta + \omega(H) + \alpha_j(H), \f]
+    where each channel is chosen with probability 1/2, $\omega$ is the
+    rotation of the inner map, $\alpha_j$ the phase shift of channel j and
+    $B_j$ its Melnikov function (see outer_ell_stoch/B_j.c). \ref variance
+    gives the first order $\sigma_0^2$ of the variance of this process; here
+    the drift and the variance are estimated by simulating many
+    trajectories.
+
+    The random numbers come from the counter-based generator Philox4x32-10
+    (Salmon et al., SC'11), keyed by the seed and indexed by the trajectory
+    and the step. Each trajectory has its own stream, so the results do not
+    depend on the number of threads nor on the order in which the
+    trajectories are run.
+*/
+
+#ifndef MCDIFF_H_INCLUDED
+#define MCDIFF_H_INCLUDED
+
+#include <stdio.h>	// FILE
+#include <stdint.h>	// uint32_t, uint64_t
+
+/// Number of columns of the table: $\omega$, $\alpha_1$, $\alpha_2$,
+/// $\mathrm{Re}B_1$, $\mathrm{Im}B_1$, $\mathrm{Re}B_2$, $\mathrm{Im}B_2$.
+#define MCDIFF_NCOL 7
+
+/** Error reading the table, or the table is not valid. */
+extern const int ERR_MCDIFF_TABLE;
+
+/** Out of memory. */
+extern const int ERR_MCDIFF_MEM;
+
+/**
+  Table of the coefficients of the outer maps, on a uniform grid of
+  energies $H_i = H_0 + i\,\Delta H$, $i=0,\dots,n-1$.
+  */
+typedef struct
+{
+   int n;		///< number of energies
+   double H0;		///< first energy
+   double dH;		///< energy step
+   double (*c)[MCDIFF_NCOL];	///< coefficients at each energy
+} mcdiff_table_t;
+
+/**
+  Parameters of the simulation.
+  */
+typedef struct
+{
+   double eps;		///< size $\epsilon$ of the perturbation
+   long m;		///< number of trajectories
+   long n;		///< number of iterates of each trajectory
+   uint64_t seed;	///< key of the random streams
+} mcdiff_t;
+
+/**
+  Empirical drift and variance from one starting energy.
+
+  With $\Delta H$ the displacement of a trajectory after n iterates, the
+  drift and the variance per iterate are normalized by $\epsilon^2$:
+  \f[ d = \frac{E(\Delta H)}{n\epsilon^2}, \quad
+  \sigma^2 = \frac{\mathrm{Var}(\Delta H)}{n\epsilon^2}, \f]
+  so that $\sigma^2$ is comparable with the average over $\theta$ of
+  $\sigma_0^2$ (see \ref variance).
+  */
+typedef struct
+{
+   double H0;		///< starting energy
+   double drift;	///< drift d
+   double drift_ci;	///< half-width of the 95% confidence interval of d
+   double var;		///< variance $\sigma^2$
+   double var_ci;	///< half-width of the 95% confidence interval of $\sigma^2$
+   double escaped;	///< fraction of trajectories that left the table
+} mcdiff_stats_t;
+
+/**
+  Read the table of coefficients.
+
+  Each line holds, as the input of \ref variance with the rotation of the
+  inner map inserted after the energy,
+
+     H omega alpha_neg_1 alpha_pos_2 ReB1 ImB1 ReB2 ImB2
+
+  and the phase shifts are stored as $\alpha_1=-2\alpha^-_1$,
+  $\alpha_2=2\alpha^+_2$. Lines are read until the end of the file. The
+  energies must be increasing and equally spaced.
+
+  \param[in] fp		input file
+  \param[out] tab	table; tab->c is allocated with malloc, and must be
+  			freed by the caller
+
+  \retval ERR_MCDIFF_TABLE	Less than two lines, or energies not equally
+  				spaced.
+  \retval ERR_MCDIFF_MEM	Out of memory.
+  */
+int mcdiff_table_read(FILE *fp, mcdiff_table_t *tab);
+
+/**
+  Linear interpolation of the table at energy H.
+
+  \returns 0 if H is in the range of the table, and a non-zero value
+  otherwise (then c is not set).
+  */
+int mcdiff_table_eval(const mcdiff_table_t *tab, double H,
+      double c[MCDIFF_NCOL]);
+
+/**
+  Simulate the random iteration from one starting energy.
+
+  The m trajectories start at H0, with $\theta$ uniform in $[0,2\pi)$, and
+  are iterated n times in batches, which are distributed dynamically among
+  the OpenMP threads. A trajectory that leaves the range of the table stays
+  at its last energy, and is counted in stats->escaped.
+
+  \param[in] mc		parameters of the simulation
+  \param[in] tab	table of coefficients
+  \param[in] ih		index of the starting energy, which selects the
+  			random streams (so that different starting energies
+  			are independent)
+  \param[in] H0		starting energy
+  \param[out] stats	drift and variance
+
+  \retval ERR_MCDIFF_MEM	Out of memory.
+  */
+int mcdiff_run(const mcdiff_t *mc, const mcdiff_table_t *tab, int ih,
+      double H0, mcdiff_stats_t *stats);
+
+/**
+  Philox4x32-10 counter-based random number generator.
+
+  \param[in] ctr	counter
+  \param[in] key	key
+  \param[out] out	128 random bits
+  */
+void mcdiff_philox(const uint32_t ctr[4], const uint32_t key[2],
+      uint32_t out[4]);
+
+#endif // MCDIFF_H_INCLUDED
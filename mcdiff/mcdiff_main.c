@@ -0,0 +1,73 @@
+/*! \file
+    \brief Monte Carlo Diffusion: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, free
+#include "mcdiff.h"		// mcdiff_t, mcdiff_table_read, mcdiff_run
+
+/**
+   Monte Carlo Diffusion: main prog
+
+   This program validates the predictions of the diffusion in energy (see
+   \ref variance) by simulating the random iteration of the outer maps
+   (see \ref mcdiff_run) from many energy levels.
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin:
+
+      - size of the perturbation "eps"
+      - number of trajectories "m" per starting energy
+      - number of iterates "n" of each trajectory
+      - seed of the random streams
+      - stride: one every stride energies of the table is a starting energy
+
+   2. Input the table of coefficients from stdin, one line per energy (see
+   \ref mcdiff_table_read):
+      H, omega, alpha_neg_1, alpha_pos_2, Re B_1, Im B_1, Re B_2, Im B_2.
+
+   3. For each starting energy, simulate the m trajectories, and output the
+   following line to stdout:
+      H, drift, CI of drift, variance, CI of variance, escaped fraction,
+   where the drift and the variance are per iterate and normalized by
+   $\epsilon^2$, and CI is the half-width of the 95% confidence interval.
+
+   The results only depend on the input (not on the number of threads), so
+   runs can be reproduced exactly.
+ */
+
+int main( )
+{
+   mcdiff_t mc;
+   mcdiff_table_t tab;
+   mcdiff_stats_t st;
+   unsigned long long seed;
+   int stride, i;
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %ld %ld %llu %d", &mc.eps, &mc.m, &mc.n, &seed, &stride)
+	 < 5 || mc.m < 1 || mc.n < 1 || stride < 1)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+   mc.seed = seed;
+
+   // 2. Table of coefficients.
+   if(mcdiff_table_read(stdin, &tab))
+      exit(EXIT_FAILURE);
+
+   // 3. Simulate from each starting energy.
+   for(i=0; i<tab.n; i+=stride)
+   {
+      if(mcdiff_run(&mc, &tab, i, tab.H0+i*tab.dH, &st))
+	 exit(EXIT_FAILURE);
+      printf("%.6e %.15e %.15e %.15e %.15e %f\n", st.H0, st.drift,
+	    st.drift_ci, st.var, st.var_ci, st.escaped);
+      fflush(stdout);
+   }
+   free(tab.c);
+   exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,288 @@
+/*! \file
+    \brief Manifold Crossings: Intersections of Manifold Polylines
+*/
+
+#include <stdio.h>	// fprintf
+#include <stdlib.h>	// malloc, calloc, realloc, free, qsort
+#include <math.h>	// floor, sqrt, fmin, fmax
+
+#include <mfldset.h>	// mfldset_t
+
+#include "mfldcross.h"
+
+const int ERR_MFLDCROSS_MEM=1;
+
+/// Max number of cells of the grid in each direction.
+static const int MFLDCROSS_MAXGRID=1024;
+
+/// Bounding box of a set of segments: xmin, xmax, ymin, ymax.
+typedef double mfldcross_box_t[4];
+
+void mfldcross_seg(const mfldcross_curve_t *w, int id, double a[2],
+      double b[2]);
+void mfldcross_bbox(const mfldcross_curve_t *w, mfldcross_box_t box);
+int mfldcross_cell(double v, double v0, double d, int g);
+int mfldcross_cmp(const void *a, const void *b);
+
+int mfldcross(const mfldcross_curve_t *wu, const mfldcross_curve_t *ws,
+      mfldcross_t **cross, int *ncross)
+{
+   const int nu = wu->nblocks*(wu->npoints-1);	// segments of $W^u$
+   const int ns = ws->nblocks*(ws->npoints-1);	// segments of $W^s$
+   mfldcross_box_t bu, bs, box;
+   double dx, dy;	// size of the cells
+   int g;		// number of cells in each direction
+   int *start = NULL;	// segments of cell c: seg[start[c]],...,seg[start[c+1]-1]
+   int *seg = NULL;
+   int *fill = NULL;
+   double a[2], b[2], c[2], d[2], r[2], q[2], e[2];
+   double den, s, t, z[2];
+   int size = 0;	// size of the array of crossings
+   mfldcross_t *tmp;
+   int i, j, l, cx, cy, cx0, cx1, cy0, cy1, pass;
+   int status = 0;
+
+   *cross = NULL;
+   *ncross = 0;
+   if(nu <= 0 || ns <= 0)
+      return(0);
+
+   // Crossings can only lie in the box where both manifolds overlap.
+   mfldcross_bbox(wu, bu);
+   mfldcross_bbox(ws, bs);
+   box[0] = fmax(bu[0], bs[0]);
+   box[1] = fmin(bu[1], bs[1]);
+   box[2] = fmax(bu[2], bs[2]);
+   box[3] = fmin(bu[3], bs[3]);
+   if(box[0] > box[1] || box[2] > box[3])
+      return(0);
+
+   g = (int)sqrt((double)nu);
+   if(g < 1)
+      g = 1;
+   if(g > MFLDCROSS_MAXGRID)
+      g = MFLDCROSS_MAXGRID;
+   dx = (box[1]-box[0])/g;
+   dy = (box[3]-box[2])/g;
+
+   // Bin the segments of $W^u$ into the cells covered by their bounding box:
+   // count them (pass 0), then store them (pass 1).
+   start = calloc(g*g+1, sizeof(int));
+   fill = calloc(g*g, sizeof(int));
+   if(start == NULL || fill == NULL)
+   {
+      fprintf(stderr, "mfldcross: out of memory\n");
+      free(start);
+      free(fill);
+      return(ERR_MFLDCROSS_MEM);
+   }
+   for(pass=0; pass<2; pass++)
+   {
+      for(i=0; i<nu; i++)
+      {
+	 mfldcross_seg(wu, i, a, b);
+	 if(fmax(a[0],b[0]) < box[0] || fmin(a[0],b[0]) > box[1] ||
+	       fmax(a[1],b[1]) < box[2] || fmin(a[1],b[1]) > box[3])
+	    continue;
+	 cx0 = mfldcross_cell(fmin(a[0],b[0]), box[0], dx, g);
+	 cx1 = mfldcross_cell(fmax(a[0],b[0]), box[0], dx, g);
+	 cy0 = mfldcross_cell(fmin(a[1],b[1]), box[2], dy, g);
+	 cy1 = mfldcross_cell(fmax(a[1],b[1]), box[2], dy, g);
+	 for(cy=cy0; cy<=cy1; cy++)
+	    for(cx=cx0; cx<=cx1; cx++)
+	    {
+	       if(pass == 0)
+		  start[cy*g+cx+1]++;
+	       else
+		  seg[start[cy*g+cx] + fill[cy*g+cx]++] = i;
+	    }
+      }
+      if(pass == 0)
+      {
+	 for(l=0; l<g*g; l++)
+	    start[l+1] += start[l];
+	 seg = malloc((start[g*g] > 0 ? start[g*g] : 1)*sizeof(int));
+	 if(seg == NULL)
+	 {
+	    fprintf(stderr, "mfldcross: out of memory\n");
+	    free(start);
+	    free(fill);
+	    return(ERR_MFLDCROSS_MEM);
+	 }
+      }
+   }
+
+   // Check each segment of $W^s$ against the segments of $W^u$ in the cells
+   // it covers. A crossing is kept only in the cell that contains it, so a
+   // pair of segments sharing several cells is reported once.
+   for(j=0; j<ns && status==0; j++)
+   {
+      mfldcross_seg(ws, j, c, d);
+      if(fmax(c[0],d[0]) < box[0] || fmin(c[0],d[0]) > box[1] ||
+	    fmax(c[1],d[1]) < box[2] || fmin(c[1],d[1]) > box[3])
+	 continue;
+      cx0 = mfldcross_cell(fmin(c[0],d[0]), box[0], dx, g);
+      cx1 = mfldcross_cell(fmax(c[0],d[0]), box[0], dx, g);
+      cy0 = mfldcross_cell(fmin(c[1],d[1]), box[2], dy, g);
+      cy1 = mfldcross_cell(fmax(c[1],d[1]), box[2], dy, g);
+      q[0] = d[0]-c[0];
+      q[1] = d[1]-c[1];
+      for(cy=cy0; cy<=cy1 && status==0; cy++)
+	 for(cx=cx0; cx<=cx1 && status==0; cx++)
+	    for(l=start[cy*g+cx]; l<start[cy*g+cx+1]; l++)
+	    {
+	       // Solve $a+s(b-a) = c+t(d-c)$.
+	       i = seg[l];
+	       mfldcross_seg(wu, i, a, b);
+	       r[0] = b[0]-a[0];
+	       r[1] = b[1]-a[1];
+	       e[0] = c[0]-a[0];
+	       e[1] = c[1]-a[1];
+	       den = r[0]*q[1] - r[1]*q[0];
+	       if(den == 0)	// parallel segments
+		  continue;
+	       s = (e[0]*q[1] - e[1]*q[0])/den;
+	       t = (e[0]*r[1] - e[1]*r[0])/den;
+	       if(s < 0 || s >= 1 || t < 0 || t >= 1)
+		  continue;
+	       z[0] = a[0] + s*r[0];
+	       z[1] = a[1] + s*r[1];
+	       if(mfldcross_cell(z[0], box[0], dx, g) != cx ||
+		     mfldcross_cell(z[1], box[2], dy, g) != cy)
+		  continue;
+
+	       if(*ncross == size)
+	       {
+		  size = (size > 0 ? 2*size : 64);
+		  tmp = realloc(*cross, size*sizeof(mfldcross_t));
+		  if(tmp == NULL)
+		  {
+		     fprintf(stderr, "mfldcross: out of memory\n");
+		     status = ERR_MFLDCROSS_MEM;
+		     break;
+		  }
+		  *cross = tmp;
+	       }
+	       tmp = *cross + (*ncross)++;
+	       tmp->bu = i/(wu->npoints-1);
+	       tmp->iu = i%(wu->npoints-1);
+	       tmp->su = s;
+	       tmp->bs = j/(ws->npoints-1);
+	       tmp->is = j%(ws->npoints-1);
+	       tmp->ss = t;
+	       tmp->z[0] = z[0];
+	       tmp->z[1] = z[1];
+	    }
+   }
+   free(start);
+   free(fill);
+   free(seg);
+   if(status)
+   {
+      free(*cross);
+      *cross = NULL;
+      *ncross = 0;
+      return(status);
+   }
+   if(*ncross > 1)
+      qsort(*cross, *ncross, sizeof(mfldcross_t), mfldcross_cmp);
+   return(0);
+}
+
+void mfldcross_hseg(const mfldset_t *ms, const mfldcross_curve_t *w,
+      const double p[2], const double v[2], double hseg[2])
+{
+   double a[2], b[2];
+
+   mfldcross_seg(w, 0, a, b);	// a = $p_1$
+   hseg[0] = ms->h;
+   hseg[1] = ((a[0]-p[0])*v[0] + (a[1]-p[1])*v[1])/(v[0]*v[0] + v[1]*v[1]);
+}
+
+// name OF FUNCTION: mfldcross_seg
+//
+// PURPOSE
+// =======
+// Endpoints a, b (in coordinates $(x,p_x)$) of the segment id of the
+// polyline w. Segment id joins the points i and i+1 of block
+// id/(npoints-1), with i = id%(npoints-1).
+
+void mfldcross_seg(const mfldcross_curve_t *w, int id, double a[2],
+      double b[2])
+{
+   const int ipx = (w->dim > 2 ? 2 : 1);	// index of $p_x$
+   const double *x = w->pts +
+      (long)w->dim*((id/(w->npoints-1))*w->npoints + id%(w->npoints-1));
+
+   a[0] = x[0];
+   a[1] = x[ipx];
+   b[0] = x[w->dim];
+   b[1] = x[w->dim+ipx];
+}
+
+// name OF FUNCTION: mfldcross_bbox
+//
+// PURPOSE
+// =======
+// Bounding box of all the points of the polyline w.
+
+void mfldcross_bbox(const mfldcross_curve_t *w, mfldcross_box_t box)
+{
+   const int ipx = (w->dim > 2 ? 2 : 1);	// index of $p_x$
+   const long n = (long)w->nblocks*w->npoints;
+   const double *x;
+   long i;
+
+   box[0] = box[2] = HUGE_VAL;
+   box[1] = box[3] = -HUGE_VAL;
+   for(i=0; i<n; i++)
+   {
+      x = w->pts + w->dim*i;
+      box[0] = fmin(box[0], x[0]);
+      box[1] = fmax(box[1], x[0]);
+      box[2] = fmin(box[2], x[ipx]);
+      box[3] = fmax(box[3], x[ipx]);
+   }
+}
+
+// name OF FUNCTION: mfldcross_cell
+//
+// PURPOSE
+// =======
+// Index of the cell of size d (out of g, starting at v0) that contains the
+// coordinate v. Coordinates outside the grid are assigned to the first or
+// last cell.
+
+int mfldcross_cell(double v, double v0, double d, int g)
+{
+   double c;
+
+   if(d <= 0)
+      return(0);
+   c = floor((v-v0)/d);
+   if(c < 0)
+      return(0);
+   if(c > g-1)
+      return(g-1);
+   return((int)c);
+}
+
+// name OF FUNCTION: mfldcross_cmp
+//
+// PURPOSE
+// =======
+// Order of the crossings: by block, segment and fraction of $W^u$ (for
+// qsort).
+
+int mfldcross_cmp(const void *a, const void *b)
+{
+   const mfldcross_t *x = a, *y = b;
+
+   if(x->bu != y->bu)
+      return(x->bu < y->bu ? -1 : 1);
+   if(x->iu != y->iu)
+      return(x->iu < y->iu ? -1 : 1);
+   if(x->su != y->su)
+      return(x->su < y->su ? -1 : 1);
+   return(0);
+}
@@ -0,0 +1,100 @@
+/*! \file
+    \brief Manifold Crossings: Intersections of Manifold Polylines
+
+    The unstable and stable manifolds of a fixed point of the 2D Poincare
+    map are computed by \ref invmfld as polylines on the section: blocks of
+    npoints points, one block per iterate of the fundamental segment (see
+    \ref mfldset.h). Every transversal crossing of a segment of $W^u$ with a
+    segment of $W^s$ brackets a homoclinic point (or heteroclinic, if the
+    manifolds belong to different fixed points), primary or secondary.
+
+    Instead of checking the $N_u N_s$ pairs of segments, the segments of
+    $W^u$ are binned into a uniform grid on the box where both manifolds
+    overlap, and each segment of $W^s$ is only checked against the segments
+    of $W^u$ in the cells it covers. With a few segments per cell, the cost
+    is about linear in $N_u+N_s$.
+*/
+
+#ifndef MFLDCROSS_H_INCLUDED
+#define MFLDCROSS_H_INCLUDED
+
+#include <mfldset.h>	// mfldset_t
+
+/** Out of memory. */
+extern const int ERR_MFLDCROSS_MEM;
+
+/**
+  A manifold polyline, as loaded from a dataset (see \ref mfldset_load).
+
+  Point i has coordinates $(x,p_x)$ = (pts[dim*i], pts[dim*i+2]) if dim>2
+  (points $(x,y,p_x,p_y)$ on the section $y=0$), and (pts[dim*i],
+  pts[dim*i+1]) otherwise. Only consecutive points of the same block are
+  joined by a segment.
+  */
+typedef struct
+{
+   int npoints;		///< number of points per block
+   int nblocks;		///< number of blocks
+   int dim;		///< number of coordinates of each point
+   const double *pts;	///< points, block after block
+} mfldcross_curve_t;
+
+/**
+  Crossing of a segment of $W^u$ with a segment of $W^s$.
+
+  The segment (i,i+1) of block b is crossed at the point $(1-s)q_i+sq_{i+1}$,
+  with $0\le s<1$.
+  */
+typedef struct
+{
+   int bu;		///< block of $W^u$
+   int iu;		///< first point of the segment of $W^u$ in the block
+   double su;		///< fraction along the segment of $W^u$
+   int bs;		///< block of $W^s$
+   int is;		///< first point of the segment of $W^s$ in the block
+   double ss;		///< fraction along the segment of $W^s$
+   double z[2];		///< crossing point $(x,p_x)$
+} mfldcross_t;
+
+/**
+  All the crossings of two manifold polylines.
+
+  \param[in] wu		unstable manifold
+  \param[in] ws		stable manifold
+  \param[out] cross	crossings, in an array allocated with malloc, which
+  			the caller must free
+  \param[out] ncross	number of crossings
+
+  \retval ERR_MFLDCROSS_MEM	Out of memory.
+
+  \remark
+  The crossings are sorted by block and segment of $W^u$. Crossings at a
+  shared endpoint of two segments are reported once.
+  */
+int mfldcross(const mfldcross_curve_t *wu, const mfldcross_curve_t *ws,
+      mfldcross_t **cross, int *ncross);
+
+/**
+  Segment parameters at the ends of the fundamental segment.
+
+  If the dataset was computed from the linear segment between $p_0=p+hv$
+  and $p_1=P^{\pm 1}(p_0)$, the point $p_0+t(p_1-p_0)$ of the segment
+  corresponds to $h(t)=h_0+t(h_1-h_0)$ in the parameterization $p+hv$ of
+  the local manifold used by \ref homweb_newton. Since $p_1$ is the first
+  point of the first block, $h_0=h$ and $h_1=(p_1-p)\cdot v/|v|^2$.
+
+  \param[in] ms		parameters of the dataset
+  \param[in] w		manifold polyline of the dataset
+  \param[in] p		fixed point
+  \param[in] v		eigenvector
+  \param[out] hseg	$h_0$, $h_1$
+
+  \remark
+  Only for datasets seeded by the linear segment (ms->order == 0). Those
+  computed with the parameterization method (\ref invmfld -p) have no such
+  parameters.
+  */
+void mfldcross_hseg(const mfldset_t *ms, const mfldcross_curve_t *w,
+      const double p[2], const double v[2], double hseg[2]);
+
+#endif // MFLDCROSS_H_INCLUDED
@@ -0,0 +1,137 @@
+/*! \file
+    \brief Manifold Crossings: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, free
+#include <rtbp.h>		// DIM
+#include <section.h>		// SEC2
+#include <mfldset.h>		// mfldset_t, mfldset_load
+#include "mfldcross.h"		// mfldcross_curve_t, mfldcross
+
+/**
+   Manifold Crossings: main prog
+
+   This program lists all the crossings of an unstable and a stable manifold
+   dataset (see \ref mfldset.h), and turns each of them into a starting
+   bracket for \ref homweb, so that
+
+      mfldcross Wu.dat Ws.dat < problem.dat | homweb
+
+   lists all the primary and secondary homoclinic points found by the
+   manifolds.
+
+   Usage: mfldcross unstable_dataset stable_dataset
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin (those of \ref homweb):
+
+      - mass parameter
+      - number of cuts "k" with Poincare section SEC2
+      - energy value "H"
+      - fixed point "p_u" and unstable eigenvector "v_u"
+      - fixed point "p_s" and stable eigenvector "v_s"
+
+   2. Load both datasets, which must have been computed by \ref invmfld on
+   SEC2 (the section of \ref homweb) from the linear segment (order 0, not
+   with option -p), at the same mu, H and k.
+
+   3. Find all the crossings of the two polylines (see \ref mfldcross).
+
+   4. Output the input parameters to stdout, and then, for each crossing of
+   segment (i,i+1) of block $b_u$ of $W^u$ with segment (j,j+1) of block
+   $b_s$ of $W^s$, the bracket
+      n_u, n_s, h_{u,1}, h_{u,2}, h_{s,1}, h_{s,2},
+   with $n_u=b_u+1$, $n_s=b_s+1$, and the segment parameters of the points
+   i-1 and i+2 (resp. j-1 and j+2) of the fundamental segment (see \ref
+   mfldcross_hseg). The bracket is one segment wider on each side than the
+   crossing segments, since the polyline is only a chord of the manifold.
+ */
+
+int main(int argc, char *argv[])
+{
+   double mu, H;
+   int k;
+   double pu[2], vu[2], ps[2], vs[2];
+   mfldset_t msu, mss;
+   mfldcross_curve_t wu, ws;
+   double *ptsu, *ptss;
+   double hu[2], hs[2];	// segment parameters of the fundamental segments
+   double du, ds;	// increment of h per point
+   mfldcross_t *cross, *c;
+   int ncross, i;
+
+   if(argc < 3)
+   {
+      fprintf(stderr, "Usage: %s unstable_dataset stable_dataset\n",
+	    argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %d %le %le %le %le %le %le %le %le %le", &mu, &k, &H, pu,
+	    pu+1, vu, vu+1, ps, ps+1, vs, vs+1) < 11)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+
+   // 2. Load the datasets.
+   if(mfldset_load(argv[1], &msu, &ptsu, &wu.nblocks) ||
+	 mfldset_load(argv[2], &mss, &ptss, &ws.nblocks))
+      exit(EXIT_FAILURE);
+   if(msu.stable || !mss.stable || msu.mu != mu || mss.mu != mu ||
+	 msu.H != H || mss.H != H || msu.k != k || mss.k != k ||
+	 msu.npoints < 2 || mss.npoints < 2)
+   {
+      fprintf(stderr, "main: datasets do not match the input parameters\n");
+      exit(EXIT_FAILURE);
+   }
+   if(msu.sec != SEC2 || mss.sec != SEC2 || msu.dim != DIM || mss.dim != DIM)
+   {
+      fprintf(stderr, "main: datasets must hold points (x,y,px,py) on SEC2\n");
+      exit(EXIT_FAILURE);
+   }
+   if(msu.order != 0 || mss.order != 0)
+   {
+      fprintf(stderr, "main: datasets must be seeded by the linear segment\n");
+      exit(EXIT_FAILURE);
+   }
+   if(wu.nblocks == 0 || ws.nblocks == 0)
+   {
+      fprintf(stderr, "main: empty dataset\n");
+      exit(EXIT_FAILURE);
+   }
+   wu.npoints = msu.npoints;
+   wu.dim = msu.dim;
+   wu.pts = ptsu;
+   ws.npoints = mss.npoints;
+   ws.dim = mss.dim;
+   ws.pts = ptss;
+
+   // 3. Find the crossings.
+   if(mfldcross(&wu, &ws, &cross, &ncross))
+      exit(EXIT_FAILURE);
+   fprintf(stderr, "main: %d crossings found\n", ncross);
+
+   // 4. Output the starting brackets.
+   mfldcross_hseg(&msu, &wu, pu, vu, hu);
+   mfldcross_hseg(&mss, &ws, ps, vs, hs);
+   du = (hu[1]-hu[0])/(msu.npoints-1);
+   ds = (hs[1]-hs[0])/(mss.npoints-1);
+   printf("%.15e %d %.15e %.15e %.15e %.15e %.15e %.15e %.15e %.15e %.15e\n",
+	 mu, k, H, pu[0], pu[1], vu[0], vu[1], ps[0], ps[1], vs[0], vs[1]);
+   for(i=0; i<ncross; i++)
+   {
+      c = cross+i;
+      printf("%d %d %.15e %.15e %.15e %.15e\n", c->bu+1, c->bs+1,
+	    hu[0]+(c->iu-1)*du, hu[0]+(c->iu+2)*du,
+	    hs[0]+(c->is-1)*ds, hs[0]+(c->is+2)*ds);
+   }
+   free(cross);
+   free(ptsu);
+   free(ptss);
+   exit(EXIT_SUCCESS);
+}
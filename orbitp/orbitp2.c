@@ -34,6 +34,27 @@
 
 #include <stdio.h>	// fprintf
 #include <stdlib.h>	// EXIT_FAILURE
+#include <stdbool.h>	// bool
+#include <rtbp.h>	// DIM, rtbp
+#include <frtbp.h>	// frtbp
+#include <section.h>	// SEC2
+#include <hinv.h>	// hinv
+#include <psec.h>	// psec_stream, psec_y, psec_side_x
+
+/// Detection step and tolerance of the cuts (as in prtbp_nl).
+static const double ORBITP2_STEP=0.01;
+static const double ORBITP2_TOL=1.e-16;
+
+// Parameters of the output function orbitp2_out
+struct orbitp2_par
+{
+   int k;		/* iterated map $P^k$ */
+   double *orbit;	/* orbit, as in orbitp2 */
+};
+
+int orbitp2_psec(double mu, double H, int k, double p[2], int n,
+      double *orbit, bool fwd);
+int orbitp2_out(const psec_cut_t *cut, void *par);
 
 // name OF FUNCTION: orbitp2
 // CREDIT: 
@@ -73,24 +94,17 @@
 //
 // NOTES
 // =====
+// The whole orbit is computed in a single integration (see orbitp2_psec).
+// On return, p holds the last point of the orbit.
 //
-// CALLS TO: prtbp2_2d
+// CALLS TO: orbitp2_psec
 
 int orbitp2(double mu, double H, int k, double p[2], int n, double *orbit)
 {
-   int i=0;
-   double ti;
-
-   while(i<n)
+   if(orbitp2_psec(mu,H,k,p,n,orbit,true))
    {
-      if(prtbp2_2d(mu,H,k,p,&ti))
-      {
-	 fprintf(stderr, "orbitp2: error computing Poincare map\n");
-	 return(1);
-      }
-      orbit[2*i] = p[0];
-      orbit[2*i+1] = p[1];
-      i++;
+      fprintf(stderr, "orbitp2: error computing Poincare map\n");
+      return(1);
    }
    return(0);
 }
@@ -130,24 +144,85 @@ int orbitp2(double mu, double H, int k, double p[2], int n, double *orbit)
 //
 // NOTES
 // =====
+// As in orbitp2, the map is the iterated map $P^6$ (1:7 resonance).
 //
-// CALLS TO: prtbp2_2d_inv
+// CALLS TO: orbitp2_psec
 
 int orbitp2_bwd(double mu, double H, double p[2], int n, double *orbit)
 {
-   int i=0;
-   double ti;
+   if(orbitp2_psec(mu,H,6,p,n,orbit,false))
+   {
+      fprintf(stderr, "orbitp2_bwd: error computing inverse Poincare map\n");
+      return(1);
+   }
+   return(0);
+}
+
+// name OF FUNCTION: orbitp2_psec
+// CREDIT: 
+//
+// PURPOSE
+// =======
+// Common part of orbitp2 (fwd=true) and orbitp2_bwd (fwd=false).
+// The point p is lifted to the section $\Sigma^-$ at energy H, and its
+// trajectory is followed once with psec_stream, on the section and loop
+// filter of prtbp_nl, for k*n cuts. Every k-th cut is stored in the orbit
+// by orbitp2_out. If n<=0 there is nothing to compute (psec_stream would
+// take 0 cuts as no limit), and p is left unchanged.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+//
+// CALLS TO: hinv, psec_stream
+
+int orbitp2_psec(double mu, double H, int k, double p[2], int n,
+      double *orbit, bool fwd)
+{
+   psec_flow_t fl = {frtbp, rtbp, DIM, ORBITP2_STEP};
+   psec_t s = {psec_y, psec_y_grad, NULL, 0, 0, psec_side_x};
+   struct orbitp2_par par = {k, orbit};
+   double x[DIM];
 
-   while(i<n)
+   if(n <= 0)
+      return(0);
+   x[0]=p[0];	// x
+   x[1]=0.0;	// y
+   x[2]=p[1]; 	// p_x
+   if(hinv(mu,SEC2,H,x))
    {
-      if(prtbp2_2d_inv(mu,H,6,p,&ti))
-      {
-	 fprintf(stderr, "orbitp2_bwd: error computing inverse Poincare map\n");
-	 return(1);
-      }
-      orbit[2*i] = p[0];
-      orbit[2*i+1] = p[1];
-      i++;
+      fprintf(stderr, "orbitp2_psec: error inverting the Hamiltonian\n");
+      return(1);
+   }
+   if(psec_stream(mu,&fl,&s,k*n,fwd,ORBITP2_TOL,false,x,orbitp2_out,&par))
+      return(1);
+   p[0]=x[0];	// x
+   p[1]=x[2];	// p_x
+   return(0);
+}
+
+// name OF FUNCTION: orbitp2_out
+// CREDIT: 
+//
+// PURPOSE
+// =======
+// Output function of psec_stream: store every k-th cut in the orbit.
+//
+// RETURN VALUE
+// ============
+// Always 0 (the stream stops after k*n cuts).
+
+int orbitp2_out(const psec_cut_t *cut, void *par)
+{
+   struct orbitp2_par *op = (struct orbitp2_par *)par;
+   int i;
+
+   if(cut->k % op->k == 0)
+   {
+      i = cut->k/op->k - 1;
+      op->orbit[2*i] = cut->x[0];	// x
+      op->orbit[2*i+1] = cut->x[2];	// p_x
    }
    return(0);
 }
@@ -21,6 +21,10 @@
 //#include <frtbpred.h>
 
 #include <inner_circ.h>	// integrand_omega_in, iparams_omega_in
+#include <utils_module.h>	// dblsum
+#include <tolprof.h>	// tolprof_tol
+
+int omega_pm_period(double mu, double x[DIM], int k, int sgn, double *res);
 
 // name OF FUNCTION: omega_pm_old 
 //
@@ -91,7 +95,8 @@ int omega_pm_old(double mu, double x[DIM], int N, double T0, double *omega)
    // Integrate integrand function from 0 to 14N\pi. 
    // Notice that N may be positive or negative.
    // We request a absolute error of 0 and a relative error $10^{-13}$.
-   gsl_integration_qags (&F, 0, 14*N*M_PI, 0, 1.e-13, 1000, w, &result, &error);
+   gsl_integration_qags (&F, 0, 14*N*M_PI, 0, tolprof_tol(TOL_QUAD,1.e-13),
+	 1000, w, &result, &error);
    fprintf (stderr, "estimated error = % .3le\n", error);
 
    gsl_integration_workspace_free (w);
@@ -165,60 +170,40 @@ int omega_pm_old(double mu, double x[DIM], int N, double T0, double *omega)
 
 int omega_pos(double mu, double x[DIM], int N, double T0, double *omega)
 {
-   double result, error;
+   double *terms;	/* terms[N-i] = i-th term of the sum */
 
    // auxiliary variables
-   int i,j;
-   double xi[DIM];		/* point \xi=P^{-(N-i)}(z^s) */
-   double t;
+   int i;
+   int err = 0;
 
    assert(N>0);
 
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_omega_in params;
-
-   gsl_function F;
-   F.function = &integrand_omega_in;
-   F.params = &params;
+   terms = malloc(N*sizeof(double));
+   if(terms == NULL)
+   {
+      fprintf(stderr, "omega_pos: out of memory\n");
+      return(1);
+   }
 
-   params.mu = mu;
-   
-   *omega = 0.0;
+   // The terms are independent, so they are computed in parallel (if
+   // compiled with OpenMP), and added up in a fixed order at the end.
+#pragma omp parallel for schedule(dynamic) reduction(|:err)
    for(i=N; i>=1; i--)
    {
       // $\gamma_i(s)$ is the homoclinic trajectory that starts at the
       // point \xi = P^{-(N-i)}(z^s) = P^{i}(z). 
-      for(j=0;j<DIM;j++) xi[j]=x[j];
-
-      // WARNING!!!! WE PROBABLY WANT TO USE PRTBP_DEL_CAR HERE!!!!
-      if(prtbp_del_inv(mu,SEC1,(N-i)*3,xi,&t))
+      if(omega_pm_period(mu, x, N-i, -1, &terms[N-i]))
       {
-	 fprintf(stderr, "omega_pos: error computing point P^{i}(z)\n");
-	 return(1);
+	 fprintf(stderr, "omega_pos: error computing point P^{%d}(z)\n", i);
+	 err = 1;
+	 continue;
       }
-
-      params.x[0] = xi[0];
-      params.x[1] = xi[1];
-      params.x[2] = xi[2];
-      params.x[3] = xi[3];
-
-      // Integrate integrand function from -6\pi to 0. 
-      // We request a absolute error of 0 and a relative error $10^{-13}$.
-
-      // NOTE: we can't reach accuracy of 10^{-13} when computing
-      // omega_pos_f, so we lower it to 10^{-9}
-      gsl_integration_qags (&F, -6*M_PI, 0, 0, 1.e-9, 1000, w, &result,
-	    &error); 
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // \omega_+
-      (*omega) = (*omega) +(result + T0);
+      terms[N-i] += T0;		// \omega_+
    }
 
-   gsl_integration_workspace_free (w);
-   return 0;
+   *omega = (err ? 0.0 : dblsum(terms, N));
+   free(terms);
+   return err;
 }
 
 /**
@@ -285,60 +270,118 @@ int omega_pos(double mu, double x[DIM], int N, double T0, double *omega)
 
 int omega_neg(double mu, double x[DIM], int N, double T0, double *omega)
 {
-   double result, error;
+   double *terms;	/* terms[N-i] = i-th term of the sum */
 
    // auxiliary variables
-   int i,j;
-   double xi[DIM];		/* point \xi=P^{N-i}(z^u) */
-   double t;
+   int i;
+   int err = 0;
 
    assert(N>0);
 
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_omega_in params;
-
-   gsl_function F;
-   F.function = &integrand_omega_in;
-   F.params = &params;
+   terms = malloc(N*sizeof(double));
+   if(terms == NULL)
+   {
+      fprintf(stderr, "omega_neg: out of memory\n");
+      return(1);
+   }
 
-   params.mu = mu;
-   
-   *omega = 0.0;
+   // The terms are independent, so they are computed in parallel (if
+   // compiled with OpenMP), and added up in a fixed order at the end.
+#pragma omp parallel for schedule(dynamic) reduction(|:err)
    for(i=N; i>=1; i--)
    {
       // $\gamma_i(s)$ is the homoclinic trajectory that starts at the
       // point \xi = P^{N-i}(z^u) = P^{-i}(z). 
-      for(j=0;j<DIM;j++) xi[j]=x[j];
-
-      // WARNING!!!! WE PROBABLY WANT TO USE PRTBP_DEL_CAR HERE!!!!
-      if(prtbp_del(mu,SEC1,(N-i)*3,xi,&t))
+      if(omega_pm_period(mu, x, N-i, 1, &terms[N-i]))
       {
 	 fprintf(stderr, "omega_neg: error computing point P^{%d}(z^u)\n",
 	       (N-i));
-	 return(1);
+	 err = 1;
+	 continue;
       }
+      terms[N-i] -= T0;		// \omega_-
+   }
 
-      params.x[0] = xi[0];
-      params.x[1] = xi[1];
-      params.x[2] = xi[2];
-      params.x[3] = xi[3];
+   *omega = (err ? 0.0 : dblsum(terms, N));
+   free(terms);
+   return err;
+}
 
-      // Integrate integrand function from 6\pi to 0. 
-      // We request a absolute error of 0 and a relative error $10^{-13}$.
+// name OF FUNCTION: omega_pm_period
+//
+// PURPOSE
+// =======
+// Compute one term of the sums in omega_pos (sgn=-1) and omega_neg
+// (sgn=+1), without the shift T_0:
+//
+// \[ \int_{sgn 6\pi}^{0} f0(\gamma(s)) ds, \]
+//
+// where \gamma(s) is the trajectory that starts at the point
+// \xi = P^{sgn k}(x).
+//
+// This function only uses local workspaces, so it can be called
+// concurrently from several threads.
+//
+// PARAMETERS
+// ==========
+// mu
+//    mass parameter for the RTBP
+// x
+//    x=(l=0,L,g,G), point z^s (sgn=-1) or z^u (sgn=+1), on the section l=0.
+// k
+//    number of iterates of the Poincare map (k>=0).
+// sgn
+//    -1 for omega_pos, +1 for omega_neg.
+// res
+//    On return, the value of the integral.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
 
-      // NOTE: we can't reach accuracy of 10^{-13} when computing
-      // omega_pos_f, so we lower it to 10^{-9}
-      gsl_integration_qags (&F, 6*M_PI, 0, 0, 1.e-9, 1000, w, &result,
-	    &error); 
-      fprintf (stderr, "estimated error = % .3le\n", error);
+int omega_pm_period(double mu, double x[DIM], int k, int sgn, double *res)
+{
+   double result, error;
+   double xi[DIM];		/* point \xi=P^{sgn k}(x) */
+   double t;
+   int j, status;
 
-      // \omega_-
-      (*omega) = (*omega) +(result - T0);
-   }
+   struct iparams_omega_in params;
+   gsl_function F;
+   gsl_integration_workspace * w;
+
+   for(j=0;j<DIM;j++) xi[j]=x[j];
+
+   // WARNING!!!! WE PROBABLY WANT TO USE PRTBP_DEL_CAR HERE!!!!
+   if(sgn>0)
+      status = prtbp_del(mu,SEC1,k*3,xi,&t);
+   else
+      status = prtbp_del_inv(mu,SEC1,k*3,xi,&t);
+   if(status)
+      return(1);
 
+   params.mu = mu;
+   params.x[0] = xi[0];
+   params.x[1] = xi[1];
+   params.x[2] = xi[2];
+   params.x[3] = xi[3];
+
+   F.function = &integrand_omega_in;
+   F.params = &params;
+
+   // Integrate integrand function from sgn*6\pi to 0. 
+   // We request a absolute error of 0 and a relative error $10^{-13}$.
+
+   // NOTE: we can't reach accuracy of 10^{-13} when computing
+   // omega_pos_f, so we lower it to 10^{-9}
+   w = gsl_integration_workspace_alloc (1000);
+   gsl_integration_qags (&F, sgn*6*M_PI, 0, 0, tolprof_tol(TOL_QUAD,1.e-9),
+	 1000, w, &result, &error); 
+   fprintf (stderr, "estimated error = % .3le\n", error);
    gsl_integration_workspace_free (w);
+
+   *res = result;
    return 0;
 }
 
@@ -16,6 +16,7 @@
 #include <math.h>   // M_PI
 
 #include <frtbp.h>
+#include <htraj.h>	// htraj_t, htraj_read
 #include <approxint.h>	// stability_t
 #include "outer_circ_stoch_module.h"
 
@@ -47,6 +48,12 @@
   For each input line, it outputs result to stdout:
   - omega_neg
   - omega_pos
+
+  Usage: outer_circ_stoch [storefile]
+
+  If a store file written by intersec is given, the homoclinic of each input
+  line is evaluated from the next store of the file (see \ref
+  omega_neg_stoch_htraj) instead of being integrated again.
  
  */
  
@@ -54,7 +61,7 @@
 //     \omega_- = - \omega_+, 
 //  so it is enough to compute one of them.
  
-int main( )
+int main(int argc, char *argv[])
 {
    double mu;
 
@@ -84,6 +91,8 @@ int main( )
    int status;
    stability_t st;
    double t_aux;
+   FILE *fstore = NULL;	/* store file (if given) */
+   htraj_t tr;		/* homoclinic from z_u to z */
 
    // Input parameters from stdin.
    if(scanf("%le %d", &mu, &stability)<2)
@@ -94,6 +103,12 @@ int main( )
 
    st = (stability==0 ? UNSTABLE : STABLE);
 
+   if(argc > 1 && (fstore = fopen(argv[1], "rb")) == NULL)
+   {
+      perror("main: error opening store file");
+      exit(EXIT_FAILURE);
+   }
+
    // Input period T, zu, time to reach hom. pt. z, from stdin.
    while(scanf("%le %le %le %le %le %le", &T, zu, zu+1, zu+2, zu+3, &t) == 6)
    {
@@ -101,6 +116,34 @@ int main( )
 	  //T0 = (T-2*M_PI)/mu;
 	  T0 = T-2*M_PI;
 
+	  // With a store file, the homoclinic from z_u is evaluated from the
+	  // store instead of being integrated again.
+	  if(fstore != NULL)
+	  {
+		  if(htraj_read(fstore, &tr))
+			 exit(EXIT_FAILURE);
+		  if(fabs(tr.t1-t) > 1.e-10*fabs(t))
+		  {
+			 fprintf(stderr, "main: store does not match input line\n");
+			 exit(EXIT_FAILURE);
+		  }
+		  t_aux = fmod(t,T);
+		  M = t/T;
+		  if(st==UNSTABLE)
+			 status = omega_neg_stoch_htraj(mu, &tr, t_aux, M, T0, &w_neg);
+		  else
+			 status = omega_pos_stoch_htraj(mu, &tr, t_aux, -M, T0, &w_pos);
+		  htraj_free(&tr);
+		  if(status)
+		  {
+			 fprintf(stderr, "main: error computing omega\n");
+			 exit(EXIT_FAILURE);
+		  }
+		  printf("%.15e\n", (st==UNSTABLE ? w_neg : w_pos));
+		  fflush(NULL);
+		  continue;
+	  }
+
 	   if(st==UNSTABLE)
 	   {
 		   // Instead of fetching zs from intersecs_st_SECg_br1.res, 
@@ -11,11 +11,13 @@
 #include <assert.h>
 
 #include <gsl/gsl_integration.h>	// gsl_integration_qags
-#include <utils_module.h>           // dblcpy
+#include <utils_module.h>           // dblcpy, dblsum
 #include <rtbpdel.h>            	// f0_stoch
 #include <frtbpred.h>
 #include <frtbp.h>
 #include <cardel.h>
+#include <htraj.h>			// htraj_build, htraj_eval
+#include <tolprof.h>			// tolprof_tol
 
 // We request a absolute error of 0 and a relative error $10^{-13}$.
 
@@ -24,11 +26,16 @@
 const double INTEGRATION_EPSABS = 0.0;
 const double INTEGRATION_EPSREL = 1.e-8;
 
+int omega_pm_stoch(double mu, const double x[DIM], const htraj_t *orbit,
+      double t0, int N, double T0, int sgn, double *omega);
+int omega_pm_stoch_period(double mu, double xi_car[DIM], int sgn,
+      double *res);
+
 /// Parameters to the \ref integrand_omega_pm function.
 struct iparams_omega_pm
 {
    double mu;
-   double x[DIM];
+   const htraj_t *gamma;	///< trajectory \f$\gamma_i(s)\f$ of reduced flow
 };
 
 double integrand_omega_pm(double s, void *params)
@@ -43,19 +50,11 @@ double integrand_omega_pm(double s, void *params)
 
    mu = ((struct iparams_omega_pm *)params)->mu;
 
-   x[0] = ((struct iparams_omega_pm *)params)->x[0];    // l
-   x[1] = ((struct iparams_omega_pm *)params)->x[1];    // L
-   x[2] = ((struct iparams_omega_pm *)params)->x[2];    // g
-   x[3] = ((struct iparams_omega_pm *)params)->x[3];    // G
-
-   x[4] = 0;    // t
-   x[5] = 0;    // I (not used).
-
-   // Compute x = \lambda(s)
-   status = frtbp_red_g(mu,s,x);
+   // Compute x = \lambda(s), from the stored trajectory
+   status = htraj_eval(((struct iparams_omega_pm *)params)->gamma,s,x);
    if(status)
    {
-      fprintf(stderr, "integrand_omega_pm: error integrating trajectory");
+      fprintf(stderr, "integrand_omega_pm: error evaluating trajectory");
       exit(EXIT_FAILURE);
    }
 
@@ -76,58 +75,21 @@ double integrand_omega_pm(double s, void *params)
 
 int omega_pos_stoch(double mu, double x[DIM], int N, double T0, double *omega) 
 {
-   double result, error;
-
-   // auxiliary variables
-   int i, status;
-   double xi[DIM];		    /* point \xi=P^{-(N-i)}(z^s) in Delaunay */
-   double xi_car[DIM];	    /* point \xi=P^{-(N-i)}(z^s) in Cartesian */
-   double t;
-
-   double T = 2*M_PI+T0;
-
-   assert(N>0);
-
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
-
-   struct iparams_omega_pm params;
+   // \omega_+
+   return omega_pm_stoch(mu, x, NULL, 0, N, T0, -1, omega);
+}
 
-   gsl_function F;
-   F.function = &integrand_omega_pm;
-   F.params = &params;
+int omega_pos_stoch_htraj(double mu, const htraj_t *tr, double t0, int N,
+      double T0, double *omega)
+{
+   double x[DIM];
 
-   params.mu = mu;
-   
-   *omega = 0.0;
-   for(i=N; i>=1; i--)
+   if(htraj_eval(tr, t0, x))
    {
-      // $\gamma_i(s)$ is the homoclinic trajectory that starts at the
-      // point \xi = P^{-(N-i)}(z^s) = P^{i}(z). 
-       dblcpy(xi_car,x,DIM);
-
-	   status = frtbp(mu,-(N-i)*T,xi_car);
-	   if(status)
-	   {
-         fprintf(stderr, "omega_pos_stoch: error computing point P^{-%d}(z^s)\n",
-               N-i);
-         return(1);
-	   }
-	   cardel(xi_car,xi);
-
-      dblcpy(params.x, xi, DIM);
-
-      // Integrate integrand function from -2\pi to 0. 
-      gsl_integration_qags (&F, -2*M_PI, 0, INTEGRATION_EPSABS,
-			  INTEGRATION_EPSREL, 1000, w, &result, &error); 
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // \omega_+
-      (*omega) = (*omega) +(result + T0);
+      fprintf(stderr, "omega_pos_stoch_htraj: time out of the store\n");
+      return(1);
    }
-
-   gsl_integration_workspace_free (w);
-   return 0;
+   return omega_pm_stoch(mu, x, tr, t0, N, T0, -1, omega);
 }
 
 // NOTE: Instead of P^{N-i}(z^u), we use frtbp_red(2(N-i)\pi, z^u). They should
@@ -135,57 +97,164 @@ int omega_pos_stoch(double mu, double x[DIM], int N, double T0, double *omega)
 
 int omega_neg_stoch(double mu, double x[DIM], int N, double T0, double *omega)
 {
-   double result, error;
+   // \omega_-
+   return omega_pm_stoch(mu, x, NULL, 0, N, T0, 1, omega);
+}
 
-   // auxiliary variables
-   int i, status;
-   double xi[DIM];		    /* point \xi=P^{N-i}(z^u) in Delaunay */
-   double xi_car[DIM];	    /* point \xi=P^{N-i}(z^u) in Cartesian */
-   double t;
+int omega_neg_stoch_htraj(double mu, const htraj_t *tr, double t0, int N,
+      double T0, double *omega)
+{
+   double x[DIM];
 
+   if(htraj_eval(tr, t0, x))
+   {
+      fprintf(stderr, "omega_neg_stoch_htraj: time out of the store\n");
+      return(1);
+   }
+   return omega_pm_stoch(mu, x, tr, t0, N, T0, 1, omega);
+}
+
+// name OF FUNCTION: omega_pm_stoch
+//
+// PURPOSE
+// =======
+// Common part of omega_pos_stoch (sgn=-1) and omega_neg_stoch (sgn=+1).
+// Compute
+//
+// \[ \sum_{i=N,1} (\int_{sgn 2\pi}^{0} f0(\gamma_i(s)) ds - sgn T_0), \]
+//
+// where \gamma_i(s) is the trajectory of the reduced flow that starts at the
+// point \xi = \phi_{sgn(N-i)T}(x), T=2\pi+T_0.
+//
+// If orbit is NULL, the homoclinic orbit is integrated once, from x to
+// \phi_{sgn(N-1)T}(x). Otherwise, orbit is a store of the homoclinic orbit
+// (e.g. written by intersec) with x = \phi_{t0}, and nothing is integrated.
+// The points \xi are evaluated from the store. Then the N terms are
+// independent: they are computed in parallel (if compiled with OpenMP), and
+// added up in a fixed order with dblsum, so the result does not depend on
+// the number of threads.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+
+int omega_pm_stoch(double mu, const double x[DIM], const htraj_t *orbit,
+      double t0, int N, double T0, int sgn, double *omega)
+{
+   const char *name = (sgn<0 ? "omega_pos_stoch" : "omega_neg_stoch");
    double T = 2*M_PI+T0;
+   htraj_t tr;		    /* homoclinic orbit from x, in Cartesian */
+   double *terms;	    /* terms[N-i] = i-th term of the sum */
+
+   // auxiliary variables
+   int i;
+   int err = 0;
+   int own = 0;		    /* tr is built (and freed) here */
 
    assert(N>0);
 
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (1000);
+   terms = malloc(N*sizeof(double));
+   if(terms == NULL)
+   {
+      fprintf(stderr, "%s: out of memory\n", name);
+      return(1);
+   }
+   if(orbit == NULL && N>1)
+   {
+      if(htraj_build(&tr,mu,frtbp,DIM,0,x,sgn*(N-1)*T,HTRAJ_SEGLEN))
+      {
+	 fprintf(stderr, "%s: error integrating homoclinic orbit\n", name);
+	 free(terms);
+	 return(1);
+      }
+      orbit = &tr;
+      own = 1;
+   }
+   
+#pragma omp parallel for schedule(dynamic) reduction(|:err)
+   for(i=N; i>=1; i--)
+   {
+      double xi_car[DIM];   /* point \xi in Cartesian */
+
+      if(i==N)
+	 dblcpy(xi_car,x,DIM);
+      else if(htraj_eval(orbit, t0+sgn*(N-i)*T, xi_car))
+      {
+	 fprintf(stderr, "%s: point P^{%d} is out of the store\n", name,
+	       sgn*(N-i));
+	 err = 1;
+	 continue;
+      }
+      if(omega_pm_stoch_period(mu, xi_car, sgn, &terms[N-i]))
+      {
+	 fprintf(stderr, "%s: error computing term i=%d\n", name, i);
+	 err = 1;
+	 continue;
+      }
+      terms[N-i] -= sgn*T0;
+   }
 
-   struct iparams_omega_pm params;
+   if(own) htraj_free(&tr);
+   *omega = (err ? 0.0 : dblsum(terms, N));
+   free(terms);
+   return err;
+}
 
+// name OF FUNCTION: omega_pm_stoch_period
+//
+// PURPOSE
+// =======
+// Compute one term of the sum in omega_pm_stoch, without the shift T_0:
+//
+// \[ \int_{sgn 2\pi}^{0} f0(\gamma(s)) ds, \]
+//
+// where \gamma(s) is the trajectory of the reduced flow that starts at the
+// point \xi of the homoclinic orbit (xi_car, in Cartesian).
+//
+// All workspaces are local, so this function can be called concurrently
+// from several threads.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+
+int omega_pm_stoch_period(double mu, double xi_car[DIM], int sgn,
+      double *res)
+{
+   double result, error;
+   double xi[DIM];		    /* point \xi in Delaunay */
+   double xi_red[DIMRED];   /* point \xi in the reduced flow, with t=I=0 */
+   htraj_t gamma;	    /* \gamma(s), s\in[0,sgn 2\pi], in the reduced flow */
+
+   struct iparams_omega_pm params;
    gsl_function F;
-   F.function = &integrand_omega_pm;
-   F.params = &params;
+   gsl_integration_workspace * w;
+
+   cardel(xi_car,xi);
+
+   // $\gamma(s)$ is integrated once, and the integrand only evaluates it.
+   dblcpy(xi_red, xi, DIM);
+   xi_red[4] = 0;    // t
+   xi_red[5] = 0;    // I (not used).
+   if(htraj_build(&gamma,mu,frtbp_red_g,DIMRED,0,xi_red,sgn*2*M_PI,
+	    HTRAJ_SEGLEN_RED))
+      return(1);
 
    params.mu = mu;
-   
-   *omega = 0.0;
-   for(i=N; i>=1; i--)
-   {
-      // $\gamma_i(s)$ is the homoclinic trajectory that starts at the
-      // point \xi = P^{N-i}(z^u) = P^{-i}(z). 
-       dblcpy(xi_car,x,DIM);
-
-	   // Compute x = \lambda(s)
-	   status = frtbp(mu,(N-i)*T,xi_car);
-	   if(status)
-	   {
-         fprintf(stderr, "omega_neg_stoch: error computing point P^{%d}(z^u)\n",
-               N-i);
-         return(1);
-	   }
-	   cardel(xi_car,xi);
-
-      dblcpy(params.x, xi, DIM);
-
-      // Integrate integrand function from 2\pi to 0. 
-      gsl_integration_qags (&F, 2*M_PI, 0, INTEGRATION_EPSABS,
-			  INTEGRATION_EPSREL, 1000, w, &result, &error); 
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // \omega_-
-      (*omega) = (*omega) +(result - T0);
-   }
+   params.gamma = &gamma;
+   F.function = &integrand_omega_pm;
+   F.params = &params;
 
+   // Integrate integrand function from sgn*2\pi to 0. 
+   w = gsl_integration_workspace_alloc (1000);
+   gsl_integration_qags (&F, sgn*2*M_PI, 0, INTEGRATION_EPSABS,
+	 tolprof_tol(TOL_QUAD,INTEGRATION_EPSREL), 1000, w, &result, &error); 
+   fprintf (stderr, "estimated error = % .3le\n", error);
    gsl_integration_workspace_free (w);
+   htraj_free(&gamma);
+
+   *res = result;
    return 0;
 }
@@ -6,6 +6,7 @@
 #define OUTER_CIRC_STOCH_MODULE_H_INCLUDED
 
 #include <rtbp.h>   // DIM
+#include <htraj.h>  // htraj_t
 
 /**
   Given an energy level \f$H\f$, compute \f$\omega_-^j(H)\f$.
@@ -65,6 +66,18 @@
 
 int omega_neg_stoch(double mu, double x[DIM], int N, double T0, double *omega);
 
+/**
+  Compute \f$\omega_-^j(H)\f$ along a stored homoclinic.
+
+  Same as \ref omega_neg_stoch, but the homoclinic is evaluated from a
+  trajectory store in Cartesian coordinates (such as those written by
+  intersec) instead of being integrated again. The point z^u is the point of
+  the store at time t0, and the points P^{N-i}(z^u) are those at times
+  t0+(N-i)T, T=2\pi+T_0, which must be in the store.
+  */
+int omega_neg_stoch_htraj(double mu, const htraj_t *tr, double t0, int N,
+      double T0, double *omega);
+
 /**
   Given an energy level \f$H\f$, compute \f$\omega_+^j(H)\f$.
 
@@ -123,5 +136,15 @@ int omega_neg_stoch(double mu, double x[DIM], int N, double T0, double *omega);
 
 int omega_pos_stoch(double mu, double x[DIM], int N, double T0, double *omega);
 
+/**
+  Compute \f$\omega_+^j(H)\f$ along a stored homoclinic.
+
+  Same as \ref omega_pos_stoch, with z^s the point of the store at time t0,
+  and P^{-(N-i)}(z^s) those at times t0-(N-i)T (see \ref
+  omega_neg_stoch_htraj).
+  */
+int omega_pos_stoch_htraj(double mu, const htraj_t *tr, double t0, int N,
+      double T0, double *omega);
+
 #endif // OUTER_CIRC_STOCH_MODULE_H_INCLUDED
 
@@ -56,6 +56,8 @@
 #include <rtbpdel.h>			// rtbp_del
 #include <frtbpred.h>
 #include <inner_ell.h>			// re_f_integrand, im_f_integrand
+#include <htraj.h>			// htraj_periodic, htraj_eval
+#include <tolprof.h>			// tolprof_tol
 
 // 1.e-6 is too much
 const double RELERROR = 1.e-2;
@@ -64,7 +66,8 @@ const size_t NINTERVALS = 1000;
 struct iparams_outer_ell
 {
    double mu;
-   double p_red[DIMRED];
+   const htraj_t *gamma_p;	// periodic trajectory, from (p,t=0)
+   double t_p;			// shift of time t along gamma_p
    double h_red[DIMRED];
 };
 
@@ -85,8 +88,9 @@ struct iparams_outer_ell
 //    integration time in the homoclinic trajectory.
 // mu
 //    mass parameter for the RTBP
-// p
-//    periodic point, 6 coordinates: (l_p,L_p,g_p,G_p,t_p,I_p). 
+// gamma_p, t_p
+//    stored periodic trajectory from (l_p,L_p,g_p,G_p,0,0), and shift of
+//    its time component t.
 // h
 //    homoclinic point, 6 coordinates: (l_h,L_h,g_h,G_h,t_h,I_h). 
 // 
@@ -100,13 +104,14 @@ struct iparams_outer_ell
 // (or $\gamma_4$), and $h$ is a point in the homoclinic trajectory
 // $\gamma^f$.
 //
-// CALLS TO: frtbp_red, re_f_integrand, im_f_integrand
+// CALLS TO: htraj_eval, frtbp_red, re_f_integrand, im_f_integrand
 
 double re_integrand_B(double s, void *params)
 {
    double mu;
    double p[DIMRED];
    double h[DIMRED];
+   const struct iparams_outer_ell *par = params;
 
    // auxiliary variables
    int i,status;
@@ -122,19 +127,16 @@ double re_integrand_B(double s, void *params)
    mu = ((struct iparams_outer_ell *)params)->mu;
 
    for(i=0;i<DIMRED;i++)
-   {
-      p[i] = ((struct iparams_outer_ell *)params)->p_red[i];
-      h[i] = ((struct iparams_outer_ell *)params)->h_red[i];
-   }
+      h[i] = par->h_red[i];
 
-   // Compute $\Phi_s(p)$
-   status = frtbp_red(mu,s,p);
+   // Evaluate $\Phi_s(p)$ from the stored periodic trajectory
+   status = htraj_eval(par->gamma_p,s,p);
    if(status)
    {
-      fprintf(stderr, "integrand: error integrating trajectory");
+      fprintf(stderr, "integrand: error evaluating trajectory");
       exit(EXIT_FAILURE);
    }
-   t_p = p[4];
+   t_p = par->t_p + p[4];
 
    // Compute $\Phi_s(h)$
    status = frtbp_red(mu,s,h);
@@ -171,6 +173,7 @@ double im_integrand_B(double s, void *params)
    double mu;
    double p[DIMRED];
    double h[DIMRED];
+   const struct iparams_outer_ell *par = params;
 
    // auxiliary variables
    int i,status;
@@ -186,19 +189,16 @@ double im_integrand_B(double s, void *params)
    mu = ((struct iparams_outer_ell *)params)->mu;
 
    for(i=0;i<DIMRED;i++)
-   {
-      p[i] = ((struct iparams_outer_ell *)params)->p_red[i];
-      h[i] = ((struct iparams_outer_ell *)params)->h_red[i];
-   }
+      h[i] = par->h_red[i];
 
-   // Compute $\Phi_s(p)$
-   status = frtbp_red(mu,s,p);
+   // Evaluate $\Phi_s(p)$ from the stored periodic trajectory
+   status = htraj_eval(par->gamma_p,s,p);
    if(status)
    {
-      fprintf(stderr, "integrand: error integrating trajectory");
+      fprintf(stderr, "integrand: error evaluating trajectory");
       exit(EXIT_FAILURE);
    }
-   t_p = p[4];
+   t_p = par->t_p + p[4];
 
    // Compute $\Phi_s(h)$
    status = frtbp_red(mu,s,h);
@@ -327,6 +327,8 @@ int re_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
 
    // auxiliary variables
    int j;
+   const htraj_t *gamma_p;	// periodic trajectory, one period
+   double tau_p;		// increment of t over one period
    double pi_red[DIMRED]; 	// point pi = P^{-i}(p)
    double xi_red[DIMRED]; 	// point xi = P^{M-i}(z^u)
    double t;
@@ -348,10 +350,21 @@ int re_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
    frtbp_red(mu, -14*M*M_PI, xi_red);
    tf = -xi_red[4];
 
+   // Periodic trajectory from p, over one period. It is integrated only
+   // once per energy level (see htraj_periodic).
    for(j=0;j<DIM;j++) pi_red[j]=p[j];
-   // Initialize t,I components.
-   pi_red[4] = -mu*omega;  // t_0-\mu\omega_0^+
+   pi_red[4] = 0;              // t_0
    pi_red[5] = 0;              // I_0
+   gamma_p = htraj_periodic(mu, frtbp_red, DIMRED, pi_red, 14*M_PI,
+	 HTRAJ_SEGLEN_RED);
+   if(gamma_p == NULL)
+   {
+      fprintf(stderr, "integrand: error integrating trajectory");
+      exit(EXIT_FAILURE);
+   }
+   htraj_eval(gamma_p, 14*M_PI, pi_red);
+   tau_p = pi_red[4];
+   params.gamma_p = gamma_p;
 
    result = 0;
    for(i=0; i<N; i++)
@@ -368,31 +381,21 @@ int re_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
       }
 
       for(j=0;j<DIMRED;j++)
-      {
-	 params.p_red[j] = pi_red[j];
 	 params.h_red[j] = xi_red[j];
-      }
+
+      // periodic point p_3. It is important to exploit the fact that
+      // \Phi_{14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p), so the i-th period
+      // is the stored one with time t_0-\mu\omega_0^+ shifted by i*tau_p.
+      params.t_p = -mu*omega + i*tau_p;
 
       // Integrate integrand function by parts. 
       // Previously, we used 14M parts of size \pi. Now we use M parts of
       // size 14pi.
       // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qags (&F, 0, 14*M_PI, 0, RELERROR, NINTERVALS, w,
-	    &result_i, &error);
+      gsl_integration_qags (&F, 0, 14*M_PI, 0,
+	    tolprof_tol(TOL_QUAD,RELERROR), NINTERVALS, w, &result_i, &error);
       fprintf (stderr, "estimated error = % .3le\n", error);
 
-      // periodic point p_3
-
-      // It is important to exploit the fact that
-      // \Phi_{14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      for(j=0;j<DIM;j++) pi_red[j]=p[j];
-      status = frtbp_red(mu,14*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
       result += result_i;
    }
    gsl_integration_workspace_free (w);
@@ -417,6 +420,8 @@ int im_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
 
    // auxiliary variables
    int j;
+   const htraj_t *gamma_p;	// periodic trajectory, one period
+   double tau_p;		// increment of t over one period
    double pi_red[DIMRED]; 	// point pi = P^{-i}(p)
    double xi_red[DIMRED]; 	// point xi = P^{M-i}(z^u)
    double t;
@@ -438,10 +443,21 @@ int im_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
    frtbp_red(mu, -14*M*M_PI, xi_red);
    tf = -xi_red[4];
 
+   // Periodic trajectory from p, over one period. It is integrated only
+   // once per energy level (see htraj_periodic).
    for(j=0;j<DIM;j++) pi_red[j]=p[j];
-   // Initialize t,I components.
-   pi_red[4] = -mu*omega;  // t_0-\mu\omega_0^+
+   pi_red[4] = 0;              // t_0
    pi_red[5] = 0;              // I_0
+   gamma_p = htraj_periodic(mu, frtbp_red, DIMRED, pi_red, 14*M_PI,
+	 HTRAJ_SEGLEN_RED);
+   if(gamma_p == NULL)
+   {
+      fprintf(stderr, "integrand: error integrating trajectory");
+      exit(EXIT_FAILURE);
+   }
+   htraj_eval(gamma_p, 14*M_PI, pi_red);
+   tau_p = pi_red[4];
+   params.gamma_p = gamma_p;
 
    result = 0;
    for(i=0; i<N; i++)
@@ -458,31 +474,21 @@ int im_B(double mu, double p[DIM], double zu[DIM], double omega, double *res,
       }
 
       for(j=0;j<DIMRED;j++)
-      {
-	 params.p_red[j] = pi_red[j];
 	 params.h_red[j] = xi_red[j];
-      }
+
+      // periodic point p_3. It is important to exploit the fact that
+      // \Phi_{14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p), so the i-th period
+      // is the stored one with time t_0-\mu\omega_0^+ shifted by i*tau_p.
+      params.t_p = -mu*omega + i*tau_p;
 
       // Integrate integrand function by parts. 
       // Previously, we used 14M parts of size \pi. Now we use M parts of
       // size 14pi.
       // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qags (&F, 0, 14*M_PI, 0, RELERROR, NINTERVALS, w,
-	    &result_i, &error);
+      gsl_integration_qags (&F, 0, 14*M_PI, 0,
+	    tolprof_tol(TOL_QUAD,RELERROR), NINTERVALS, w, &result_i, &error);
       fprintf (stderr, "estimated error = % .3le\n", error);
 
-      // periodic point p_3
-
-      // It is important to exploit the fact that
-      // \Phi_{14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      for(j=0;j<DIM;j++) pi_red[j]=p[j];
-      status = frtbp_red(mu,14*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
       result += result_i;
    }
    gsl_integration_workspace_free (w);
@@ -588,6 +594,8 @@ int re_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
 
    // auxiliary variables
    int j;
+   const htraj_t *gamma_p;	// periodic trajectory, one period
+   double tau_p;		// increment of t over one period
    double pi_red[DIMRED]; 	// point pi = P^{i}(p)
    double xi_red[DIMRED]; 	// point xi = P^{-(M-i)}(z^s)
    double t;
@@ -609,10 +617,21 @@ int re_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
    frtbp_red(mu, 14*M*M_PI, xi_red);
    tf = -xi_red[4];
 
+   // Periodic trajectory from p, over one period. It is integrated only
+   // once per energy level (see htraj_periodic).
    for(j=0;j<DIM;j++) pi_red[j]=p[j];
-   // Initialize t,I components.
-   pi_red[4] = -mu*omega;  // t_0-\mu\omega_0^-
+   pi_red[4] = 0;              // t_0
    pi_red[5] = 0;              // I_0
+   gamma_p = htraj_periodic(mu, frtbp_red, DIMRED, pi_red, -14*M_PI,
+	 HTRAJ_SEGLEN_RED);
+   if(gamma_p == NULL)
+   {
+      fprintf(stderr, "integrand: error integrating trajectory");
+      exit(EXIT_FAILURE);
+   }
+   htraj_eval(gamma_p, -14*M_PI, pi_red);
+   tau_p = pi_red[4];
+   params.gamma_p = gamma_p;
 
    result = 0;
    for(i=0; i<N; i++)
@@ -629,31 +648,21 @@ int re_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
       }
 
       for(j=0;j<DIMRED;j++)
-      {
-	 params.p_red[j] = pi_red[j];
 	 params.h_red[j] = xi_red[j];
-      }
+
+      // periodic point p_4. It is important to exploit the fact that
+      // \Phi_{-14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p), so the i-th period
+      // is the stored one with time t_0-\mu\omega_0^- shifted by i*tau_p.
+      params.t_p = -mu*omega + i*tau_p;
 
       // Integrate integrand function by parts. 
       // Previously, we used 14M parts of size \pi. Now we use M parts of
       // size 14pi.
       // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qags (&F, 0, -14*M_PI, 0, RELERROR, NINTERVALS, w,
-	    &result_i, &error);
+      gsl_integration_qags (&F, 0, -14*M_PI, 0,
+	    tolprof_tol(TOL_QUAD,RELERROR), NINTERVALS, w, &result_i, &error);
       fprintf (stderr, "estimated error = % .3le\n", error);
 
-      // periodic point p_4
-
-      // It is important to exploit the fact that
-      // \Phi_{-14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      for(j=0;j<DIM;j++) pi_red[j]=p[j];
-      status = frtbp_red(mu,-14*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
       result += result_i;
    }
    gsl_integration_workspace_free (w);
@@ -678,6 +687,8 @@ int im_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
 
    // auxiliary variables
    int j;
+   const htraj_t *gamma_p;	// periodic trajectory, one period
+   double tau_p;		// increment of t over one period
    double pi_red[DIMRED]; 	// point pi = P^{i}(p)
    double xi_red[DIMRED]; 	// point xi = P^{-(M-i)}(z^s)
    double t;
@@ -699,10 +710,21 @@ int im_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
    frtbp_red(mu, 14*M*M_PI, xi_red);
    tf = -xi_red[4];
 
+   // Periodic trajectory from p, over one period. It is integrated only
+   // once per energy level (see htraj_periodic).
    for(j=0;j<DIM;j++) pi_red[j]=p[j];
-   // Initialize t,I components.
-   pi_red[4] = -mu*omega;  // t_0-\mu\omega_0^-
+   pi_red[4] = 0;              // t_0
    pi_red[5] = 0;              // I_0
+   gamma_p = htraj_periodic(mu, frtbp_red, DIMRED, pi_red, -14*M_PI,
+	 HTRAJ_SEGLEN_RED);
+   if(gamma_p == NULL)
+   {
+      fprintf(stderr, "integrand: error integrating trajectory");
+      exit(EXIT_FAILURE);
+   }
+   htraj_eval(gamma_p, -14*M_PI, pi_red);
+   tau_p = pi_red[4];
+   params.gamma_p = gamma_p;
 
    result = 0;
    for(i=0; i<N; i++)
@@ -719,31 +741,21 @@ int im_C(double mu, double p[DIM], double zs[DIM], double omega, double *res,
       }
 
       for(j=0;j<DIMRED;j++)
-      {
-	 params.p_red[j] = pi_red[j];
 	 params.h_red[j] = xi_red[j];
-      }
+
+      // periodic point p_4. It is important to exploit the fact that
+      // \Phi_{-14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p), so the i-th period
+      // is the stored one with time t_0-\mu\omega_0^- shifted by i*tau_p.
+      params.t_p = -mu*omega + i*tau_p;
 
       // Integrate integrand function by parts. 
       // Previously, we used 14M parts of size \pi. Now we use M parts of
       // size 14pi.
       // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qags (&F, 0, -14*M_PI, 0, RELERROR, NINTERVALS, w,
-	    &result_i, &error);
+      gsl_integration_qags (&F, 0, -14*M_PI, 0,
+	    tolprof_tol(TOL_QUAD,RELERROR), NINTERVALS, w, &result_i, &error);
       fprintf (stderr, "estimated error = % .3le\n", error);
 
-      // periodic point p_4
-
-      // It is important to exploit the fact that
-      // \Phi_{-14\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      for(j=0;j<DIM;j++) pi_red[j]=p[j];
-      status = frtbp_red(mu,-14*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
       result += result_i;
    }
    gsl_integration_workspace_free (w);
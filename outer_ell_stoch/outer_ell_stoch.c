@@ -51,10 +51,12 @@
 
 #include <gsl/gsl_integration.h>	// gsl_integration_qags
 
-#include <utils_module.h>       // dblcpy
+#include <utils_module.h>       // dblcpy, dblsum
 #include <rtbpdel.h>			// rtbp_del
 #include <frtbpred.h>
 #include <inner_ell_stoch.h>	// re_f_integrand_stoch, im_f_integrand_stoch
+#include <htraj.h>		// htraj_build, htraj_eval
+#include <tolprof.h>		// tolprof_tol
 
 // 1.e-6 is too much
 const double RELERROR = 1.e-5;
@@ -63,10 +65,18 @@ const size_t NINTERVALS = 1000;
 struct iparams_outer_ell_stoch
 {
    double mu;
-   double p_red[DIMRED];
-   double h_red[DIMRED];
+   const htraj_t *gamma_p;	// periodic trajectory, from (p,t=0)
+   const htraj_t *gamma_h;	// homoclinic trajectory, from (z,t=0)
+   double t_p;		// shift of time t along gamma_p
+   double t_h;		// shift of time t along gamma_h
+   double s_h;		// shift of s along gamma_h
 };
 
+int gamma_ph(double s, struct iparams_outer_ell_stoch *par, double p2[DIM],
+      double h2[DIM], double *t_p, double *t_h);
+int outer_ell_stoch(double mu, double p[DIM], double z[DIM], double omega,
+      double *res, int M, int N, int sgn, double (*integrand)(double, void *));
+
 // name OF FUNCTION: re_integrand_B_stoch
 //
 // PURPOSE
@@ -82,12 +92,9 @@ struct iparams_outer_ell_stoch
 // ==========
 // s
 //    integration time in the homoclinic trajectory.
-// mu
-//    mass parameter for the RTBP
-// p
-//    periodic point, 6 coordinates: (l_p,L_p,g_p,G_p,t_p,I_p). 
-// h
-//    homoclinic point, 6 coordinates: (l_h,L_h,g_h,G_h,t_h,I_h). 
+// params
+//    struct iparams_outer_ell_stoch, with the stored periodic and
+//    homoclinic trajectories of the reduced flow (see gamma_ph).
 // 
 // RETURN VALUE
 // ============
@@ -99,16 +106,14 @@ struct iparams_outer_ell_stoch
 // (or $\gamma_4$), and $h$ is a point in the homoclinic trajectory
 // $\gamma^f$.
 //
-// CALLS TO: frtbp_red_g, re_f_integrand_stoch, im_f_integrand_stoch
+// CALLS TO: gamma_ph, re_f_integrand_stoch, im_f_integrand_stoch
+
 
 double re_integrand_B_stoch(double s, void *params)
 {
    double mu;
-   double p[DIMRED];
-   double h[DIMRED];
 
    // auxiliary variables
-   int status;
    double p2[DIM], h2[DIM];
 
    double t_p, t_h;     // original time
@@ -120,32 +125,12 @@ double re_integrand_B_stoch(double s, void *params)
 
    mu = ((struct iparams_outer_ell_stoch *)params)->mu;
 
-   dblcpy(p, ((struct iparams_outer_ell_stoch *)params)->p_red, DIMRED);
-   dblcpy(h, ((struct iparams_outer_ell_stoch *)params)->h_red, DIMRED);
-
-   // Compute $\Phi_s(p)$
-   status = frtbp_red_g(mu,s,p);
-   if(status)
-   {
-      fprintf(stderr, "integrand: error integrating trajectory");
-      exit(EXIT_FAILURE);
-   }
-   t_p = p[4];
-
-   // Compute $\Phi_s(h)$
-   status = frtbp_red_g(mu,s,h);
-   if(status)
+   // Evaluate $\Phi_s(p)$ and $\Phi_s(h)$
+   if(gamma_ph(s, params, p2, h2, &t_p, &t_h))
    {
-      fprintf(stderr, "integrand: error integrating trajectory");
+      fprintf(stderr, "integrand: error evaluating trajectory");
       exit(EXIT_FAILURE);
    }
-   t_h = h[4];
-
-   // p2=\Phi_s(p)
-   dblcpy(p2,p,DIM);
-
-   // h2=\Phi_s(h)
-   dblcpy(h2,h,DIM);
 
    // Compute first term in integrand: f(\gamma_h(s)) e^{it_h} (real part).
    re_fh = re_f_integrand_stoch(mu,h2);
@@ -154,7 +139,7 @@ double re_integrand_B_stoch(double s, void *params)
 
    // Compute second term in integrand: f(\gamma_p(s)) e^{i(t_p+\omega)}
    // (real part). Notice that t_p has already been shifted by \omega in
-   // function re_B_stoch, so no need to do it here.
+   // function outer_ell_stoch, so no need to do it here.
    re_fp = re_f_integrand_stoch(mu,p2);
    im_fp = im_f_integrand_stoch(mu,p2);
    term2 = -(re_fp*sin(t_p) + im_fp*cos(t_p));
@@ -165,11 +150,8 @@ double re_integrand_B_stoch(double s, void *params)
 double im_integrand_B_stoch(double s, void *params)
 {
    double mu;
-   double p[DIMRED];
-   double h[DIMRED];
 
    // auxiliary variables
-   int status;
    double p2[DIM], h2[DIM];
 
    double t_p, t_h;     // original time
@@ -181,32 +163,12 @@ double im_integrand_B_stoch(double s, void *params)
 
    mu = ((struct iparams_outer_ell_stoch *)params)->mu;
 
-   dblcpy(p, ((struct iparams_outer_ell_stoch *)params)->p_red, DIMRED);
-   dblcpy(h, ((struct iparams_outer_ell_stoch *)params)->h_red, DIMRED);
-
-   // Compute $\Phi_s(p)$
-   status = frtbp_red_g(mu,s,p);
-   if(status)
-   {
-      fprintf(stderr, "integrand: error integrating trajectory");
-      exit(EXIT_FAILURE);
-   }
-   t_p = p[4];
-
-   // Compute $\Phi_s(h)$
-   status = frtbp_red_g(mu,s,h);
-   if(status)
+   // Evaluate $\Phi_s(p)$ and $\Phi_s(h)$
+   if(gamma_ph(s, params, p2, h2, &t_p, &t_h))
    {
-      fprintf(stderr, "integrand: error integrating trajectory");
+      fprintf(stderr, "integrand: error evaluating trajectory");
       exit(EXIT_FAILURE);
    }
-   t_h = h[4];
-
-   // p2=\Phi_s(p)
-   dblcpy(p2,p,DIM);
-
-   // h2=\Phi_s(h)
-   dblcpy(h2,h,DIM);
 
    // Compute first term in integrand: f(\gamma_h(s)) e^{it_h} (imaginary part).
    re_fh = re_f_integrand_stoch(mu,h2);
@@ -215,7 +177,7 @@ double im_integrand_B_stoch(double s, void *params)
 
    // Compute second term in integrand: f(\gamma_p(s)) e^{i(t_p+\omega)}
    // (imaginary part). Notice that t_p has already been shifted by
-   // \omega in function re_B_stoch, so no need to do it here.
+   // \omega in function outer_ell_stoch, so no need to do it here.
    re_fp = re_f_integrand_stoch(mu,p2);
    im_fp = im_f_integrand_stoch(mu,p2);
    term2 = re_fp*cos(t_p) - im_fp*sin(t_p);
@@ -223,6 +185,36 @@ double im_integrand_B_stoch(double s, void *params)
    return term1 - term2;
 }
 
+// name OF FUNCTION: gamma_ph
+//
+// PURPOSE
+// =======
+// Evaluate the periodic and homoclinic trajectories at integration time $s$,
+// from the trajectory stores:
+//    - \gamma_p(s) = \Phi_s(p), with time $t_p$ shifted by par->t_p,
+//    - \gamma_h(s) = \Phi_{s_h+s}(z), with time $t_h$ shifted by par->t_h.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+
+int gamma_ph(double s, struct iparams_outer_ell_stoch *par, double p2[DIM],
+      double h2[DIM], double *t_p, double *t_h)
+{
+   double p[DIMRED];
+   double h[DIMRED];
+
+   if(htraj_eval(par->gamma_p, s, p) || htraj_eval(par->gamma_h, par->s_h+s, h))
+      return(1);
+   *t_p = par->t_p + p[4];
+   *t_h = par->t_h + h[4];
+
+   dblcpy(p2,p,DIM);
+   dblcpy(h2,h,DIM);
+   return(0);
+}
+
 // name OF FUNCTION: re_B_stoch
 // CREDIT: 
 //
@@ -276,6 +268,11 @@ double im_integrand_B_stoch(double s, void *params)
 //
 // This is computed using numerical integration.
 //
+// The homoclinic trajectory from z_u (for i=0,...,N-1) and one period of
+// the periodic trajectory are integrated only once, and stored as
+// piecewise Chebyshev interpolants (see htraj.h); the integrands only
+// evaluate them. Thus N must not exceed M.
+//
 // PARAMETERS
 // ==========
 // mu
@@ -301,178 +298,23 @@ double im_integrand_B_stoch(double s, void *params)
 // NOTES
 // =====
 // 
-// CALLS TO: re_integrand_B_stoch
+// CALLS TO: outer_ell_stoch, re_integrand_B_stoch
+
 
 int re_B_stoch(double mu, double p[DIM], double zu[DIM], double omega, double *res,
       int M, int N)
 {
-   double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (NINTERVALS);
-
-   struct iparams_outer_ell_stoch params;
-
-   int i;		// integration interval
-   double result_i;	// intermediate result
-
-   double tf;   // final time to reach z from z_u
-
-   // auxiliary variables
-   double pi_red[DIMRED]; 	// point pi = P^{-i}(p)
-   double xi_red[DIMRED]; 	// point xi = P^{M-i}(z^u)
-   double t;
-   int status;
-
-   params.mu = mu;
-   
-   gsl_function F;
-   F.function = &re_integrand_B_stoch;
-   F.params = &params;
-
-   // Compute the final time t_f
-   xi_red[0] = zu[0];
-   xi_red[1] = zu[1];
-   xi_red[2] = zu[2];
-   xi_red[3] = zu[3];
-   xi_red[4] = 0;              // t_0
-   xi_red[5] = 0;              // I_0
-   frtbp_red_g(mu, -2*M*M_PI, xi_red);
-   tf = -xi_red[4];
-
-   dblcpy(pi_red,p,DIM);
-   // Initialize t,I components.
-   pi_red[4] = omega;  // t_0+\omega_+^f
-   pi_red[5] = 0;      // I_0
-
-   result = 0;
-   for(i=0; i<N; i++)
-   {
-      // homoclinic point z_u
-       dblcpy(xi_red,zu,DIM);
-      xi_red[4] = tf;	// t_0+t_f
-      xi_red[5] = 0;	// I_0
-      status = frtbp_red_g(mu,-(M-i)*2*M_PI,xi_red);
-      if(status)
-      {
-	 fprintf(stderr, "re_B_stoch: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      dblcpy(params.p_red, pi_red, DIMRED);
-      dblcpy(params.h_red, xi_red, DIMRED);
-
-      // Integrate integrand function by parts. 
-      // Previously, we used 2M parts of size \pi. Now we use M parts of
-      // size 2pi.
-      // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qag (&F, 0, 2*M_PI, 0, RELERROR, NINTERVALS,
-              GSL_INTEG_GAUSS61, w, &result_i, &error);
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // periodic point p_3
-
-      // It is important to exploit the fact that
-      // \Phi_{2\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      dblcpy(pi_red, p, DIM);
-      status = frtbp_red_g(mu,2*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      result += result_i;
-   }
-   gsl_integration_workspace_free (w);
-
-   *res = result;		// real(B^+)
-   return 0;
+   // real(B^+)
+   return outer_ell_stoch(mu, p, zu, omega, res, M, N, 1,
+         &re_integrand_B_stoch);
 }
 
 int im_B_stoch(double mu, double p[DIM], double zu[DIM], double omega, double *res,
       int M, int N)
 {
-   double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (NINTERVALS);
-
-   struct iparams_outer_ell_stoch params;
-
-   int i;		// integration interval
-   double result_i;	// intermediate result
-
-   double tf;   // final time to reach z from z_u
-
-   // auxiliary variables
-   double pi_red[DIMRED]; 	// point pi = P^{-i}(p)
-   double xi_red[DIMRED]; 	// point xi = P^{M-i}(z^u)
-   double t;
-   int status;
-
-   params.mu = mu;
-   
-   gsl_function F;
-   F.function = &im_integrand_B_stoch;
-   F.params = &params;
-
-   // Compute the final time t_f
-   xi_red[0] = zu[0];
-   xi_red[1] = zu[1];
-   xi_red[2] = zu[2];
-   xi_red[3] = zu[3];
-   xi_red[4] = 0;              // t_0
-   xi_red[5] = 0;              // I_0
-   frtbp_red_g(mu, -2*M*M_PI, xi_red);
-   tf = -xi_red[4];
-
-   dblcpy(pi_red,p,DIM);
-   // Initialize t,I components.
-   pi_red[4] = omega;  // t_0+\omega_0^+
-   pi_red[5] = 0;              // I_0
-
-   result = 0;
-   for(i=0; i<N; i++)
-   {
-      // homoclinic point z_u
-       dblcpy(xi_red,zu,DIM);
-      xi_red[4] = tf;	// t_0+t_f
-      xi_red[5] = 0;	// I_0
-      status = frtbp_red_g(mu,-(M-i)*2*M_PI,xi_red);
-      if(status)
-      {
-	 fprintf(stderr, "re_B_stoch: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      dblcpy(params.p_red, pi_red, DIMRED);
-      dblcpy(params.h_red, xi_red, DIMRED);
-
-      // Integrate integrand function by parts. 
-      // Previously, we used 2M parts of size \pi. Now we use M parts of
-      // size 2pi.
-      // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qag (&F, 0, 2*M_PI, 0, RELERROR, NINTERVALS,
-              GSL_INTEG_GAUSS61, w, &result_i, &error);
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // periodic point p_3
-
-      // It is important to exploit the fact that
-      // \Phi_{2\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      dblcpy(pi_red,p,DIM);
-      status = frtbp_red_g(mu,2*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      result += result_i;
-   }
-   gsl_integration_workspace_free (w);
-
-   *res = result;		// imaginary(B^+)
-   return 0;
+   // imaginary(B^+)
+   return outer_ell_stoch(mu, p, zu, omega, res, M, N, 1,
+         &im_integrand_B_stoch);
 }
 
 // name OF FUNCTION: re_C_stoch
@@ -529,6 +371,11 @@ int im_B_stoch(double mu, double p[DIM], double zu[DIM], double omega, double *r
 //
 // This is computed using numerical integration.
 //
+// The homoclinic trajectory from z_s (for i=0,...,N-1) and one period of
+// the periodic trajectory are integrated only once, and stored as
+// piecewise Chebyshev interpolants (see htraj.h); the integrands only
+// evaluate them. Thus N must not exceed M.
+//
 // PARAMETERS
 // ==========
 // mu
@@ -554,177 +401,140 @@ int im_B_stoch(double mu, double p[DIM], double zu[DIM], double omega, double *r
 // NOTES
 // =====
 // 
-// CALLS TO: re_integrand_B_stoch
+// CALLS TO: outer_ell_stoch, re_integrand_B_stoch
+
 
 int re_C_stoch(double mu, double p[DIM], double zs[DIM], double omega, double *res,
       int M, int N)
 {
-   double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (NINTERVALS);
-
-   struct iparams_outer_ell_stoch params;
-
-   int i;		// integration interval
-   double result_i;	// intermediate result
-
-   double tf;   // final time to reach z from z_s
-
-   // auxiliary variables
-   double pi_red[DIMRED]; 	// point pi = P^{i}(p)
-   double xi_red[DIMRED]; 	// point xi = P^{-(M-i)}(z^s)
-   double t;
-   int status;
-
-   params.mu = mu;
-   
-   gsl_function F;
-   F.function = &re_integrand_B_stoch;
-   F.params = &params;
-
-   // Compute the final time t_f
-   xi_red[0] = zs[0];
-   xi_red[1] = zs[1];
-   xi_red[2] = zs[2];
-   xi_red[3] = zs[3];
-   xi_red[4] = 0;              // t_0
-   xi_red[5] = 0;              // I_0
-   frtbp_red_g(mu, 2*M*M_PI, xi_red);
-   tf = -xi_red[4];
-
-   dblcpy(pi_red,p,DIM);
-   // Initialize t,I components.
-   pi_red[4] = omega;  // t_0+\omega_-^j
-   pi_red[5] = 0;              // I_0
-
-   result = 0;
-   for(i=0; i<N; i++)
-   {
-      // homoclinic point z_s
-       dblcpy(xi_red,zs,DIM);
-      xi_red[4] = tf;	// t_0+t_f
-      xi_red[5] = 0;	// I_0
-      status = frtbp_red_g(mu,(M-i)*2*M_PI,xi_red);
-      if(status)
-      {
-	 fprintf(stderr, "re_C_stoch: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      dblcpy(params.p_red, pi_red, DIMRED);
-      dblcpy(params.h_red, xi_red, DIMRED);
-
-      // Integrate integrand function by parts. 
-      // Previously, we used 2M parts of size \pi. Now we use M parts of
-      // size 2pi.
-      // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qag (&F, 0, -2*M_PI, 0, RELERROR, NINTERVALS,
-              GSL_INTEG_GAUSS61, w, &result_i, &error);
-      fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // periodic point p_4
-
-      // It is important to exploit the fact that
-      // \Phi_{-2\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      dblcpy(pi_red,p,DIM);
-      status = frtbp_red_g(mu,-2*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      result += result_i;
-   }
-   gsl_integration_workspace_free (w);
-
-   *res = result;		// real(C^+)
-   return 0;
+   // real(C^+)
+   return outer_ell_stoch(mu, p, zs, omega, res, M, N, -1,
+         &re_integrand_B_stoch);
 }
 
 int im_C_stoch(double mu, double p[DIM], double zs[DIM], double omega, double *res,
       int M, int N)
 {
-   double result, error;
-   gsl_integration_workspace * w
-               = gsl_integration_workspace_alloc (NINTERVALS);
+   // imaginary(C^+)
+   return outer_ell_stoch(mu, p, zs, omega, res, M, N, -1,
+         &im_integrand_B_stoch);
+}
+
+// name OF FUNCTION: outer_ell_stoch
+//
+// PURPOSE
+// =======
+// Common part of re/im_B_stoch (sgn=1) and re/im_C_stoch (sgn=-1).
+// Compute
+//
+// \[ \Sum_{i=0,N-1} \int_0^{sgn 2\pi} integrand(s) ds, \]
+//
+// where the integrand is evaluated along
+//    - \gamma_h(s) = \Phi_{-sgn 2(M-i)\pi+s}{z,t_0+t_f}
+//    - \gamma_p(s) = \Phi_{sgn 2i\pi+s}{l_p,L_p,0,G_p,t_0+\omega}
+//
+// The homoclinic trajectory is integrated once from z to
+// \Phi_{-sgn 2M\pi}(z) (towards the periodic orbit, as before), and the
+// periodic one for one period. Since
+// \Phi_{sgn 2\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p), the periodic trajectory
+// over the i-th period is the stored one with time shifted by i times the
+// increment of t over one period. The periodic trajectory is kept in the
+// cache of htraj_periodic, so it is integrated only once per energy level.
+
+int outer_ell_stoch(double mu, double p[DIM], double z[DIM], double omega,
+      double *res, int M, int N, int sgn, double (*integrand)(double, void *))
+{
+   double error;
+   gsl_integration_workspace * w;
 
    struct iparams_outer_ell_stoch params;
 
    int i;		// integration interval
-   double result_i;	// intermediate result
+   double *terms;	// terms[i] = integral over the i-th interval
 
-   double tf;   // final time to reach z from z_s
+   const htraj_t *gamma_p;	// periodic trajectory, one period (cached)
+   htraj_t gamma_h;	// homoclinic trajectory, from z to P^{-sgn M}(z)
+   double tau_p;	// increment of t over one period
 
    // auxiliary variables
-   double pi_red[DIMRED]; 	// point pi = P^{i}(p)
-   double xi_red[DIMRED]; 	// point xi = P^{-(M-i)}(z^s)
-   double t;
-   int status;
+   double x[DIMRED];
+
+   if(N>M)
+   {
+      fprintf(stderr, "outer_ell_stoch: N=%d must not exceed M=%d\n", N, M);
+      return(1);
+   }
+
+   // Homoclinic trajectory from z, and final time t_f
+   dblcpy(x,z,DIM);
+   x[4] = 0;              // t_0
+   x[5] = 0;              // I_0
+   if(htraj_build(&gamma_h, mu, frtbp_red_g, DIMRED, 0, x, -sgn*2*M*M_PI,
+            HTRAJ_SEGLEN_RED))
+   {
+      fprintf(stderr, "outer_ell_stoch: error integrating trajectory\n");
+      return(1);
+   }
+   htraj_eval(&gamma_h, -sgn*2*M*M_PI, x);
+   params.t_h = -x[4];	// t_0+t_f
+
+   // Periodic trajectory from p. It is built once per energy level, and
+   // shared by re/im_B_stoch (or re/im_C_stoch).
+   dblcpy(x,p,DIM);
+   x[4] = 0;              // t_0
+   x[5] = 0;              // I_0
+   gamma_p = htraj_periodic(mu, frtbp_red_g, DIMRED, x, sgn*2*M_PI,
+         HTRAJ_SEGLEN_RED);
+   if(gamma_p == NULL)
+   {
+      fprintf(stderr, "outer_ell_stoch: error integrating trajectory\n");
+      htraj_free(&gamma_h);
+      return(1);
+   }
+   htraj_eval(gamma_p, sgn*2*M_PI, x);
+   tau_p = x[4];
 
    params.mu = mu;
-   
-   gsl_function F;
-   F.function = &im_integrand_B_stoch;
-   F.params = &params;
-
-   // Compute the final time t_f
-   xi_red[0] = zs[0];
-   xi_red[1] = zs[1];
-   xi_red[2] = zs[2];
-   xi_red[3] = zs[3];
-   xi_red[4] = 0;              // t_0
-   xi_red[5] = 0;              // I_0
-   frtbp_red_g(mu, 2*M*M_PI, xi_red);
-   tf = -xi_red[4];
-
-   dblcpy(pi_red,p,DIM);
-   // Initialize t,I components.
-   pi_red[4] = omega;  // t_0+\omega_0^-
-   pi_red[5] = 0;      // I_0
-
-   result = 0;
+   params.gamma_p = gamma_p;
+   params.gamma_h = &gamma_h;
+
+   terms = malloc(N*sizeof(double));
+   if(terms == NULL)
+   {
+      fprintf(stderr, "outer_ell_stoch: out of memory\n");
+      htraj_free(&gamma_h);
+      return(1);
+   }
+
+   // The stores are only read from now on, so the N parts are computed in
+   // parallel (if compiled with OpenMP), each with its own parameters and
+   // workspace, and added up in a fixed order with dblsum.
+#pragma omp parallel for schedule(dynamic) private(w, error)
    for(i=0; i<N; i++)
    {
-      // homoclinic point z_s
-       dblcpy(xi_red,zs,DIM);
-      xi_red[4] = tf;	// t_0+t_f
-      xi_red[5] = 0;	// I_0
-      status = frtbp_red_g(mu,(M-i)*2*M_PI,xi_red);
-      if(status)
-      {
-	 fprintf(stderr, "re_C_stoch: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      dblcpy(params.p_red, pi_red, DIMRED);
-      dblcpy(params.h_red, xi_red, DIMRED);
-
-      // Integrate integrand function by parts. 
+      struct iparams_outer_ell_stoch par_i = params;
+      gsl_function F;
+
+      F.function = integrand;
+      F.params = &par_i;
+      par_i.t_p = omega + i*tau_p;	// t_0+\omega
+      par_i.s_h = -sgn*(M-i)*2*M_PI;
+
+      // Integrate integrand function by parts.
       // Previously, we used 2M parts of size \pi. Now we use M parts of
       // size 2pi.
       // We request a absolute error of 0 and a relative error RELERROR.
-      gsl_integration_qag (&F, 0, -2*M_PI, 0, RELERROR, NINTERVALS,
-              GSL_INTEG_GAUSS61, w, &result_i, &error);
+      w = gsl_integration_workspace_alloc (NINTERVALS);
+      gsl_integration_qag (&F, 0, sgn*2*M_PI, 0,
+	    tolprof_tol(TOL_QUAD,RELERROR), NINTERVALS,
+              GSL_INTEG_GAUSS61, w, &terms[i], &error);
       fprintf (stderr, "estimated error = % .3le\n", error);
-
-      // periodic point p_4
-
-      // It is important to exploit the fact that
-      // \Phi_{-2\pi}(l_p,L_p,0,G_p) = (l_p,L_p,0,G_p).
-      dblcpy(pi_red,p,DIM);
-      status = frtbp_red_g(mu,-2*M_PI,pi_red);
-      if(status)
-      {
-	 fprintf(stderr, "integrand: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-
-      result += result_i;
+      gsl_integration_workspace_free (w);
    }
-   gsl_integration_workspace_free (w);
+   htraj_free(&gamma_h);
 
-   *res = result;		// imaginary(C^+)
+   *res = dblsum(terms, N);
+   free(terms);
    return 0;
 }
 
@@ -0,0 +1,210 @@
+/*! \file
+    \brief Parameterization Method for the Local Invariant Manifolds
+*/
+
+#include <stdio.h>	// fprintf
+#include <math.h>	// cos, pow, hypot, fabs, M_PI
+
+#include <section.h>	// section_t
+#include <prtbp_nl_2d_module.h>	// prtbp_nl_2d, prtbp_nl_2d_inv
+#include <dprtbp_2d.h>	// dprtbp_2d, dprtbp_2d_inv
+
+#include "pmfld.h"
+
+const int ERR_PMFLD_MAP=1;
+const int ERR_PMFLD_PARAM=2;
+
+const double PMFLD_TOL=1.e-12;
+
+/// Number of Chebyshev nodes in excess of the order, to keep the aliasing
+/// of the higher order terms of G(W(s)) off the computed coefficients. More
+/// nodes amplify the rounding errors of the conversion to monomials.
+#define PMFLD_EXTRA 2
+
+/// Corrections below this size end the sweeps of pmfld_build.
+static const double PMFLD_EPS=1.e-15;
+
+/// Max number of halvings in pmfld_domain.
+static const int PMFLD_MAXHALF=40;
+
+int pmfld_map(const pmfld_t *pm, int fwd, double q[2]);
+
+int pmfld_build(pmfld_t *pm, double mu, section_t sec, double H, int k,
+      double p[2], double v[2], double lambda, int stable, double tau,
+      int order)
+{
+   const int m = order + PMFLD_EXTRA;		// number of nodes
+   double f[2][PMFLD_MAXORD+PMFLD_EXTRA];	// G(W(s)) at the nodes
+   double c[2][PMFLD_MAXORD+PMFLD_EXTRA];	// its Chebyshev coefficients
+   double t0[PMFLD_MAXORD+PMFLD_EXTRA];		// monomial coefficients of
+   double t1[PMFLD_MAXORD+PMFLD_EXTRA];		// T_{j-1}, T_j
+   double b[PMFLD_MAXORD+1][2];			// Taylor coefficients of G(W)
+   double dg[4];	// DG(p)
+   double q[2], e[2], d[2];
+   double r, det, corr, tmp, sum;
+   int sweep, i, j, n, ic;
+
+   if(order < 1 || order > PMFLD_MAXORD)
+   {
+      fprintf(stderr, "pmfld_build: invalid order %d\n", order);
+      return(ERR_PMFLD_PARAM);
+   }
+   pm->mu = mu;
+   pm->sec = sec;
+   pm->H = H;
+   pm->k = k;
+   pm->stable = stable;
+   pm->rho = (stable ? 1.0/lambda : lambda);
+   pm->order = order;
+   for(n=0; n<=order; n++)
+      pm->a[n][0] = pm->a[n][1] = 0;
+   pm->a[0][0] = p[0];
+   pm->a[0][1] = p[1];
+   pm->a[1][0] = tau*v[0];
+   pm->a[1][1] = tau*v[1];
+
+   // Derivative of the contracting map G at the fixed point
+   if((stable ? dprtbp_2d(mu,sec,H,k,p,dg) : dprtbp_2d_inv(mu,sec,H,k,p,dg)))
+   {
+      fprintf(stderr, "pmfld_build: error computing derivative of the map\n");
+      return(ERR_PMFLD_MAP);
+   }
+
+   for(sweep=1; sweep<order; sweep++)
+   {
+      // G(W(s)) at the Chebyshev nodes, and its Chebyshev coefficients
+      for(i=0; i<m; i++)
+      {
+	 pmfld_eval(pm, cos(M_PI*(i+0.5)/m), q);
+	 if(pmfld_map(pm, stable, q))
+	    return(ERR_PMFLD_MAP);
+	 f[0][i] = q[0];
+	 f[1][i] = q[1];
+      }
+      for(ic=0; ic<2; ic++)
+	 for(j=0; j<m; j++)
+	 {
+	    sum = 0;
+	    for(i=0; i<m; i++)
+	       sum += f[ic][i]*cos(M_PI*j*(i+0.5)/m);
+	    c[ic][j] = (j==0 ? 1.0 : 2.0)*sum/m;
+	 }
+
+      // Taylor coefficients: b_n = sum_j c_j [T_j]_n, with the monomial
+      // coefficients of T_j from $T_{j+1}=2sT_j-T_{j-1}$.
+      for(j=0; j<m; j++)
+	 t0[j] = t1[j] = 0;
+      t0[0] = 1;	// T_0
+      t1[1] = 1;	// T_1
+      for(n=0; n<=order; n++)
+      {
+	 b[n][0] = c[0][0]*t0[n] + (m>1 ? c[0][1]*t1[n] : 0);
+	 b[n][1] = c[1][0]*t0[n] + (m>1 ? c[1][1]*t1[n] : 0);
+      }
+      for(j=2; j<m; j++)
+      {
+	 for(i=j; i>=0; i--)
+	 {
+	    tmp = (i>0 ? 2*t1[i-1] : 0) - t0[i];
+	    t0[i] = t1[i];
+	    t1[i] = tmp;
+	 }
+	 for(n=0; n<=order && n<=j; n++)
+	 {
+	    b[n][0] += c[0][j]*t1[n];
+	    b[n][1] += c[1][j]*t1[n];
+	 }
+      }
+
+      // Cohomological equation: $(\rho^{-n}-DG(p)) d = b_n - \rho^{-n} a_n$
+      corr = 0;
+      for(n=2; n<=order; n++)
+      {
+	 r = pow(pm->rho, -n);
+	 e[0] = b[n][0] - r*pm->a[n][0];
+	 e[1] = b[n][1] - r*pm->a[n][1];
+	 det = (r-dg[0])*(r-dg[3]) - dg[1]*dg[2];
+	 if(det == 0)
+	 {
+	    fprintf(stderr, "pmfld_build: resonance at order %d\n", n);
+	    return(ERR_PMFLD_PARAM);
+	 }
+	 d[0] = ((r-dg[3])*e[0] + dg[1]*e[1])/det;
+	 d[1] = (dg[2]*e[0] + (r-dg[0])*e[1])/det;
+	 pm->a[n][0] += d[0];
+	 pm->a[n][1] += d[1];
+	 if(hypot(d[0],d[1]) > corr)
+	    corr = hypot(d[0],d[1]);
+      }
+      if(corr < PMFLD_EPS)
+	 break;
+   }
+   pm->tail = hypot(pm->a[order][0], pm->a[order][1]) +
+      (order > 1 ? hypot(pm->a[order-1][0], pm->a[order-1][1]) : 0);
+   return(0);
+}
+
+void pmfld_eval(const pmfld_t *pm, double s, double q[2])
+{
+   int n;
+
+   q[0] = pm->a[pm->order][0];
+   q[1] = pm->a[pm->order][1];
+   for(n=pm->order-1; n>=0; n--)
+   {
+      q[0] = q[0]*s + pm->a[n][0];
+      q[1] = q[1]*s + pm->a[n][1];
+   }
+}
+
+double pmfld_err(const pmfld_t *pm, double s)
+{
+   double q[2], w[2];
+
+   pmfld_eval(pm, s/pm->rho, q);
+   if(pmfld_map(pm, !pm->stable, q))
+      return(-1);
+   pmfld_eval(pm, s, w);
+   return(hypot(q[0]-w[0], q[1]-w[1]));
+}
+
+double pmfld_domain(const pmfld_t *pm, double tol, int branch)
+{
+   double s = (branch < 0 ? -1.0 : 1.0);
+   double err;
+   int i;
+
+   for(i=0; i<PMFLD_MAXHALF; i++, s/=2)
+   {
+      err = pmfld_err(pm, s);
+      if(err >= 0 && err <= tol)
+	 return(s);
+   }
+   fprintf(stderr, "pmfld_domain: tolerance %e not reached\n", tol);
+   return(0);
+}
+
+// name OF FUNCTION: pmfld_map
+//
+// PURPOSE
+// =======
+// Apply the Poincare map $P$ (fwd=1) or its inverse (fwd=0) to the point q
+// of the section, in coordinates $(x,p_x)$.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the map could not be computed, and 0
+// otherwise.
+
+int pmfld_map(const pmfld_t *pm, int fwd, double q[2])
+{
+   double ti;
+
+   if((fwd ? prtbp_nl_2d(pm->mu,pm->sec,pm->H,pm->k,q,&ti) :
+	    prtbp_nl_2d_inv(pm->mu,pm->sec,pm->H,pm->k,q,&ti)))
+   {
+      fprintf(stderr, "pmfld: error computing Poincare map\n");
+      return(1);
+   }
+   return(0);
+}
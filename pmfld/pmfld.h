@@ -0,0 +1,120 @@
+/*! \file
+    \brief Parameterization Method for the Local Invariant Manifolds
+
+    Let $p$ be a hyperbolic fixed point of the 2D Poincare map $P$ (with $k$
+    cuts with the section), with eigenvalue $\lambda$ and eigenvector $v$.
+    Instead of the linear approximation $p+hv$ of the manifold (see \ref
+    h_opt), the manifold is parameterized by a polynomial
+    \f[ W(s) = \sum_{n=0}^{N} a_n s^n, \quad a_0=p,\ a_1=\tau v, \f]
+    that solves the invariance equation $P(W(s)) = W(\lambda s)$ up to order
+    $N$. Since the error of $W$ is $O(s^{N+1})$ instead of $O(h^2)$, the
+    fundamental domain can be taken orders of magnitude farther from $p$, and
+    fewer iterates of $P$ are needed to globalize the manifold.
+
+    The coefficients are obtained with the contracting map $G=P^{-1}$ for the
+    unstable manifold ($G=P$ for the stable one), which conjugates to
+    $s\mapsto s/\rho$, with $\rho=\lambda$ (resp. $1/\lambda$). At each sweep,
+    $G(W(s))$ is sampled at the Chebyshev nodes of $[-1,1]$, its Taylor
+    coefficients $b_n$ are obtained from the Chebyshev interpolant, and each
+    coefficient is corrected with the cohomological equation
+    \f[ (\rho^{-n} I - DG(p))\,\delta a_n = b_n - \rho^{-n} a_n,
+    \quad n\ge 2. \f]
+    The sweep with the first $n-1$ coefficients exact makes $a_n$ exact, so
+    at most $N-1$ sweeps are needed; the iteration stops earlier when the
+    corrections are negligible.
+*/
+
+#ifndef PMFLD_H_INCLUDED
+#define PMFLD_H_INCLUDED
+
+#include <section.h>	// section_t
+
+/// Max order of the parameterization.
+#define PMFLD_MAXORD 24
+
+/** Error computing the Poincare map or its derivative. */
+extern const int ERR_PMFLD_MAP;
+
+/** Invalid order, or the cohomological equation is singular. */
+extern const int ERR_PMFLD_PARAM;
+
+/// Default tolerance of the invariance error (see \ref pmfld_domain).
+extern const double PMFLD_TOL;
+
+/**
+  Parameterization of a local invariant manifold.
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   section_t sec;	///< Poincare section
+   double H;		///< energy value
+   int k;		///< number of cuts with the section per iterate
+   int stable;		///< unstable (0) or stable (1) manifold
+   double rho;		///< expansion factor: $\lambda$ or $1/\lambda$
+   int order;		///< order $N$ of the parameterization
+   double a[PMFLD_MAXORD+1][2];	///< coefficients $a_n=(x,p_x)$
+   double tail;		///< $|a_{N-1}|+|a_N|$, estimate of the truncation
+} pmfld_t;
+
+/**
+  Compute the parameterization of the local manifold.
+
+  \param[out] pm	parameterization
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] sec	type of Poincare section (SEC1 or SEC2)
+  \param[in] H		energy value
+  \param[in] k		number of cuts with the section per iterate
+  \param[in] p		fixed point $p=(x,p_x)$
+  \param[in] v		eigenvector of the manifold
+  \param[in] lambda	eigenvalue of the manifold
+  \param[in] stable	unstable (0) or stable (1) manifold
+  \param[in] tau	scale of the parameter: $a_1=\tau v$. The
+  			coefficients are computed on $s\in[-1,1]$, so
+  			$W([-1,1])$ must stay well inside the domain where the
+  			manifold is a graph over $v$.
+  \param[in] order	order $N$, $1\le N\le$ PMFLD_MAXORD
+
+  \retval ERR_PMFLD_MAP		Error computing the Poincare map.
+  \retval ERR_PMFLD_PARAM	Invalid order.
+
+  \remark
+  The Chebyshev coefficients are converted to monomial ones, which amplifies
+  their rounding errors by about $2^N$, so orders above 20 are seldom
+  useful.
+  */
+int pmfld_build(pmfld_t *pm, double mu, section_t sec, double H, int k,
+      double p[2], double v[2], double lambda, int stable, double tau,
+      int order);
+
+/**
+  Evaluate the parameterization: q = W(s).
+  */
+void pmfld_eval(const pmfld_t *pm, double s, double q[2]);
+
+/**
+  Invariance error at parameter s.
+
+  \returns $|P(W(s/\lambda))-W(s)|$ for the unstable manifold (resp.
+  $|P^{-1}(W(\lambda s))-W(s)|$ for the stable one), which corresponds to
+  \ref err_mfld for the linear approximation, or a negative value if the
+  map could not be computed.
+  */
+double pmfld_err(const pmfld_t *pm, double s);
+
+/**
+  Largest parameter with small invariance error.
+
+  Starting at $s=\pm 1$ (with the sign of branch), s is halved until the
+  invariance error (see \ref pmfld_err) is at most tol. The fundamental
+  domain of the manifold is then $W([s/\rho,s])$, with $\rho$ = pm->rho.
+
+  \param[in] pm		parameterization
+  \param[in] tol	tolerance of the invariance error (e.g. PMFLD_TOL)
+  \param[in] branch	+1 for $s>0$, -1 for $s<0$
+
+  \returns the parameter s, or 0 if the tolerance is not reached.
+  */
+double pmfld_domain(const pmfld_t *pm, double tol, int branch);
+
+#endif // PMFLD_H_INCLUDED
@@ -0,0 +1,324 @@
+/*! \file
+    \brief Persistent Cache of Periodic Orbits and Hyperbolic Data
+
+    The cache file starts with the 8-byte magic string POC_MAGIC, followed
+    by the records (struct \ref pocache_rec) in native binary format.
+    Records are only appended, so that several runs can share the file; when
+    loading, the last record of each key wins.
+*/
+
+#include <stdio.h>	// fopen, fread, fwrite, fseek, ftell
+#include <stdlib.h>	// realloc, free
+#include <string.h>	// memcmp, memmove
+
+#include <rtbp.h>	// DIM
+#include <section.h>	// section_t
+#include <hinv.h>	// hinv
+#include <cardel.h>	// cardel
+#include <prtbp_2d.h>	// prtbp_2d
+#include <portbp.h>	// portbp, TOL_FIXED_PT
+#include <hyper.h>	// hyper
+#include <errmfld.h>	// h_opt
+
+#include "pocache.h"
+
+const int ERR_POC_IO=1;
+const int ERR_POC_FORMAT=2;
+const int ERR_POC_PORBIT=3;
+const int ERR_POC_HYPER=4;
+
+/// Magic string at the beginning of the cache file.
+static const char POC_MAGIC[8] = {'R','T','B','P','P','O','C','2'};
+
+int pocache_cmp(const pocache_rec *a, const pocache_rec *b);
+size_t pocache_find(const pocache_t *c, const pocache_rec *r, int *found);
+int pocache_insert(pocache_t *c, const pocache_rec *r);
+
+int pocache_open(pocache_t *c, const char *filename)
+{
+   char magic[8];
+   pocache_rec r;
+   long len;		// length of the file
+   long nrec;		// number of records in the file
+   long i;
+
+   c->n = 0;
+   c->size = 0;
+   c->rec = NULL;
+
+   // Reads are allowed anywhere, writes always go to the end of file.
+   c->fp = fopen(filename, "a+b");
+   if(c->fp == NULL)
+   {
+      perror("pocache_open: error opening cache file");
+      return(ERR_POC_IO);
+   }
+   if(fseek(c->fp, 0, SEEK_END) || (len = ftell(c->fp)) < 0)
+   {
+      perror("pocache_open: error reading cache file");
+      fclose(c->fp);
+      return(ERR_POC_IO);
+   }
+   rewind(c->fp);
+
+   if(len == 0)
+   {
+      // empty file: write header
+      if(fwrite(POC_MAGIC, sizeof(POC_MAGIC), 1, c->fp) != 1
+	    || fflush(c->fp))
+      {
+	 perror("pocache_open: error writing cache file");
+	 fclose(c->fp);
+	 return(ERR_POC_IO);
+      }
+      return(0);
+   }
+   // A short or truncated file would misalign the records appended later.
+   if(len < (long)sizeof(magic) ||
+	 (len - (long)sizeof(magic)) % (long)sizeof(r) != 0 ||
+	 fread(magic, sizeof(magic), 1, c->fp) != 1 ||
+	 memcmp(magic, POC_MAGIC, sizeof(magic)))
+   {
+      fprintf(stderr, "pocache_open: %s is not a cache file, or it is "
+	    "truncated\n", filename);
+      fclose(c->fp);
+      return(ERR_POC_FORMAT);
+   }
+
+   nrec = (len - (long)sizeof(magic)) / (long)sizeof(r);
+   for(i=0; i<nrec; i++)
+   {
+      if(fread(&r, sizeof(r), 1, c->fp) != 1)
+      {
+	 perror("pocache_open: error reading cache file");
+	 pocache_close(c);
+	 return(ERR_POC_IO);
+      }
+      if(pocache_insert(c, &r))
+      {
+	 pocache_close(c);
+	 return(ERR_POC_IO);
+      }
+   }
+   return(0);
+}
+
+void pocache_close(pocache_t *c)
+{
+   if(c->fp != NULL)
+      fclose(c->fp);
+   free(c->rec);
+   c->fp = NULL;
+   c->rec = NULL;
+   c->n = c->size = 0;
+}
+
+void pocache_key(pocache_rec *r, double mu, section_t sec, double H, int k,
+      double tol, const double p0[2])
+{
+   // Clear padding too, since records are written to disk as they are.
+   memset(r, 0, sizeof(*r));
+   r->mu = mu;
+   r->H = H;
+   r->sec = sec;
+   r->k = k;
+   r->tol = tol;
+   r->p0[0] = p0[0];
+   r->p0[1] = p0[1];
+}
+
+int pocache_get(const pocache_t *c, pocache_rec *r)
+{
+   int found;
+   size_t i;
+
+   i = pocache_find(c, r, &found);
+   if(found)
+      *r = c->rec[i];
+   return(found);
+}
+
+int pocache_put(pocache_t *c, const pocache_rec *r)
+{
+   if(pocache_insert(c, r))
+      return(ERR_POC_IO);
+   if(fwrite(r, sizeof(*r), 1, c->fp) != 1 || fflush(c->fp))
+   {
+      perror("pocache_put: error writing cache file");
+      return(ERR_POC_IO);
+   }
+   return(0);
+}
+
+int pocache_porbit(pocache_t *c, double mu, section_t sec, double H, int k,
+      pocache_rec *r)
+{
+   double p[2];		// approximate fixed point
+   double x[DIM];	// 4D fixed point
+   double T;
+
+   p[0] = r->p[0];
+   p[1] = r->p[1];
+
+   pocache_key(r, mu, sec, H, k, TOL_FIXED_PT, p);
+   if(c != NULL && pocache_get(c, r) && (r->flags & POC_HYPER))
+      return(0);
+
+   // Cache miss: refine fixed point
+   if(portbp(mu, sec, H, k, p))
+   {
+      fprintf(stderr, "pocache_porbit: error computing periodic orbit\n");
+      return(ERR_POC_PORBIT);
+   }
+   r->p[0] = p[0];
+   r->p[1] = p[1];
+
+   // period
+   if(prtbp_2d(mu, sec, H, k, p, &T))
+   {
+      fprintf(stderr, "pocache_porbit: error computing period\n");
+      return(ERR_POC_PORBIT);
+   }
+   r->T = T;
+
+   // hyperbolic splitting
+   if(hyper(mu, sec, H, k, r->p, r->eval, r->evec))
+   {
+      fprintf(stderr, "pocache_porbit: error computing eigenvectors\n");
+      return(ERR_POC_HYPER);
+   }
+
+   // Delaunay coordinates
+   x[0] = r->p[0];
+   x[1] = 0;
+   x[2] = r->p[1];
+   r->flags = POC_PORBIT | POC_HYPER;
+   if(!hinv(mu, sec, H, x))
+   {
+      cardel(x, r->del);
+      r->flags |= POC_DEL;
+   }
+
+   if(c != NULL)
+      return(pocache_put(c, r));
+   return(0);
+}
+
+int pocache_h_opt(pocache_t *c, pocache_rec *r, int stable,
+      branch_t branch, double h, double *hopt)
+{
+   int i = 2*(stable ? 1 : 0) + (branch==RIGHT ? 1 : 0);
+   int j = (stable ? 1 : 0);	// index of eigenvalue/eigenvector
+
+   if(!(r->flags & (POC_H << i)))
+   {
+      r->h[i] = h_opt(r->mu, r->sec, r->H, r->k, r->p, r->evec+2*j,
+	    r->eval[j], stable, h);
+      r->flags |= (POC_H << i);
+      if(c != NULL && pocache_put(c, r))
+      {
+	 *hopt = r->h[i];
+	 return(ERR_POC_IO);
+      }
+   }
+   *hopt = r->h[i];
+   return(0);
+}
+
+// name OF FUNCTION: pocache_cmp
+//
+// PURPOSE
+// =======
+// Compare the keys of two records. Doubles are compared bitwise, so that
+// the order is total (and NaN's are harmless).
+//
+// RETURN VALUE
+// ============
+// Negative, zero or positive, as memcmp.
+
+int pocache_cmp(const pocache_rec *a, const pocache_rec *b)
+{
+   int d;
+
+   if((d = memcmp(&a->mu, &b->mu, sizeof(double))))
+      return(d);
+   if((d = memcmp(&a->H, &b->H, sizeof(double))))
+      return(d);
+   if(a->sec != b->sec)
+      return(a->sec < b->sec ? -1 : 1);
+   if(a->k != b->k)
+      return(a->k < b->k ? -1 : 1);
+   if((d = memcmp(&a->tol, &b->tol, sizeof(double))))
+      return(d);
+   return(memcmp(a->p0, b->p0, sizeof(a->p0)));
+}
+
+// name OF FUNCTION: pocache_find
+//
+// PURPOSE
+// =======
+// Binary search of the key of record "r" in the cache.
+//
+// RETURN VALUE
+// ============
+// Returns the position of the key if found (and sets found=1), or the
+// position where it should be inserted otherwise (and sets found=0).
+
+size_t pocache_find(const pocache_t *c, const pocache_rec *r, int *found)
+{
+   size_t lo = 0, hi = c->n, mid;
+   int d;
+
+   while(lo < hi)
+   {
+      mid = lo + (hi-lo)/2;
+      d = pocache_cmp(c->rec+mid, r);
+      if(d == 0)
+      {
+	 *found = 1;
+	 return(mid);
+      }
+      if(d < 0)
+	 lo = mid+1;
+      else
+	 hi = mid;
+   }
+   *found = 0;
+   return(lo);
+}
+
+// name OF FUNCTION: pocache_insert
+//
+// PURPOSE
+// =======
+// Insert (or replace) record "r" in the in-memory sorted array.
+
+int pocache_insert(pocache_t *c, const pocache_rec *r)
+{
+   int found;
+   size_t i, size;
+   pocache_rec *tmp;
+
+   i = pocache_find(c, r, &found);
+   if(found)
+   {
+      c->rec[i] = *r;
+      return(0);
+   }
+   if(c->n == c->size)
+   {
+      size = (c->size ? 2*c->size : 64);
+      tmp = realloc(c->rec, size*sizeof(pocache_rec));
+      if(tmp == NULL)
+      {
+	 fprintf(stderr, "pocache_insert: out of memory\n");
+	 return(1);
+      }
+      c->rec = tmp;
+      c->size = size;
+   }
+   memmove(c->rec+i+1, c->rec+i, (c->n-i)*sizeof(pocache_rec));
+   c->rec[i] = *r;
+   c->n++;
+   return(0);
+}
@@ -0,0 +1,176 @@
+/*! \file
+    \brief Persistent Cache of Periodic Orbits and Hyperbolic Data
+
+    Fixed points, periods, eigenvalues/eigenvectors, optimal displacements
+    and Delaunay coordinates of periodic orbits are stored in a binary file,
+    keyed by (mu, H, sec, k, tol, p0), so that repeated runs over the same
+    energy table become pure lookups.
+*/
+
+#ifndef POCACHE_H_INCLUDED
+#define POCACHE_H_INCLUDED
+
+#include <stdio.h>	// FILE
+#include <rtbp.h>	// DIM
+#include <section.h>	// section_t, branch_t
+
+/// Record holds the fixed point and period (always set).
+#define POC_PORBIT	1
+/// Record holds the eigenvalues/eigenvectors.
+#define POC_HYPER	2
+/// Record holds the Delaunay coordinates of the fixed point.
+#define POC_DEL		4
+/// Record holds the optimal displacement h[i] (bit POC_H << i).
+#define POC_H		8
+
+/** Error opening/reading/writing the cache file. */
+extern const int ERR_POC_IO;
+
+/** The cache file is not a periodic orbit cache. */
+extern const int ERR_POC_FORMAT;
+
+/** Error computing the periodic orbit. */
+extern const int ERR_POC_PORBIT;
+
+/** Error computing the hyperbolic splitting. */
+extern const int ERR_POC_HYPER;
+
+/**
+  One cached periodic orbit.
+
+  The key is (mu, H, sec, k, tol, p0), where p0 is the approximate fixed
+  point given by the caller: several fixed points of $P^k$ (e.g. a fixed
+  point and its symmetric $R(p)$) may share the same energy. Doubles in the
+  key are compared bitwise, so the same energy table always hits the same
+  records.
+  */
+typedef struct
+{
+   // key
+   double mu;		///< mass parameter
+   double H;		///< energy value
+   int sec;		///< Poincare section (section_t)
+   int k;		///< number of cuts with section
+   double tol;		///< tolerance of the fixed point
+   double p0[2];	///< approximate fixed point, as given by the caller
+
+   // data
+   unsigned flags;	///< which fields below are set (POC_*)
+   double p[2];		///< fixed point $p=(x,p_x)$ of $P^k$
+   double T;		///< period (integration time of $k$ cuts)
+   double eval[2];	///< unstable, stable eigenvalues
+   double evec[4];	///< unstable, stable eigenvectors
+
+   /// Optimal displacement \ref h_opt, indexed by 2*stable+branch.
+   double h[4];
+
+   double del[DIM];	///< Delaunay coordinates (l,L,g,G) of the fixed point
+} pocache_rec;
+
+/**
+  Cache of periodic orbits.
+
+  Records are kept in memory sorted by key (for binary search), and every
+  new record is appended to the file. When a key is stored several times,
+  the last record wins.
+  */
+typedef struct
+{
+   FILE *fp;		///< cache file, opened for appending
+   size_t n;		///< number of records
+   size_t size;		///< allocated records
+   pocache_rec *rec;	///< records, sorted by key
+} pocache_t;
+
+/**
+  Open (or create) a cache file, and load its records into memory.
+
+  \param[out] c		cache
+  \param[in] filename	name of the cache file
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_POC_IO		Error opening or reading the file.
+  \retval ERR_POC_FORMAT	File is not a periodic orbit cache, or its
+  				length is not that of the header plus a whole
+  				number of records (e.g. a write was cut
+  				short).
+  */
+int pocache_open(pocache_t *c, const char *filename);
+
+/** Close the cache file and free memory. */
+void pocache_close(pocache_t *c);
+
+/**
+  Initialize a record with the given key, and no data.
+  */
+void pocache_key(pocache_rec *r, double mu, section_t sec, double H, int k,
+      double tol, const double p0[2]);
+
+/**
+  Look up a record.
+
+  \param[in] c		cache
+  \param[in,out] r
+  On entry, the key fields of r must be set (see \ref pocache_key).
+  On exit, if the key is in the cache, r holds the cached record.
+
+  \returns 1 if the key was found, and 0 otherwise.
+  */
+int pocache_get(const pocache_t *c, pocache_rec *r);
+
+/**
+  Store a record in the cache (in memory and on disk).
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_POC_IO		Error writing the file.
+  */
+int pocache_put(pocache_t *c, const pocache_rec *r);
+
+/**
+  Periodic orbit and hyperbolic splitting, through the cache.
+
+  On a cache miss, the fixed point is refined with \ref portbp and the
+  hyperbolic splitting is computed with \ref hyper; the period and
+  Delaunay coordinates are computed too, and the record is stored.
+
+  \param[in] c		cache (if NULL, nothing is cached)
+  \param[in] mu		mass parameter of RTBP
+  \param[in] sec	Poincare section
+  \param[in] H		energy value
+  \param[in] k		number of cuts with section
+  \param[in,out] r
+  On entry, r->p holds the approximate fixed point.
+  On exit, r holds the record for the key (mu, H, sec, k, TOL_FIXED_PT,
+  p0), with p0 the approximate fixed point.
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_POC_PORBIT	Error computing the periodic orbit.
+  \retval ERR_POC_HYPER	Error computing the hyperbolic splitting.
+  \retval ERR_POC_IO		Error writing the cache file.
+  */
+int pocache_porbit(pocache_t *c, double mu, section_t sec, double H, int k,
+      pocache_rec *r);
+
+/**
+  Optimal displacement along the manifold, through the cache.
+
+  \param[in] c		cache (if NULL, nothing is cached)
+  \param[in,out] r	record, as returned by \ref pocache_porbit
+  \param[in] stable	unstable (0) or stable (1) manifold
+  \param[in] branch	left or right branch of the manifold
+  \param[in] h		initial displacement for \ref h_opt
+  \param[out] hopt	optimal displacement (set even if the cache file
+  			could not be written)
+
+  \retval ERR_POC_IO		Error writing the cache file.
+  */
+int pocache_h_opt(pocache_t *c, pocache_rec *r, int stable,
+      branch_t branch, double h, double *hopt);
+
+#endif // POCACHE_H_INCLUDED
@@ -1,3 +1,5 @@
 #include <prtbp.h>	// section_t
 
+extern const double TOL_FIXED_PT;	///< desired accuracy for fixed point
+
 int portbp(double mu, section_t sec, double H, int k, double pt[2]);
@@ -0,0 +1,198 @@
+/*! \file
+    \brief Phase Portraits of the Poincare Maps
+*/
+
+#include <stdio.h>	// fprintf, fopen, fwrite
+#include <stdlib.h>	// malloc, free
+#include <math.h>	// sqrt, isfinite, NAN, M_PI
+
+#include <rtbp.h>	// DIM, rtbp
+#include <section.h>	// section_t
+#include <frtbp.h>	// frtbp_rk
+#include <psec.h>	// psec_map
+#include <prtbpdel.h>	// prtbp_del
+#include <hinv.h>	// hinv
+#include <hinvdel.h>	// hinv_del
+
+#include "portrait.h"
+
+const int ERR_PORTRAIT_MEM=1;
+const int ERR_PORTRAIT_SEED=2;
+const int ERR_PORTRAIT_IO=3;
+
+/// Tolerance of the Cartesian map (as POINCARE_TOL_NL in prtbp_nl).
+static const double PORTRAIT_TOL_CAR=1.e-16;
+
+int portrait_cut(const portrait_t *pp, double x[DIM]);
+void portrait_coords(const portrait_t *pp, const double x[DIM], double *q);
+
+int portrait_seed_line(const portrait_t *pp, double H, const double q0[2],
+      const double q1[2], int n, double *seeds)
+{
+   int i, nbad = 0;
+   double s, *x;
+
+   if(pp->map == PORTRAIT_DEL && pp->sec != SEC1 && pp->sec != SEC2)
+   {
+      fprintf(stderr, "portrait_seed_line: section not supported\n");
+      return(-ERR_PORTRAIT_SEED);
+   }
+   for(i=0; i<n; i++)
+   {
+      s = (n > 1 ? (double)i/(n-1) : 0);
+      x = seeds+DIM*i;
+      if(pp->map == PORTRAIT_CAR)
+      {
+	 x[0] = q0[0] + s*(q1[0]-q0[0]);	// x
+	 x[1] = 0;				// y
+	 x[2] = q0[1] + s*(q1[1]-q0[1]);	// px
+	 if(hinv(pp->mu,pp->sec,H,x) == 0)
+	    continue;
+      }
+      else
+      {
+	 x[0] = (pp->sec == SEC1 ? 0 : M_PI);	// l
+	 x[2] = q0[0] + s*(q1[0]-q0[0]);	// g
+	 x[3] = q0[1] + s*(q1[1]-q0[1]);	// G
+	 if(hinv_del(pp->mu,H,x) == 0)
+	    continue;
+      }
+      x[0] = x[1] = x[2] = x[3] = NAN;
+      nbad++;
+   }
+   return(nbad);
+}
+
+int portrait_alloc(portrait_buf_t *buf, int n, int cuts)
+{
+   buf->n = n;
+   buf->cuts = cuts;
+   buf->count = malloc(n*sizeof(int));
+   buf->p = malloc(2*(size_t)n*cuts*sizeof(double));
+   if(buf->count == NULL || buf->p == NULL)
+   {
+      fprintf(stderr, "portrait_alloc: out of memory\n");
+      portrait_free(buf);
+      return(ERR_PORTRAIT_MEM);
+   }
+   return(0);
+}
+
+void portrait_free(portrait_buf_t *buf)
+{
+   free(buf->count);
+   free(buf->p);
+   buf->count = NULL;
+   buf->p = NULL;
+}
+
+int portrait(const portrait_t *pp, const double *seeds, portrait_buf_t *buf)
+{
+   int nstop = 0;	// number of seeds that stopped early
+   int i;
+
+   #pragma omp parallel for schedule(dynamic,1) reduction(+:nstop)
+   for(i=0; i<buf->n; i++)
+   {
+      double x[DIM];
+      double *q = buf->p + 2*(size_t)i*buf->cuts;
+      int j, k;
+
+      for(k=0; k<DIM; k++)
+	 x[k] = seeds[DIM*i+k];
+      for(j=0; j<buf->cuts; j++)
+      {
+	 if(!isfinite(x[0]) || portrait_cut(pp,x))
+	    break;
+	 portrait_coords(pp, x, q+2*j);
+      }
+      buf->count[i] = j;
+      for(k=2*j; k<2*buf->cuts; k++)
+	 q[k] = NAN;
+      if(j < buf->cuts)
+	 nstop++;
+   }
+   return(nstop);
+}
+
+int portrait_write(const char *fname, const portrait_t *pp,
+      const portrait_buf_t *buf)
+{
+   const int hdr[4] = {pp->map, pp->sec, buf->n, buf->cuts};
+   size_t n = 2*(size_t)buf->n*buf->cuts;
+   FILE *fp;
+   int ok;
+
+   fp = fopen(fname, "wb");
+   if(fp == NULL)
+   {
+      fprintf(stderr, "portrait_write: cannot open file %s\n", fname);
+      return(ERR_PORTRAIT_IO);
+   }
+   ok = (fwrite("PORTRAIT", 1, 8, fp) == 8 &&
+	 fwrite(hdr, sizeof(int), 4, fp) == 4 &&
+	 fwrite(&pp->mu, sizeof(double), 1, fp) == 1 &&
+	 fwrite(buf->count, sizeof(int), buf->n, fp) == (size_t)buf->n &&
+	 fwrite(buf->p, sizeof(double), n, fp) == n);
+   if(fclose(fp) || !ok)
+   {
+      fprintf(stderr, "portrait_write: error writing file %s\n", fname);
+      return(ERR_PORTRAIT_IO);
+   }
+   return(0);
+}
+
+// name OF FUNCTION: portrait_cut
+//
+// PURPOSE
+// =======
+// Apply the Poincare map of the portrait once to the point x.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the Poincare map fails (e.g. a collision) or
+// the image point escapes (see portrait_t), and 0 otherwise.
+
+int portrait_cut(const portrait_t *pp, double x[DIM])
+{
+   psec_flow_t fl = {frtbp_rk, rtbp, DIM, PSEC_STEP_CAR};
+   psec_t s = {psec_y, psec_y_grad, NULL, 0, 0, psec_side_x};
+   double t;
+
+   if(pp->map == PORTRAIT_CAR)
+   {
+      if(psec_map(pp->mu, &fl, &s, 1, true, PORTRAIT_TOL_CAR, x, &t))
+	 return(1);
+      x[1] = 0;		// y
+      return(pp->rmax > 0 && sqrt(x[0]*x[0]+x[1]*x[1]) > pp->rmax);
+   }
+   if(prtbp_del(pp->mu, pp->sec, 1, x, &t))
+      return(1);
+   return(pp->rmax > 0 && x[1]*x[1] > pp->rmax);
+}
+
+// name OF FUNCTION: portrait_coords
+//
+// PURPOSE
+// =======
+// Coordinates q[0], q[1] of the point x on the section of the portrait (see
+// portrait_buf_t).
+
+void portrait_coords(const portrait_t *pp, const double x[DIM], double *q)
+{
+   if(pp->map == PORTRAIT_CAR)
+   {
+      q[0] = x[0];	// x
+      q[1] = x[2];	// px
+   }
+   else if(pp->sec == SEC1 || pp->sec == SEC2)
+   {
+      q[0] = x[2];	// g
+      q[1] = x[3];	// G
+   }
+   else
+   {
+      q[0] = x[0];	// l
+      q[1] = x[1];	// L
+   }
+}
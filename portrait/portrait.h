@@ -0,0 +1,132 @@
+/*! \file
+    \brief Phase Portraits of the Poincare Maps
+
+    A phase portrait is the set of the first M iterates of the Poincare map
+    (Cartesian \ref prtbp or Delaunay \ref prtbp_del) of a set of seeds.
+    The seeds are given explicitly, or on a segment of the section at fixed
+    energy (see \ref portrait_seed_line). They are iterated concurrently
+    (OpenMP, dynamic scheduling: a free thread takes the next seed), and
+    the cuts are stored in a binary buffer as they are computed. The
+    iteration of a seed stops early if it escapes, collides, or the
+    Poincare map fails.
+
+    Both maps are run on reentrant flows: the Cartesian map is that of
+    \ref prtbp (section $\{y=0\}$ with the loop filter of \ref prtbp_nl),
+    integrated with \ref frtbp_rk instead of the Taylor method, which keeps
+    global state.
+*/
+
+#ifndef PORTRAIT_H_INCLUDED
+#define PORTRAIT_H_INCLUDED
+
+#include <rtbp.h>	// DIM
+#include <section.h>	// section_t
+
+/** Out of memory. */
+extern const int ERR_PORTRAIT_MEM;
+
+/** Invalid seed (energy level not reached, or invalid section). */
+extern const int ERR_PORTRAIT_SEED;
+
+/** Error writing the buffer to a file. */
+extern const int ERR_PORTRAIT_IO;
+
+/// Poincare map of a phase portrait.
+typedef enum
+{
+   PORTRAIT_CAR,	///< Cartesian map \ref prtbp, points (x,y,p_x,p_y)
+   PORTRAIT_DEL		///< Delaunay map \ref prtbp_del, points (l,L,g,G)
+} portrait_map_t;
+
+/**
+  Phase portrait parameters.
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   portrait_map_t map;	///< Poincare map
+   /// Poincare section: SEC1 or SEC2 for the Cartesian map (only used to
+   /// lift the seeds), any section for the Delaunay map.
+   section_t sec;
+   int cuts;		///< number of iterates M of each seed
+   /// Escape radius: the iteration of a seed stops when $\sqrt{x^2+y^2}$
+   /// (Cartesian) or the semi-major axis $L^2$ (Delaunay) is larger (0 to
+   /// never stop).
+   double rmax;
+} portrait_t;
+
+/**
+  Buffer of cuts.
+
+  The j-th cut of seed i, j=0,...,count[i]-1, is stored at
+  p[2*(i*cuts+j)] and p[2*(i*cuts+j)+1], as the pair of coordinates on the
+  section: $(x,p_x)$ for the Cartesian map, $(g,G)$ for the Delaunay
+  sections $\{l=0\}$, $\{l=\pi\}$, and $(l,L)$ for $\{g=0\}$, $\{g=\pi\}$.
+  The remaining slots of a seed that stopped early are NAN.
+  */
+typedef struct
+{
+   int n;		///< number of seeds
+   int cuts;		///< number of iterates of each seed
+   int *count;		///< number of cuts computed for each seed
+   double *p;		///< cuts (2*n*cuts doubles)
+} portrait_buf_t;
+
+/**
+  Seeds on a segment of the section, at fixed energy.
+
+  The i-th seed, i=0,...,n-1, is the point of the section with
+  coordinates $q_0 + i(q_1-q_0)/(n-1)$ (see \ref portrait_buf_t), lifted to
+  the energy level H with \ref hinv (Cartesian) or \ref hinv_del
+  (Delaunay, sections $\{l=0\}$ and $\{l=\pi\}$ only).
+
+  \param[in] pp		portrait parameters
+  \param[in] H		energy value
+  \param[in] q0,q1	end points of the segment
+  \param[in] n		number of seeds
+  \param[out] seeds	seeds (DIM*n doubles)
+
+  \returns the number of seeds that could not be lifted (they are NAN and
+  are skipped by \ref portrait), or -ERR_PORTRAIT_SEED if the section is
+  not supported.
+  */
+int portrait_seed_line(const portrait_t *pp, double H, const double q0[2],
+      const double q1[2], int n, double *seeds);
+
+/**
+  Allocate a buffer for n seeds and M=cuts iterates.
+
+  \retval ERR_PORTRAIT_MEM	Out of memory.
+  */
+int portrait_alloc(portrait_buf_t *buf, int n, int cuts);
+
+/** Free a buffer allocated with \ref portrait_alloc. */
+void portrait_free(portrait_buf_t *buf);
+
+/**
+  Compute a phase portrait.
+
+  Iterate each of the seeds buf->cuts times, and store the cuts in buf.
+  The seeds are distributed dynamically among the OpenMP threads.
+
+  \param[in] pp		portrait parameters
+  \param[in] seeds	seeds (DIM*buf->n doubles), points on the section
+  \param[in,out] buf	buffer (see \ref portrait_alloc)
+
+  \returns the number of seeds that stopped before buf->cuts iterates.
+  */
+int portrait(const portrait_t *pp, const double *seeds, portrait_buf_t *buf);
+
+/**
+  Write the buffer to a binary file.
+
+  The file holds, in native byte order, the string "PORTRAIT" (8 bytes),
+  the ints map, sec, n, cuts, the double mu, the n ints count[i], and the
+  2*n*cuts doubles of the cuts.
+
+  \retval ERR_PORTRAIT_IO	Error writing the file.
+  */
+int portrait_write(const char *fname, const portrait_t *pp,
+      const portrait_buf_t *buf);
+
+#endif // PORTRAIT_H_INCLUDED
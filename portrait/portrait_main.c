@@ -0,0 +1,121 @@
+/*! \file
+    \brief Phase Portraits of the Poincare Maps: main prog
+    \author Pau Roldan
+*/
+
+#include <stdio.h>
+#include <stdlib.h>		// EXIT_SUCCESS, EXIT_FAILURE, realloc
+#include <string.h>		// strcmp
+#include <gsl/gsl_errno.h>	// gsl_set_error_handler_off
+#include <rtbp.h>		// DIM
+#include <tolprof.h>		// tolprof_getenv
+#include "portrait.h"		// portrait_t, portrait
+
+/**
+   Phase Portraits of the Poincare Maps: main prog
+
+   Usage: portrait outfile
+
+   This program replaces the shell loops around prtbp_2d and prtbp_del
+   (prtbps_2d, prtbpdels.sh, cardels_2d_*.sh).
+
+   The tolerances are those of the profile in the environment variable
+   RTBP_TOLPROF, if it is defined (e.g. RTBP_TOLPROF=draft for exploratory
+   runs, see \ref tolprof_parse).
+
+   OVERALL METHOD
+
+   1. Input parameters from stdin:
+
+      - mass parameter
+      - Poincare map: Cartesian=0, Delaunay=1
+      - Poincare section "sec" (SEC1, SEC2, SECg or SECg2)
+      - number of iterates "M"
+      - escape radius (0 for none)
+
+   2. For each input line, input a segment of seeds:
+      - energy value "H"
+      - end points q0, q1 of the segment (coordinates on the section)
+      - number of seeds "n" on the segment (n=1 for the single seed q0)
+
+   3. Iterate all seeds M times, in parallel.
+
+   4. Write the cuts to the binary file outfile (see \ref portrait_write).
+ */
+
+int main(int argc, char *argv[])
+{
+   portrait_t pp;
+   portrait_buf_t buf;
+   int map;
+   char section_str[10];	// holds input string "SEC1", "SEC2" etc
+   double H, q0[2], q1[2];
+   double *seeds = NULL, *p;
+   int n, nseeds = 0, nbad = 0, status;
+
+   if(argc < 2)
+   {
+      fprintf(stderr, "Usage: %s outfile\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   // 1. Input parameters from stdin.
+   if(scanf("%le %d %s %d %le", &pp.mu, &map, section_str, &pp.cuts,
+	    &pp.rmax) < 5)
+   {
+      perror("main: error reading input");
+      exit(EXIT_FAILURE);
+   }
+   pp.map = (map ? PORTRAIT_DEL : PORTRAIT_CAR);
+   if (strcmp(section_str,"SEC1") == 0)
+      pp.sec = SEC1;
+   else if (strcmp(section_str,"SEC2") == 0)
+      pp.sec = SEC2;
+   else if (strcmp(section_str,"SECg") == 0)
+      pp.sec = SECg;
+   else if (strcmp(section_str,"SECg2") == 0)
+      pp.sec = SECg2;
+   else
+   {
+      perror("main: error reading section string");
+      exit(EXIT_FAILURE);
+   }
+
+   // Stop GSL default error handler from aborting the program
+   gsl_set_error_handler_off();
+   if(tolprof_getenv())
+      exit(EXIT_FAILURE);
+
+   // 2. Segments of seeds.
+   while(scanf("%le %le %le %le %le %d", &H, q0, q0+1, q1, q1+1, &n)==6)
+   {
+      if(n < 1)
+	 continue;
+      p = realloc(seeds, DIM*(size_t)(nseeds+n)*sizeof(double));
+      if(p == NULL)
+      {
+	 fprintf(stderr, "main: out of memory\n");
+	 exit(EXIT_FAILURE);
+      }
+      seeds = p;
+      status = portrait_seed_line(&pp, H, q0, q1, n, seeds+DIM*nseeds);
+      if(status < 0)
+	 exit(EXIT_FAILURE);
+      nbad += status;
+      nseeds += n;
+   }
+   if(nbad)
+      fprintf(stderr, "main: %d seeds out of the energy level\n", nbad);
+
+   // 3. Iterate the seeds.
+   if(portrait_alloc(&buf, nseeds, pp.cuts))
+      exit(EXIT_FAILURE);
+   n = portrait(&pp, seeds, &buf);
+   fprintf(stderr, "main: %d seeds stopped early\n", n);
+
+   // 4. Write the cuts.
+   status = portrait_write(argv[1], &pp, &buf);
+   portrait_free(&buf);
+   free(seeds);
+   exit(status ? EXIT_FAILURE : EXIT_SUCCESS);
+}
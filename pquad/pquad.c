@@ -0,0 +1,174 @@
+/*! \file
+    \brief Quadrature along a Closed Orbit
+*/
+
+#include <stdio.h>	// fprintf
+#include <stdlib.h>	// realloc, free
+#include <math.h>	// fabs
+
+#include <utils_module.h>	// dblcpy
+#include <tolprof.h>	// tolprof_tol
+
+#include "pquad.h"
+
+const int ERR_PQUAD_FLOW=1;
+const int ERR_PQUAD_FUN=2;
+const int ERR_PQUAD_MAXITER=3;
+const int ERR_PQUAD_MEM=4;
+
+int pquad_midpoints(double mu, pquad_flow_t flow, int dim, int n, double h,
+      double **xs, pquad_fun_t f, void *params, double *sum);
+
+int pquad(double mu, pquad_flow_t flow, int dim, const double *x0, double T,
+      int periodic, pquad_fun_t f, void *params, double tol, double *res,
+      double *err)
+{
+   int n = 1<<PQUAD_KMIN;	// number of subintervals
+   double h = T/n;		// length of subintervals
+   double *xs;			// points of the trajectory at the nodes
+   double x[PQUAD_MAXDIM];
+   double fj;			// integrand at node j
+   double sum;			// sum of the integrand over the nodes
+   double romb[PQUAD_KMAX-PQUAD_KMIN+1];	// last row of Romberg table
+   double prev, val, fac, r;
+
+   // auxiliary variables
+   int j, k, m, status;
+
+   *res = 0;
+   *err = 0;
+   tol = tolprof_tol(TOL_QUAD, tol);
+   if(dim < 1 || dim > PQUAD_MAXDIM || T == 0)
+   {
+      fprintf(stderr, "pquad: invalid arguments\n");
+      return(ERR_PQUAD_MEM);
+   }
+   xs = malloc(n*dim*sizeof(double));
+   if(xs == NULL)
+   {
+      fprintf(stderr, "pquad: out of memory\n");
+      return(ERR_PQUAD_MEM);
+   }
+
+   // First level: one pass through the nodes s_j = j*h.
+   dblcpy(x, x0, dim);
+   sum = 0;
+   for(j=0; j<=n; j++)
+   {
+      if(j>0 && flow(mu, h, x))
+      {
+	 fprintf(stderr, "pquad: error integrating trajectory\n");
+	 free(xs);
+	 return(ERR_PQUAD_FLOW);
+      }
+      if(j<n)
+	 dblcpy(xs+j*dim, x, dim);
+      else if(periodic)
+	 break;		// f(\phi(T,x_0)) = f(x_0)
+      if(f(x, &fj, params))
+      {
+	 fprintf(stderr, "pquad: error evaluating integrand\n");
+	 free(xs);
+	 return(ERR_PQUAD_FUN);
+      }
+      sum += ((j==0 || j==n) && !periodic ? fj/2 : fj);
+   }
+   romb[0] = h*sum;
+   val = romb[0];
+
+   for(k=1; PQUAD_KMIN+k<=PQUAD_KMAX; k++)
+   {
+      // Next level: add the midpoints, reusing the previous nodes.
+      if((status=pquad_midpoints(mu, flow, dim, n, h, &xs, f, params, &sum)))
+      {
+	 free(xs);
+	 *res = val;
+	 return(status);
+      }
+      n *= 2;
+      h /= 2;
+
+      // Trapezoidal rule, and Romberg's extrapolation of the previous row.
+      prev = val;
+      r = h*sum;
+      if(periodic)
+	 romb[0] = r;
+      else
+      {
+	 fac = 1;
+	 for(m=0; m<k; m++)
+	 {
+	    fac *= 4;
+	    val = r + (r - romb[m])/(fac - 1);
+	    romb[m] = r;
+	    r = val;
+	 }
+	 romb[k] = r;
+      }
+      val = (periodic ? romb[0] : romb[k]);
+      *err = fabs(val-prev);
+      if(*err <= tol*fabs(val))
+	 break;
+   }
+   free(xs);
+   *res = val;
+   if(PQUAD_KMIN+k > PQUAD_KMAX)
+   {
+      fprintf(stderr, "pquad: tolerance not reached with %d nodes\n", n);
+      fprintf(stderr, "pquad: estimated error: %e\n", *err);
+      return(ERR_PQUAD_MAXITER);
+   }
+   return(0);
+}
+
+// name OF FUNCTION: pquad_midpoints
+//
+// PURPOSE
+// =======
+// Given the points xs[j], j=0,...,n-1, of the trajectory at the nodes
+// s_j = j*h, compute the points at the midpoints s_j+h/2 and add the
+// integrand at them to sum. On return, *xs holds the 2n points at the nodes
+// of the next level (the array is reallocated).
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero error code to indicate an error and 0 to indicate
+// success.
+
+int pquad_midpoints(double mu, pquad_flow_t flow, int dim, int n, double h,
+      double **xs, pquad_fun_t f, void *params, double *sum)
+{
+   double *p;
+   double x[PQUAD_MAXDIM];
+   double fj;
+   int j;
+
+   p = realloc(*xs, 2*n*dim*sizeof(double));
+   if(p == NULL)
+   {
+      fprintf(stderr, "pquad: out of memory\n");
+      return(ERR_PQUAD_MEM);
+   }
+   *xs = p;
+
+   // Spread the points backwards, so no point is overwritten before it is
+   // used: node j moves to 2j, and its midpoint goes to 2j+1.
+   for(j=n-1; j>=0; j--)
+   {
+      dblcpy(x, p+j*dim, dim);
+      dblcpy(p+2*j*dim, x, dim);
+      if(flow(mu, h/2, x))
+      {
+	 fprintf(stderr, "pquad: error integrating trajectory\n");
+	 return(ERR_PQUAD_FLOW);
+      }
+      dblcpy(p+(2*j+1)*dim, x, dim);
+      if(f(x, &fj, params))
+      {
+	 fprintf(stderr, "pquad: error evaluating integrand\n");
+	 return(ERR_PQUAD_FUN);
+      }
+      *sum += fj;
+   }
+   return(0);
+}
@@ -0,0 +1,92 @@
+/*! \file
+    \brief Quadrature along a Closed Orbit
+
+    Integrals of a smooth function along one pass of a trajectory,
+    \f$\int_0^T f(\phi(s,x_0)) ds\f$, are computed with the trapezoidal rule
+    on \f$2^k\f$ equally spaced nodes. The trajectory is integrated once
+    through the nodes, and k is doubled until the value converges; each
+    level only adds the midpoints, reusing the nodes (and the points of the
+    trajectory) of the previous one.
+
+    If the integrand is periodic with period T (e.g. any function of the
+    point along a closed orbit), the trapezoidal rule converges
+    exponentially. Otherwise (e.g. a factor \f$e^{it(s)}\f$ with t not
+    periodic), the trapezoidal values are accelerated with Romberg's
+    extrapolation.
+*/
+
+#ifndef PQUAD_H_INCLUDED
+#define PQUAD_H_INCLUDED
+
+/// Max dimension of the flow (DIMRED=6 for the reduced flow).
+#define PQUAD_MAXDIM 6
+
+/// The trapezoidal rule starts with \f$2^{PQUAD\_KMIN}\f$ subintervals.
+#define PQUAD_KMIN 4
+
+/// Max number of subintervals is \f$2^{PQUAD\_KMAX}\f$.
+#define PQUAD_KMAX 16
+
+/** Integration error. */
+extern const int ERR_PQUAD_FLOW;
+
+/** Error evaluating the integrand. */
+extern const int ERR_PQUAD_FUN;
+
+/** Max number of nodes reached without convergence. */
+extern const int ERR_PQUAD_MAXITER;
+
+/** Out of memory, or invalid arguments. */
+extern const int ERR_PQUAD_MEM;
+
+/**
+  Flow function, as \ref frtbp_red_l or \ref frtbp_red_g: on return, x holds
+  the point $\phi(t,x)$.
+  */
+typedef int (*pquad_flow_t)(double mu, double t, double *x);
+
+/**
+  Integrand, evaluated at a point of the trajectory (same signature as
+  \ref f0 or \ref dot_l).
+  */
+typedef int (*pquad_fun_t)(const double *x, double *f, void *params);
+
+/**
+  Integral along one pass of a trajectory.
+
+  Compute
+  \f[ \int_0^T f(\phi(s,x_0)) ds \f]
+  with the trapezoidal rule on \f$2^k\f$ subintervals,
+  k=PQUAD_KMIN,...,PQUAD_KMAX, until two consecutive values agree to the
+  relative tolerance tol.
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] flow	flow function
+  \param[in] dim	dimension of the flow (at most PQUAD_MAXDIM)
+  \param[in] x0		initial point of the trajectory
+  \param[in] T		length of the interval (positive or negative)
+  \param[in] periodic
+     If set, the integrand is assumed to be T-periodic, so $f(\phi(T,x_0))$
+     is not evaluated and no extrapolation is done. Otherwise, the
+     trapezoidal values are extrapolated with Romberg's method.
+  \param[in] f		integrand
+  \param[in] params	parameters of the integrand
+  \param[in] tol	relative tolerance (relaxed by the tolerance profile,
+  			see \ref tolprof_tol)
+  \param[out] res	value of the integral
+  \param[out] err	estimated (absolute) error
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_PQUAD_FLOW	Integration error.
+  \retval ERR_PQUAD_FUN		Error evaluating the integrand.
+  \retval ERR_PQUAD_MAXITER	Tolerance not reached with
+  \f$2^{PQUAD\_KMAX}\f$ subintervals. On return, res holds the last value.
+  \retval ERR_PQUAD_MEM		Out of memory, or invalid arguments.
+  */
+int pquad(double mu, pquad_flow_t flow, int dim, const double *x0, double T,
+      int periodic, pquad_fun_t f, void *params, double tol, double *res,
+      double *err);
+
+#endif // PQUAD_H_INCLUDED
@@ -16,6 +16,8 @@
 #include <rtbp.h>	// DIM
 #include <section.h>
 #include <prtbp_nl.h>
+#include <rootstop.h>	// rootstop_t, rootstop_residual
+#include <tolprof.h>	// tolprof_tol
 
 const double POINCARE_TOL=1.e-16;
 const double TANGENT_TOL=1.e-6;     ///< tolerance for tangent condition
@@ -204,7 +206,7 @@ int prtbp(double mu, section_t sec, int cuts, double x[DIM], double *ti)
 
    // Intersect trajectory starting at point x with section.
    // WARNING! passing 0 instead of 0.0 gives me trouble?!?!
-   if(inter(mu, sec, POINCARE_TOL, x, 0.0, t-t_pre, &t1))
+   if(inter(mu, sec, tolprof_tol(TOL_MAP,POINCARE_TOL), x, 0.0, t-t_pre, &t1))
    {
       fprintf(stderr, "prtbp: error intersectig trajectory with section\n");
       return(1);
@@ -284,7 +286,7 @@ int prtbp_inv(double mu, section_t sec, int cuts, double x[DIM], double *ti)
    // Intersect trajectory starting at point x with section.
    // Note that (t-t_pre) < 0.
    // WARNING! passing 0 instead of 0.0 gives me trouble?!?!
-   if(inter(mu, sec, POINCARE_TOL, x, t-t_pre, 0.0, &t1))
+   if(inter(mu, sec, tolprof_tol(TOL_MAP,POINCARE_TOL), x, t-t_pre, 0.0, &t1))
    {
       fprintf(stderr, "prtbp_inv: error intersectig trajectory with section\n");
       return(1);
@@ -321,7 +323,9 @@ int prtbp_inv(double mu, section_t sec, int cuts, double x[DIM], double *ti)
 // epsabs
 //    maximum desired error bound (tolerance) for intersection.
 //    A point $p=(x,y,p_x,p_y)$ is considered to intersect the section if
-//       |y| < epsabs.
+//       |y| < epsabs,
+//    or if the intersection time has converged to machine precision (see
+//    rootstop_residual).
 // x
 //    Initial point, 4 coordinates: (X, Y, P_X, P_Y). 
 //    On return of the function, it holds the intersection point.
@@ -359,6 +363,7 @@ int inter(double mu, section_t sec, double epsabs, double x[DIM], double t0,
     double f;
     gsl_function F;
     struct inter_f_params params = {mu, sec, x[0], x[1], x[2], x[3]};
+    rootstop_t rs;
     *t=0.0;
   
     F.function = &inter_f;
@@ -367,6 +372,7 @@ int inter(double mu, section_t sec, double epsabs, double x[DIM], double t0,
     T = gsl_root_fsolver_brent;
     s = gsl_root_fsolver_alloc (T);
     gsl_root_fsolver_set (s, &F, t0, t1);
+    rootstop_init(&rs, epsabs);
 
     do
       {
@@ -380,7 +386,7 @@ int inter(double mu, section_t sec, double epsabs, double x[DIM], double t0,
 	}
 	*t = gsl_root_fsolver_root (s);
 	f=inter_f(*t,&params);
-	status = gsl_root_test_residual(f, epsabs);
+	status = rootstop_residual(&rs, *t, f);
       }
     while (status == GSL_CONTINUE && iter < max_iter);
     gsl_root_fsolver_free (s);
@@ -390,6 +396,9 @@ int inter(double mu, section_t sec, double epsabs, double x[DIM], double t0,
        fprintf(stderr, "inter: maximum number of iterations reached\n");
        return(ERR_MAXITER);
     }
+    if(rs.flag == ROOTSTOP_PREC)
+       fprintf(stderr, "inter: converged to machine precision, "
+	     "residual %e\n", f);
     // "*t" is the intersection time.
     if(frtbp(mu,*t,x))	// compute the intersection point "x"
     {
@@ -12,10 +12,6 @@
 #include <rtbp.h>	    // DIM
 #include <section.h>	// section_t
 
-bool onsection_del (section_t sec, double x[DIM]);
-bool crossing_fwd_del (section_t sec, double x[DIM], double y[DIM]);
-bool crossing_bwd_del (section_t sec, double x[DIM], double y[DIM]);
-
 /**
   Poincare map of RTBP in Delaunay coordinates
 
@@ -8,13 +8,11 @@
 #include <stdbool.h>    // bool
 #include <math.h>       // remainder
 
-#include <gsl/gsl_errno.h>	// GSL_SUCCESS
-#include <gsl/gsl_roots.h>
-
 #include <frtbp.h>	    // frtbp
-#include <rtbp.h>	    // DIM
-#include <section.h>	// TWOPI, section_t
+#include <rtbp.h>	    // DIM, rtbp
+#include <section.h>	// section_t
 #include <cardel.h>	    // cardel
+#include <psec.h>	    // psec_map
 
 const double POINCARE_G_TOL=1.e-16;
 
@@ -30,22 +28,8 @@ const double POINCARE_G_TOL=1.e-16;
 // and 0.0001 when computing true homoclinic intersections.
 const double SHORT_TIME_G=0.001;		
 
-bool onsection_g (section_t sec, double a[DIM]);
-bool crossing_fwd_g (section_t sec, double a[DIM], double b[DIM]);
-bool crossing_bwd_g (section_t sec, double a[DIM], double b[DIM]);
-int inter_g(double mu, section_t sec, double epsabs, 
-        double x_del[DIM], double x_car[DIM],
-        double t0, double t1, double *t);
-double inter_g_f(double t, void *p);
-
-// Parameters to the intersection funtion "inter_g_f"
-struct inter_g_f_params;	// Forward declaration
-
-struct inter_g_f_params
-{
-   double mu; section_t sec;
-   double x; double y; double px; double py;
-};
+int prtbp_g_psec(double mu, section_t sec, int cuts, 
+        double x_del[DIM], double x_car[DIM], double *ti, bool fwd);
 
 /**
  * \remark We do not impose that $x$ is on the section.
@@ -59,81 +43,12 @@ struct inter_g_f_params
 int prtbp_g(double mu, section_t sec, int cuts, double x_del[DIM], 
         double x_car[DIM], double *ti)
 {
-   double t = 0.0;
-   double t_pre;	        /* previous value of time t */
-   double x_car_pre[DIM];	/* previous value of point x_car */
-   double x_del_pre[DIM];	/* previous value of point x_del */
    int status;
-   int i,n;
-   double t1;
-
-   n=0;
-   while(n!=cuts)
-   {
-      // Integrate trajectory until it reaches section
-      do
-      {
-         // Save previous value of point "x_del", "x_car" and time "t"
-         for(i=0;i<DIM;i++)
-         {
-            x_del_pre[i]=x_del[i];
-            x_car_pre[i]=x_car[i];
-         }
-         t_pre=t;
-
-         // Integrate for a "short" time t1=SHORT_TIME, short enough so that
-         // we can detect crossing of Poincare section.
-
-         // WARNING! Before we used t1=1 as a "short" time, but sometime this
-         // was too long...
-         status = frtbp(mu,SHORT_TIME_G,x_car);
-         t += SHORT_TIME_G;
-         if (status != GSL_SUCCESS)
-         {
-            fprintf(stderr, "prtbp_g: error integrating trajectory\n");
-            return(1);
-         }
-         cardel(x_car,x_del);
-      } 
-      // while(no crossing of Poincare section)
-      while(!(onsection_g(sec,x_del) || 
-                  crossing_fwd_g(sec,x_del_pre,x_del))); 
-      n++;
-      //fprintf(stderr, "DEBUG: befor %d crossing with sect: l=%.15le, g=%.15le\n", n, x_del_pre[0], x_del_pre[2]);
-      //fprintf(stderr, "DEBUG: after %d crossing with sect: l=%.15le, g=%.15le\n", n, x_del[0], x_del[2]);
-   }
-   // point "x_del" is exactly on the section
-   // This would be very unlikely...
-   if(onsection_g(sec,x_del))
-   {
-      (*ti)=t;
-      return(0);
-   }
-   // Crossing happened between times t_pre and t. 
 
-   // Restore previous value of point "x_del" and "x_car"
-   for(i=0;i<DIM;i++)
-   {
-      x_del[i]=x_del_pre[i];
-      x_car[i]=x_car_pre[i];
-   }
+   status = prtbp_g_psec(mu, sec, cuts, x_del, x_car, ti, true);
+   if(status || cuts==0)
+      return(status);
 
-   // Intersect trajectory starting at point x with section.
-   // WARNING! passing 0 instead of 0.0 gives me trouble?!?!
-   if(inter_g(mu, sec, POINCARE_G_TOL, x_del, x_car, 0.0, 
-               SHORT_TIME_G, &t1))
-   {
-          fprintf(stderr, "prtbp_g: error intersecting trajectory with section\n");
-          fprintf(stderr, "prtbp_g: giving up...\n");
-          /*fprintf(stderr, "x_del_pre: %.15e %.15e %.15e %.15e\n", 
-                  x_del_pre[0], x_del_pre[1], x_del_pre[2], x_del_pre[3]);
-          fprintf(stderr, "x_car_pre: %.15e %.15e %.15e %.15e\n", 
-                  x_car_pre[0], x_car_pre[1], x_car_pre[2], x_car_pre[3]);
-          fprintf(stderr, "t: %.15e\n", 
-                  SHORT_TIME_G);
-          return(1);
-                  */
-   }
    // Here, point x is on section with tolerance POINCARE_G_TOL. 
    //
    // CAREFUL! Make sure to return a point that is exactly ON the section.
@@ -141,359 +56,53 @@ int prtbp_g(double mu, section_t sec, int cuts, double x_del[DIM],
    // will be counted.
    if(sec==SEC1) x_del[0]=0;
    else if(sec==SEC2) x_del[0]=-M_PI;
-
-   // Set time to reach Poincare section
-   (*ti)=t_pre+t1;
    return(0);
 }
 
 int prtbp_g_inv(double mu, section_t sec, int cuts, 
         double x_del[DIM], double x_car[DIM], double *ti)
 {
-   double t = 0.0;
-   double t_pre;	        /* previous value of time t */
-   double x_car_pre[DIM];	/* previous value of point x_car */
-   double x_del_pre[DIM];	/* previous value of point x_del */
-   int status;
-   int i,n;
-   double t1;
-
-   n=0;
-   while(n!=cuts)
-   {
-      // Integrate trajectory backwards until it reaches section
-      do
-      {
-         // Save previous value of point "x_del", "x_car" and time "t"
-         for(i=0;i<DIM;i++)
-         {
-            x_del_pre[i]=x_del[i];
-            x_car_pre[i]=x_car[i];
-         }
-         t_pre=t;
-
-         // Integrate for a "short" time t1=-SHORT_TIME, short enough so that
-         // we can detect crossing of Poincare section.
-
-         // WARNING! Before we used t1=1 as a "short" time, but sometime this
-         // was too long...
-         status = frtbp(mu,-SHORT_TIME_G,x_car);
-         t -= SHORT_TIME_G;
-         if (status != GSL_SUCCESS)
-         {
-            fprintf(stderr, "prtbp_g_inv: error integrating trajectory\n");
-            return(1);
-         }
-         cardel(x_car,x_del);
-      } 
-      // while(no crossing of Poincare section)
-      while(!(onsection_g(sec,x_del) || 
-                  crossing_fwd_g(sec,x_del_pre,x_del))); 
-      n++;
-   }
-   // point "x_del" is exactly on the section
-   // This would be very unlikely...
-   if(onsection_g(sec,x_del))
-   {
-      (*ti)=t;
-      return(0);
-   }
-   // Crossing happened between times t_pre and t. 
-
-   // Restore previous value of point "x_del" and "x_car"
-   for(i=0;i<DIM;i++)
-   {
-      x_del[i]=x_del_pre[i];
-      x_car[i]=x_car_pre[i];
-   }
-
-   // Intersect trajectory starting at point x with section.
-   // Note that (t-t_pre) < 0.
-   // WARNING! passing 0 instead of 0.0 gives me trouble?!?!
-   if(inter_g(mu, sec, POINCARE_G_TOL, x_del, x_car, 0.0, 
-               t-t_pre, &t1))
-   {
-      fprintf(stderr, "prtbp_g_inv: error intersectig trajectory with section\n");
-      return(1);
-   }
-   // Here, point x is on section with tolerance POINCARE_G_TOL. 
-
-   // Set time to reach Poincare section
-   (*ti)=t_pre+t1;
-   return(0);
-}
-
-/** 
-  This function determines if the point A is exactly on the section.
-
-  \param[in] sec 	type of Poincare section (sect = SEC1 or SEC2).
-  \param[in] a 		point, 4 coordinates: (l, L, g, G).
-
-  \returns true if point $a$ is exactly on section, false if it is not.
-  */
-bool onsection_g (section_t sec, double a[DIM])
-{
-   bool bonsection = false;
-   double l;
-
-   l = a[0];
-
-   switch(sec)
-   {
-      case SEC1 :       // section {l=0}
-         {
-            bonsection = (fabs(remainder(l,TWOPI))<POINCARE_G_TOL);
-            break;
-         }
-      case SEC2 :       // section {l=\pi}
-         {
-            bonsection = (fabs(remainder(l-M_PI,TWOPI))<POINCARE_G_TOL);
-            break;
-         }
-   }
-   return(bonsection);
-}
-
-/**
-  Let $a$ and $b$ be two consecutive points in an orbit (forwards orbit).
-  This function determines if the trajectory from $a$ to $b$ does cross the
-  poincare section sec or not.
-
-  \param[in] sec 	type of Poincare section (sec = SEC1 or SEC2).
-  \param[in] a		First point, 4 coordinates: (l, L, g, G).
-  \param[in] b		Second point, 4 coordinates: (l, L, g, G).
-
-  \return 		true if trajectory cuts section, false if it does not.
-  */
-
-bool crossing_fwd_g (section_t sec, double a[DIM], double b[DIM])
-{
-   // auxiliary variables
-   double n1,n2;
-   bool bcrossing = false;
-
-   switch(sec)
-   {
-      case SEC1 :       // section {l=0}
-         {
-             // Since dl/dt>0, it is enough to check if the angle 
-             // has been reset from 2\pi to 0.
-             // DEBUG bcrossing = (b[0] < a[0]);
-             bcrossing = (a[0] < 0 && b[0] > 0);
-             break;
-         }
-      case SEC2 :       // section {l=\pi}
-         {
-             // Since dl/dt>0, it is enough to check if the angle 
-             // has passed from <\pi to >\pi.
-             // DEBUG bcrossing = (a[0] < M_PI && b[0] > M_PI);
-             bcrossing = (b[0] < a[0]);
-             break;
-         }
-   }
-   return(bcrossing);
+   return(prtbp_g_psec(mu, sec, cuts, x_del, x_car, ti, false));
 }
 
-/**
-  Let $a$ and $b$ be two consecutive points in an orbit (backwards orbit).
-  This function determines if the trajectory from $a$ to $b$ does cross the
-  poincare section sec or not.
-
-  \param[in] sec 	type of Poincare section (sec = SEC1 or SEC2).
-  \param[in] a		First point, 4 coordinates: (l, L, g, G).
-  \param[in] b		Second point, 4 coordinates: (l, L, g, G).
-
-  \return 		true if trajectory cuts section, false if it does not.
-  */
-
-bool crossing_bwd_g (section_t sec, double a[DIM], double b[DIM])
+// name OF FUNCTION: prtbp_g_psec
+//
+// PURPOSE
+// =======
+// Common part of prtbp_g (fwd=true) and prtbp_g_inv (fwd=false).
+// The map is computed by the generic section engine, on the Cartesian flow
+// with step SHORT_TIME_G, and the section functional $l$ (SEC1 or SEC2)
+// evaluated on the Delaunay elements of the Cartesian point.
+// On return, x_del holds the Delaunay elements of x_car.
+
+int prtbp_g_psec(double mu, section_t sec, int cuts, 
+        double x_del[DIM], double x_car[DIM], double *ti, bool fwd)
 {
-   // auxiliary variables
-   double n1,n2;
-   bool bcrossing = false;
+   psec_flow_t fl = {frtbp, rtbp, DIM, SHORT_TIME_G};
+   psec_t s;
+   int status;
 
-   switch(sec)
+   psec_section_del(sec, true, &s);
+   status = psec_map(mu, &fl, &s, cuts, fwd, POINCARE_G_TOL, x_car, ti);
+   if(status == ERR_PSEC_FLOW)
    {
-      case SEC1 :       // section {l=0}
-         {
-             // Since dl/dt<0, it is enough to check if the angle 
-             // has been reset from 0 to 2\pi.
-             bcrossing = (b[0] > a[0]);
-             break;
-         }
-      case SEC2 :       // section {l=\pi}
-         {
-             // Since dl/dt<0, it is enough to check if the angle 
-             // has passed from >\pi to <\pi.
-             bcrossing = (a[0] > M_PI && b[0] < M_PI);
-             break;
-         }
+      fprintf(stderr, "%s: error integrating trajectory\n",
+	    (fwd ? "prtbp_g" : "prtbp_g_inv"));
+      return(1);
    }
-   return(bcrossing);
-}
-
-double inter_g_f(double t, void *p)
-{
-   int i, status;
-   struct inter_g_f_params *params = (struct inter_g_f_params *)p;
-   double mu = (params->mu);
-   section_t sec = (params->sec);
-   double x = (params->x); 
-   double y = (params->y); 
-   double px = (params->px);
-   double py = (params->py);
-   double pt[DIM];
-
-   // auxiliary variables
-   double pt_del[DIM];  // point in Delaunay coordinates
-   double l;
-   double d;            // distance to section
-
-   pt[0]=x; 
-   pt[1]=y; 
-   pt[2]=px;
-   pt[3]=py;
-
-   status=frtbp(mu,t,pt);	// flow(t,pt)
-   if(status!=0)
+   // The forward map gives up on the refinement and goes on with the
+   // point as it is (as it always did); the inverse map reports it.
+   if(status && fwd)
    {
-      fprintf(stderr, "inter_g_f: error computing flow");
-      exit(EXIT_FAILURE);
+      fprintf(stderr, "prtbp_g: error intersecting trajectory with section\n");
+      fprintf(stderr, "prtbp_g: giving up...\n");
    }
-
-   cardel(pt,pt_del);
-   l = pt_del[0];
-
-   switch(sec)
+   else if(status)
    {
-      case SEC1 :       // section {l=0}
-         {
-            d = remainder(l,TWOPI);
-	    //fprintf(stderr,"DEBUG: l=%.15le, d=%.15le\n", l, d);
-            break;
-         }
-      case SEC2 :       // section {l=\pi}
-         {
-            d = remainder(l-M_PI,TWOPI);
-	    //fprintf(stderr,"DEBUG: l=%.15le, d=%.15le\n", l, d);
-            break;
-         }
+      fprintf(stderr, "prtbp_g_inv: error intersecting trajectory with "
+	    "section\n");
+      return(1);
    }
-   return(d);
-}
-
-// name OF FUNCTION: inter_g
-// CREDIT: 
-//
-// PURPOSE
-// =======
-// Let "sec" be the given Poincare section.
-// Given a point "x" whose trajectory intersects the section "sec" during the
-// time interval (t0,t1), this function computes the intersection time "t"
-// such that $flow(t,x)$ is precisely on the section. 
-// The intersection point $y = flow(t,x)$ is also returned.
-//
-// We use a (1-dimensional) root finding algorithm to solve the function
-// "inter_g_f" for the intersection time "t".
-//
-// PARAMETERS
-// ==========
-// mu
-//    mass parameter of the RTBP
-// sec
-//    type of Poincare section = {SEC1,SEC2}
-// epsabs
-//    maximum desired error bound (tolerance) for intersection.
-//    A point $p=(x,y,p_x,p_y)$ is considered to intersect the section if
-//    dist(p,sec) < epsabs.
-// x_del
-//    Initial point, 4 coordinates: (l, L, g, G). 
-//    On return of the function, it holds the intersection point.
-// x_car
-//    Initial point, 4 coordinates: (X, Y, P_X, P_Y). 
-//    On return of the function, it holds the intersection point.
-// t0,t1
-//    Lower and upper bounds for the time of intersection. 
-//    The caller must guarantee that solution lies in between (t0,t1).
-// t
-//    Pointer to intersection time.
-//    On return of the this function, *t holds the intersection time.
-// 
-// RETURN VALUE
-// ============
-// Returns a non-zero error code to indicate an error and 0 to indicate
-// success.
-// If an error is encountered, the function returns a non-zero value:
-//
-// ERR_MAXITER_G
-//    A specified maximum number of iterations of the root finding algorithm
-//    has been reached.
-
-const int ERR_MAXITER_G=1;
-
-int inter_g(double mu, section_t sec, double epsabs, 
-        double x_del[DIM], double x_car[DIM], 
-        double t0, double t1, double *t)
-{
-    int status;
-    int iter = 0, max_iter = 100;
-    const gsl_root_fsolver_type *T;
-    gsl_root_fsolver *s;
-    double f;
-    gsl_function F;
-    struct inter_g_f_params params = {mu, sec, x_car[0], x_car[1], x_car[2], x_car[3]};
-    *t=0.0;
-  
-    F.function = &inter_g_f;
-    F.params = &params;
-  
-    T = gsl_root_fsolver_brent;
-    s = gsl_root_fsolver_alloc (T);
-    gsl_root_fsolver_set (s, &F, t0, t1);
-
-    do
-      {
-        iter++;
-        status = gsl_root_fsolver_iterate (s);
-        if (status)
-        {
-           fprintf(stderr, \
-             "inter_g: solver iteration failed, gsl_errno=%d\n", \
-             status);
-           return(1);
-        }
-        *t = gsl_root_fsolver_root (s);
-        f=inter_g_f(*t,&params);
-        status = gsl_root_test_residual(f, epsabs);
-      }
-    while (status == GSL_CONTINUE && iter < max_iter);
-    gsl_root_fsolver_free (s);
-
-    /*
-    if(iter>=max_iter)
-    {
-       fprintf(stderr, \
-               "inter_g: maximum number of iterations reached\n");
-       fprintf(stderr, \
-               "inter_g: latest residual: %.15e\n",f);
-       return(ERR_MAXITER_G);
-    }
-    */
-    // "*t" is the intersection time.
-    if(frtbp(mu,*t,x_car))	// compute the intersection point "x"
-    {
-       fprintf(stderr, "inter_g: error computing intersection point\n");
-       exit(EXIT_FAILURE);
-    }
-    cardel(x_car,x_del);
-
-    if(iter>=max_iter)
-    {
-       fprintf(stderr, \
-               "inter_g: maximum number of iterations reached\n");
-       fprintf(stderr, \
-               "inter_g: latest residual: %.15e\n",f);
-       return(ERR_MAXITER_G);
-    }
-    return 0;
+   cardel(x_car,x_del);
+   return(0);
 }
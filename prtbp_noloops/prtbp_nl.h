@@ -52,6 +52,11 @@ extern const double POINCARE_TOL;	///< error bound (tolerance) for Poincare map
   For this, we impose that TWO CONSECUTIVE ITERATES do NOT lie both to the
   right or to the left of the origin.
 
+  \remark
+  Crossings with the x axis are classified as they are found, with a
+  sliding window of the last three crossings, so each stretch of the
+  trajectory is integrated only once.
+
   \remark
   On successful return of this function, the point $x$ is exactly on the
   section, i.e. we set coordinate $y$ exactly equal to zero.
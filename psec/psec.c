@@ -0,0 +1,463 @@
+/*! \file
+    \brief Generic Poincare Section Engine
+*/
+
+#include <stdio.h>	// fprintf
+#include <stdbool.h>	// bool
+#include <math.h>	// fabs, remainder, M_PI
+#include <gsl/gsl_errno.h>	// GSL_CONTINUE
+
+#include <rtbp.h>	// DIM, rtbp
+#include <rtbpdel.h>	// rtbp_del
+#include <frtbp.h>	// frtbp, dfrtbp
+#include <frtbpdel.h>	// frtbp_del
+#include <cardel.h>	// cardel
+#include <section.h>	// section_t
+#include <utils_module.h>	// dblcpy, TWOPI
+#include <rootstop.h>	// rootstop_t, rootstop_residual, rootstop_delta
+#include <tolprof.h>	// tolprof_tol
+
+#include "psec.h"
+
+const int ERR_PSEC_FLOW=1;
+const int ERR_PSEC_MAXITER=2;
+const int ERR_PSEC_JAC=3;
+
+/// Detection steps. A const double is not a constant expression in C, so
+/// the flows below take the step from these macros, not from PSEC_STEP_*.
+#define PSEC_STEP_CAR_INIT 0.01
+#define PSEC_STEP_DEL_INIT 0.1
+
+const double PSEC_STEP_CAR=PSEC_STEP_CAR_INIT;
+const double PSEC_STEP_DEL=PSEC_STEP_DEL_INIT;
+
+const psec_flow_t PSEC_FLOW_CAR =
+   {frtbp, rtbp, DIM, PSEC_STEP_CAR_INIT, dfrtbp};
+const psec_flow_t PSEC_FLOW_DEL =
+   {frtbp_del, rtbp_del, DIM, PSEC_STEP_DEL_INIT};
+
+/// Max number of iterations to refine a crossing.
+static const int PSEC_MAXITER=100;
+
+/// Offsets of the Delaunay sections (parameter of psec_l, psec_g, ...).
+static double PSEC_ZERO=0;
+static double PSEC_PI=M_PI;
+
+// Crossing of a trajectory with the section, between points x_pre and x.
+struct crossing_psec
+{
+   double x[PSEC_MAXDIM];	/* first point after crossing (or on section) */
+   double x_pre[PSEC_MAXDIM];	/* last point before crossing */
+   double t;		/* time of point x */
+   double t_pre;	/* time of point x_pre */
+   double s;		/* S(x) */
+   double s_pre;	/* S(x_pre) */
+   int sign;		/* sign of side() at the crossing */
+};
+
+bool crossing_psec(const psec_t *sec, double h, double s0, double s1);
+int next_crossing_psec(double mu, const psec_flow_t *fl, const psec_t *sec,
+      double h, struct crossing_psec *c);
+int refine_psec(double mu, const psec_flow_t *fl, const psec_t *sec,
+      double tol, const struct crossing_psec *c, double *x, double *t);
+
+double psec_y(const double *x, void *par)
+{
+   return(x[1]);
+}
+
+void psec_y_grad(const double *x, double *dS, void *par)
+{
+   dS[0]=0; dS[1]=1; dS[2]=0; dS[3]=0;
+}
+
+double psec_side_x(const double *x, void *par)
+{
+   return(x[0]);
+}
+
+double psec_l(const double *x, void *par)
+{
+   return(remainder(x[0] - *(double *)par, TWOPI));
+}
+
+void psec_l_grad(const double *x, double *dS, void *par)
+{
+   dS[0]=1; dS[1]=0; dS[2]=0; dS[3]=0;
+}
+
+double psec_g(const double *x, void *par)
+{
+   return(remainder(x[2] - *(double *)par, TWOPI));
+}
+
+void psec_g_grad(const double *x, double *dS, void *par)
+{
+   dS[0]=0; dS[1]=0; dS[2]=1; dS[3]=0;
+}
+
+double psec_car_l(const double *x, void *par)
+{
+   double x_del[DIM];
+
+   cardel((double *)x, x_del);
+   return(psec_l(x_del, par));
+}
+
+double psec_car_g(const double *x, void *par)
+{
+   double x_del[DIM];
+
+   cardel((double *)x, x_del);
+   return(psec_g(x_del, par));
+}
+
+void psec_section_del(section_t sec, bool car, psec_t *s)
+{
+   s->period = TWOPI;
+   s->dir = 0;
+   s->side = NULL;
+   switch(sec)
+   {
+      case SEC1 : 	// Poincare section {l=0}
+      case SEC2 : 	// Poincare section {l=pi}
+	 {
+	    s->fun = (car ? psec_car_l : psec_l);
+	    s->grad = (car ? NULL : psec_l_grad);
+	    s->par = (sec==SEC1 ? &PSEC_ZERO : &PSEC_PI);
+	    break;
+	 }
+      case SECg : 	// Poincare section {g=0}
+      case SECg2 : 	// Poincare section {g=pi}
+	 {
+	    s->fun = (car ? psec_car_g : psec_g);
+	    s->grad = (car ? NULL : psec_g_grad);
+	    s->par = (sec==SECg ? &PSEC_ZERO : &PSEC_PI);
+	    if(sec==SECg)
+	       s->dir = -1;
+	    break;
+	 }
+   }
+}
+
+int psec_map(double mu, const psec_flow_t *fl, const psec_t *sec, int cuts,
+      bool fwd, double tol, double *x, double *ti)
+{
+   double h = (fwd ? fl->step : -fl->step);
+   struct crossing_psec cur;	/* current crossing with section */
+   struct crossing_psec nxt;	/* next crossing with section */
+   int sign_pre;		/* sign of side() at previous crossing */
+   int n, status;
+   double t1;
+
+   *ti = 0.0;
+   if(cuts<=0)
+      return(0);
+
+   // Integrate trajectory until it crosses section
+   dblcpy(cur.x, x, fl->dim);
+   cur.t = 0.0;
+   cur.s = sec->fun(x, sec->par);
+   if(sec->side)
+      sign_pre = (sec->side(x, sec->par)>0 ? +1 : -1);
+   if((status=next_crossing_psec(mu, fl, sec, h, &cur)))
+      return(status);
+
+   n=0;
+   while(1)
+   {
+      if(sec->side == NULL)
+	 n++;
+      else
+      {
+	 // Loop filter: the crossing "cur" is classified from the sides of
+	 // the previous, current and next crossings. We keep a sliding
+	 // window with the last three of them, so each stretch of trajectory
+	 // is integrated only once.
+	 nxt = cur;
+	 if((status=next_crossing_psec(mu, fl, sec, h, &nxt)))
+	    return(status);
+	 if((sign_pre!=cur.sign && cur.sign!=nxt.sign) ||
+	       (sign_pre==cur.sign && cur.sign==nxt.sign)) n++;
+      }
+      if(n==cuts)
+	 break;
+
+      // Go to the next crossing
+      if(sec->side == NULL)
+      {
+	 if((status=next_crossing_psec(mu, fl, sec, h, &cur)))
+	    return(status);
+      }
+      else
+      {
+	 sign_pre = cur.sign;
+	 cur = nxt;
+      }
+   }
+
+   // point "x" is exactly on the section
+   // This would be very unlikely...
+   if(cur.s == 0)
+   {
+      dblcpy(x, cur.x, fl->dim);
+      *ti = cur.t;
+      return(0);
+   }
+
+   // Crossing happened between times t_pre and t.
+   status = refine_psec(mu, fl, sec, tolprof_tol(TOL_MAP, tol), &cur, x, &t1);
+   *ti = cur.t_pre + t1;
+   return(status);
+}
+
+// NOTES
+// =====
+// The crossings are classified with the same sliding window as in psec_map.
+// The refinement of a crossing starts from its own copy of the point before
+// it (see refine_psec), so the detection goes on from cur.x without being
+// disturbed.
+
+int psec_stream(double mu, const psec_flow_t *fl, const psec_t *sec,
+      int cuts, bool fwd, double tol, bool jac, double *x, psec_out_t out,
+      void *par)
+{
+   double h = (fwd ? fl->step : -fl->step);
+   struct crossing_psec cur;	/* current crossing with section */
+   struct crossing_psec nxt;	/* next crossing with section */
+   double xc[PSEC_MAXDIM];	/* refined cut */
+   double xp[PSEC_MAXDIM];	/* previous cut (or initial point) */
+   double dphi[PSEC_MAXDIM*PSEC_MAXDIM];
+   double tp = 0.0;		/* time of the previous cut */
+   double t1;
+   psec_cut_t cut;
+   int sign_pre;		/* sign of side() at previous crossing */
+   int status;
+   bool accept;
+
+   if(jac && fl->dflow == NULL)
+   {
+      fprintf(stderr, "psec_stream: the flow has no derivative\n");
+      return(ERR_PSEC_JAC);
+   }
+   tol = tolprof_tol(TOL_MAP, tol);
+
+   dblcpy(xp, x, fl->dim);
+   dblcpy(cur.x, x, fl->dim);
+   cur.t = 0.0;
+   cur.s = sec->fun(x, sec->par);
+   if(sec->side)
+      sign_pre = (sec->side(x, sec->par)>0 ? +1 : -1);
+   if((status=next_crossing_psec(mu, fl, sec, h, &cur)))
+      return(status);
+
+   cut.k = 0;
+   while(1)
+   {
+      accept = true;
+      if(sec->side)
+      {
+	 nxt = cur;
+	 if((status=next_crossing_psec(mu, fl, sec, h, &nxt)))
+	    return(status);
+	 accept = ((sign_pre!=cur.sign && cur.sign!=nxt.sign) ||
+	       (sign_pre==cur.sign && cur.sign==nxt.sign));
+      }
+      if(accept)
+      {
+	 if(cur.s == 0)
+	 {
+	    dblcpy(xc, cur.x, fl->dim);
+	    t1 = cur.t - cur.t_pre;
+	 }
+	 else if((status=refine_psec(mu, fl, sec, tol, &cur, xc, &t1)))
+	    return(status);
+	 cut.k++;
+	 cut.t = cur.t_pre + t1;
+	 cut.x = xc;
+	 cut.dir = ((cur.s-cur.s_pre)*h > 0 ? +1 : -1);
+	 cut.dphi = NULL;
+	 if(jac)
+	 {
+	    if(fl->dflow(mu, cut.t-tp, xp, dphi))
+	    {
+	       fprintf(stderr, "psec_stream: error integrating variational "
+		     "equations\n");
+	       return(ERR_PSEC_FLOW);
+	    }
+	    cut.dphi = dphi;
+	 }
+	 dblcpy(xp, xc, fl->dim);
+	 tp = cut.t;
+	 dblcpy(x, xc, fl->dim);
+	 if(out(&cut, par) || cut.k == cuts)
+	    break;
+      }
+
+      // Go to the next crossing
+      if(sec->side == NULL)
+      {
+	 if((status=next_crossing_psec(mu, fl, sec, h, &cur)))
+	    return(status);
+      }
+      else
+      {
+	 sign_pre = cur.sign;
+	 cur = nxt;
+      }
+   }
+   return(0);
+}
+
+// name OF FUNCTION: crossing_psec
+//
+// PURPOSE
+// =======
+// Let s0=S(a) and s1=S(b) be the values of the section functional at two
+// consecutive points a, b of an orbit, integrated with step h (positive or
+// negative). This function determines if the trajectory from a to b crosses
+// the section, and if the crossing passes the period and direction filters.
+
+bool crossing_psec(const psec_t *sec, double h, double s0, double s1)
+{
+   if(!(s1 == 0 || s0*s1 < 0))
+      return(false);
+
+   // Wrap-around of an angular functional on the opposite side
+   if(sec->period > 0 && fabs(s1-s0) >= sec->period/2)
+      return(false);
+
+   // Sign of dS/dt is the sign of (s1-s0)/h
+   if(sec->dir != 0 && sec->dir*(s1-s0)*h <= 0)
+      return(false);
+
+   return(true);
+}
+
+// name OF FUNCTION: next_crossing_psec
+//
+// PURPOSE
+// =======
+// Starting at the point c->x at time c->t, integrate the trajectory in steps
+// of h until it crosses the section (see crossing_psec).
+// On return, c holds the first point after the crossing (or exactly on it),
+// the previous point, their times and values of S, and the sign of side()
+// at the crossing.
+//
+// RETURN VALUE
+// ============
+// ERR_PSEC_FLOW if an integration error is encountered, 0 otherwise.
+
+int next_crossing_psec(double mu, const psec_flow_t *fl, const psec_t *sec,
+      double h, struct crossing_psec *c)
+{
+   do
+   {
+      // Save previous value of point "x" and time "t"
+      dblcpy(c->x_pre, c->x, fl->dim);
+      c->t_pre = c->t;
+      c->s_pre = c->s;
+
+      if(fl->flow(mu, h, c->x))
+      {
+	 fprintf(stderr, "psec_map: error integrating trajectory\n");
+	 return(ERR_PSEC_FLOW);
+      }
+      c->t += h;
+      c->s = sec->fun(c->x, sec->par);
+   }
+   while(!crossing_psec(sec, h, c->s_pre, c->s));
+
+   if(sec->side)
+      c->sign = (sec->side(c->x, sec->par)>0 ? +1 : -1);
+   return(0);
+}
+
+// name OF FUNCTION: refine_psec
+//
+// PURPOSE
+// =======
+// Given a crossing c, between times c->t_pre and c->t, find the time t
+// (relative to c->t_pre) such that x=\phi(t,c->x_pre) is on the section,
+// |S(x)| <= tol.
+//
+// The bracket [a,b] of the root is updated at each iterate. The next iterate
+// is obtained with Newton's method, if the gradient of S and the vector
+// field are given and the Newton iterate falls inside the bracket, and with
+// the Illinois variant of the secant method otherwise. The flow is
+// integrated from the current iterate to the next one.
+// The refinement stops when |S| <= tol, or when the time has converged to
+// machine precision (next iterate within a few ulps of the current one).
+//
+// RETURN VALUE
+// ============
+// ERR_PSEC_FLOW if an integration error is encountered, ERR_PSEC_MAXITER if
+// the maximum number of iterations is reached, and 0 otherwise.
+
+int refine_psec(double mu, const psec_flow_t *fl, const psec_t *sec,
+      double tol, const struct crossing_psec *c, double *x, double *t)
+{
+   bool newton = (sec->grad != NULL && fl->field != NULL);
+   double a = 0.0, fa = c->s_pre;	// bracket [a,b]
+   double b = c->t - c->t_pre, fb = c->s;
+   double tc = 0.0, fc = c->s_pre;	// current iterate
+   double tn;				// next iterate
+   double f[PSEC_MAXDIM], dS[PSEC_MAXDIM], dsdt;
+   rootstop_t rs;
+   int i, iter;
+
+   // Times are measured from c->t_pre, so the ulps are relative to 1+|t|.
+   rootstop_init(&rs, tol);
+   rs.scale = 1;
+
+   dblcpy(x, c->x_pre, fl->dim);
+   for(iter=0; iter<PSEC_MAXITER; iter++)
+   {
+      if(fabs(fc) <= tol)
+	 break;
+
+      tn = NAN;
+      if(newton && fl->field(0.0, x, f, &mu) == 0)
+      {
+	 sec->grad(x, dS, sec->par);
+	 dsdt = 0;
+	 for(i=0; i<fl->dim; i++)
+	    dsdt += dS[i]*f[i];
+	 tn = tc - fc/dsdt;
+      }
+      // Secant (Illinois) iterate, if Newton fails or leaves the bracket
+      if(!((a<tn && tn<b) || (b<tn && tn<a)))
+	 tn = (a*fb - b*fa)/(fb - fa);
+
+      // The bracket has shrunk to the precision of the time variable
+      if(rootstop_delta(&rs, c->t_pre+tc, c->t_pre+tn) != GSL_CONTINUE)
+	 break;
+
+      if(fl->flow(mu, tn-tc, x))
+      {
+	 fprintf(stderr, "psec_map: error refining crossing\n");
+	 *t = tc;
+	 return(ERR_PSEC_FLOW);
+      }
+      tc = tn;
+      fc = sec->fun(x, sec->par);
+
+      if(fc*fb < 0)
+      {
+	 a = b;
+	 fa = fb;
+      }
+      else
+	 fa /= 2;
+      b = tc;
+      fb = fc;
+   }
+   *t = tc;
+   if(iter>=PSEC_MAXITER)
+   {
+      fprintf(stderr, "psec_map: maximum number of iterations reached\n");
+      fprintf(stderr, "psec_map: last residual: %e\n", fc);
+      return(ERR_PSEC_MAXITER);
+   }
+   return(0);
+}
@@ -0,0 +1,236 @@
+/*! \file
+    \brief Generic Poincare Section Engine
+
+    A Poincare section is given by a section functional $S$ (the section is
+    $\{S=0\}$), together with a direction filter and an optional loop
+    filter. The engine follows a flow (Cartesian, Delaunay, ...), detects
+    the sign changes of $S$ along the trajectory, and refines each of them
+    with Newton's method in time (or with a safeguarded secant method if the
+    gradient of $S$ is not available).
+    The Poincare maps \ref prtbp_nl, \ref prtbp_del, \ref prtbp_del_car and
+    \ref prtbp_g are thin wrappers around \ref psec_map.
+*/
+
+#ifndef PSEC_H_INCLUDED
+#define PSEC_H_INCLUDED
+
+#include <stdbool.h>	// bool
+#include <rtbp.h>	// DIM
+#include <section.h>	// section_t
+
+/// Max dimension of the flow.
+#define PSEC_MAXDIM 6
+
+/** Integration error. */
+extern const int ERR_PSEC_FLOW;
+
+/** Max number of iterations reached while refining a crossing. */
+extern const int ERR_PSEC_MAXITER;
+
+/** The derivative of the flow was requested, but the flow has none. */
+extern const int ERR_PSEC_JAC;
+
+/// Default detection step for the Cartesian flow \ref frtbp.
+extern const double PSEC_STEP_CAR;
+
+/// Default detection step for the Delaunay flow \ref frtbp_del.
+extern const double PSEC_STEP_DEL;
+
+/**
+  Flow on which the section engine runs.
+  */
+typedef struct
+{
+   /// flow function, as \ref frtbp or \ref frtbp_del.
+   int (*flow)(double mu, double t, double *x);
+   /// vector field (GSL convention, params=&mu), as \ref rtbp or
+   /// \ref rtbp_del. May be NULL (then Newton's method is not used).
+   int (*field)(double t, const double *x, double *f, void *params);
+   int dim;		///< dimension of the flow
+   double step;		///< detection step (positive)
+   /// derivative of the flow $D\phi(t,x)$ (dim*dim, as \ref dfrtbp; x is
+   /// not modified), or NULL. Only used by \ref psec_stream.
+   int (*dflow)(double mu, double t, double *x, double *dphi);
+} psec_flow_t;
+
+/**
+  Section functional, with direction and loop filters.
+
+  A crossing of the section is a sign change of $S$ between two consecutive
+  points of the trajectory (or a point with $S$ exactly zero). It is
+  accepted if
+  - (period) for an angular functional with values in
+    $(-period/2,period/2]$, the jump of $S$ is smaller than period/2, i.e.
+    it is not the wrap-around on the opposite side;
+  - (direction) dir=0, or $dS/dt$ has the sign of dir;
+  - (loops) side=NULL, or the crossing is not a "contractible loop", i.e.
+    the signs of side() at the previous, current and next crossings are all
+    equal or alternate (see \ref prtbp_nl).
+  */
+typedef struct
+{
+   /// section functional $S(x)$
+   double (*fun)(const double *x, void *par);
+   /// gradient $\nabla S(x)$, or NULL
+   void (*grad)(const double *x, double *dS, void *par);
+   void *par;		///< parameters of fun, grad and side
+   double period;	///< 0, or period of an angular functional
+   int dir;		///< direction filter: +1, -1, or 0 (both)
+   /// loop filter: side of the section (e.g. $x$ for $\{y=0\}$), or NULL
+   double (*side)(const double *x, void *par);
+} psec_t;
+
+/// Cartesian flow \ref frtbp, detection step PSEC_STEP_CAR, derivative
+/// \ref dfrtbp.
+extern const psec_flow_t PSEC_FLOW_CAR;
+
+/// Delaunay flow \ref frtbp_del, detection step PSEC_STEP_DEL.
+extern const psec_flow_t PSEC_FLOW_DEL;
+
+/** Section functional $S=y$ (Cartesian). */
+double psec_y(const double *x, void *par);
+/** Gradient of \ref psec_y. */
+void psec_y_grad(const double *x, double *dS, void *par);
+/** Side of the section $\{y=0\}$: $x$ (Cartesian). */
+double psec_side_x(const double *x, void *par);
+
+/** Section functional $S=l-c$ mod $2\pi$ (Delaunay), par=&c. */
+double psec_l(const double *x, void *par);
+/** Gradient of \ref psec_l. */
+void psec_l_grad(const double *x, double *dS, void *par);
+
+/** Section functional $S=g-c$ mod $2\pi$ (Delaunay), par=&c. */
+double psec_g(const double *x, void *par);
+/** Gradient of \ref psec_g. */
+void psec_g_grad(const double *x, double *dS, void *par);
+
+/** Section functional $S=l-c$ mod $2\pi$ on a Cartesian point, par=&c. */
+double psec_car_l(const double *x, void *par);
+
+/** Section functional $S=g-c$ mod $2\pi$ on a Cartesian point, par=&c. */
+double psec_car_g(const double *x, void *par);
+
+/**
+  Section functional of the Delaunay sections.
+
+  \param[in] sec
+  SEC1, SEC2, SECg or SECg2, corresponding to $\{l=0\}$, $\{l=\pi\}$,
+  $\{g=0\}$ or $\{g=\pi\}$.
+  \param[in] car
+  false if the points are Delaunay elements (l,L,g,G) (flow \ref frtbp_del),
+  true if they are Cartesian (flow \ref frtbp); then the elements are
+  obtained with \ref cardel, and the gradient is not available.
+  \param[out] s	section
+  
+  \remark
+  Since $dg/dt<0$ near the 3:1 resonance, only crossings of $\{g=0\}$ with
+  decreasing $g$ are accepted, as the Delaunay maps always required.
+  */
+void psec_section_del(section_t sec, bool car, psec_t *s);
+
+/**
+  Poincare map on a generic section.
+
+  Compute the n-th iterate of the Poincare map $P^n(x)$ (or of the inverse
+  map $P^{-n}(x)$) associated to the section, and the integration time to
+  intersect the section n times.
+
+  The trajectory is integrated with steps of fl->step, and every step is
+  checked for a crossing. Each accepted crossing is refined with Newton's
+  method on $t\mapsto S(\phi(t,x))$, using $dS/dt=\nabla S\cdot f$. The flow
+  is integrated incrementally from one Newton iterate to the next, so each
+  iterate costs a short integration only. If the gradient (or the vector
+  field) is not given, the secant method (Illinois variant) is used instead.
+  The iterates are always kept inside the bracket of the crossing.
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] fl		flow
+  \param[in] sec	section
+  \param[in] cuts	number of cuts with the section (positive or zero)
+  \param[in] fwd	true for $P^n$, false for $P^{-n}$
+  \param[in] tol	tolerance for the refinement: $|S| \le tol$ (relaxed
+  			by the tolerance profile, see \ref tolprof_tol)
+
+  \param[in,out] x
+  Initial point. On return of this function, it holds the image point.
+
+  \param[out] ti
+  On return, it holds the integration time to intersect the section "n"
+  times (negative if fwd is false).
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success.
+
+  \retval ERR_PSEC_FLOW		Integration error.
+  \retval ERR_PSEC_MAXITER	The refinement did not converge. On return,
+  x holds the last iterate.
+
+  \remark
+  The refinement also stops (successfully) if the bracket of the crossing
+  has shrunk to the precision of the time variable, since then $|S|$ can
+  not be made smaller.
+  */
+int psec_map(double mu, const psec_flow_t *fl, const psec_t *sec, int cuts,
+      bool fwd, double tol, double *x, double *ti);
+
+/**
+  Crossing of a trajectory with the section, as passed to the output
+  function of \ref psec_stream.
+  */
+typedef struct
+{
+   int k;		///< index of the cut (1, 2, ...)
+   double t;		///< integration time from the initial point
+   const double *x;	///< point on the section
+   /// direction of the crossing: sign of $dS/dt$ (for $S=y$, +1 on SEC1
+   /// and -1 on SEC2)
+   int dir;
+   /// derivative $D\phi$ of the flow from the previous cut (or the initial
+   /// point) to this one, as in \ref dprtbp, or NULL if not requested
+   const double *dphi;
+} psec_cut_t;
+
+/**
+  Output function of \ref psec_stream: receives each cut and the parameters
+  par given to \ref psec_stream. A non-zero return value stops the stream.
+  */
+typedef int (*psec_out_t)(const psec_cut_t *cut, void *par);
+
+/**
+  Stream of Poincare cuts along one trajectory.
+
+  Follow the trajectory of x, as in \ref psec_map, and pass every accepted
+  crossing with the section (refined to the tolerance) to out, until n cuts
+  or until out returns a non-zero value. The trajectory is integrated only
+  once: each crossing is refined from the last point before it, while the
+  detection continues from the first point after it. Since the direction of
+  each cut is reported, the cuts of $\{y=0\}$ with SEC1 and SEC2 come out of
+  a single pass (use dir=0 in the section).
+
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] fl		flow
+  \param[in] sec	section
+  \param[in] cuts	number of cuts (0 for no limit)
+  \param[in] fwd	true for forward, false for backward integration
+  \param[in] tol	tolerance for the refinement, as in \ref psec_map
+  \param[in] jac	true to compute the derivative of the flow between
+  			consecutive cuts (needs fl->dflow)
+
+  \param[in,out] x
+  Initial point. On return of this function, it holds the last cut.
+
+  \param[in] out	output function
+  \param[in] par	parameters of the output function
+
+  \returns a non-zero error code to indicate an error and 0 to indicate
+  success (also if the stream is stopped by out).
+
+  \retval ERR_PSEC_FLOW		Integration error.
+  \retval ERR_PSEC_MAXITER	The refinement of a crossing did not converge.
+  \retval ERR_PSEC_JAC		jac is true, but fl->dflow is NULL.
+  */
+int psec_stream(double mu, const psec_flow_t *fl, const psec_t *sec,
+      int cuts, bool fwd, double tol, bool jac, double *x, psec_out_t out,
+      void *par);
+
+#endif // PSEC_H_INCLUDED
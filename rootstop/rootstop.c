@@ -0,0 +1,88 @@
+/*! \file
+    \brief Precision-Aware Termination of Root Finders
+*/
+
+#include <math.h>	// fabs, fmax, NAN
+#include <float.h>	// DBL_EPSILON
+#include <gsl/gsl_errno.h>	// GSL_SUCCESS, GSL_CONTINUE
+
+#include "rootstop.h"
+
+const int ROOTSTOP_ULPS=4;
+const int ROOTSTOP_NSTALL=3;
+
+int rootstop_close(const rootstop_t *rs, double a, double b);
+int rootstop_stop(rootstop_t *rs, rootstop_flag_t flag);
+
+void rootstop_init(rootstop_t *rs, double epsabs)
+{
+   rs->epsabs = epsabs;
+   rs->ulps = ROOTSTOP_ULPS;
+   rs->scale = 0;
+   rs->nstall = ROOTSTOP_NSTALL;
+   rs->flag = ROOTSTOP_CONTINUE;
+   rs->last = NAN;
+   rs->stall = 0;
+}
+
+int rootstop_interval(rootstop_t *rs, double x_lo, double x_hi)
+{
+   double w = fabs(x_hi - x_lo);
+
+   if(w < rs->epsabs)
+      return(rootstop_stop(rs, ROOTSTOP_TOL));
+   if(rootstop_close(rs, x_lo, x_hi))
+      return(rootstop_stop(rs, ROOTSTOP_PREC));
+
+   // The bracket has stopped shrinking
+   rs->stall = (w >= rs->last ? rs->stall+1 : 0);
+   rs->last = w;
+   if(rs->stall >= rs->nstall)
+      return(rootstop_stop(rs, ROOTSTOP_PREC));
+   return(GSL_CONTINUE);
+}
+
+int rootstop_residual(rootstop_t *rs, double x, double f)
+{
+   if(fabs(f) < rs->epsabs)
+      return(rootstop_stop(rs, ROOTSTOP_TOL));
+
+   // The iterate has stopped moving: the residual is at its rounding floor
+   rs->stall = (rootstop_close(rs, x, rs->last) ? rs->stall+1 : 0);
+   rs->last = x;
+   if(rs->stall >= rs->nstall)
+      return(rootstop_stop(rs, ROOTSTOP_PREC));
+   return(GSL_CONTINUE);
+}
+
+int rootstop_delta(rootstop_t *rs, double x0, double x1)
+{
+   if(rootstop_close(rs, x0, x1))
+      return(rootstop_stop(rs, ROOTSTOP_PREC));
+   return(GSL_CONTINUE);
+}
+
+// name OF FUNCTION: rootstop_close
+//
+// PURPOSE
+// =======
+// Determine if a and b are within rs->ulps units in the last place (see
+// rootstop_t). Returns 0 if any of them is NAN.
+
+int rootstop_close(const rootstop_t *rs, double a, double b)
+{
+   return(fabs(a-b) <=
+	 rs->ulps*DBL_EPSILON*(rs->scale + fmax(fabs(a),fabs(b))));
+}
+
+// name OF FUNCTION: rootstop_stop
+//
+// PURPOSE
+// =======
+// Record the reason of the stop, and return GSL_SUCCESS.
+
+int rootstop_stop(rootstop_t *rs, rootstop_flag_t flag)
+{
+   rs->flag = flag;
+   return(GSL_SUCCESS);
+}
@@ -0,0 +1,102 @@
+/*! \file
+    \brief Precision-Aware Termination of Root Finders
+
+    The root finders of the library (Brent's and bisection methods on the
+    manifold distance, Newton's method in time on a Poincare section, ...)
+    ask for tolerances at the resolution of double precision. When the
+    tolerance cannot be reached, the iteration would run to its maximum
+    number of iterations, each of them a full Poincare map in the worst
+    case.
+
+    The tests in this module are drop-in replacements of
+    gsl_root_test_interval and gsl_root_test_residual (they return
+    GSL_SUCCESS or GSL_CONTINUE). They also stop the iteration successfully
+    when it stagnates at machine precision:
+    - the end points of the bracket, or two consecutive iterates, are
+      within a few units in the last place;
+    - the bracket has not shrunk for a few consecutive iterations;
+    - the iterate has not moved for a few consecutive iterations, so the
+      residual sits at its rounding floor.
+
+    The reason of the stop is recorded in the flag of the \ref rootstop_t.
+*/
+
+#ifndef ROOTSTOP_H_INCLUDED
+#define ROOTSTOP_H_INCLUDED
+
+/// Reason why a root finder stopped.
+typedef enum
+{
+   ROOTSTOP_CONTINUE,	///< not converged yet
+   ROOTSTOP_TOL,	///< requested tolerance reached
+   ROOTSTOP_PREC	///< converged to machine precision (tolerance not
+   			///< reached)
+} rootstop_flag_t;
+
+/// Default distance (in units in the last place) regarded as converged.
+extern const int ROOTSTOP_ULPS;
+
+/// Default number of iterations without progress before stopping.
+extern const int ROOTSTOP_NSTALL;
+
+/**
+  Termination policy of a root finder.
+
+  Two numbers a, b are within ulps units in the last place if
+  $|a-b| \le ulps\cdot\epsilon\cdot(scale+\max(|a|,|b|))$, with $\epsilon$
+  the machine epsilon. Set scale to 0 for a purely relative test, or to the
+  typical size of the variable if it may cross zero (e.g. a time).
+  */
+typedef struct
+{
+   double epsabs;	///< requested tolerance
+   int ulps;		///< distance regarded as converged (ulps)
+   double scale;	///< absolute scale of the variable
+   int nstall;		///< iterations without progress before stopping
+   rootstop_flag_t flag;	///< reason of the stop
+
+   double last;		///< previous bracket width, or previous iterate
+   int stall;		///< consecutive iterations without progress
+} rootstop_t;
+
+/**
+  Initialize the policy with tolerance epsabs and default parameters
+  (ROOTSTOP_ULPS, scale 0, ROOTSTOP_NSTALL).
+  */
+void rootstop_init(rootstop_t *rs, double epsabs);
+
+/**
+  Convergence test on a bracket $[x_{lo},x_{hi}]$.
+
+  Succeeds if $|x_{hi}-x_{lo}| < epsabs$ (as gsl_root_test_interval with
+  epsrel=0), if the end points are within rs->ulps, or if the width has not
+  decreased for rs->nstall iterations.
+
+  \returns GSL_SUCCESS or GSL_CONTINUE. On success, rs->flag is ROOTSTOP_TOL
+  or ROOTSTOP_PREC.
+  */
+int rootstop_interval(rootstop_t *rs, double x_lo, double x_hi);
+
+/**
+  Convergence test on the residual $f$ at the iterate $x$.
+
+  Succeeds if $|f| < epsabs$ (as gsl_root_test_residual), or if the iterate
+  has moved less than rs->ulps for rs->nstall consecutive iterations.
+
+  \returns GSL_SUCCESS or GSL_CONTINUE. On success, rs->flag is ROOTSTOP_TOL
+  or ROOTSTOP_PREC.
+  */
+int rootstop_residual(rootstop_t *rs, double x, double f);
+
+/**
+  Convergence test on the step from the iterate $x_0$ to the next one $x_1$.
+
+  To be called before evaluating the function at $x_1$: succeeds (with
+  rs->flag=ROOTSTOP_PREC) if $x_0$ and $x_1$ are within rs->ulps, since then
+  the evaluation can not improve the residual.
+
+  \returns GSL_SUCCESS or GSL_CONTINUE.
+  */
+int rootstop_delta(rootstop_t *rs, double x0, double x1);
+
+#endif // ROOTSTOP_H_INCLUDED
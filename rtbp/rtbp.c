@@ -18,11 +18,21 @@
 // Hamilt
 //    Hamiltonian function of the RTBP.
 //
+// Hamilt_batch
+//    Hamiltonian function of the RTBP at n points.
+//
 // rtbp
 //    Computes the vectorfield of the RTBP problem.
 //
 // rtbp_inv
 //    Computes the negative vectorfield of the RTBP problem.
+//
+// rtbp_lc
+//    Computes the vectorfield of the RTBP problem in Levi-Civita
+//    coordinates centered at the small primary (Jupiter).
+//
+// car2lc, lc2car
+//    Change from Cartesian to Levi-Civita coordinates, and back.
 
 #include <math.h>
 #include <gsl/gsl_errno.h>
@@ -47,6 +57,31 @@ double Hamilt(double mu, const double *p)
    return 0.5*(px*px + py*py) + y*px - x*py - mu1/r1 - mu2/r2;
 }
 
+// name OF FUNCTION: Hamilt_batch
+// PURPOSE:
+//    Same as Hamilt, for n points in structure-of-arrays layout:
+//    H[i] = Hamilt(mu, (x[i],y[i],px[i],py[i])).
+//    The loop has no branches, so that compilers can vectorize it.
+void Hamilt_batch(double mu, int n, const double *restrict x,
+      const double *restrict y, const double *restrict px,
+      const double *restrict py, double *restrict H)
+{
+   // Place large mass to the left of the origin, small mass to the right.
+   double mu1 = mu;
+   double mu2 = 1.0-mu;
+
+   int i;
+   double r1, r2;
+
+   for(i=0; i<n; i++)
+   {
+      r1=sqrt((x[i]-mu2)*(x[i]-mu2)+y[i]*y[i]);
+      r2=sqrt((x[i]+mu1)*(x[i]+mu1)+y[i]*y[i]);
+      H[i] = 0.5*(px[i]*px[i] + py[i]*py[i]) + y[i]*px[i] - x[i]*py[i]
+         - mu1/r1 - mu2/r2;
+   }
+}
+
 // name OF FUNCTION: rtbp
 // CREDIT: Angel Jorba, with modifications by Pau Roldan
 // PURPOSE:
@@ -160,3 +195,125 @@ int rtbp_inv(double t, const double *x, double *y, void *params)
    y[3]=x[2]+aux3*x[1];
    return GSL_SUCCESS;
 }
+
+// name OF FUNCTION: rtbp_lc
+// PURPOSE:
+//    The function computes the vectorfield of the RTBP in Levi-Civita
+//    coordinates centered at the small primary (Jupiter), with fictitious
+//    time $s$, $dt/ds = r$, where $r$ is the distance to Jupiter.
+//    The vectorfield is regular at the collision with Jupiter $r=0$.
+//
+// NOTES
+// -----
+//
+// Let $z = (x-\mu_2) + iy = u^2$ be the position relative to Jupiter, and
+// $' = d/ds$. The equations of motion $\ddot z + 2i\dot z = \nabla\Omega$,
+// with $\Omega = |z+\mu_2|^2/2 + \mu/|z| + (1-\mu)/|z+1|$, become
+//
+//    u'' = -2i|u|^2 u' + u(\Omega_r+H)/2 + |u|^2 \bar u G(u^2)/2,
+//    t' = |u|^2,
+//
+// where $\Omega_r = \Omega - \mu/|z|$, $G = \nabla\Omega_r$, and the energy
+// $H$ (the value of the Hamiltonian, see Hamilt) has been used to cancel the
+// singular terms. Thus the vectorfield depends on $H$, and it is only valid
+// on the energy level $H$.
+//
+// PARAMETERS:
+// - s fictitious time. Since this is an autonomous ODE, this parameter is
+//   not used.
+// - y point in phase space, 5 coordinates: (u_1, u_2, u_1', u_2', t).
+// - f vectorfield at (s,y), 5 coordinates.
+// - params pointer to the parameters of the system, 2 doubles: the mass
+//   ratio "mu" and the energy "H".
+// 
+// RETURN VALUE:
+// status code of the function (success/error):
+//    - GSL_SUCCESS: success.
+//    - ERR_COLLISION: collision of the third mass with the Sun.
+
+int rtbp_lc(double s, const double *y, double *f, void *params)
+{
+   double mu = ((double *)params)[0];
+   double H = ((double *)params)[1];
+   double mu2 = 1.0-mu;
+   double u1=y[0], u2=y[1], w1=y[2], w2=y[3];
+
+   double r = u1*u1+u2*u2;		// distance to Jupiter
+   double z1 = u1*u1-u2*u2;		// z = u^2
+   double z2 = 2*u1*u2;
+   double rho2 = (z1+1)*(z1+1)+z2*z2;	// squared distance to the Sun
+   double rho = sqrt(rho2);
+   double rho3 = rho2*rho;
+   double omr, g1, g2, b;
+
+   if(rho3<COLLISION_TOL)
+      return ERR_COLLISION;
+
+   // \Omega_r and its gradient G
+   omr = 0.5*((z1+mu2)*(z1+mu2)+z2*z2) + mu2/rho;
+   g1 = (z1+mu2) - mu2*(z1+1)/rho3;
+   g2 = z2 - mu2*z2/rho3;
+
+   b = 0.5*(omr + H);
+   f[0] = w1;
+   f[1] = w2;
+   f[2] = 2*r*w2 + b*u1 + 0.5*r*(u1*g1+u2*g2);
+   f[3] = -2*r*w1 + b*u2 + 0.5*r*(u1*g2-u2*g1);
+   f[4] = r;
+   return GSL_SUCCESS;
+}
+
+// name OF FUNCTION: car2lc
+// PURPOSE:
+//    Change from Cartesian coordinates x = (X, Y, P_X, P_Y) to Levi-Civita
+//    coordinates y = (u_1, u_2, u_1', u_2'), centered at Jupiter.
+//    The time coordinate y[4] is not set.
+//
+// NOTES
+// -----
+// $u = \sqrt z$ (principal branch), and $u' = \dot z \bar u/2$, where
+// $\dot z = (P_X+Y) + i(P_Y-X)$ is the velocity.
+
+void car2lc(double mu, const double *x, double *y)
+{
+   double z1 = x[0]-(1.0-mu);
+   double z2 = x[1];
+   double v1 = x[2]+x[1];
+   double v2 = x[3]-x[0];
+   double r = sqrt(z1*z1+z2*z2);
+   double u1, u2;
+
+   // Avoid cancellation: compute the largest of u1, u2 first.
+   if(z1>=0)
+   {
+      u1 = sqrt(0.5*(r+z1));
+      u2 = (u1>0 ? z2/(2*u1) : 0);
+   }
+   else
+   {
+      u2 = copysign(sqrt(0.5*(r-z1)), z2);
+      u1 = z2/(2*u2);
+   }
+   y[0] = u1;
+   y[1] = u2;
+   y[2] = 0.5*(v1*u1+v2*u2);
+   y[3] = 0.5*(v2*u1-v1*u2);
+}
+
+// name OF FUNCTION: lc2car
+// PURPOSE:
+//    Change from Levi-Civita coordinates y = (u_1, u_2, u_1', u_2') back to
+//    Cartesian coordinates x = (X, Y, P_X, P_Y). See car2lc.
+
+void lc2car(double mu, const double *y, double *x)
+{
+   double u1=y[0], u2=y[1], w1=y[2], w2=y[3];
+   double r = u1*u1+u2*u2;
+   double v1 = 2*(w1*u1-w2*u2)/r;	// \dot z = 2u'u/|u|^2
+   double v2 = 2*(w1*u2+w2*u1)/r;
+
+   x[0] = u1*u1-u2*u2 + (1.0-mu);
+   x[1] = 2*u1*u2;
+   x[2] = v1-x[1];
+   x[3] = v2+x[0];
+}
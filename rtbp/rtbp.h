@@ -1,5 +1,13 @@
 #define DIM 4	// dimension of the (planar) RTBP
 #define ERR_COLLISION 1
+#define DIMLC 5	// dimension of the Levi-Civita regularized RTBP: (u,u',t)
+
 double Hamilt(double mu, const double *p);
+void Hamilt_batch(double mu, int n, const double *restrict x,
+      const double *restrict y, const double *restrict px,
+      const double *restrict py, double *restrict H);
 int rtbp(double t, const double *x, double *y, void *params);
 int rtbp_inv(double t, const double *x, double *y, void *params);
+int rtbp_lc(double s, const double *y, double *f, void *params);
+void car2lc(double mu, const double *x, double *y);
+void lc2car(double mu, const double *y, double *x);
@@ -16,11 +16,13 @@
 //    This function computes the function $\Delta_{ell}^{1,+}$ (real and
 //    imaginary part).
 
+#include <stdio.h>		// fprintf
 #include <math.h>		// M_PI
 #include <stdlib.h>		// EXIT_FAILURE
 #include <assert.h>
 #include <gsl/gsl_errno.h>	// GSL_SUCCESS
 #include <gsl/gsl_roots.h>	// GSL one-dimensional root finding
+#include <rootstop.h>		// rootstop_t, rootstop_interval
 #include "rtbpdel.h"		// ERR_COLLISION
 
 //const double COLLISION_TOL = 1.e-12;
@@ -70,9 +72,11 @@ void trig_fdf(double u, void *params, double *y, double *dy)
 double eccentric(double e, double l)
 {
    // Desired precision for root. 
-   // Note: we have tried 1.e-15, but such high precision could not always be
-   // achieved.
+   // Note: such high precision can not always be achieved, so we also stop
+   // when the bracket has converged to machine precision.
    const double epsabs = 1.e-15;
+   // Residual of Kepler's equation accepted at machine precision.
+   const double restol = 1.e-12;
 
     int status;
     int iter = 0, max_iter = 1000;
@@ -82,6 +86,7 @@ double eccentric(double e, double l)
     double x_lo = l-1, x_hi = 1+l;
     gsl_function F;
     struct trig_params params = {e, l};
+    rootstop_t rs;
   
     F.function = &trig;
     F.params = &params;
@@ -89,6 +94,7 @@ double eccentric(double e, double l)
     T = gsl_root_fsolver_brent;
     s = gsl_root_fsolver_alloc (T);
     gsl_root_fsolver_set (s, &F, x_lo, x_hi);
+    rootstop_init(&rs, epsabs);
   
     /*
     printf ("using %s method\n", 
@@ -106,8 +112,7 @@ double eccentric(double e, double l)
 	r = gsl_root_fsolver_root (s);
 	x_lo = gsl_root_fsolver_x_lower (s);
 	x_hi = gsl_root_fsolver_x_upper (s);
-	status = gsl_root_test_interval (x_lo, x_hi,
-					 epsabs, 0);
+	status = rootstop_interval (&rs, x_lo, x_hi);
   
 	/*
 	if (status == GSL_SUCCESS)
@@ -126,6 +131,14 @@ double eccentric(double e, double l)
        fprintf(stderr, "eccentric: can not find root!\n");
        exit(EXIT_FAILURE);
     }
+    // Stopping at machine precision is expected here, but then the root
+    // must still solve Kepler's equation to rounding error.
+    if(rs.flag == ROOTSTOP_PREC && fabs(trig(r,&params)) > restol*(1+fabs(l)))
+    {
+       fprintf(stderr, "eccentric: converged to machine precision, "
+	     "but residual is %e\n", trig(r,&params));
+       exit(EXIT_FAILURE);
+    }
     gsl_root_fsolver_free (s);
 
     //assert((0<=r) && (r<2*M_PI));
@@ -0,0 +1,708 @@
+/*! \file
+    \brief Segment Jet: Jet Transport of a Fundamental Segment
+
+    A jet is a polynomial in $\tau$, stored as its SEGJET_DEG+1 coefficients.
+    Products are truncated at degree SEGJET_DEG. The powers $g^\alpha$ (for
+    $r^{-1}$, $r^{-3}$ and the square root of \ref hinv) are computed with
+    the recurrence of frtbp_jet, which holds for any series with $g_0>0$.
+
+    The Taylor method carries two expansions: in time (order SEGJET_ORD),
+    whose coefficients are jets in $\tau$. The step size is that of the
+    constant-order method of Jorba and Zou, with the norm of a jet taken as
+    the sum of the absolute values of its coefficients (a bound on
+    $[-1,1]$).
+*/
+
+#include <stdio.h>	// fprintf
+#include <string.h>	// memcpy, memset
+#include <math.h>	// pow, fabs, HUGE_VAL
+#include <float.h>	// DBL_EPSILON
+
+#include <rtbp.h>	// DIM
+#include <section.h>	// SEC2
+#include <hinv.h>	// hinv
+#include <prtbp_nl.h>	// prtbp_nl, prtbp_nl_inv
+#include <tolprof.h>	// tolprof_tol
+
+#include "segjet.h"
+
+const int ERR_SEGJET_MAP=1;
+const int ERR_SEGJET_SPLIT=2;
+const int ERR_SEGJET_ROOT=3;
+
+const double SEGJET_TOL=1.e-12;
+
+/// Local error of the Taylor steps, relative to the size of the jets.
+static const double SEGJET_EPS=1.e-16;
+
+/// Max number of Taylor steps on each piece.
+static const int SEGJET_MAXSTEPS=100000;
+
+/// Max depth of the splitting (2^SEGJET_MAXDEPTH <= SEGJET_MAXPIECES).
+static const int SEGJET_MAXDEPTH=6;
+
+/// Max number of iterations of Newton's method on polynomials.
+static const int SEGJET_MAXITER=100;
+
+/// Max number of iterations of Newton's method on the map.
+static const int SEGJET_MAXNEWTON=5;
+
+/// Precision of the root on the map (as BISECT_TOL in intersec).
+static const double SEGJET_HTOL=1.e-15;
+
+/// Jet: polynomial in the segment parameter $\tau$.
+typedef double jet_t[SEGJET_DEG+1];
+
+void jet_mac(const double *a, const double *b, double s, double *c);
+int jet_pow(const double *g, double alpha, double *f);
+int jet_div(const double *a, const double *b, double *c);
+double jet_eval(const double *a, double tau, double *da);
+double jet_norm(const double *a);
+int jet_ok(const double *a, double tol);
+int segjet_lift(const segjet_t *sj, double hc, double hr, jet_t x[DIM]);
+int segjet_taylor(double mu, jet_t x[DIM], jet_t c[DIM][SEGJET_ORD+1]);
+double segjet_step(jet_t c[DIM][SEGJET_ORD+1]);
+int segjet_transport(const segjet_t *sj, double a, double b,
+      double coef[SEGJET_NCOMP][SEGJET_DEG+1]);
+int segjet_piece(segjet_t *sj, double a, double b, int depth);
+int segjet_dist(const segjet_t *sj, double h, double a, double *d);
+
+int segjet_build(segjet_t *sj, double mu, double H, const double p[2],
+      const double v[2], int iter, int fwd, double h1, double h2, double tol)
+{
+   sj->mu = mu;
+   sj->H = H;
+   sj->p[0] = p[0];
+   sj->p[1] = p[1];
+   sj->v[0] = v[0];
+   sj->v[1] = v[1];
+   sj->iter = iter;
+   sj->fwd = fwd;
+   sj->tol = tol;
+   sj->npieces = 0;
+   sj->hb[0] = (h1 < h2 ? h1 : h2);
+   return(segjet_piece(sj, sj->hb[0], (h1 < h2 ? h2 : h1), 0));
+}
+
+int segjet_eval(const segjet_t *sj, double h, double q[SEGJET_NCOMP],
+      double dq[SEGJET_NCOMP])
+{
+   double tau, len, d;
+   int j, c;
+
+   if(sj->npieces == 0 || h < sj->hb[0] || h > sj->hb[sj->npieces])
+      return(1);
+   for(j=0; j<sj->npieces-1 && h > sj->hb[j+1]; j++);
+   len = sj->hb[j+1] - sj->hb[j];
+   tau = (2*h - sj->hb[j] - sj->hb[j+1])/len;
+   for(c=0; c<SEGJET_NCOMP; c++)
+   {
+      q[c] = jet_eval(sj->coef[j][c], tau, &d);
+      if(dq != NULL)
+	 dq[c] = d*2/len;
+   }
+   return(0);
+}
+
+int segjet_root(const segjet_t *sj, double a, double *h)
+{
+   const int n = 2*SEGJET_DEG;	// size of the grid on each piece
+   const double *c;		// jet of p_x on the piece
+   double q[SEGJET_NCOMP], dq[SEGJET_NCOMP];
+   double lo, hi, tau, tnew, f0, f1, f, df;
+   double d, dprev, hprev, dh;
+   int i, j, k, found = 0;
+
+   // Bracket the first crossing on the grids.
+   for(j=0; j<sj->npieces && !found; j++)
+   {
+      c = sj->coef[j][1];
+      f0 = jet_eval(c, -1, NULL) - a;
+      for(i=1; i<=n && !found; i++)
+      {
+	 hi = -1 + 2.0*i/n;
+	 f1 = jet_eval(c, hi, NULL) - a;
+	 if(f0*f1 <= 0)
+	 {
+	    lo = -1 + 2.0*(i-1)/n;
+	    found = 1;
+	 }
+	 else
+	    f0 = f1;
+      }
+   }
+   if(!found)
+   {
+      fprintf(stderr, "segjet_root: the segment does not cross p_x=%e\n", a);
+      return(ERR_SEGJET_ROOT);
+   }
+   j--;
+
+   // Newton's method on the polynomial, safeguarded by bisection.
+   tau = (f0 == 0 ? lo : (lo+hi)/2);
+   for(k=0; k<SEGJET_MAXITER && f0 != 0; k++)
+   {
+      f = jet_eval(c, tau, &df) - a;
+      if(f == 0)
+	 break;
+      if((f < 0) == (f0 < 0))
+	 lo = tau;
+      else
+	 hi = tau;
+      tnew = tau - f/df;
+      if(!(tnew > lo && tnew < hi))
+	 tnew = (lo+hi)/2;
+      if(fabs(tnew-tau) <= DBL_EPSILON)
+      {
+	 tau = tnew;
+	 break;
+      }
+      tau = tnew;
+   }
+   *h = sj->hb[j] + (tau+1)/2*(sj->hb[j+1]-sj->hb[j]);
+
+   // Newton's method on the map, with the derivative of the jet. It stops
+   // when the correction is below SEGJET_HTOL, or when the distance stops
+   // decreasing (the accuracy of the map is reached).
+   dprev = HUGE_VAL;
+   hprev = *h;
+   for(k=0; k<SEGJET_MAXNEWTON; k++)
+   {
+      if(segjet_dist(sj, *h, a, &d))
+	 return(ERR_SEGJET_ROOT);
+      if(fabs(d) >= dprev)
+      {
+	 *h = hprev;
+	 return(0);
+      }
+      if(segjet_eval(sj, *h, q, dq) || dq[1] == 0)
+	 break;
+      dh = -d/dq[1];
+      hprev = *h;
+      dprev = fabs(d);
+      *h += dh;
+      if(fabs(dh) <= tolprof_tol(TOL_ROOT, SEGJET_HTOL))
+	 return(0);
+   }
+   fprintf(stderr, "segjet_root: Newton's method on the map did not "
+	 "converge\n");
+   return(ERR_SEGJET_ROOT);
+}
+
+// name OF FUNCTION: segjet_piece
+//
+// PURPOSE
+// =======
+// Transport the piece [a,b] of the segment (see segjet_transport), and
+// append it to the jet. If the truncation error is above the tolerance, the
+// piece is split in halves, up to depth SEGJET_MAXDEPTH.
+//
+// RETURN VALUE
+// ============
+// Returns ERR_SEGJET_MAP if the piece could not be lifted or mapped,
+// ERR_SEGJET_SPLIT if the tolerance was not reached, and 0 otherwise.
+
+int segjet_piece(segjet_t *sj, double a, double b, int depth)
+{
+   int status;
+
+   status = segjet_transport(sj, a, b, sj->coef[sj->npieces]);
+   if(status == ERR_SEGJET_SPLIT && depth < SEGJET_MAXDEPTH)
+   {
+      if((status = segjet_piece(sj, a, (a+b)/2, depth+1)))
+	 return(status);
+      return(segjet_piece(sj, (a+b)/2, b, depth+1));
+   }
+   if(status == ERR_SEGJET_SPLIT)
+      fprintf(stderr, "segjet: tolerance not reached on [%e,%e]\n", a, b);
+   if(status)
+      return(status);
+   sj->npieces++;
+   sj->hb[sj->npieces] = b;
+   return(0);
+}
+
+// name OF FUNCTION: segjet_transport
+//
+// PURPOSE
+// =======
+// Jet transport of the piece [a,b] of the segment, with $h=(a+b)/2 +
+// \tau (b-a)/2$.
+//
+// The center of the piece is mapped with prtbp_nl (or prtbp_nl_inv), which
+// counts the crossings and gives the integration time T. The lifted piece
+// is integrated up to time T with the Taylor method on jets. Then the
+// crossing time T+d(\tau) of the whole piece is solved by Newton's method
+// on jets, with the Taylor expansion at time T:
+//    y(d) = \sum_k c_k d^k = 0,   d(0) \approx 0.
+// On return, coef holds the jets of x, p_x and the integration time.
+//
+// RETURN VALUE
+// ============
+// Returns ERR_SEGJET_MAP if the piece could not be lifted or integrated,
+// ERR_SEGJET_SPLIT if the truncation error is above the tolerance (the
+// piece must be split), and 0 otherwise.
+
+int segjet_transport(const segjet_t *sj, double a, double b,
+      double coef[SEGJET_NCOMP][SEGJET_DEG+1])
+{
+   jet_t x[DIM];			/* lifted piece */
+   jet_t c[DIM][SEGJET_ORD+1];		/* Taylor coefficients in time */
+   jet_t d;				/* crossing time, minus T */
+   jet_t y, dy, u;
+   double xc[DIM];			/* center of the piece */
+   double T, t, dt, rho;
+   int i, k, l, n;
+
+   if(segjet_lift(sj, (a+b)/2, (b-a)/2, x))
+      return(ERR_SEGJET_MAP);
+
+   // The crossings are counted on the center of the piece.
+   for(i=0; i<DIM; i++)
+      xc[i] = x[i][0];
+   if((sj->fwd ? prtbp_nl(sj->mu,SEC2,sj->iter,xc,&T) :
+	    prtbp_nl_inv(sj->mu,SEC2,sj->iter,xc,&T)))
+   {
+      fprintf(stderr, "segjet: error computing Poincare map\n");
+      return(ERR_SEGJET_MAP);
+   }
+
+   // Taylor steps on jets, up to time T.
+   t = 0;
+   for(n=0; t != T; n++)
+   {
+      if(n == SEGJET_MAXSTEPS || segjet_taylor(sj->mu, x, c))
+      {
+	 fprintf(stderr, "segjet: error integrating the segment\n");
+	 return(ERR_SEGJET_MAP);
+      }
+      rho = segjet_step(c);
+      if(fabs(T-t) <= rho)
+      {
+	 dt = T-t;
+	 t = T;
+      }
+      else
+      {
+	 dt = (T > 0 ? rho : -rho);
+	 t += dt;
+      }
+      for(i=0; i<DIM; i++)
+      {
+	 memcpy(x[i], c[i][SEGJET_ORD], sizeof(jet_t));
+	 for(k=SEGJET_ORD-1; k>=0; k--)
+	    for(l=0; l<=SEGJET_DEG; l++)
+	       x[i][l] = x[i][l]*dt + c[i][k][l];
+	 if(!jet_ok(x[i], sj->tol))
+	    return(ERR_SEGJET_SPLIT);
+      }
+   }
+
+   // Crossing time of the piece.
+   if(segjet_taylor(sj->mu, x, c))
+   {
+      fprintf(stderr, "segjet: error integrating the segment\n");
+      return(ERR_SEGJET_MAP);
+   }
+   rho = segjet_step(c);
+   memset(d, 0, sizeof(jet_t));
+   for(n=0; n<SEGJET_MAXITER; n++)
+   {
+      // y = y(d), dy = y'(d), with Horner's rule on jets
+      memcpy(y, c[1][SEGJET_ORD], sizeof(jet_t));
+      for(l=0; l<=SEGJET_DEG; l++)
+	 dy[l] = SEGJET_ORD*c[1][SEGJET_ORD][l];
+      for(k=SEGJET_ORD-1; k>=0; k--)
+      {
+	 memcpy(u, c[1][k], sizeof(jet_t));
+	 jet_mac(y, d, 1, u);
+	 memcpy(y, u, sizeof(jet_t));
+	 if(k == 0)
+	    break;
+	 for(l=0; l<=SEGJET_DEG; l++)
+	    u[l] = k*c[1][k][l];
+	 jet_mac(dy, d, 1, u);
+	 memcpy(dy, u, sizeof(jet_t));
+      }
+      if(jet_div(y, dy, u))
+      {
+	 fprintf(stderr, "segjet: flow is tangent to section\n");
+	 return(ERR_SEGJET_MAP);
+      }
+      for(l=0; l<=SEGJET_DEG; l++)
+	 d[l] -= u[l];
+      if(jet_norm(u) <= 10*DBL_EPSILON*(1+jet_norm(d)))
+	 break;
+   }
+   // The crossing must be within the Taylor step at time T.
+   if(n == SEGJET_MAXITER || jet_norm(d) > rho)
+      return(ERR_SEGJET_SPLIT);
+
+   // x and p_x at the crossing, and integration time
+   for(i=0; i<2; i++)
+   {
+      memcpy(y, c[2*i][SEGJET_ORD], sizeof(jet_t));
+      for(k=SEGJET_ORD-1; k>=0; k--)
+      {
+	 memcpy(u, c[2*i][k], sizeof(jet_t));
+	 jet_mac(y, d, 1, u);
+	 memcpy(y, u, sizeof(jet_t));
+      }
+      memcpy(coef[i], y, sizeof(jet_t));
+   }
+   memcpy(coef[2], d, sizeof(jet_t));
+   coef[2][0] += T;
+
+   for(i=0; i<SEGJET_NCOMP; i++)
+      if(!jet_ok(coef[i], sj->tol))
+	 return(ERR_SEGJET_SPLIT);
+   return(0);
+}
+
+// name OF FUNCTION: segjet_lift
+//
+// PURPOSE
+// =======
+// Lift the piece $p+hv$, $h=hc+\tau hr$, of the segment to the energy level
+// H on SEC2, as hinv does, on jets:
+//    p_y = x - \sqrt{-p_x^2 + x^2 + 2 \mu_1/r_1 + 2 \mu_2/r_2 + 2H}.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the discriminant is not positive, and 0
+// otherwise.
+
+int segjet_lift(const segjet_t *sj, double hc, double hr, jet_t x[DIM])
+{
+   const double mu1 = sj->mu;
+   const double mu2 = 1.0-sj->mu;
+   jet_t r1, r2;	/* 1/r1, 1/r2 */
+   jet_t u, disc;
+   int l;
+
+   memset(x, 0, DIM*sizeof(jet_t));
+   x[0][0] = sj->p[0] + hc*sj->v[0];	// x
+   x[0][1] = hr*sj->v[0];
+   x[2][0] = sj->p[1] + hc*sj->v[1];	// px
+   x[2][1] = hr*sj->v[1];
+
+   // 1/r1 = ((x-mu2)^2)^{-1/2}, 1/r2 = ((x+mu1)^2)^{-1/2}
+   memset(u, 0, sizeof(jet_t));
+   u[0] = (x[0][0]-mu2)*(x[0][0]-mu2);
+   u[1] = 2*(x[0][0]-mu2)*x[0][1];
+   u[2] = x[0][1]*x[0][1];
+   if(jet_pow(u, -0.5, r1))
+      return(1);
+   u[0] = (x[0][0]+mu1)*(x[0][0]+mu1);
+   u[1] = 2*(x[0][0]+mu1)*x[0][1];
+   if(jet_pow(u, -0.5, r2))
+      return(1);
+
+   memset(disc, 0, sizeof(jet_t));
+   jet_mac(x[0], x[0], 1, disc);
+   jet_mac(x[2], x[2], -1, disc);
+   for(l=0; l<=SEGJET_DEG; l++)
+      disc[l] += 2*(mu1*r1[l] + mu2*r2[l]);
+   disc[0] += 2*sj->H;
+   if(jet_pow(disc, 0.5, u))
+   {
+      fprintf(stderr, "segjet: error lifting segment\n");
+      return(1);
+   }
+   for(l=0; l<=SEGJET_DEG; l++)
+      x[3][l] = x[0][l] - u[l];		// in section SEC2, we want vy<0
+   return(0);
+}
+
+// name OF FUNCTION: segjet_taylor
+//
+// PURPOSE
+// =======
+// Taylor coefficients c[i][k], k=0,...,SEGJET_ORD, of the solution of the
+// RTBP through the jet x at t=0. These are the recurrences of frtbp_jet,
+// with jets instead of numbers: with $A=x-\mu_2$, $B=x+\mu_1$, the series
+// $s_1=A^2+y^2$, $s_2=B^2+y^2$ are powered to $q=s^{-3/2}$ with
+// $q_k = \frac{1}{k s_0} \sum_{j=1}^k (-\frac{3}{2} j - (k-j)) s_j q_{k-j}$,
+// where the division by the jet $s_0$ is a product by its inverse.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the piece hits a primary, and 0 otherwise.
+
+int segjet_taylor(double mu, jet_t x[DIM], jet_t c[DIM][SEGJET_ORD+1])
+{
+   const double mu1 = mu;
+   const double mu2 = 1.0-mu;
+   jet_t a[SEGJET_ORD+1], b[SEGJET_ORD+1];	/* x-mu2, x+mu1 */
+   jet_t s1[SEGJET_ORD+1], s2[SEGJET_ORD+1];	/* r1^2, r2^2 */
+   jet_t q1[SEGJET_ORD+1], q2[SEGJET_ORD+1];	/* r1^-3, r2^-3 */
+   jet_t m[SEGJET_ORD+1];			/* mu1 q1 + mu2 q2 */
+   jet_t i1, i2;				/* 1/s1_0, 1/s2_0 */
+   jet_t yy, u1, u2, aq, bq, qy;
+   int i, j, k, l;
+
+   for(i=0; i<DIM; i++)
+      memcpy(c[i][0], x[i], sizeof(jet_t));
+   for(k=0; k<SEGJET_ORD; k++)
+   {
+      memcpy(a[k], c[0][k], sizeof(jet_t));
+      memcpy(b[k], c[0][k], sizeof(jet_t));
+      if(k == 0)
+      {
+	 a[0][0] -= mu2;
+	 b[0][0] += mu1;
+      }
+      memset(yy, 0, sizeof(jet_t));
+      memset(s1[k], 0, sizeof(jet_t));
+      memset(s2[k], 0, sizeof(jet_t));
+      for(j=0; j<=k; j++)
+      {
+	 jet_mac(c[1][j], c[1][k-j], 1, yy);
+	 jet_mac(a[j], a[k-j], 1, s1[k]);
+	 jet_mac(b[j], b[k-j], 1, s2[k]);
+      }
+      for(l=0; l<=SEGJET_DEG; l++)
+      {
+	 s1[k][l] += yy[l];
+	 s2[k][l] += yy[l];
+      }
+      if(k == 0)
+      {
+	 if(jet_pow(s1[0], -1.5, q1[0]) || jet_pow(s2[0], -1.5, q2[0]) ||
+	       jet_pow(s1[0], -1, i1) || jet_pow(s2[0], -1, i2))
+	    return(1);
+      }
+      else
+      {
+	 memset(u1, 0, sizeof(jet_t));
+	 memset(u2, 0, sizeof(jet_t));
+	 for(j=1; j<=k; j++)
+	 {
+	    jet_mac(s1[j], q1[k-j], (-1.5*j-(k-j))/k, u1);
+	    jet_mac(s2[j], q2[k-j], (-1.5*j-(k-j))/k, u2);
+	 }
+	 memset(q1[k], 0, sizeof(jet_t));
+	 memset(q2[k], 0, sizeof(jet_t));
+	 jet_mac(u1, i1, 1, q1[k]);
+	 jet_mac(u2, i2, 1, q2[k]);
+      }
+      for(l=0; l<=SEGJET_DEG; l++)
+	 m[k][l] = mu1*q1[k][l] + mu2*q2[k][l];
+
+      memset(aq, 0, sizeof(jet_t));
+      memset(bq, 0, sizeof(jet_t));
+      memset(qy, 0, sizeof(jet_t));
+      for(j=0; j<=k; j++)
+      {
+	 jet_mac(a[j], q1[k-j], 1, aq);
+	 jet_mac(b[j], q2[k-j], 1, bq);
+	 jet_mac(m[j], c[1][k-j], 1, qy);
+      }
+      for(l=0; l<=SEGJET_DEG; l++)
+      {
+	 c[0][k+1][l] = (c[2][k][l]+c[1][k][l])/(k+1);
+	 c[1][k+1][l] = (-c[0][k][l]+c[3][k][l])/(k+1);
+	 c[2][k+1][l] = (c[3][k][l]-mu1*aq[l]-mu2*bq[l])/(k+1);
+	 c[3][k+1][l] = (-c[2][k][l]-qy[l])/(k+1);
+      }
+   }
+   return(0);
+}
+
+// name OF FUNCTION: segjet_step
+//
+// PURPOSE
+// =======
+// Step size of the Taylor method of order SEGJET_ORD (as in Jorba and Zou),
+// from the norms of the last two coefficients:
+//    \min_{k=ord-1,ord} (\epsilon/|c_k|)^{1/k},
+// with $\epsilon$ = SEGJET_EPS relative to the size of the point.
+
+double segjet_step(jet_t c[DIM][SEGJET_ORD+1])
+{
+   double nx = 0, n1 = 0, n2 = 0, eps, rho;
+   int i;
+
+   for(i=0; i<DIM; i++)
+   {
+      nx = fmax(nx, jet_norm(c[i][0]));
+      n1 = fmax(n1, jet_norm(c[i][SEGJET_ORD-1]));
+      n2 = fmax(n2, jet_norm(c[i][SEGJET_ORD]));
+   }
+   eps = SEGJET_EPS*fmax(nx, 1);
+   rho = HUGE_VAL;
+   if(n1 > 0)
+      rho = pow(eps/n1, 1.0/(SEGJET_ORD-1));
+   if(n2 > 0)
+      rho = fmin(rho, pow(eps/n2, 1.0/SEGJET_ORD));
+   return(rho);
+}
+
+// name OF FUNCTION: segjet_dist
+//
+// PURPOSE
+// =======
+// Distance d = p_x(P^{\pm n}(p+hv)) - a, on the true map, as in
+// distance_f_unst and distance_f_st of intersec.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if the point could not be lifted or mapped, and 0
+// otherwise.
+
+int segjet_dist(const segjet_t *sj, double h, double a, double *d)
+{
+   double x[DIM];
+   double t;
+
+   x[0] = sj->p[0] + h*sj->v[0];	// x
+   x[1] = 0;				// y
+   x[2] = sj->p[1] + h*sj->v[1];	// px
+   if(hinv(sj->mu,SEC2,sj->H,x))
+   {
+      fprintf(stderr, "segjet: error lifting point\n");
+      return(1);
+   }
+   if((sj->fwd ? prtbp_nl(sj->mu,SEC2,sj->iter,x,&t) :
+	    prtbp_nl_inv(sj->mu,SEC2,sj->iter,x,&t)))
+   {
+      fprintf(stderr, "segjet: error computing Poincare map\n");
+      return(1);
+   }
+   *d = x[2] - a;
+   return(0);
+}
+
+// name OF FUNCTION: jet_mac
+//
+// PURPOSE
+// =======
+// Truncated product and accumulation on jets: c += s*a*b. The jet c must
+// not be a or b.
+
+void jet_mac(const double *a, const double *b, double s, double *c)
+{
+   double sum;
+   int j, k;
+
+   for(k=0; k<=SEGJET_DEG; k++)
+   {
+      sum = 0;
+      for(j=0; j<=k; j++)
+	 sum += a[j]*b[k-j];
+      c[k] += s*sum;
+   }
+}
+
+// name OF FUNCTION: jet_pow
+//
+// PURPOSE
+// =======
+// Power f = g^alpha of a jet, with the recurrence
+//    f_0 = g_0^alpha,
+//    f_k = \frac{1}{k g_0} \sum_{j=1}^k (\alpha j - (k-j)) g_j f_{k-j}.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if g_0 is not positive, and 0 otherwise.
+
+int jet_pow(const double *g, double alpha, double *f)
+{
+   int j, k;
+
+   if(!(g[0] > 0))
+      return(1);
+   f[0] = pow(g[0], alpha);
+   for(k=1; k<=SEGJET_DEG; k++)
+   {
+      f[k] = 0;
+      for(j=1; j<=k; j++)
+	 f[k] += (alpha*j-(k-j))*g[j]*f[k-j];
+      f[k] /= k*g[0];
+   }
+   return(0);
+}
+
+// name OF FUNCTION: jet_div
+//
+// PURPOSE
+// =======
+// Quotient of jets, c = a/b:
+//    c_k = (a_k - \sum_{j=1}^k b_j c_{k-j}) / b_0.
+//
+// RETURN VALUE
+// ============
+// Returns a non-zero value if b_0 is zero, and 0 otherwise.
+
+int jet_div(const double *a, const double *b, double *c)
+{
+   int j, k;
+
+   if(b[0] == 0)
+      return(1);
+   for(k=0; k<=SEGJET_DEG; k++)
+   {
+      c[k] = a[k];
+      for(j=1; j<=k; j++)
+	 c[k] -= b[j]*c[k-j];
+      c[k] /= b[0];
+   }
+   return(0);
+}
+
+// name OF FUNCTION: jet_eval
+//
+// PURPOSE
+// =======
+// Evaluate the jet a (and its derivative da, if not NULL) at tau, with
+// Horner's rule.
+
+double jet_eval(const double *a, double tau, double *da)
+{
+   double f = a[SEGJET_DEG], df = 0;
+   int k;
+
+   for(k=SEGJET_DEG-1; k>=0; k--)
+   {
+      df = df*tau + f;
+      f = f*tau + a[k];
+   }
+   if(da != NULL)
+      *da = df;
+   return(f);
+}
+
+// name OF FUNCTION: jet_norm
+//
+// PURPOSE
+// =======
+// Sum of the absolute values of the coefficients (a bound of the jet on
+// $[-1,1]$).
+
+double jet_norm(const double *a)
+{
+   double s = 0;
+   int k;
+
+   for(k=0; k<=SEGJET_DEG; k++)
+      s += fabs(a[k]);
+   return(s);
+}
+
+// name OF FUNCTION: jet_ok
+//
+// PURPOSE
+// =======
+// Check the truncation error of a jet: the tail (last two coefficients)
+// must be below tol, relative to the size of the jet.
+//
+// RETURN VALUE
+// ============
+// Returns 1 if the tail is below the tolerance, and 0 otherwise.
+
+int jet_ok(const double *a, double tol)
+{
+   double tail = fabs(a[SEGJET_DEG-1]) + fabs(a[SEGJET_DEG]);
+
+   return(tail <= tol*(1+fabs(a[0])));
+}
@@ -0,0 +1,133 @@
+/*! \file
+    \brief Segment Jet: Jet Transport of a Fundamental Segment
+
+    Let $p$ be a fixed point of the Poincare map $P$ on SEC2, and $v$ its
+    unstable (stable) eigenvector. The segment $p+hv$, $h\in[h_1,h_2]$, is
+    lifted to the energy level and integrated as a whole: each coordinate is
+    a polynomial in the rescaled parameter $\tau\in[-1,1]$, truncated at
+    degree SEGJET_DEG, and the Taylor method of the RTBP (the recurrences of
+    frtbp_jet) is run with polynomial coefficients. The crossing time with
+    the section is solved as a polynomial in $\tau$ too, by Newton's method.
+    One integration gives the image of the segment under $P^n$ (resp.
+    $P^{-n}$): $x$, $p_x$ and the integration time, as polynomials in
+    $\tau$.
+
+    The truncation error is estimated by the last two coefficients of the
+    polynomials. The interval is split in halves until it is below the
+    tolerance.
+
+    Once the jet is built, points of the manifold, brackets of the crossings
+    with a line $p_x=a$, and the derivatives $d/dh$ needed by Newton's method
+    are polynomial evaluations, instead of new orbits.
+*/
+
+#ifndef SEGJET_H_INCLUDED
+#define SEGJET_H_INCLUDED
+
+/// Degree of the polynomials in the segment parameter.
+#define SEGJET_DEG 12
+
+/// Order of the Taylor method in time.
+#define SEGJET_ORD 20
+
+/// Max number of pieces of the segment.
+#define SEGJET_MAXPIECES 64
+
+/// Number of components: $x$, $p_x$, integration time.
+#define SEGJET_NCOMP 3
+
+/** Error lifting the segment, or integrating its center. */
+extern const int ERR_SEGJET_MAP;
+
+/** Tolerance not reached with SEGJET_MAXPIECES pieces. */
+extern const int ERR_SEGJET_SPLIT;
+
+/** No root found, or Newton's method on the map did not converge. */
+extern const int ERR_SEGJET_ROOT;
+
+/// Default tolerance on the truncation error.
+extern const double SEGJET_TOL;
+
+/**
+  Segment jet.
+
+  Piece $j$ is $[h_j,h_{j+1}]$, with hb[j]=$h_j$ increasing. On piece $j$,
+  component $c$ is $\sum_{k=0}^{deg} a_k \tau^k$, with $\tau\in[-1,1]$
+  the rescaled parameter, and $a_k$ = coef[j][c][k].
+  */
+typedef struct
+{
+   double mu;		///< mass parameter for the RTBP
+   double H;		///< energy value
+   double p[2];		///< fixed point $p=(x,p_x)$
+   double v[2];		///< eigenvector
+   int iter;		///< number of cuts with the section
+   int fwd;		///< 1 for $P^n$ (unstable), 0 for $P^{-n}$ (stable)
+   double tol;		///< tolerance on the truncation error
+
+   int npieces;		///< number of pieces
+   double hb[SEGJET_MAXPIECES+1];	///< boundaries of the pieces
+   /// Coefficients of $x$, $p_x$ and time on each piece.
+   double coef[SEGJET_MAXPIECES][SEGJET_NCOMP][SEGJET_DEG+1];
+} segjet_t;
+
+/**
+  Build the jet of the segment $p+hv$, $h\in[h_1,h_2]$.
+
+  The map is the iterate (with iter cuts) of \ref prtbp_nl (fwd=1) or
+  \ref prtbp_nl_inv (fwd=0), as in \ref intersec_h_unst and \ref
+  intersec_h_st. The crossings are counted on the center of each piece,
+  which is integrated once with \ref prtbp_nl; the whole piece is then
+  transported for the same time, and its crossing time is solved.
+
+  \param[out] sj	segment jet
+  \param[in] mu		mass parameter for the RTBP
+  \param[in] H		energy value
+  \param[in] p		fixed point $p=(x,p_x)$
+  \param[in] v		eigenvector
+  \param[in] iter	number of cuts with the section
+  \param[in] fwd	1 for the unstable manifold, 0 for the stable one
+  \param[in] h1,h2	interval of the segment parameter
+  \param[in] tol	tolerance on the truncation error (e.g. SEGJET_TOL)
+
+  \retval ERR_SEGJET_MAP	Error lifting a piece or mapping its center.
+  \retval ERR_SEGJET_SPLIT	Tolerance not reached (the jet is not usable).
+  */
+int segjet_build(segjet_t *sj, double mu, double H, const double p[2],
+      const double v[2], int iter, int fwd, double h1, double h2, double tol);
+
+/**
+  Evaluate the jet.
+
+  \param[in] sj		segment jet
+  \param[in] h		segment parameter (in $[h_1,h_2]$)
+  \param[out] q		$x$, $p_x$ and integration time of the image point
+  \param[out] dq	their derivatives with respect to $h$ (or NULL)
+
+  \returns a non-zero value if h is outside the jet, and 0 otherwise.
+  */
+int segjet_eval(const segjet_t *sj, double h, double q[SEGJET_NCOMP],
+      double dq[SEGJET_NCOMP]);
+
+/**
+  First crossing of the segment with the line $p_x=a$.
+
+  The crossing is bracketed by the sign changes of $p_x-a$ on a uniform
+  grid of each piece (in increasing $h$), and refined with Newton's method
+  on the polynomial, safeguarded by bisection. Then the root is checked
+  against the true map: Newton's method is iterated on
+  $p_x(P^{\pm n}(p+hv))-a$, with the derivative taken from the jet, until
+  the correction is below the precision of \ref intersec_h_unst, or the
+  distance stops decreasing (the accuracy of the map is reached). This
+  usually takes two or three orbits.
+
+  \param[in] sj		segment jet
+  \param[in] a		line $p_x=a$
+  \param[out] h		root
+
+  \retval ERR_SEGJET_ROOT	No crossing found, or Newton's method on the
+  map did not converge.
+  */
+int segjet_root(const segjet_t *sj, double a, double *h);
+
+#endif // SEGJET_H_INCLUDED
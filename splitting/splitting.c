@@ -15,6 +15,7 @@
 #include <prtbp_nl_2d_module.h>
 #include <prtbp_nl.h>
 #include <dprtbp_2d.h>	// dprtbp_nl_2d, dprtbp_2d_inv
+#include "splitting.h"	// splitting_angle_unst, splitting_angle_st
 
 int tanvec_u(double mu, double H, double v_u[2], int n, double p_u[2], 
       double w[2]);
@@ -76,7 +77,6 @@ int splitting_unst(double mu, double H, double v[2], int n, double p[2],
 {
    double w[2]; // tangent vector to the unstable manifold at z
    //double dot;	  // dot product w_u\times w_s
-   double alpha;  // splitting half-angle
 
    tanvec_u(mu, H, v, n, p, w);
    //printf("w_u: %.15le %.15le\n", w_u[0], w_u[1]);
@@ -84,8 +84,7 @@ int splitting_unst(double mu, double H, double v[2], int n, double p[2],
    // Output splitting angle
    //dot = - w_u[1];
 
-   alpha=atan2(-w[0],-w[1]);
-   *angle = WrapPosNegPI(2.0*alpha);
+   *angle = splitting_angle_unst(w);
    return(0);
 }
 
@@ -101,7 +100,6 @@ int splitting_st(double mu, double H, double v[2], int n, double p[2],
 {
    double w[2]; // tangent vector to the stable manifold at z
    //double dot;	  // dot product w_u\times w_s
-   double alpha;  // splitting half-angle
 
    tanvec_s(mu, H, v, n, p, w);
    //printf("w_u: %.15le %.15le\n", w_u[0], w_u[1]);
@@ -109,12 +107,46 @@ int splitting_st(double mu, double H, double v[2], int n, double p[2],
    // Output splitting angle
    //dot = - w_u[1];
 
-   alpha=atan2(w[0],w[1]);
    //*angle = 2.0*acos(dot);
-   *angle = WrapPosNegPI(2.0*alpha);
+   *angle = splitting_angle_st(w);
    return(0);
 }
 
+/**
+  Splitting angle from the tangent vector to the unstable manifold at the
+  homoclinic point $z$.
+
+  The manifolds are symmetric w.r.t. the line $p_x=0$, so the splitting
+  angle is twice the half-angle between $w$ and the vertical vector $(0,-1)$.
+
+  \param[in] w   tangent vector to the unstable manifold at $z$.
+
+  \returns the splitting angle, in \f$(-\pi,\pi]\f$.
+ */
+
+double splitting_angle_unst(double w[2])
+{
+   double alpha;  // splitting half-angle
+
+   alpha=atan2(-w[0],-w[1]);
+   return(WrapPosNegPI(2.0*alpha));
+}
+
+/**
+  Splitting angle from the tangent vector to the stable manifold at the
+  homoclinic point $z$.
+
+  Exactly as \ref splitting_angle_unst.
+ */
+
+double splitting_angle_st(double w[2])
+{
+   double alpha;  // splitting half-angle
+
+   alpha=atan2(w[0],w[1]);
+   return(WrapPosNegPI(2.0*alpha));
+}
+
 // name OF FUNCTION: tanvec_u
 //
 // PURPOSE
@@ -2,3 +2,5 @@ int splitting_unst(double mu, double H, double v[2], int n, double p[2],
       double *angle);
 int splitting_st(double mu, double H, double v[2], int n, double p[2],
       double *angle);
+double splitting_angle_unst(double w[2]);
+double splitting_angle_st(double w[2]);
@@ -6,15 +6,52 @@
 #include <stdio.h>
 #include <stdlib.h>	    // EXIT_SUCCESS, EXIT_FAILURE
 #include <math.h>	    // fabs, fmax
-#include <frtbp.h>      // DIM
-#include <prtbp_2d.h>
-#include <sec2sec1_module.h>
+#include <frtbp.h>      // DIM, frtbp
+#include <rtbp.h>       // rtbp
+#include <section.h>    // section_t
+#include <hinv.h>       // hinv
+#include <psec.h>       // psec_stream, psec_y, psec_side_x
+
+const double MAX_DIST = 1e-4;
+const int MAX_ITERS= 200;
+
+// Parameters of the output function niterates_out
+struct niterates_par
+{
+    section_t sec;  // section where the homoclinic point lies
+    double z[2];    // homoclinic point (2D)
+    int n0;         // index of the starting cut (-1 if not reached yet)
+    int n;          // number of iterates from the starting cut
+};
 
 double dist(double x[2], double y[2])
 {
     return fmax(fabs(x[0]-y[0]), fabs(x[1]-y[1]));
 }
 
+/**
+   Output function of psec_stream.
+
+   The starting cut is the initial point $p_u$ on SEC2, or the first cut
+   with SEC1 (as in sec2sec1). The stream stops when a cut is within
+   MAX_DIST of the homoclinic point, or after MAX_ITERS cuts from the
+   starting one.
+ */
+int niterates_out(const psec_cut_t *cut, void *par)
+{
+    struct niterates_par *np = (struct niterates_par *)par;
+    double x[2] = {cut->x[0], cut->x[2]};   // (x, p_x)
+
+    if(np->n0 < 0)
+    {
+        if(cut->dir < 0)
+            return(0);
+        np->n0 = cut->k;
+    }
+    np->n = cut->k - np->n0;
+    return(dist(x,np->z)<=MAX_DIST || np->n>=MAX_ITERS);
+}
+
 /** 
    Number of Poincare iterates to reach homoclinic point
 
@@ -41,7 +78,9 @@ double dist(double x[2], double y[2])
       - point "p_u" in the unstable segment (2D)
       - homoclinic point "z" (2D)
   
-   2. Iterate the point p_u until it reaches homoclinic point z.
+   2. Iterate the point p_u until it reaches homoclinic point z. The cuts
+      of the trajectory of p_u with SEC1 and SEC2 are obtained in a single
+      pass with psec_stream.
   
    3. Output the following data to stdout:
 
@@ -52,23 +91,18 @@ double dist(double x[2], double y[2])
 
 int main( )
 {
-    const double MAX_DIST = 1e-4;
-    const int MAX_ITERS= 200;
    double mu, H;
 
    double p_u[2];	// points in the unstable segment
    double z[DIM];	    // homoclinic points
-   double z2[2];	    // homoclinic points
-
-   // Number of iterations by the Poincare map in the unstable dir.
-   int n;
 
    // auxiliary vars
+   psec_flow_t fl = {frtbp, rtbp, DIM, 0.01};
+   psec_t s = {psec_y, psec_y_grad, NULL, 0, 0, psec_side_x};
+   struct niterates_par np;
    int status;
-   double x[2];     // point in the manifold
-   double ti;
+   double x[DIM];     // point in the manifold
    double vy;
-   section_t sec;
 
    // 1. Input parameters from stdin.
    if(scanf("%le", &mu) < 1)
@@ -82,35 +116,35 @@ int main( )
    {
        fprintf(stderr, "H=%e\n",H);
 
-       z2[0] = z[0];    // x
-       z2[1] = z[2];    // p_x
+       np.z[0] = z[0];    // x
+       np.z[1] = z[2];    // p_x
 
        vy = z[3]-z[0];  // p_y - x
-       if(vy>0)
+       np.sec = (vy>0 ? SEC1 : SEC2);
+       np.n0 = (np.sec==SEC1 ? -1 : 0);
+       np.n = 0;
+
+       x[0] = p_u[0];   // x
+       x[1] = 0;        // y
+       x[2] = p_u[1];   // p_x
+       if(hinv(mu,SEC2,H,x))
        {
-           // take p_u to section SEC1
-           sec2sec1(mu,H,p_u,&ti);
-           sec = SEC1;
+          fprintf(stderr, "main: error inverting the Hamiltonian");
+          exit(EXIT_FAILURE);
        }
-       else
-           sec = SEC2;
-
-       x[0] = p_u[0];
-       x[1] = p_u[1];
        
       // 2. Iterate the point x until it reaches homoclinic point z.
-      n=0;
-      while(dist(x,z2)>MAX_DIST && n<MAX_ITERS)
+      if(np.sec==SEC1 || dist(p_u,np.z)>MAX_DIST)
       {
-          status = prtbp_2d(mu,sec,H,1,x,&ti);
+          status = psec_stream(mu,&fl,&s,0,true,1.e-16,false,x,
+                niterates_out,&np);
           if(status)
           {
              fprintf(stderr, "main: error iterating point");
              exit(EXIT_FAILURE);
           }
-          n++;
       }
-      if(n==MAX_ITERS)
+      if(np.n==MAX_ITERS)
       {
          fprintf(stderr, "main: too many iterates!");
          //exit(EXIT_FAILURE);
@@ -121,7 +155,7 @@ int main( )
        //    - energy value "H"
        //    - section "SEC1" or "SEC2" where the homoclinic point lies
        //    - number of iterates to reach z
-      printf("%le %s %d\n", H, (sec==SEC1? "SEC1":"SEC2"), n);
+      printf("%le %s %d\n", H, (np.sec==SEC1? "SEC1":"SEC2"), np.n);
    }
    exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,161 @@
+/*! \file
+    \brief Tolerance Profiles
+*/
+
+#include <stdio.h>	// fprintf
+#include <stdlib.h>	// getenv, strtod
+#include <string.h>	// strlen, strncmp, strcspn
+#include <math.h>	// fabs
+#include <time.h>	// clock_gettime
+
+#include "tolprof.h"
+
+const int ERR_TOLPROF_PARSE=1;
+const int ERR_TOLPROF_CALIB=2;
+
+const char *TOLPROF_NAMES[TOLPROF_NPROF] = {"draft", "standard", "publication"};
+const char *TOLPROF_STAGES[TOL_NSTAGES] = {"flow", "map", "root", "quad"};
+
+/// Relaxation factors of the named profiles (flow, map, root, quad).
+static const double TOLPROF_FACTOR[TOLPROF_NPROF][TOL_NSTAGES] = {
+   {1.e4, 1.e4, 1.e6, 1.e3},	// draft
+   {1.e2, 1.e2, 1.e2, 1.e1},	// standard
+   {1, 1, 1, 1}			// publication
+};
+
+tolprof_t tolprof = {TOLPROF_PUBLICATION, {1, 1, 1, 1}, {0, 0, 0, 0}};
+
+double tolprof_wtime(void);
+
+void tolprof_set(tolprof_name_t name)
+{
+   int i;
+
+   tolprof.name = name;
+   for(i=0; i<TOL_NSTAGES; i++)
+   {
+      tolprof.factor[i] = TOLPROF_FACTOR[name][i];
+      tolprof.tol[i] = 0;
+   }
+}
+
+void tolprof_override(tolprof_stage_t stage, double tol)
+{
+   tolprof.tol[stage] = tol;
+}
+
+double tolprof_tol(tolprof_stage_t stage, double tol)
+{
+   if(tolprof.tol[stage] > 0)
+      return(tolprof.tol[stage]);
+   return(tol*tolprof.factor[stage]);
+}
+
+int tolprof_parse(const char *s)
+{
+   tolprof_t save = tolprof;
+   size_t len;
+   char *end;
+   double tol;
+   int i;
+
+   // Profile name
+   len = strcspn(s, ",");
+   for(i=0; i<TOLPROF_NPROF; i++)
+      if(strlen(TOLPROF_NAMES[i]) == len && strncmp(s, TOLPROF_NAMES[i], len) == 0)
+	 break;
+   if(i == TOLPROF_NPROF)
+   {
+      fprintf(stderr, "tolprof_parse: unknown profile in \"%s\"\n", s);
+      return(ERR_TOLPROF_PARSE);
+   }
+   tolprof_set(i);
+
+   // Overrides "stage=tol"
+   for(s += len; *s == ','; s += len)
+   {
+      s++;
+      len = strcspn(s, "=,");
+      for(i=0; i<TOL_NSTAGES; i++)
+	 if(strlen(TOLPROF_STAGES[i]) == len &&
+	       strncmp(s, TOLPROF_STAGES[i], len) == 0)
+	    break;
+      if(i == TOL_NSTAGES || s[len] != '=')
+	 break;
+      tol = strtod(s+len+1, &end);
+      if(end == s+len+1 || !(tol > 0))
+	 break;
+      tolprof_override(i, tol);
+      len = end-s;
+   }
+   if(*s != '\0')
+   {
+      fprintf(stderr, "tolprof_parse: invalid override \"%s\"\n", s);
+      tolprof = save;
+      return(ERR_TOLPROF_PARSE);
+   }
+   return(0);
+}
+
+int tolprof_getenv(void)
+{
+   const char *s = getenv("RTBP_TOLPROF");
+
+   if(s == NULL)
+      return(0);
+   return(tolprof_parse(s));
+}
+
+int tolprof_calibrate(tolprof_qfun_t fun, void *par, double target,
+      tolprof_name_t *best, double *q)
+{
+   tolprof_t save = tolprof;
+   double val, err, t0, time;
+   int name, status;
+
+   *best = TOLPROF_PUBLICATION;
+   for(name=TOLPROF_PUBLICATION; name>=0; name--)
+   {
+      tolprof_set(name);
+      t0 = tolprof_wtime();
+      status = fun(par, &val);
+      time = tolprof_wtime() - t0;
+      if(name == TOLPROF_PUBLICATION)
+      {
+	 if(status)
+	 {
+	    fprintf(stderr, "tolprof_calibrate: error computing reference\n");
+	    tolprof = save;
+	    return(ERR_TOLPROF_CALIB);
+	 }
+	 *q = val;
+      }
+      if(status)
+      {
+	 fprintf(stderr, "tolprof: %-11s failed (%.3f s)\n",
+	       TOLPROF_NAMES[name], time);
+	 continue;
+      }
+      err = fabs(val - *q);
+      fprintf(stderr, "tolprof: %-11s q=%.15e err=%.3e (%.3f s)\n",
+	    TOLPROF_NAMES[name], val, err, time);
+      if(err <= target)
+	 *best = name;
+   }
+   tolprof = save;
+   return(0);
+}
+
+// name OF FUNCTION: tolprof_wtime
+//
+// PURPOSE
+// =======
+// Wall clock time in seconds (since an arbitrary origin).
+
+double tolprof_wtime(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(ts.tv_sec + 1.e-9*ts.tv_nsec);
+}
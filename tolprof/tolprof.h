@@ -0,0 +1,140 @@
+/*! \file
+    \brief Tolerance Profiles
+
+    The tolerances of the library are grouped in four stages: flows
+    (local error of the integrators), Poincare maps (distance to the
+    section), root finders (manifold intersections), and quadratures.
+    Each module keeps its own "publication" tolerance, and asks the current
+    profile for the tolerance actually used, with \ref tolprof_tol.
+
+    A profile relaxes each stage by a factor. The named profiles are
+    - publication: all factors 1 (the tolerances of the modules);
+    - standard: flows, maps and roots $10^2$, quadratures $10$;
+    - draft: flows and maps $10^4$, roots $10^6$, quadratures $10^3$.
+
+    Any stage may be overridden with an absolute tolerance. The current
+    profile is global (as the mass parameter of the Taylor integrator), and
+    must be set before any parallel region.
+
+    Calibration (\ref tolprof_calibrate) evaluates a final quantity
+    (splitting angle, ...) with every profile, and reports the cheapest one
+    that meets a target error with respect to the publication profile.
+*/
+
+#ifndef TOLPROF_H_INCLUDED
+#define TOLPROF_H_INCLUDED
+
+/** Invalid profile string. */
+extern const int ERR_TOLPROF_PARSE;
+
+/** The quantity could not be computed with the publication profile. */
+extern const int ERR_TOLPROF_CALIB;
+
+/// Named profiles, from the cheapest to the most accurate.
+typedef enum
+{
+   TOLPROF_DRAFT,
+   TOLPROF_STANDARD,
+   TOLPROF_PUBLICATION,
+   TOLPROF_NPROF
+} tolprof_name_t;
+
+/// Stages of a computation.
+typedef enum
+{
+   TOL_FLOW,	///< local error of the integrators
+   TOL_MAP,	///< distance to the Poincare section
+   TOL_ROOT,	///< root finders on the manifolds
+   TOL_QUAD,	///< quadratures
+   TOL_NSTAGES
+} tolprof_stage_t;
+
+/// Names of the profiles ("draft", "standard", "publication").
+extern const char *TOLPROF_NAMES[TOLPROF_NPROF];
+
+/// Names of the stages ("flow", "map", "root", "quad").
+extern const char *TOLPROF_STAGES[TOL_NSTAGES];
+
+/**
+  Tolerance profile.
+  */
+typedef struct
+{
+   tolprof_name_t name;		///< named profile
+   double factor[TOL_NSTAGES];	///< relaxation factor of each stage
+   double tol[TOL_NSTAGES];	///< absolute override of each stage, or 0
+} tolprof_t;
+
+/// Current profile (publication by default).
+extern tolprof_t tolprof;
+
+/**
+  Set the current profile to a named profile, without overrides.
+  */
+void tolprof_set(tolprof_name_t name);
+
+/**
+  Override the tolerance of a stage of the current profile.
+
+  \param[in] stage	stage
+  \param[in] tol	absolute tolerance (0 to remove the override)
+  */
+void tolprof_override(tolprof_stage_t stage, double tol);
+
+/**
+  Tolerance of a stage.
+
+  \param[in] stage	stage
+  \param[in] tol	publication tolerance of the caller
+
+  \returns the override of the stage if there is one, and tol times the
+  factor of the stage otherwise.
+  */
+double tolprof_tol(tolprof_stage_t stage, double tol);
+
+/**
+  Set the current profile from a string.
+
+  The string is a profile name, optionally followed by comma-separated
+  overrides, e.g. "draft" or "standard,flow=1e-13,quad=1e-8".
+
+  \retval ERR_TOLPROF_PARSE	Invalid string (the profile is unchanged).
+  */
+int tolprof_parse(const char *s);
+
+/**
+  Set the current profile from the environment variable RTBP_TOLPROF (see
+  \ref tolprof_parse), if it is defined.
+
+  \retval ERR_TOLPROF_PARSE	Invalid value (the profile is unchanged).
+  */
+int tolprof_getenv(void);
+
+/**
+  Quantity to calibrate: compute *q with the current profile, and return a
+  non-zero value on error.
+  */
+typedef int (*tolprof_qfun_t)(void *par, double *q);
+
+/**
+  Calibration of the profiles.
+
+  Compute the quantity with the publication profile (the reference), and
+  with the cheaper ones. A line with the value, the error with respect to
+  the reference, and the wall time is printed to stderr for each profile.
+  The current profile is restored on return.
+
+  \param[in] fun	quantity
+  \param[in] par	parameters of fun
+  \param[in] target	target error (absolute)
+  \param[out] best	cheapest profile with error at most target
+
+  \param[out] q
+  Value of the quantity with the publication profile.
+
+  \retval ERR_TOLPROF_CALIB	The reference could not be computed.
+  */
+int tolprof_calibrate(tolprof_qfun_t fun, void *par, double target,
+      tolprof_name_t *best, double *q);
+
+#endif // TOLPROF_H_INCLUDED
@@ -23,7 +23,10 @@
 //
 // NOTES:
 // Here, step size does not refer to integration step size, which is actually
-// variable, but to the distance between points in trajectory.
+// variable, but to the distance between points in trajectory. The
+// integrator takes its natural steps, and the points that fall inside a step
+// are interpolated (see frtbp_del_sample), so the cost does not depend on the
+// step size.
 //
 // The step size must have the same sign as the integration time!!!
 // (positive->fwd integration, negative->bwd integration).
@@ -32,7 +35,7 @@
 // The list of general tasks is:
 // 1. Input mass parameter, initial condition, integration time, and step
 //    size from stdin.
-// 2. Integrate trajectory numerically by calling frtbp. 
+// 2. Integrate trajectory numerically by calling frtbp_del_sample. 
 //    As the trajectory is integrated, output points in the trajectory to
 //    stdout.
 //
@@ -40,19 +43,21 @@
 //
 // print_pt
 //    Print a point of a trajectory to stdout.
+//
+// print_sample
+//    Output function of frtbp_del_sample.
 
 #include <stdio.h>
 #include <stdlib.h>	// EXIT_SUCCESS, EXIT_FAILURE
-#include <math.h>	// fabs
-#include <frtbpdel.h>	// frtbp_del
+#include <frtbpdel.h>	// frtbp_del_sample
 #include <rtbp.h>	// DIM
 
-inline void print_pt(double t, double x[DIM]);
+inline void print_pt(double t, const double x[DIM]);
+int print_sample(double t, const double x[DIM], void *par);
 
 int main( )
 {
    double mu;		/* mass parameter */
-   double t;		/* current time */
    double t0;		/* initial time */
    double t1;		/* final time */
    double h;		/* step size */
@@ -77,33 +82,14 @@ int main( )
       exit(EXIT_FAILURE);
    }
 	    
-   // Integrate trajectory numerically.
-   t=t0;
-   do
-   {
-      // Output time and point to stdout.
-      print_pt(t, x);
-
-      status = frtbp_del(mu,h,x);
-      if (status != 0)
-      {
-	 fprintf(stderr, "main: error integrating trajectory");
-	 exit(EXIT_FAILURE);
-      }
-      t += h;
-   } while (fabs(t-t0)<fabs(t1));
-
-   // Final point is treated specially.
-   status = frtbp_del(mu,-h,x);
-   t -= h;
-   status = frtbp_del(mu,t1-(t-t0),x);
+   // Integrate trajectory numerically, and output the time and points to
+   // stdout.
+   status = frtbp_del_sample(mu,t1,x,h,print_sample,&t0);
    if (status != 0)
    {
       fprintf(stderr, "main: error integrating trajectory");
       exit(EXIT_FAILURE);
    }
-   t = t0+t1;
-   print_pt(t, x);
    exit(EXIT_SUCCESS);
 }
 
@@ -123,9 +109,9 @@ int main( )
 //
 // CALLS TO: none
 //
-// CALLED FROM: main
+// CALLED FROM: print_sample
 
-inline void print_pt(double t, double x[DIM])
+inline void print_pt(double t, const double x[DIM])
 {
    if(printf("%le %le %le %le %le\n", t, x[0], x[1], x[2], x[3])<0)
    {
@@ -133,3 +119,22 @@ inline void print_pt(double t, double x[DIM])
       exit(EXIT_FAILURE);
    }
 }
+
+// name OF FUNCTION: print_sample
+// CREDIT: 
+// PURPOSE:
+// Output function of frtbp_del_sample: print the point x of the trajectory at
+// time t0+t to stdout, where t0 is the initial time pointed to by par.
+//
+// RETURN VALUE:
+// Always 0 (print_pt exits on output errors).
+//
+// CALLS TO: print_pt
+//
+// CALLED FROM: frtbp_del_sample
+
+int print_sample(double t, const double x[DIM], void *par)
+{
+   print_pt(*(double *)par + t, x);
+   return(0);
+}
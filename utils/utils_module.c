@@ -6,7 +6,7 @@
 #include <stdlib.h>	// malloc
 #include <string.h>	// memcpy
 #include <stdio.h>	// printf
-#include <math.h>	// M_PI, floor
+#include <math.h>	// M_PI, floor, fabs
 
 const double TWOPI = 2*M_PI;
 
@@ -16,6 +16,23 @@ double *dblcpy(double * dst, double const * src, size_t len)
    return dst;
 }
 
+double dblsum(double const *x, size_t len)
+{
+   double s = 0, c = 0, t;
+   size_t i;
+
+   for(i=0; i<len; i++)
+   {
+      t = s + x[i];
+      if(fabs(s) >= fabs(x[i]))
+	 c += (s - t) + x[i];
+      else
+	 c += (x[i] - t) + s;
+      s = t;
+   }
+   return s + c;
+}
+
 void dblprint(double const *x, size_t len)
 {
    int i;
@@ -18,6 +18,21 @@ extern const double TWOPI;
   */
 double * dblcpy(double * dst, double const * src, size_t len);
 
+/** 
+  Compensated sum of an array of doubles.
+
+  The terms are added in index order with the Kahan-Babuska (Neumaier)
+  compensated summation, so the result does not depend on how the terms
+  were computed (e.g. by how many threads), and the rounding error does not
+  grow with len.
+
+  \param[in] x 		array
+  \param[in] len	length of array
+
+  \return		sum of x[0],...,x[len-1]
+  */
+double dblsum(double const *x, size_t len);
+
 /** 
   Print an array of doubles.
 